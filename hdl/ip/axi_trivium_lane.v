@@ -0,0 +1,489 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Design Name:      /
+// Module Name:      axi_trivium_lane
+// Project Name:     Trivium
+// Target Devices:   Spartan-6, Zynq
+// Tool versions:    ISE 14.7, Vivado v2016.2
+// Description:      A single lane of the Trivium IP core. It consists of one
+//                   trivium_top instance along with its register bank, which is
+//                   accessed through a simple register interface driven by the
+//                   AXI4LITE slave (see axi_trivium_v1_0_S00_AXI for the register
+//                   map). The AXI4-Stream ports are only used while the Stream
+//                   bit of the lane's control register is set. The cipher state
+//                   registers allow saving the lane's state and restoring it
+//                   later, which lets several users share one lane. Together with
+//                   the Hold bit, the key stream FIFO registers allow saving and
+//                   restoring the prefetched key stream as part of that state.
+//                   The interrupt status register latches the init done,
+//                   output available and skip done events, irq_o is asserted
+//                   while an enabled event is pending. The Skip bit fast-forwards
+//                   the key stream by the number of words in the skip register.
+//                   Writing the data queue register queues the word right away,
+//                   so a run of input words takes a single write per word.
+//                   The FIFO window port pushes and pops words of the data FIFOs on
+//                   behalf of the full AXI4 slave, in bursts of one word per clock.
+//                   The DMA engine inputs report whether the engine is idle in the
+//                   control register and latch its completion events in the interrupt
+//                   status register, they are only connected for lane 0.
+//
+// Dependencies:     trivium_top
+//
+//////////////////////////////////////////////////////////////////////////////////
+`timescale 1 ns / 1 ps
+
+module axi_trivium_lane #
+(
+    /* Number of bits processed per clock by the cipher (1, 8, 16, 32 or 64) */
+    parameter integer BITS_PER_CYCLE        = 1,
+    /* The input and output FIFOs hold 2^FIFO_DEPTH_LOG2 words (at most 2^7) */
+    parameter integer FIFO_DEPTH_LOG2       = 2,
+    /* The key stream prefetch FIFO holds 2^KS_FIFO_DEPTH_LOG2 words (at most 2^7) */
+    parameter integer KS_FIFO_DEPTH_LOG2    = 2,
+    /* Number of lanes of the IP core, reported in the info register */
+    parameter integer NUM_LANES             = 1
+)
+(
+    /* Standard control signals */
+    input wire          clk_i,          /* System clock */
+    input wire          n_rst_i,        /* Synchronous active low reset */
+
+    /* Register interface */
+    input wire          wr_i,           /* Write wr_dat_i to register wr_addr_i */
+    input wire  [4:0]   wr_addr_i,      /* Register index of write access */
+    input wire  [31:0]  wr_dat_i,       /* Write data */
+    input wire  [3:0]   wr_strb_i,      /* Byte enables of write access */
+    input wire          rd_i,           /* Register rd_addr_i is being read */
+    input wire  [4:0]   rd_addr_i,      /* Register index of read access */
+    output reg  [31:0]  rd_dat_o,       /* Read data */
+
+    /* AXI4-Stream data interfaces */
+    input wire  [31:0]  s_axis_tdata_i, /* Plaintext stream data */
+    input wire          s_axis_tvalid_i,/* Plaintext stream valid */
+    output wire         s_axis_tready_o,/* Plaintext stream ready */
+    input wire          s_axis_tlast_i, /* Plaintext stream last word of a message */
+    output wire [31:0]  m_axis_tdata_o, /* Ciphertext stream data */
+    output wire         m_axis_tvalid_o,/* Ciphertext stream valid */
+    input wire          m_axis_tready_i,/* Ciphertext stream ready */
+    output wire         m_axis_tlast_o, /* Ciphertext stream last word of a message */
+
+    /* FIFO window interface, ignored in stream mode */
+    input wire          win_push_i,     /* Queue win_dat_i in the input FIFO */
+    input wire  [31:0]  win_dat_i,      /* Word to queue */
+    input wire          win_pop_i,      /* Remove the head of the output FIFO */
+    output wire [31:0]  win_dat_o,      /* Head of the output FIFO */
+    output wire [15:0]  lvl_o,          /* Number of output FIFO entries and free input FIFO entries */
+
+    /* DMA engine status */
+    input wire          dma_idle_i,     /* No DMA descriptor is pending */
+    input wire          dma_evt_i,      /* DMA descriptor requesting an event completed */
+
+    /* Interrupt */
+    output wire         irq_o           /* Enabled interrupt event pending */
+);
+
+//////////////////////////////////////////////////////////////////////////////////
+// Register space related signals
+//////////////////////////////////////////////////////////////////////////////////
+reg    [31:0]                      reg_key_lo_r;    /* Key register LO */
+reg    [31:0]                      reg_key_mid_r;   /* Key register MID */
+reg    [31:0]                      reg_key_hi_r;    /* Key register HI */
+reg    [31:0]                      reg_iv_lo_r;     /* IV register LO */
+reg    [31:0]                      reg_iv_mid_r;    /* IV register MID */
+reg    [31:0]                      reg_iv_hi_r;     /* IV register HI */
+reg    [31:0]                      reg_idat_r;      /* Input data register */
+reg    [287:0]                     reg_st_r;        /* Cipher state to restore */
+reg    [31:0]                      reg_ks_spare_r;  /* Buffered key stream half to restore */
+reg                                reg_ks_spare_vld_r; /* Validity of reg_ks_spare_r */
+wire   [287:0]                     st_s;            /* Current cipher state */
+wire   [31:0]                      ks_spare_s;      /* Current buffered key stream half */
+wire                               ks_spare_vld_s;  /* Validity of ks_spare_s */
+wire   [31:0]                      ks_dat_s;        /* Head of the key stream FIFO */
+wire   [KS_FIFO_DEPTH_LOG2:0]      ks_lvl_s;        /* Key stream FIFO level */
+wire   [7:0]                       ks_avail_s;      /* Available key stream FIFO entries */
+wire                               ks_gen_s;        /* Key stream word partially generated */
+reg                                ks_wr_r;         /* Append word to the key stream FIFO */
+reg    [31:0]                      ks_wr_dat_r;     /* Word to append to the key stream FIFO */
+wire                               ks_rd_s;         /* Remove word from key stream FIFO via register read */
+wire   [31:0]                      reg_odat_s;      /* Output data register */
+wire   [31:0]                      reg_info_s;      /* Core information register */
+reg    [31:0]                      ld_dat_r;        /* Data loaded into register a or b */
+reg    [2:0]                       ld_sel_a_r;      /* Register a slice selection */
+reg    [2:0]                       ld_sel_b_r;      /* Register b slice selection */
+reg                                init_r;          /* Init cipher */
+reg                                stop_r;          /* Stop any calculations and reset the core */
+reg                                proc_r;          /* Queue input data for processing */
+reg                                restore_r;       /* Load the cipher state registers into the cipher */
+reg                                stream_en_r;     /* Data is exchanged via the AXI4-Stream interfaces */
+reg                                hold_r;          /* Stop prefetching key stream */
+reg                                skip_r;          /* Fast-forward the key stream */
+reg    [31:0]                      reg_skip_r;      /* Number of key stream words to skip */
+wire                               pop_s;           /* Remove word from output FIFO via register read */
+wire                               axis_push_s;     /* Word accepted on the AXI4-Stream slave */
+wire                               axis_pop_s;      /* Word delivered on the AXI4-Stream master */
+wire                               odat_last_s;     /* Last flag of the current output word */
+wire   [FIFO_DEPTH_LOG2:0]         in_lvl_s;        /* Input FIFO level */
+wire   [FIFO_DEPTH_LOG2:0]         out_lvl_s;       /* Output FIFO level */
+wire   [7:0]                       in_free_s;       /* Free input FIFO entries */
+wire   [7:0]                       out_avail_s;     /* Available output FIFO entries */
+wire                               busy_s;          /* Flag indicating whether core is busy */
+reg                                init_active_r;   /* Flag indicating whether init process is active */
+reg                                init_done_r;     /* Flag indicating whether init process is done */
+reg                                init_done_d_r;   /* init_done_r delayed by one cycle for edge detection */
+reg                                skip_active_r;   /* Flag indicating whether a fast-forward is active */
+reg                                skip_done_r;     /* Flag indicating whether the last fast-forward is done */
+reg                                skip_done_d_r;   /* skip_done_r delayed by one cycle for edge detection */
+reg    [3:0]                       reg_ier_r;       /* Interrupt enable register */
+reg    [3:0]                       reg_isr_r;       /* Interrupt status register */
+wire   [3:0]                       isr_set_s;       /* Interrupt events of the current cycle */
+integer                            byte_index;      /* Iteration index used for byte access of registers */
+
+//////////////////////////////////////////////////////////////////////////////////
+// Module instantiations
+//////////////////////////////////////////////////////////////////////////////////
+trivium_top #(
+    .BITS_PER_CYCLE(BITS_PER_CYCLE),
+    .FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+    .KS_FIFO_DEPTH_LOG2(KS_FIFO_DEPTH_LOG2)
+) trivium(
+    .clk_i(clk_i),
+    .n_rst_i(n_rst_i & ~stop_r),
+    .dat_i(stream_en_r ? s_axis_tdata_i : (win_push_i ? win_dat_i : reg_idat_r)),
+    .ld_dat_i(ld_dat_r),
+    .ld_reg_a_i(ld_sel_a_r),
+    .ld_reg_b_i(ld_sel_b_r),
+    .init_i(init_r),
+    .proc_i(stream_en_r ? axis_push_s : (proc_r | win_push_i)),
+    .last_i(stream_en_r ? s_axis_tlast_i : 1'b0),
+    .pop_i(stream_en_r ? axis_pop_s : (pop_s | win_pop_i)),
+    .st_ld_i(restore_r),
+    .st_dat_i(reg_st_r),
+    .ks_spare_i(reg_ks_spare_r),
+    .ks_spare_vld_i(reg_ks_spare_vld_r),
+    .hold_i(hold_r),
+    .ks_wr_i(ks_wr_r),
+    .ks_dat_i(ks_wr_dat_r),
+    .ks_rd_i(ks_rd_s),
+    .skip_i(skip_r),
+    .skip_cnt_i(reg_skip_r),
+    .dat_o(reg_odat_s),
+    .last_o(odat_last_s),
+    .busy_o(busy_s),
+    .in_lvl_o(in_lvl_s),
+    .out_lvl_o(out_lvl_s),
+    .st_o(st_s),
+    .ks_spare_o(ks_spare_s),
+    .ks_spare_vld_o(ks_spare_vld_s),
+    .ks_dat_o(ks_dat_s),
+    .ks_lvl_o(ks_lvl_s),
+    .ks_gen_o(ks_gen_s)
+);
+
+assign in_free_s = (1 << FIFO_DEPTH_LOG2) - in_lvl_s;
+assign out_avail_s = out_lvl_s;
+assign ks_avail_s = ks_lvl_s;
+assign reg_info_s = {KS_FIFO_DEPTH_LOG2[7:0], FIFO_DEPTH_LOG2[7:0], BITS_PER_CYCLE[7:0], NUM_LANES[7:0]};
+
+/* AXI4-Stream handshakes, the FIFOs ignore pushes when full and pops when empty */
+assign s_axis_tready_o = stream_en_r && (in_free_s != 0);
+assign axis_push_s = s_axis_tvalid_i && s_axis_tready_o;
+assign m_axis_tdata_o = reg_odat_s;
+assign m_axis_tlast_o = odat_last_s;
+assign m_axis_tvalid_o = stream_en_r && (out_avail_s != 0);
+assign axis_pop_s = m_axis_tvalid_o && m_axis_tready_i;
+
+/*
+ * FIFO window, a word pushed in the same cycle as the Process bit or the data
+ * queue register takes precedence, so the two must not be used concurrently
+ */
+assign win_dat_o = reg_odat_s;
+assign lvl_o = {out_avail_s, in_free_s};
+
+/*
+ * Implement register write logic
+ * Write strobes are used to select byte enables of the registers while writing.
+ * Writes to key and IV registers are forwarded to the cipher right away.
+ */
+always @(posedge clk_i) begin
+    if (n_rst_i == 1'b0) begin
+        /* Reset addressable registers driven here */
+        reg_key_lo_r <= 0;
+        reg_key_mid_r <= 0;
+        reg_key_hi_r <= 0;
+        reg_iv_lo_r <= 0;
+        reg_iv_mid_r <= 0;
+        reg_iv_hi_r <= 0;
+        reg_idat_r <= 0;
+        reg_st_r <= 0;
+        reg_ks_spare_r <= 0;
+        reg_ks_spare_vld_r <= 0;
+        reg_skip_r <= 0;
+
+        /* Reset any other registers driven here */
+        init_r <= 0;
+        stop_r <= 0;
+        proc_r <= 0;
+        restore_r <= 0;
+        stream_en_r <= 0;
+        hold_r <= 0;
+        skip_r <= 0;
+        ks_wr_r <= 0;
+        ks_wr_dat_r <= 0;
+        reg_ier_r <= 0;
+        ld_dat_r <= 0;
+        ld_sel_a_r <= 0;
+        ld_sel_b_r <= 0;
+    end
+    else begin
+        if (wr_i) begin
+            case (wr_addr_i)
+                5'h00:      /* Configuration register */
+                    /* Currently only byte 0 of configuration register is writable */
+                    if (wr_strb_i[0] == 1'b1) begin
+                        stream_en_r <= wr_dat_i[3];                         /* Bit 3 selects the data interface */
+                        hold_r <= wr_dat_i[5];                              /* Bit 5 stops the key stream prefetching */
+
+                        if (wr_dat_i[1] == 1'b1)                            /* Bit 1 resets core in any case */
+                            stop_r <= 1'b1;
+                        else if (wr_dat_i[0] == 1'b1 & !busy_s)             /* Bit 0 triggers init if core is not busy */
+                            init_r <= 1'b1;
+                        else if (wr_dat_i[4] == 1'b1 & !busy_s)             /* Bit 4 restores the state if core is not busy */
+                            restore_r <= 1'b1;
+                        else if (wr_dat_i[6] == 1'b1 & !busy_s)             /* Bit 6 fast-forwards the key stream if core is not busy */
+                            skip_r <= 1'b1;
+                        else if (wr_dat_i[2] == 1'b1)                       /* Bit 2 queues the input data */
+                            proc_r <= 1'b1;
+                    end
+                5'h01: begin /* LO key register */
+                    /* Reconstruct key LO value written so far */
+                    ld_dat_r <= reg_key_lo_r;
+                    ld_sel_a_r[0] <= 1'b1;
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1) begin
+                        /* Incorporate the rest that is currently being written */
+                        if (wr_strb_i[byte_index] == 1) begin
+                            ld_dat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            reg_key_lo_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                    end
+                end
+                5'h02: begin /* MID key register */
+                    /* Reconstruct key MID value written so far */
+                    ld_dat_r <= reg_key_mid_r;
+                    ld_sel_a_r[1] <= 1'b1;
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1) begin
+                        /* Incorporate the rest that is currently being written */
+                        if (wr_strb_i[byte_index] == 1) begin
+                            ld_dat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            reg_key_mid_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                    end
+                end
+                5'h03: begin /* HI key register */
+                    /* Reconstruct key HI value written so far */
+                    ld_dat_r <= reg_key_hi_r;
+                    ld_sel_a_r[2] <= 1'b1;
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1) begin
+                        /* Incorporate the rest that is currently being written */
+                        if (wr_strb_i[byte_index] == 1) begin
+                            ld_dat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            reg_key_hi_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                    end
+                end
+                5'h04: begin /* LO IV register */
+                    /* Reconstruct IV LO value written so far */
+                    ld_dat_r <= reg_iv_lo_r;
+                    ld_sel_b_r[0] <= 1'b1;
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1) begin
+                        /* Incorporate the rest that is currently being written */
+                        if (wr_strb_i[byte_index] == 1) begin
+                            ld_dat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            reg_iv_lo_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                    end
+                end
+                5'h05: begin /* MID IV register */
+                    /* Reconstruct IV MID value written so far */
+                    ld_dat_r <= reg_iv_mid_r;
+                    ld_sel_b_r[1] <= 1'b1;
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1) begin
+                        /* Incorporate the rest that is currently being written */
+                        if (wr_strb_i[byte_index] == 1) begin
+                            ld_dat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            reg_iv_mid_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                    end
+                end
+                5'h06: begin /* HI IV register */
+                    /* Reconstruct IV HI value written so far */
+                    ld_dat_r <= reg_iv_hi_r;
+                    ld_sel_b_r[2] <= 1'b1;
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1) begin
+                        /* Incorporate the rest that is currently being written */
+                        if (wr_strb_i[byte_index] == 1) begin
+                            ld_dat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            reg_iv_hi_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                    end
+                end
+                5'h07:   /* Input data register */
+                    /* Respective byte enables are asserted as per write strobes */
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1)
+                        if (wr_strb_i[byte_index] == 1) begin
+                            reg_idat_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                5'h0a:  /* Skip count register */
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1)
+                        if (wr_strb_i[byte_index] == 1) begin
+                            reg_skip_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                5'h0b: begin /* Data queue register, only complete words are queued */
+                    reg_idat_r <= wr_dat_i;
+                    proc_r <= 1'b1;
+                end
+                5'h19:  /* Key stream spare register */
+                    for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1)
+                        if (wr_strb_i[byte_index] == 1) begin
+                            reg_ks_spare_r[(byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                        end
+                5'h1a:  /* Key stream spare valid register */
+                    if (wr_strb_i[0] == 1'b1)
+                        reg_ks_spare_vld_r <= wr_dat_i[0];
+                5'h1b: begin /* Key stream FIFO register, only complete words are appended */
+                    ks_wr_r <= 1'b1;
+                    ks_wr_dat_r <= wr_dat_i;
+                end
+                5'h1d:  /* Interrupt enable register */
+                    if (wr_strb_i[0] == 1'b1)
+                        reg_ier_r <= wr_dat_i[3:0];
+                default:
+                    /* Cipher state registers, word 0 holds the state bits 31:0 */
+                    if (wr_addr_i >= 5'h10 && wr_addr_i <= 5'h18)
+                        for (byte_index = 0; byte_index <= 3; byte_index = byte_index+1)
+                            if (wr_strb_i[byte_index] == 1) begin
+                                reg_st_r[((wr_addr_i - 5'h10)*32 + byte_index*8) +: 8] <= wr_dat_i[(byte_index*8) +: 8];
+                            end
+            endcase
+        end
+        else begin
+            /* Reset all strobes/pulses that resulted from a register write */
+            init_r <= 0;
+            stop_r <= 0;
+            proc_r <= 0;
+            restore_r <= 0;
+            skip_r <= 0;
+            ks_wr_r <= 0;
+            ld_sel_a_r <= 0;
+            ld_sel_b_r <= 0;
+        end
+    end
+end
+
+/* Implement register read logic */
+always @(*) begin
+    /* Address decoding for reading registers */
+    case (rd_addr_i)
+        5'h00:      rd_dat_o <= {out_avail_s, in_free_s, 4'b0000, dma_idle_i, skip_done_r, init_done_r, busy_s, 2'b00, hold_r, 1'b0, stream_en_r, 3'b000};
+        5'h01:      rd_dat_o <= reg_key_lo_r;
+        5'h02:      rd_dat_o <= reg_key_mid_r;
+        5'h03:      rd_dat_o <= reg_key_hi_r;
+        5'h04:      rd_dat_o <= reg_iv_lo_r;
+        5'h05:      rd_dat_o <= reg_iv_mid_r;
+        5'h06:      rd_dat_o <= reg_iv_hi_r;
+        5'h07:      rd_dat_o <= reg_idat_r;
+        5'h08:      rd_dat_o <= reg_odat_s;
+        5'h09:      rd_dat_o <= reg_info_s;
+        5'h0a:      rd_dat_o <= reg_skip_r;
+        5'h10:      rd_dat_o <= st_s[31:0];
+        5'h11:      rd_dat_o <= st_s[63:32];
+        5'h12:      rd_dat_o <= st_s[95:64];
+        5'h13:      rd_dat_o <= st_s[127:96];
+        5'h14:      rd_dat_o <= st_s[159:128];
+        5'h15:      rd_dat_o <= st_s[191:160];
+        5'h16:      rd_dat_o <= st_s[223:192];
+        5'h17:      rd_dat_o <= st_s[255:224];
+        5'h18:      rd_dat_o <= st_s[287:256];
+        5'h19:      rd_dat_o <= ks_spare_s;
+        5'h1a:      rd_dat_o <= {31'h00000000, ks_spare_vld_s};
+        5'h1b:      rd_dat_o <= ks_dat_s;
+        5'h1c:      rd_dat_o <= {23'h000000, ks_gen_s, ks_avail_s};
+        5'h1d:      rd_dat_o <= {28'h0000000, reg_ier_r};
+        5'h1e:      rd_dat_o <= {28'h0000000, reg_isr_r};
+        default:    rd_dat_o <= 0;
+    endcase
+end
+
+/* Reading the output data and key stream FIFO registers consumes the word */
+assign pop_s = rd_i && (rd_addr_i == 5'h08);
+assign ks_rd_s = rd_i && (rd_addr_i == 5'h1b);
+
+/*
+ * This process monitors the initialization process of
+ * the core.
+ */
+always @(posedge clk_i) begin
+    if (n_rst_i == 1'b0 || stop_r == 1'b1) begin
+        init_active_r <= 0;
+        init_done_r <= 0;
+    end
+    else begin
+        if (restore_r == 1'b1)  /* A restored state needs no warm-up */
+            init_done_r <= 1'b1;
+        else if (init_r == 1'b1 && init_done_r == 1'b0 && busy_s == 1'b0)
+            init_active_r <= 1'b1;
+        else if (init_active_r == 1'b1 && busy_s == 1'b0)
+            init_done_r <= 1'b1;
+    end
+end
+
+/*
+ * This process monitors the fast-forward of the key stream. The done flag
+ * is cleared by the next fast-forward.
+ */
+always @(posedge clk_i) begin
+    if (n_rst_i == 1'b0 || stop_r == 1'b1) begin
+        skip_active_r <= 0;
+        skip_done_r <= 0;
+    end
+    else begin
+        if (skip_r == 1'b1) begin
+            skip_active_r <= 1'b1;
+            skip_done_r <= 1'b0;
+        end
+        else if (skip_active_r == 1'b1 && busy_s == 1'b0) begin
+            skip_active_r <= 1'b0;
+            skip_done_r <= 1'b1;
+        end
+    end
+end
+
+/*
+ * Interrupt status register, bits are set by the respective event and
+ * cleared by writing a one to them. An event in the same cycle as the
+ * clearing write takes precedence.
+ *  - Bit 0: Initialization (or restore) completed
+ *  - Bit 1: Output FIFO holds at least one word, set again as long as
+ *           words are available
+ *  - Bit 2: Fast-forward of the key stream completed
+ *  - Bit 3: DMA descriptor requesting an event (or failing) completed
+ */
+assign isr_set_s = {dma_evt_i, skip_done_r & ~skip_done_d_r, (out_avail_s != 0), init_done_r & ~init_done_d_r};
+assign irq_o = ((reg_isr_r & reg_ier_r) != 0);
+
+always @(posedge clk_i) begin
+    if (n_rst_i == 1'b0) begin
+        init_done_d_r <= 0;
+        skip_done_d_r <= 0;
+        reg_isr_r <= 0;
+    end
+    else begin
+        init_done_d_r <= init_done_r;
+        skip_done_d_r <= skip_done_r;
+        
+        if (wr_i == 1'b1 && wr_addr_i == 5'h1e && wr_strb_i[0] == 1'b1)
+            reg_isr_r <= (reg_isr_r & ~wr_dat_i[3:0]) | isr_set_s;
+        else
+            reg_isr_r <= reg_isr_r | isr_set_s;
+    end
+end
+
+endmodule
@@ -4,6 +4,11 @@
 	module axi_trivium_v1_0 #
 	(
 		// Users to add parameters here
+		parameter integer BITS_PER_CYCLE	= 1,
+		parameter integer FIFO_DEPTH_LOG2	= 2,
+		parameter integer KS_FIFO_DEPTH_LOG2	= 2,
+		// Number of independent cipher lanes, requires C_S00_AXI_ADDR_WIDTH >= 7 + ceil(log2(NUM_LANES))
+		parameter integer NUM_LANES	= 1,
 
 		// User parameters ends
 		// Do not modify the parameters beyond this line
@@ -11,11 +16,36 @@
 
 		// Parameters of Axi Slave Bus Interface S00_AXI
 		parameter integer C_S00_AXI_DATA_WIDTH	= 32,
-		parameter integer C_S00_AXI_ADDR_WIDTH	= 6
+		parameter integer C_S00_AXI_ADDR_WIDTH	= 7,
+
+		// Parameters of Axi Slave Bus Interface S01_AXI (FIFO windows, requires C_S01_AXI_ADDR_WIDTH >= 13 + ceil(log2(NUM_LANES)))
+		parameter integer C_S01_AXI_ID_WIDTH	= 1,
+		parameter integer C_S01_AXI_DATA_WIDTH	= 32,
+		parameter integer C_S01_AXI_ADDR_WIDTH	= 13,
+
+		// Parameters of Axi Master Bus Interface M00_AXI (DMA engine)
+		parameter integer C_M00_AXI_ID_WIDTH	= 1,
+		parameter integer C_M00_AXI_ADDR_WIDTH	= 32,
+		parameter integer C_M00_AXI_DATA_WIDTH	= 32
 	)
 	(
 		// Users to add ports here
 
+		// Ports of Axi Slave Stream Interface S00_AXIS (plaintext, clocked by s00_axi_aclk)
+		input wire [31 : 0] s00_axis_tdata,
+		input wire  s00_axis_tvalid,
+		output wire  s00_axis_tready,
+		input wire  s00_axis_tlast,
+
+		// Ports of Axi Master Stream Interface M00_AXIS (ciphertext, clocked by s00_axi_aclk)
+		output wire [31 : 0] m00_axis_tdata,
+		output wire  m00_axis_tvalid,
+		input wire  m00_axis_tready,
+		output wire  m00_axis_tlast,
+
+		// Interrupt request (level sensitive, active high, synchronous to s00_axi_aclk)
+		output wire  irq,
+
 		// User ports ends
 		// Do not modify the ports beyond this line
 
@@ -41,10 +71,118 @@
 		output wire [C_S00_AXI_DATA_WIDTH-1 : 0] s00_axi_rdata,
 		output wire [1 : 0] s00_axi_rresp,
 		output wire  s00_axi_rvalid,
-		input wire  s00_axi_rready
+		input wire  s00_axi_rready,
+
+		// Ports of Axi Slave Bus Interface S01_AXI (clocked by s00_axi_aclk)
+		input wire [C_S01_AXI_ID_WIDTH-1 : 0] s01_axi_awid,
+		input wire [C_S01_AXI_ADDR_WIDTH-1 : 0] s01_axi_awaddr,
+		input wire [7 : 0] s01_axi_awlen,
+		input wire [2 : 0] s01_axi_awsize,
+		input wire [1 : 0] s01_axi_awburst,
+		input wire  s01_axi_awlock,
+		input wire [3 : 0] s01_axi_awcache,
+		input wire [2 : 0] s01_axi_awprot,
+		input wire [3 : 0] s01_axi_awqos,
+		input wire [3 : 0] s01_axi_awregion,
+		input wire  s01_axi_awvalid,
+		output wire  s01_axi_awready,
+		input wire [C_S01_AXI_DATA_WIDTH-1 : 0] s01_axi_wdata,
+		input wire [(C_S01_AXI_DATA_WIDTH/8)-1 : 0] s01_axi_wstrb,
+		input wire  s01_axi_wlast,
+		input wire  s01_axi_wvalid,
+		output wire  s01_axi_wready,
+		output wire [C_S01_AXI_ID_WIDTH-1 : 0] s01_axi_bid,
+		output wire [1 : 0] s01_axi_bresp,
+		output wire  s01_axi_bvalid,
+		input wire  s01_axi_bready,
+		input wire [C_S01_AXI_ID_WIDTH-1 : 0] s01_axi_arid,
+		input wire [C_S01_AXI_ADDR_WIDTH-1 : 0] s01_axi_araddr,
+		input wire [7 : 0] s01_axi_arlen,
+		input wire [2 : 0] s01_axi_arsize,
+		input wire [1 : 0] s01_axi_arburst,
+		input wire  s01_axi_arlock,
+		input wire [3 : 0] s01_axi_arcache,
+		input wire [2 : 0] s01_axi_arprot,
+		input wire [3 : 0] s01_axi_arqos,
+		input wire [3 : 0] s01_axi_arregion,
+		input wire  s01_axi_arvalid,
+		output wire  s01_axi_arready,
+		output wire [C_S01_AXI_ID_WIDTH-1 : 0] s01_axi_rid,
+		output wire [C_S01_AXI_DATA_WIDTH-1 : 0] s01_axi_rdata,
+		output wire [1 : 0] s01_axi_rresp,
+		output wire  s01_axi_rlast,
+		output wire  s01_axi_rvalid,
+		input wire  s01_axi_rready,
+
+		// Ports of Axi Master Bus Interface M00_AXI (clocked by s00_axi_aclk)
+		output wire [C_M00_AXI_ID_WIDTH-1 : 0] m00_axi_awid,
+		output wire [C_M00_AXI_ADDR_WIDTH-1 : 0] m00_axi_awaddr,
+		output wire [7 : 0] m00_axi_awlen,
+		output wire [2 : 0] m00_axi_awsize,
+		output wire [1 : 0] m00_axi_awburst,
+		output wire  m00_axi_awlock,
+		output wire [3 : 0] m00_axi_awcache,
+		output wire [2 : 0] m00_axi_awprot,
+		output wire [3 : 0] m00_axi_awqos,
+		output wire  m00_axi_awvalid,
+		input wire  m00_axi_awready,
+		output wire [C_M00_AXI_DATA_WIDTH-1 : 0] m00_axi_wdata,
+		output wire [C_M00_AXI_DATA_WIDTH/8-1 : 0] m00_axi_wstrb,
+		output wire  m00_axi_wlast,
+		output wire  m00_axi_wvalid,
+		input wire  m00_axi_wready,
+		input wire [C_M00_AXI_ID_WIDTH-1 : 0] m00_axi_bid,
+		input wire [1 : 0] m00_axi_bresp,
+		input wire  m00_axi_bvalid,
+		output wire  m00_axi_bready,
+		output wire [C_M00_AXI_ID_WIDTH-1 : 0] m00_axi_arid,
+		output wire [C_M00_AXI_ADDR_WIDTH-1 : 0] m00_axi_araddr,
+		output wire [7 : 0] m00_axi_arlen,
+		output wire [2 : 0] m00_axi_arsize,
+		output wire [1 : 0] m00_axi_arburst,
+		output wire  m00_axi_arlock,
+		output wire [3 : 0] m00_axi_arcache,
+		output wire [2 : 0] m00_axi_arprot,
+		output wire [3 : 0] m00_axi_arqos,
+		output wire  m00_axi_arvalid,
+		input wire  m00_axi_arready,
+		input wire [C_M00_AXI_ID_WIDTH-1 : 0] m00_axi_rid,
+		input wire [C_M00_AXI_DATA_WIDTH-1 : 0] m00_axi_rdata,
+		input wire [1 : 0] m00_axi_rresp,
+		input wire  m00_axi_rlast,
+		input wire  m00_axi_rvalid,
+		output wire  m00_axi_rready
 	);
+	// FIFO window signals between the two slaves
+	wire [NUM_LANES-1 : 0] win_push;
+	wire [31 : 0] win_wdata;
+	wire [NUM_LANES-1 : 0] win_pop;
+	wire [(NUM_LANES*32)-1 : 0] win_rdata;
+
+	// DMA engine signals
+	wire  dma_reg_wr;
+	wire [4 : 0] dma_reg_wr_addr;
+	wire [31 : 0] dma_reg_wr_dat;
+	wire [4 : 0] dma_reg_rd_addr;
+	wire [31 : 0] dma_reg_rd_dat;
+	wire  dma_lane_hold;
+	wire  dma_lane_wr;
+	wire [4 : 0] dma_lane_wr_addr;
+	wire [31 : 0] dma_lane_wr_dat;
+	wire [15 : 0] dma_lane_lvl;
+	wire  dma_idle;
+	wire  dma_push;
+	wire [31 : 0] dma_push_dat;
+	wire  dma_pop;
+	wire [31 : 0] dma_pop_dat;
+	wire  dma_evt;
+
 // Instantiation of Axi Bus Interface S00_AXI
 	axi_trivium_v1_0_S00_AXI # ( 
+		.BITS_PER_CYCLE(BITS_PER_CYCLE),
+		.FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+		.KS_FIFO_DEPTH_LOG2(KS_FIFO_DEPTH_LOG2),
+		.NUM_LANES(NUM_LANES),
 		.C_S_AXI_DATA_WIDTH(C_S00_AXI_DATA_WIDTH),
 		.C_S_AXI_ADDR_WIDTH(C_S00_AXI_ADDR_WIDTH)
 	) axi_trivium_v1_0_S00_AXI_inst (
@@ -68,7 +206,154 @@
 		.S_AXI_RDATA(s00_axi_rdata),
 		.S_AXI_RRESP(s00_axi_rresp),
 		.S_AXI_RVALID(s00_axi_rvalid),
-		.S_AXI_RREADY(s00_axi_rready)
+		.S_AXI_RREADY(s00_axi_rready),
+		.S_AXIS_TDATA(s00_axis_tdata),
+		.S_AXIS_TVALID(s00_axis_tvalid),
+		.S_AXIS_TREADY(s00_axis_tready),
+		.S_AXIS_TLAST(s00_axis_tlast),
+		.M_AXIS_TDATA(m00_axis_tdata),
+		.M_AXIS_TVALID(m00_axis_tvalid),
+		.M_AXIS_TREADY(m00_axis_tready),
+		.M_AXIS_TLAST(m00_axis_tlast),
+		.WIN_PUSH(win_push),
+		.WIN_WDATA(win_wdata),
+		.WIN_POP(win_pop),
+		.WIN_RDATA(win_rdata),
+		.DMA_REG_WR(dma_reg_wr),
+		.DMA_REG_WR_ADDR(dma_reg_wr_addr),
+		.DMA_REG_WR_DAT(dma_reg_wr_dat),
+		.DMA_REG_RD_ADDR(dma_reg_rd_addr),
+		.DMA_REG_RD_DAT(dma_reg_rd_dat),
+		.DMA_LANE_HOLD(dma_lane_hold),
+		.DMA_LANE_WR(dma_lane_wr),
+		.DMA_LANE_WR_ADDR(dma_lane_wr_addr),
+		.DMA_LANE_WR_DAT(dma_lane_wr_dat),
+		.DMA_PUSH(dma_push),
+		.DMA_PUSH_DAT(dma_push_dat),
+		.DMA_POP(dma_pop),
+		.DMA_POP_DAT(dma_pop_dat),
+		.DMA_LANE_LVL(dma_lane_lvl),
+		.DMA_IDLE(dma_idle),
+		.DMA_EVT(dma_evt),
+		.IRQ(irq)
+	);
+
+// Instantiation of Axi Bus Interface S01_AXI
+	axi_trivium_v1_0_S01_AXI # ( 
+		.NUM_LANES(NUM_LANES),
+		.C_S_AXI_ID_WIDTH(C_S01_AXI_ID_WIDTH),
+		.C_S_AXI_DATA_WIDTH(C_S01_AXI_DATA_WIDTH),
+		.C_S_AXI_ADDR_WIDTH(C_S01_AXI_ADDR_WIDTH)
+	) axi_trivium_v1_0_S01_AXI_inst (
+		.S_AXI_ACLK(s00_axi_aclk),
+		.S_AXI_ARESETN(s00_axi_aresetn),
+		.S_AXI_AWID(s01_axi_awid),
+		.S_AXI_AWADDR(s01_axi_awaddr),
+		.S_AXI_AWLEN(s01_axi_awlen),
+		.S_AXI_AWSIZE(s01_axi_awsize),
+		.S_AXI_AWBURST(s01_axi_awburst),
+		.S_AXI_AWLOCK(s01_axi_awlock),
+		.S_AXI_AWCACHE(s01_axi_awcache),
+		.S_AXI_AWPROT(s01_axi_awprot),
+		.S_AXI_AWQOS(s01_axi_awqos),
+		.S_AXI_AWREGION(s01_axi_awregion),
+		.S_AXI_AWVALID(s01_axi_awvalid),
+		.S_AXI_AWREADY(s01_axi_awready),
+		.S_AXI_WDATA(s01_axi_wdata),
+		.S_AXI_WSTRB(s01_axi_wstrb),
+		.S_AXI_WLAST(s01_axi_wlast),
+		.S_AXI_WVALID(s01_axi_wvalid),
+		.S_AXI_WREADY(s01_axi_wready),
+		.S_AXI_BID(s01_axi_bid),
+		.S_AXI_BRESP(s01_axi_bresp),
+		.S_AXI_BVALID(s01_axi_bvalid),
+		.S_AXI_BREADY(s01_axi_bready),
+		.S_AXI_ARID(s01_axi_arid),
+		.S_AXI_ARADDR(s01_axi_araddr),
+		.S_AXI_ARLEN(s01_axi_arlen),
+		.S_AXI_ARSIZE(s01_axi_arsize),
+		.S_AXI_ARBURST(s01_axi_arburst),
+		.S_AXI_ARLOCK(s01_axi_arlock),
+		.S_AXI_ARCACHE(s01_axi_arcache),
+		.S_AXI_ARPROT(s01_axi_arprot),
+		.S_AXI_ARQOS(s01_axi_arqos),
+		.S_AXI_ARREGION(s01_axi_arregion),
+		.S_AXI_ARVALID(s01_axi_arvalid),
+		.S_AXI_ARREADY(s01_axi_arready),
+		.S_AXI_RID(s01_axi_rid),
+		.S_AXI_RDATA(s01_axi_rdata),
+		.S_AXI_RRESP(s01_axi_rresp),
+		.S_AXI_RLAST(s01_axi_rlast),
+		.S_AXI_RVALID(s01_axi_rvalid),
+		.S_AXI_RREADY(s01_axi_rready),
+		.WIN_PUSH(win_push),
+		.WIN_WDATA(win_wdata),
+		.WIN_POP(win_pop),
+		.WIN_RDATA(win_rdata)
+	);
+
+// Instantiation of Axi Bus Interface M00_AXI
+	axi_trivium_v1_0_M00_AXI # ( 
+		.FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+		.C_M_AXI_ID_WIDTH(C_M00_AXI_ID_WIDTH),
+		.C_M_AXI_ADDR_WIDTH(C_M00_AXI_ADDR_WIDTH),
+		.C_M_AXI_DATA_WIDTH(C_M00_AXI_DATA_WIDTH)
+	) axi_trivium_v1_0_M00_AXI_inst (
+		.M_AXI_ACLK(s00_axi_aclk),
+		.M_AXI_ARESETN(s00_axi_aresetn),
+		.M_AXI_AWID(m00_axi_awid),
+		.M_AXI_AWADDR(m00_axi_awaddr),
+		.M_AXI_AWLEN(m00_axi_awlen),
+		.M_AXI_AWSIZE(m00_axi_awsize),
+		.M_AXI_AWBURST(m00_axi_awburst),
+		.M_AXI_AWLOCK(m00_axi_awlock),
+		.M_AXI_AWCACHE(m00_axi_awcache),
+		.M_AXI_AWPROT(m00_axi_awprot),
+		.M_AXI_AWQOS(m00_axi_awqos),
+		.M_AXI_AWVALID(m00_axi_awvalid),
+		.M_AXI_AWREADY(m00_axi_awready),
+		.M_AXI_WDATA(m00_axi_wdata),
+		.M_AXI_WSTRB(m00_axi_wstrb),
+		.M_AXI_WLAST(m00_axi_wlast),
+		.M_AXI_WVALID(m00_axi_wvalid),
+		.M_AXI_WREADY(m00_axi_wready),
+		.M_AXI_BID(m00_axi_bid),
+		.M_AXI_BRESP(m00_axi_bresp),
+		.M_AXI_BVALID(m00_axi_bvalid),
+		.M_AXI_BREADY(m00_axi_bready),
+		.M_AXI_ARID(m00_axi_arid),
+		.M_AXI_ARADDR(m00_axi_araddr),
+		.M_AXI_ARLEN(m00_axi_arlen),
+		.M_AXI_ARSIZE(m00_axi_arsize),
+		.M_AXI_ARBURST(m00_axi_arburst),
+		.M_AXI_ARLOCK(m00_axi_arlock),
+		.M_AXI_ARCACHE(m00_axi_arcache),
+		.M_AXI_ARPROT(m00_axi_arprot),
+		.M_AXI_ARQOS(m00_axi_arqos),
+		.M_AXI_ARVALID(m00_axi_arvalid),
+		.M_AXI_ARREADY(m00_axi_arready),
+		.M_AXI_RID(m00_axi_rid),
+		.M_AXI_RDATA(m00_axi_rdata),
+		.M_AXI_RRESP(m00_axi_rresp),
+		.M_AXI_RLAST(m00_axi_rlast),
+		.M_AXI_RVALID(m00_axi_rvalid),
+		.M_AXI_RREADY(m00_axi_rready),
+		.DMA_REG_WR(dma_reg_wr),
+		.DMA_REG_WR_ADDR(dma_reg_wr_addr),
+		.DMA_REG_WR_DAT(dma_reg_wr_dat),
+		.DMA_REG_RD_ADDR(dma_reg_rd_addr),
+		.DMA_REG_RD_DAT(dma_reg_rd_dat),
+		.DMA_LANE_HOLD(dma_lane_hold),
+		.DMA_LANE_WR(dma_lane_wr),
+		.DMA_LANE_WR_ADDR(dma_lane_wr_addr),
+		.DMA_LANE_WR_DAT(dma_lane_wr_dat),
+		.DMA_PUSH(dma_push),
+		.DMA_PUSH_DAT(dma_push_dat),
+		.DMA_POP(dma_pop),
+		.DMA_POP_DAT(dma_pop_dat),
+		.DMA_LANE_LVL(dma_lane_lvl),
+		.DMA_IDLE(dma_idle),
+		.DMA_EVT(dma_evt)
 	);
 
 	// Add user logic here
@@ -0,0 +1,513 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Design Name:      /
+// Module Name:      axi_trivium_v1_0_M00_AXI
+// Project Name:     Trivium
+// Target Devices:   Zynq
+// Tool versions:    Vivado v2016.2
+// Description:      Scatter-gather DMA engine of the Trivium IP core. An AXI4 master
+//                   fetches descriptors from a ring in memory and encrypts the buffers
+//                   they describe through lane 0 without any involvement of the CPU.
+//                   The ring consists of 2^N descriptors of 8 words (32 bytes) each:
+//                      +0:      Control
+//                         -Bits 1:0: Session (0: continue the key stream, 1: start a new
+//                                    key stream from the key and IV block, 2: restore
+//                                    the state block)
+//                         -Bit 31:   Signal the DMA event of lane 0 on completion
+//                      +1:      Source address (word aligned)
+//                      +2:      Destination address (word aligned, may equal the source)
+//                      +3:      Length in words
+//                      +4:      Session block address (64-byte aligned, bits 5:0 are ignored,
+//                               so the block never crosses a 4 KiB boundary), holding
+//                                  Session 1: Key (3 words) followed by IV (3 words), in
+//                                             the format of registers +1 to +6
+//                                  Session 2: Cipher state and key stream spare (11 words),
+//                                             in the format of registers +16 to +26
+//                      +5, +6:  UNUSED
+//                      +7:      Status, written by the engine on completion
+//                         -Bit 30:   Error (a bus error occurred while processing)
+//                         -Bit 31:   Done
+//                   The engine processes the descriptors from the head index up to the
+//                   tail index, which the driver advances after appending descriptors.
+//                   A session block is loaded by stopping lane 0, writing the block to
+//                   the respective registers and setting Init or Restore, exactly like
+//                   the driver does it. A restored state continues without prefetched key
+//                   stream, i.e. it must have been saved with an empty key stream FIFO.
+//                   The data is moved in INCR bursts of up to 16 words that neither cross
+//                   a 4 KiB boundary nor exceed the room in the FIFOs of the lane. Reads
+//                   of the source and writes of the destination overlap.
+//                   A bus error is recorded in the descriptor and the error bit of the
+//                   status register, after which the engine stops at the next descriptor.
+//                   Clearing Enable aborts the descriptor being processed as soon as the
+//                   bursts in flight have completed, without writing its status. The
+//                   head stays at the aborted descriptor.
+//                   Register map (lane 0 register bank, the other lanes read zero):
+//                      +12:     DMA control register (RW)
+//                         -12.0: UNUSED | ... | UNUSED | Enable (RW)
+//                         -12.1: UNUSED | ... | Log2 of the number of ring entries (RW, at most 16)
+//                         -12.2: UNUSED | ... | UNUSED | Busy (R)
+//                      +13:     DMA ring base address register (RW, 32-byte aligned)
+//                      +14:     DMA tail register (RW, index of the next descriptor to append)
+//                      +15:     DMA head register (RW while not enabled, index of the next
+//                               descriptor to process)
+//                      +31:     DMA status register (R, W1C)
+//                         -31.0: UNUSED | ... | UNUSED | Error
+//                   While the engine is enabled, lane 0 must only be accessed through its
+//                   configuration and interrupt registers. The AXI4LITE slave holds off
+//                   writes while the engine loads a session.
+//
+// Dependencies:     /
+//
+//////////////////////////////////////////////////////////////////////////////////
+`timescale 1 ns / 1 ps
+
+module axi_trivium_v1_0_M00_AXI #
+(
+    /* The input and output FIFOs of the lanes hold 2^FIFO_DEPTH_LOG2 words (at most 2^7) */
+    parameter integer FIFO_DEPTH_LOG2       = 2,
+    /* Width of ID for write address, write data, read address and read data */
+    parameter integer C_M_AXI_ID_WIDTH      = 1,
+    /* Width of M_AXI address bus */
+    parameter integer C_M_AXI_ADDR_WIDTH    = 32,
+    /* Width of M_AXI data bus */
+    parameter integer C_M_AXI_DATA_WIDTH    = 32
+)
+(
+    /* Global Clock Signal */
+    input wire  M_AXI_ACLK,
+    /* Global Reset Signal. This Signal is Active LOW */
+    input wire  M_AXI_ARESETN,
+    /* Master Interface Write Address ID */
+    output wire [C_M_AXI_ID_WIDTH - 1:0] M_AXI_AWID,
+    /* Master Interface Write Address */
+    output wire [C_M_AXI_ADDR_WIDTH - 1:0] M_AXI_AWADDR,
+    /* Burst length. The burst length gives the exact number of transfers in a burst */
+    output wire [7:0] M_AXI_AWLEN,
+    /* Burst size. This signal indicates the size of each transfer in the burst */
+    output wire [2:0] M_AXI_AWSIZE,
+    /* Burst type. The burst type and the size information determine how the address is calculated */
+    output wire [1:0] M_AXI_AWBURST,
+    /* Lock type. Provides additional information about the atomic characteristics of the transfer */
+    output wire  M_AXI_AWLOCK,
+    /* Memory type. This signal indicates how transactions are required to progress through a system */
+    output wire [3:0] M_AXI_AWCACHE,
+    /* Protection type. This signal indicates the privilege and security level of the transaction */
+    output wire [2:0] M_AXI_AWPROT,
+    /* Quality of Service, QoS identifier sent for each write transaction */
+    output wire [3:0] M_AXI_AWQOS,
+    /* Write address valid. This signal indicates that the channel is signaling valid write address */
+    output wire  M_AXI_AWVALID,
+    /* Write address ready. This signal indicates that the slave is ready to accept an address */
+    input wire  M_AXI_AWREADY,
+    /* Master Interface Write Data */
+    output wire [C_M_AXI_DATA_WIDTH - 1:0] M_AXI_WDATA,
+    /* Write strobes. This signal indicates which byte lanes hold valid data */
+    output wire [(C_M_AXI_DATA_WIDTH/8) - 1:0] M_AXI_WSTRB,
+    /* Write last. This signal indicates the last transfer in a write burst */
+    output wire  M_AXI_WLAST,
+    /* Write valid. This signal indicates that valid write data and strobes are available */
+    output wire  M_AXI_WVALID,
+    /* Write ready. This signal indicates that the slave can accept the write data */
+    input wire  M_AXI_WREADY,
+    /* Master Interface Write Response ID */
+    input wire [C_M_AXI_ID_WIDTH - 1:0] M_AXI_BID,
+    /* Write response. This signal indicates the status of the write transaction */
+    input wire [1:0] M_AXI_BRESP,
+    /* Write response valid. This signal indicates that the channel is signaling a valid write response */
+    input wire  M_AXI_BVALID,
+    /* Response ready. This signal indicates that the master can accept a write response */
+    output wire  M_AXI_BREADY,
+    /* Master Interface Read Address ID */
+    output wire [C_M_AXI_ID_WIDTH - 1:0] M_AXI_ARID,
+    /* Read address */
+    output wire [C_M_AXI_ADDR_WIDTH - 1:0] M_AXI_ARADDR,
+    /* Burst length. The burst length gives the exact number of transfers in a burst */
+    output wire [7:0] M_AXI_ARLEN,
+    /* Burst size. This signal indicates the size of each transfer in the burst */
+    output wire [2:0] M_AXI_ARSIZE,
+    /* Burst type. The burst type and the size information determine how the address is calculated */
+    output wire [1:0] M_AXI_ARBURST,
+    /* Lock type. Provides additional information about the atomic characteristics of the transfer */
+    output wire  M_AXI_ARLOCK,
+    /* Memory type. This signal indicates how transactions are required to progress through a system */
+    output wire [3:0] M_AXI_ARCACHE,
+    /* Protection type. This signal indicates the privilege and security level of the transaction */
+    output wire [2:0] M_AXI_ARPROT,
+    /* Quality of Service, QoS identifier sent for each read transaction */
+    output wire [3:0] M_AXI_ARQOS,
+    /* Read address valid. This signal indicates that the channel is signaling valid read address */
+    output wire  M_AXI_ARVALID,
+    /* Read address ready. This signal indicates that the slave is ready to accept an address */
+    input wire  M_AXI_ARREADY,
+    /* Read ID tag. This signal is the identification tag for the read data group of signals */
+    input wire [C_M_AXI_ID_WIDTH - 1:0] M_AXI_RID,
+    /* Master Read Data */
+    input wire [C_M_AXI_DATA_WIDTH - 1:0] M_AXI_RDATA,
+    /* Read response. This signal indicates the status of the read transfer */
+    input wire [1:0] M_AXI_RRESP,
+    /* Read last. This signal indicates the last transfer in a read burst */
+    input wire  M_AXI_RLAST,
+    /* Read valid. This signal indicates that the channel is signaling the required read data */
+    input wire  M_AXI_RVALID,
+    /* Read ready. This signal indicates that the master can accept the read data and response information */
+    output wire  M_AXI_RREADY,
+
+    /* DMA registers, driven by the AXI4LITE slave */
+    input wire          DMA_REG_WR,         /* Write DMA_REG_WR_DAT to register DMA_REG_WR_ADDR */
+    input wire  [4:0]   DMA_REG_WR_ADDR,    /* Register index of write access */
+    input wire  [31:0]  DMA_REG_WR_DAT,     /* Write data */
+    input wire  [4:0]   DMA_REG_RD_ADDR,    /* Register index of read access */
+    output reg  [31:0]  DMA_REG_RD_DAT,     /* Read data */
+
+    /* Lane 0 */
+    output wire         DMA_LANE_HOLD,      /* Lane registers are about to be written, hold off other writes */
+    output reg          DMA_LANE_WR,        /* Write DMA_LANE_WR_DAT to lane register DMA_LANE_WR_ADDR */
+    output reg  [4:0]   DMA_LANE_WR_ADDR,   /* Register index of lane write access */
+    output reg  [31:0]  DMA_LANE_WR_DAT,    /* Lane write data */
+    output wire         DMA_PUSH,           /* Queue DMA_PUSH_DAT in the input FIFO */
+    output wire [31:0]  DMA_PUSH_DAT,       /* Word to queue */
+    output wire         DMA_POP,            /* Remove the head of the output FIFO */
+    input wire  [31:0]  DMA_POP_DAT,        /* Head of the output FIFO */
+    input wire  [15:0]  DMA_LANE_LVL,       /* Number of output FIFO entries and free input FIFO entries */
+    output wire         DMA_IDLE,           /* No descriptor is pending */
+    output reg          DMA_EVT             /* Descriptor requesting an event completed */
+);
+
+//////////////////////////////////////////////////////////////////////////////////
+// Local parameter definitions
+//////////////////////////////////////////////////////////////////////////////////
+localparam  IDLE_e = 0,     /* Waiting for descriptors */
+            DESC_e = 1,     /* Fetching a descriptor */
+            STOP_e = 2,     /* Stopping the lane */
+            SESS_e = 3,     /* Loading the session block into the lane */
+            START_e = 4,    /* Starting the session */
+            DATA_e = 5,     /* Moving the data through the lane */
+            STAT_e = 6;     /* Writing back the status */
+
+localparam integer BURST_MAX = ((1 << FIFO_DEPTH_LOG2) < 16) ? (1 << FIFO_DEPTH_LOG2) : 16;
+
+//////////////////////////////////////////////////////////////////////////////////
+// Signal definitions
+//////////////////////////////////////////////////////////////////////////////////
+reg     [2:0]   state_r;        /* Current state of the engine */
+reg             enable_r;       /* Enable bit of the control register */
+reg     [4:0]   ring_log2_r;    /* Log2 of the number of ring entries */
+reg     [26:0]  ring_base_r;    /* Ring base address bits 31:5 */
+reg     [15:0]  tail_r;         /* Tail index */
+reg     [15:0]  head_r;         /* Head index */
+reg             error_r;        /* Error bit of the status register */
+wire    [15:0]  ring_mask_s;    /* Mask of valid ring indices */
+wire    [31:0]  desc_addr_s;    /* Address of the descriptor at the head */
+reg     [31:0]  desc_ctrl_r;    /* Control word of the current descriptor */
+reg     [31:0]  sess_addr_r;    /* Session block address of the current descriptor */
+reg             desc_err_r;     /* Bus error while processing the current descriptor */
+reg     [2:0]   beat_r;         /* Index of the next descriptor word */
+reg     [4:0]   sess_reg_r;     /* Lane register written by the next session block word */
+
+reg     [31:0]  araddr_r;       /* Read address */
+reg     [7:0]   arlen_r;        /* Read burst length */
+reg             arvalid_r;      /* Read address valid */
+reg             rd_act_r;       /* Read burst in progress */
+reg     [31:0]  rd_ptr_r;       /* Next source address */
+reg     [31:0]  rd_rem_r;       /* Source words left to request */
+reg     [31:0]  rd_len_s;       /* Length of the next source burst */
+
+reg     [31:0]  awaddr_r;       /* Write address */
+reg     [7:0]   awlen_r;        /* Write burst length */
+reg             awvalid_r;      /* Write address valid */
+reg             wr_act_r;       /* Write burst in progress, until its response */
+reg     [8:0]   wr_beats_r;     /* Write data beats left in the current burst */
+reg             wr_stat_r;      /* Current write burst is the status write-back */
+reg     [31:0]  wr_ptr_r;       /* Next destination address */
+reg     [31:0]  wr_rem_r;       /* Destination words left to request */
+reg     [31:0]  wr_len_s;       /* Length of the next destination burst */
+
+wire            r_beat_s;       /* Read data beat accepted */
+wire            w_beat_s;       /* Write data beat accepted */
+wire            b_beat_s;       /* Write response accepted */
+wire    [7:0]   in_free_s;      /* Free input FIFO entries of the lane */
+wire    [7:0]   out_lvl_s;      /* Output FIFO entries of the lane */
+
+//////////////////////////////////////////////////////////////////////////////////
+// I/O Connection Assignments
+//////////////////////////////////////////////////////////////////////////////////
+assign M_AXI_AWID       = 0;
+assign M_AXI_AWADDR     = awaddr_r;
+assign M_AXI_AWLEN      = awlen_r;
+assign M_AXI_AWSIZE     = 3'b010;   /* 4 bytes per beat */
+assign M_AXI_AWBURST    = 2'b01;    /* INCR */
+assign M_AXI_AWLOCK     = 1'b0;
+assign M_AXI_AWCACHE    = 4'b0011;  /* Normal non-cacheable bufferable */
+assign M_AXI_AWPROT     = 3'b000;
+assign M_AXI_AWQOS      = 4'b0000;
+assign M_AXI_AWVALID    = awvalid_r;
+assign M_AXI_WDATA      = wr_stat_r ? {1'b1, desc_err_r, 30'h00000000} : DMA_POP_DAT;
+assign M_AXI_WSTRB      = 4'hf;
+assign M_AXI_WLAST      = (wr_beats_r == 1);
+assign M_AXI_WVALID     = (wr_beats_r != 0);
+assign M_AXI_BREADY     = wr_act_r && (wr_beats_r == 0);
+assign M_AXI_ARID       = 0;
+assign M_AXI_ARADDR     = araddr_r;
+assign M_AXI_ARLEN      = arlen_r;
+assign M_AXI_ARSIZE     = 3'b010;   /* 4 bytes per beat */
+assign M_AXI_ARBURST    = 2'b01;    /* INCR */
+assign M_AXI_ARLOCK     = 1'b0;
+assign M_AXI_ARCACHE    = 4'b0011;  /* Normal non-cacheable bufferable */
+assign M_AXI_ARPROT     = 3'b000;
+assign M_AXI_ARQOS      = 4'b0000;
+assign M_AXI_ARVALID    = arvalid_r;
+/* Session block words are written to the lane every other cycle, as required by its register interface */
+assign M_AXI_RREADY     = rd_act_r && ((state_r != SESS_e) || ~DMA_LANE_WR);
+
+assign r_beat_s = M_AXI_RVALID && M_AXI_RREADY;
+assign w_beat_s = M_AXI_WVALID && M_AXI_WREADY;
+assign b_beat_s = M_AXI_BVALID && M_AXI_BREADY;
+
+assign in_free_s = DMA_LANE_LVL[7:0];
+assign out_lvl_s = DMA_LANE_LVL[15:8];
+assign DMA_PUSH = r_beat_s && (state_r == DATA_e);
+assign DMA_PUSH_DAT = M_AXI_RDATA;
+assign DMA_POP = w_beat_s && ~wr_stat_r;
+/*
+ * The lane registers are written while loading a session, other writes are
+ * held off from the descriptor fetch until one cycle after the last of them
+ */
+assign DMA_LANE_HOLD = (state_r == DESC_e) || (state_r == STOP_e) || (state_r == SESS_e) || (state_r == START_e) ||
+                       DMA_LANE_WR;
+assign DMA_IDLE = (state_r == IDLE_e) && (~enable_r || error_r || (head_r == tail_r));
+
+assign ring_mask_s = (17'h00001 << ring_log2_r) - 1;
+assign desc_addr_s = {ring_base_r, 5'b00000} + {head_r, 5'b00000};
+
+/*
+ * Burst lengths, limited by the words left, the room in the FIFOs of the
+ * lane and the next 4 KiB boundary
+ */
+always @(*) begin
+    rd_len_s = (rd_rem_r < BURST_MAX) ? rd_rem_r : BURST_MAX;
+    if (rd_len_s > ((13'h1000 - rd_ptr_r[11:0]) >> 2))
+        rd_len_s = (13'h1000 - rd_ptr_r[11:0]) >> 2;
+
+    wr_len_s = (wr_rem_r < BURST_MAX) ? wr_rem_r : BURST_MAX;
+    if (wr_len_s > ((13'h1000 - wr_ptr_r[11:0]) >> 2))
+        wr_len_s = (13'h1000 - wr_ptr_r[11:0]) >> 2;
+end
+
+/* Implement register read logic */
+always @(*) begin
+    case (DMA_REG_RD_ADDR)
+        5'h0c:      DMA_REG_RD_DAT <= {15'h0000, (state_r != IDLE_e), 3'b000, ring_log2_r, 7'h00, enable_r};
+        5'h0d:      DMA_REG_RD_DAT <= {ring_base_r, 5'b00000};
+        5'h0e:      DMA_REG_RD_DAT <= {16'h0000, tail_r};
+        5'h0f:      DMA_REG_RD_DAT <= {16'h0000, head_r};
+        5'h1f:      DMA_REG_RD_DAT <= {31'h00000000, error_r};
+        default:    DMA_REG_RD_DAT <= 0;
+    endcase
+end
+
+/*
+ * Implement the engine
+ * The read channel serves the descriptor, the session block and the source
+ * data in turn, the write channel the destination data and the status. During
+ * the data phase, a source burst is requested once the input FIFO has room for
+ * all of its words and a destination burst once the output FIFO holds all of
+ * them, so neither a push nor a pop is ever dropped.
+ */
+always @(posedge M_AXI_ACLK) begin
+    if (M_AXI_ARESETN == 1'b0) begin
+        state_r <= IDLE_e;
+        enable_r <= 0;
+        ring_log2_r <= 0;
+        ring_base_r <= 0;
+        tail_r <= 0;
+        head_r <= 0;
+        error_r <= 0;
+        desc_ctrl_r <= 0;
+        sess_addr_r <= 0;
+        desc_err_r <= 0;
+        beat_r <= 0;
+        sess_reg_r <= 0;
+        araddr_r <= 0;
+        arlen_r <= 0;
+        arvalid_r <= 0;
+        rd_act_r <= 0;
+        rd_ptr_r <= 0;
+        rd_rem_r <= 0;
+        awaddr_r <= 0;
+        awlen_r <= 0;
+        awvalid_r <= 0;
+        wr_act_r <= 0;
+        wr_beats_r <= 0;
+        wr_stat_r <= 0;
+        wr_ptr_r <= 0;
+        wr_rem_r <= 0;
+        DMA_LANE_WR <= 0;
+        DMA_LANE_WR_ADDR <= 0;
+        DMA_LANE_WR_DAT <= 0;
+        DMA_EVT <= 0;
+    end
+    else begin
+        /* Pulses */
+        DMA_LANE_WR <= 0;
+        DMA_EVT <= 0;
+
+        /* Register writes */
+        if (DMA_REG_WR) begin
+            case (DMA_REG_WR_ADDR)
+                5'h0c: begin
+                    enable_r <= DMA_REG_WR_DAT[0];
+                    ring_log2_r <= (DMA_REG_WR_DAT[12:8] > 16) ? 5'd16 : DMA_REG_WR_DAT[12:8];
+                end
+                5'h0d:  ring_base_r <= DMA_REG_WR_DAT[31:5];
+                5'h0e:  tail_r <= DMA_REG_WR_DAT[15:0];
+                5'h0f:
+                    if (~enable_r)
+                        head_r <= DMA_REG_WR_DAT[15:0];
+                5'h1f:
+                    if (DMA_REG_WR_DAT[0])
+                        error_r <= 0;
+                default: ;
+            endcase
+        end
+
+        /* Channel handshakes */
+        if (arvalid_r && M_AXI_ARREADY)
+            arvalid_r <= 0;
+
+        if (r_beat_s) begin
+            if (M_AXI_RRESP[1])
+                desc_err_r <= 1'b1;
+
+            if (M_AXI_RLAST)
+                rd_act_r <= 0;
+        end
+
+        if (awvalid_r && M_AXI_AWREADY)
+            awvalid_r <= 0;
+
+        if (w_beat_s)
+            wr_beats_r <= wr_beats_r - 1;
+
+        if (b_beat_s) begin
+            wr_act_r <= 0;
+            if (M_AXI_BRESP[1])
+                desc_err_r <= 1'b1;
+        end
+
+        case (state_r)
+            IDLE_e:
+                /* Fetch the descriptor at the head */
+                if (enable_r && ~error_r && (head_r != tail_r)) begin
+                    araddr_r <= desc_addr_s;
+                    arlen_r <= 7;
+                    arvalid_r <= 1'b1;
+                    rd_act_r <= 1'b1;
+                    beat_r <= 0;
+                    desc_err_r <= 0;
+                    state_r <= DESC_e;
+                end
+            DESC_e:
+                if (r_beat_s) begin
+                    beat_r <= beat_r + 1;
+                    case (beat_r)
+                        3'd0:   desc_ctrl_r <= M_AXI_RDATA;
+                        3'd1:   rd_ptr_r <= M_AXI_RDATA;
+                        3'd2:   wr_ptr_r <= M_AXI_RDATA;
+                        3'd3: begin
+                            rd_rem_r <= M_AXI_RDATA;
+                            wr_rem_r <= M_AXI_RDATA;
+                        end
+                        3'd4:   sess_addr_r <= {M_AXI_RDATA[31:6], 6'b000000};
+                        default: ;
+                    endcase
+
+                    if (M_AXI_RLAST) begin
+                        if (desc_err_r || M_AXI_RRESP[1]) begin
+                            /* Skip a descriptor that could not be fetched */
+                            rd_rem_r <= 0;
+                            wr_rem_r <= 0;
+                            state_r <= DATA_e;
+                        end
+                        else
+                            state_r <= (desc_ctrl_r[1:0] == 2'b00) ? DATA_e : STOP_e;
+                    end
+                end
+            STOP_e: begin
+                /* Stop the lane and fetch the session block */
+                DMA_LANE_WR <= 1'b1;
+                DMA_LANE_WR_ADDR <= 5'h00;
+                DMA_LANE_WR_DAT <= 32'h00000002;
+                araddr_r <= sess_addr_r;
+                arlen_r <= (desc_ctrl_r[1:0] == 2'b01) ? 5 : 10;
+                arvalid_r <= 1'b1;
+                rd_act_r <= 1'b1;
+                sess_reg_r <= (desc_ctrl_r[1:0] == 2'b01) ? 5'h01 : 5'h10;
+                state_r <= SESS_e;
+            end
+            SESS_e:
+                if (r_beat_s) begin
+                    DMA_LANE_WR <= 1'b1;
+                    DMA_LANE_WR_ADDR <= sess_reg_r;
+                    DMA_LANE_WR_DAT <= M_AXI_RDATA;
+                    sess_reg_r <= sess_reg_r + 1;
+                    if (M_AXI_RLAST)
+                        state_r <= START_e;
+                end
+            START_e:
+                if (~DMA_LANE_WR) begin
+                    /* Set Init or Restore */
+                    DMA_LANE_WR <= 1'b1;
+                    DMA_LANE_WR_ADDR <= 5'h00;
+                    DMA_LANE_WR_DAT <= (desc_ctrl_r[1:0] == 2'b01) ? 32'h00000001 : 32'h00000010;
+                    state_r <= DATA_e;
+                end
+            DATA_e:
+                if (~enable_r) begin
+                    /* Disabling aborts the descriptor once the bursts in flight have completed */
+                    if (~rd_act_r && ~wr_act_r)
+                        state_r <= IDLE_e;
+                end
+                else begin
+                    if (~rd_act_r && (rd_rem_r != 0) && (in_free_s >= rd_len_s)) begin
+                        araddr_r <= rd_ptr_r;
+                        arlen_r <= rd_len_s - 1;
+                        arvalid_r <= 1'b1;
+                        rd_act_r <= 1'b1;
+                        rd_ptr_r <= rd_ptr_r + (rd_len_s << 2);
+                        rd_rem_r <= rd_rem_r - rd_len_s;
+                    end
+
+                    if (~wr_act_r && (wr_rem_r != 0) && (out_lvl_s >= wr_len_s)) begin
+                        awaddr_r <= wr_ptr_r;
+                        awlen_r <= wr_len_s - 1;
+                        awvalid_r <= 1'b1;
+                        wr_act_r <= 1'b1;
+                        wr_beats_r <= wr_len_s;
+                        wr_ptr_r <= wr_ptr_r + (wr_len_s << 2);
+                        wr_rem_r <= wr_rem_r - wr_len_s;
+                    end
+                    else if (~wr_act_r && (wr_rem_r == 0)) begin
+                        /* All data written, write back the status */
+                        awaddr_r <= desc_addr_s + 28;
+                        awlen_r <= 0;
+                        awvalid_r <= 1'b1;
+                        wr_act_r <= 1'b1;
+                        wr_beats_r <= 1;
+                        wr_stat_r <= 1'b1;
+                        state_r <= STAT_e;
+                    end
+                end
+            STAT_e:
+                if (b_beat_s) begin
+                    wr_stat_r <= 0;
+                    head_r <= (head_r + 1) & ring_mask_s;
+                    DMA_EVT <= desc_ctrl_r[31] | desc_err_r | M_AXI_BRESP[1];
+                    error_r <= error_r | desc_err_r | M_AXI_BRESP[1];
+                    state_r <= IDLE_e;
+                end
+            default:
+                state_r <= IDLE_e;
+        endcase
+    end
+end
+
+endmodule
@@ -8,36 +8,123 @@
 // Target Devices:   Spartan-6, Zynq
 // Tool versions:    ISE 14.7, Vivado v2016.2
 // Description:      The top module of the Trivium IP core. Its interface is designed
-//                   such that it can connected as an AXI4LITE slave.
-//                   The module contains several registers that may be read or written to,
+//                   such that it can connected as an AXI4LITE slave. In addition, data
+//                   may be streamed through the core via an AXI4-Stream slave (plaintext)
+//                   and an AXI4-Stream master (ciphertext), both synchronous to S_AXI_ACLK.
+//                   The core contains NUM_LANES independent cipher lanes (see axi_trivium_lane),
+//                   each with its own register bank. The bank of lane i is located at byte
+//                   offset i*128, so C_S_AXI_ADDR_WIDTH must be at least 7 + ceil(log2(NUM_LANES)).
+//                   The AXI4-Stream interfaces are attached to lane 0. The FIFO window ports
+//                   connect the data FIFOs of all lanes to the full AXI4 slave
+//                   axi_trivium_v1_0_S01_AXI, which transfers words in bursts.
+//                   The scatter-gather DMA engine axi_trivium_v1_0_M00_AXI encrypts buffers
+//                   in memory through lane 0. Its registers occupy the unused addresses of
+//                   the lane 0 register bank (see axi_trivium_v1_0_M00_AXI), writes to them
+//                   and reads from them are forwarded to the engine.
+//                   Each lane contains several registers that may be read or written to,
 //                   a full list is given below.
-//                   Register map (All values are interpreted as little-endian):
+//                   Register map of a lane (All values are interpreted as little-endian):
 //                      +0:      Control register (RW)
-//                         -0.0: UNUSED | ... | UNUSED | Process (RWS) | Stop (RWS)| Init (RWS) 
-//                         -0.1: UNUSED | ... | UNUSED | Output valid (R) | Init done (R) | Busy (R)
-//                         -0.2: UNUSED | ... | UNUSED
-//                         -0.3: UNUSED | ... | UNUSED
+//                         -0.0: UNUSED | Skip (RWS) | Hold (RW) | Restore (RWS) | Stream (RW) | Process (RWS) | Stop (RWS)| Init (RWS) 
+//                         -0.1: UNUSED | ... | UNUSED | DMA idle (R) | Skip done (R) | Init done (R) | Busy (R)
+//                         -0.2: Number of free input FIFO entries (R)
+//                         -0.3: Number of output FIFO entries (R)
 //                      +1 to 3: Key register (Least significant bytes at bottom of 1, RW)
 //                      +4 to 6: IV register (Least significant bytes at bottom of 4, RW)
 //                      +7:      Input data register (RW)
-//                      +8:      Output data register (R)
+//                      +8:      Output data register (R, reading removes the word from the output FIFO)
+//                      +9:      Info register (R)
+//                         -9.0: Number of lanes
+//                         -9.1: Number of bits processed per clock
+//                         -9.2: Log2 of the FIFO depth
+//                         -9.3: Log2 of the key stream FIFO depth
+//                      +10:     Skip count register (Number of key stream words, RW)
+//                      +11:     Data queue register (W, writing queues the word for processing)
+//                      +16 to 24: Cipher state (Bits 31:0 at bottom of 16, RW)
+//                      +25:     Key stream spare register (RW)
+//                      +26:     Key stream spare valid register (RW)
+//                         -26.0: UNUSED | ... | UNUSED | Valid (RW)
+//                      +27:     Key stream FIFO register (RW, reading removes the word, writing appends it)
+//                      +28:     Key stream status register (R)
+//                         -28.0: Number of key stream FIFO entries
+//                         -28.1: UNUSED | ... | UNUSED | Generating
+//                      +29:     Interrupt enable register (RW)
+//                         -29.0: UNUSED | ... | UNUSED | DMA event | Skip done | Output available | Init done
+//                      +30:     Interrupt status register (R, W1C)
+//                         -30.0: UNUSED | ... | UNUSED | DMA event | Skip done | Output available | Init done
 //
-//                   Notation: R(Read), W(Write), S(Self clearing, will read as zero)
+//                   Setting the Process bit queues the contents of the input data register
+//                   for processing, the request is dropped if the input FIFO is full.
+//                   Writing the data queue register loads the input data register and
+//                   queues the word in a single write. A burst of input words is thus
+//                   transferred by repeatedly writing the data queue register and the
+//                   results by repeatedly reading the output data register, a single read
+//                   of the control register telling how many words fit and are available.
+//                   While the Stream bit is set, the FIFOs are exclusively connected to the
+//                   AXI4-Stream interfaces instead of the data registers. TLAST is passed
+//                   from each input word to the corresponding output word.
+//                   Reading the cipher state registers returns the live state of the lane,
+//                   writing them stores a state that is loaded into the cipher by setting
+//                   the Restore bit while the lane is not busy. A restored lane continues
+//                   the key stream of the saved state without a warm-up phase. The key
+//                   stream spare registers hold an unused key stream half, which is only
+//                   present for BITS_PER_CYCLE = 64.
+//                   Each lane prefetches key stream words into a key stream FIFO while it
+//                   waits for data, a queued word is then processed within a single cycle.
+//                   To save the complete state of a lane, set the Hold bit, wait until the
+//                   Generating bit is cleared and read the key stream FIFO along with the
+//                   cipher state. The FIFO contents are restored by writing them to the
+//                   key stream FIFO register after restoring the cipher state, followed by
+//                   clearing the Hold bit.
+//                   Setting the Skip bit while the lane is not busy discards as many key
+//                   stream words as the skip count register holds, at the rate of the
+//                   cipher and without any data. The lane is busy until Skip done is set,
+//                   words queued in the meantime are processed afterwards.
+//                   The IRQ output is asserted while any lane has a pending interrupt that
+//                   is enabled. Init done is latched when initialization or a restore
+//                   completes, Output available is latched (again) as long as the output
+//                   FIFO holds words, so it should be masked while results are collected.
+//                   Skip done is latched when a fast-forward completes. DMA event is latched
+//                   when the DMA engine completes a descriptor that requests it or fails,
+//                   DMA idle is set while the engine has no descriptor to process. Both are
+//                   only present in lane 0.
+//
+//                   Notation: R(Read), W(Write), S(Self clearing, will read as zero),
+//                             W1C(Write one to clear)
 //
 // Dependencies:     /
 //
 // Revision: 
 // Revision 0.01 - File Created 
+// Revision 0.02 - Added BITS_PER_CYCLE parameter
+// Revision 0.03 - Replaced output valid flag by input/output FIFO levels
+// Revision 0.04 - Added AXI4-Stream data interfaces
+// Revision 0.05 - Moved register bank to axi_trivium_lane, added NUM_LANES parameter
+// Revision 0.06 - Added cipher state save/restore registers
+// Revision 0.07 - Added key stream prefetch FIFO registers
+// Revision 0.08 - Added interrupt enable/status registers and IRQ output
+// Revision 0.09 - Added key stream fast-forward
+// Revision 0.10 - Added data queue register
+// Revision 0.11 - Added FIFO window ports for the full AXI4 slave
+// Revision 0.12 - Added DMA engine ports
 //
 //////////////////////////////////////////////////////////////////////////////////
 `timescale 1 ns / 1 ps
 
 module axi_trivium_v1_0_S00_AXI #
 (
+    /* Number of bits processed per clock by the cipher (1, 8, 16, 32 or 64) */
+    parameter integer BITS_PER_CYCLE        = 1,
+    /* The input and output FIFOs hold 2^FIFO_DEPTH_LOG2 words (at most 2^7) */
+    parameter integer FIFO_DEPTH_LOG2       = 2,
+    /* The key stream prefetch FIFO holds 2^KS_FIFO_DEPTH_LOG2 words (at most 2^7) */
+    parameter integer KS_FIFO_DEPTH_LOG2    = 2,
+    /* Number of independent cipher lanes */
+    parameter integer NUM_LANES             = 1,
     /* Width of S_AXI data bus */
     parameter integer C_S_AXI_DATA_WIDTH    = 32,
     /* Width of S_AXI address bus */
-    parameter integer C_S_AXI_ADDR_WIDTH    = 6
+    parameter integer C_S_AXI_ADDR_WIDTH    = 7
 )
 (
     /* Global Clock Signal */
@@ -129,7 +216,54 @@ module axi_trivium_v1_0_S00_AXI #
      * Read ready. This signal indicates that the master can
      * accept the read data and response information.
      */
-    input wire  S_AXI_RREADY
+    input wire  S_AXI_RREADY,
+    
+    /* AXI4-Stream slave data (plaintext) */
+    input wire [31:0] S_AXIS_TDATA,
+    /* AXI4-Stream slave data valid */
+    input wire  S_AXIS_TVALID,
+    /* AXI4-Stream slave ready, asserted while the input FIFO of lane 0 has room in stream mode */
+    output wire  S_AXIS_TREADY,
+    /* AXI4-Stream slave last word of a message */
+    input wire  S_AXIS_TLAST,
+    /* AXI4-Stream master data (ciphertext) */
+    output wire [31:0] M_AXIS_TDATA,
+    /* AXI4-Stream master data valid, asserted while results are available in stream mode */
+    output wire  M_AXIS_TVALID,
+    /* AXI4-Stream master ready */
+    input wire  M_AXIS_TREADY,
+    /* AXI4-Stream master last word of a message */
+    output wire  M_AXIS_TLAST,
+
+    /* FIFO window of each lane, driven by axi_trivium_v1_0_S01_AXI */
+    input wire [NUM_LANES - 1:0] WIN_PUSH,
+    input wire [31:0] WIN_WDATA,
+    input wire [NUM_LANES - 1:0] WIN_POP,
+    output wire [(NUM_LANES*32) - 1:0] WIN_RDATA,
+
+    /* DMA engine registers, forwarded to axi_trivium_v1_0_M00_AXI */
+    output wire  DMA_REG_WR,
+    output wire [4:0] DMA_REG_WR_ADDR,
+    output wire [31:0] DMA_REG_WR_DAT,
+    output wire [4:0] DMA_REG_RD_ADDR,
+    input wire [31:0] DMA_REG_RD_DAT,
+    /* Lane 0 register writes of the DMA engine, AXI4LITE writes are held off during DMA_LANE_HOLD */
+    input wire  DMA_LANE_HOLD,
+    input wire  DMA_LANE_WR,
+    input wire [4:0] DMA_LANE_WR_ADDR,
+    input wire [31:0] DMA_LANE_WR_DAT,
+    /* Lane 0 FIFO access of the DMA engine, the FIFO window of lane 0 must not be used concurrently */
+    input wire  DMA_PUSH,
+    input wire [31:0] DMA_PUSH_DAT,
+    input wire  DMA_POP,
+    output wire [31:0] DMA_POP_DAT,
+    /* Lane 0 FIFO levels and DMA engine status */
+    output wire [15:0] DMA_LANE_LVL,
+    input wire  DMA_IDLE,
+    input wire  DMA_EVT,
+
+    /* Interrupt output, asserted while an enabled interrupt of any lane is pending */
+    output wire  IRQ
 );
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -150,31 +284,20 @@ reg                             axi_rvalid;
 // Register space related signals and parameters
 //////////////////////////////////////////////////////////////////////////////////
 localparam integer ADDR_LSB = (C_S_AXI_DATA_WIDTH/32) + 1;
-localparam integer OPT_MEM_ADDR_BITS = 3;
+localparam integer OPT_MEM_ADDR_BITS = 4;
+
+localparam integer LANE_ADDR_LSB = ADDR_LSB + OPT_MEM_ADDR_BITS + 1;
 
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_conf_r;      /* Configuration register */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_key_lo_r;    /* Key register LO */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_key_mid_r;   /* Key register MID */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_key_hi_r;    /* Key register HI */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_iv_lo_r;     /* IV register LO */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_iv_mid_r;    /* IV register MID */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_iv_hi_r;     /* IV register HI */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_idat_r;      /* Input data register */
-wire   [C_S_AXI_DATA_WIDTH - 1:0]  reg_odat_s;      /* Output data register */
-reg    [C_S_AXI_DATA_WIDTH - 1:0]  ld_dat_r;        /* Data loaded into register a or b */
-reg    [2:0]                       ld_sel_a_r;      /* Register a slice selection */
-reg    [2:0]                       ld_sel_b_r;      /* Register b slice selection */
-reg                                init_r;          /* Init cipher */
-reg                                stop_r;          /* Stop any calculations and reset the core */
-reg                                proc_r;          /* Start processing */                    
-reg                                gen_output_r;    /* Register stating whether output is being computed */    
-wire                               busy_s;          /* Flag indicating whether core is busy */
-reg                                init_active_r;   /* Flag indicating whether init process is active */
-reg                                init_done_r;     /* Flag indicating whether init process is done */  
+wire   [C_S_AXI_ADDR_WIDTH - 1:0]  wr_lane_s;       /* Lane addressed by the current write */
+wire   [C_S_AXI_ADDR_WIDTH - 1:0]  rd_lane_s;       /* Lane addressed by the current read */
+wire   [(NUM_LANES*32) - 1:0]      lane_rdat_s;     /* Read data of all lanes */
+wire   [NUM_LANES - 1:0]           lane_irq_s;      /* Interrupt requests of all lanes */
+wire                               wr_dma_s;        /* Current write addresses a DMA engine register */
+wire                               rd_dma_s;        /* Current read addresses a DMA engine register */
 wire                               slv_reg_rden_r;  /* Signal that triggers the output of data */
 wire                               slv_reg_wren_r;  /* Signal that triggers the capture of input data */
 reg    [C_S_AXI_DATA_WIDTH - 1:0]  reg_data_out;    /* Data being read from registers */
-integer                            byte_index;      /* Iteration index used for byte access of registers */                                
+genvar                             lane_index;      /* Iteration index used for lane instantiation */
 
 //////////////////////////////////////////////////////////////////////////////////
 // I/O Connection Assignments
@@ -187,34 +310,110 @@ assign S_AXI_ARREADY    = axi_arready;
 assign S_AXI_RDATA      = axi_rdata;
 assign S_AXI_RRESP      = axi_rresp;
 assign S_AXI_RVALID     = axi_rvalid;
+assign IRQ              = (lane_irq_s != 0);
     
 //////////////////////////////////////////////////////////////////////////////////
 // Module instantiations
 //////////////////////////////////////////////////////////////////////////////////
-trivium_top trivium(
-    .clk_i(S_AXI_ACLK),
-    .n_rst_i(S_AXI_ARESETN & ~stop_r),
-    .dat_i(reg_idat_r),
-    .ld_dat_i(ld_dat_r),
-    .ld_reg_a_i(ld_sel_a_r),
-    .ld_reg_b_i(ld_sel_b_r),   
-    .init_i(init_r),
-    .proc_i(proc_r),
-    .dat_o(reg_odat_s),
-    .busy_o(busy_s)
-);
+assign wr_lane_s = axi_awaddr >> LANE_ADDR_LSB;
+assign rd_lane_s = axi_araddr >> LANE_ADDR_LSB;
+
+/* The DMA engine registers are located at +12 to +15 and +31 of lane 0 */
+assign wr_dma_s = (wr_lane_s == 0) && ((axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB+2] == 3'b011) ||
+                                       (axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h1f));
+assign rd_dma_s = (rd_lane_s == 0) && ((axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB+2] == 3'b011) ||
+                                       (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h1f));
+assign DMA_REG_WR = slv_reg_wren_r && wr_dma_s;
+assign DMA_REG_WR_ADDR = axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB];
+assign DMA_REG_WR_DAT = S_AXI_WDATA;
+assign DMA_REG_RD_ADDR = axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB];
+assign DMA_POP_DAT = WIN_RDATA[31:0];
+
+generate
+    for (lane_index = 0; lane_index < NUM_LANES; lane_index = lane_index + 1) begin : lane
+        if (lane_index == 0) begin : streaming
+            axi_trivium_lane #(
+                .BITS_PER_CYCLE(BITS_PER_CYCLE),
+                .FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+                .KS_FIFO_DEPTH_LOG2(KS_FIFO_DEPTH_LOG2),
+                .NUM_LANES(NUM_LANES)
+            ) trivium_lane(
+                .clk_i(S_AXI_ACLK),
+                .n_rst_i(S_AXI_ARESETN),
+                .wr_i(DMA_LANE_WR || (slv_reg_wren_r && (wr_lane_s == lane_index) && ~wr_dma_s)),
+                .wr_addr_i(DMA_LANE_WR ? DMA_LANE_WR_ADDR : axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB]),
+                .wr_dat_i(DMA_LANE_WR ? DMA_LANE_WR_DAT : S_AXI_WDATA),
+                .wr_strb_i(DMA_LANE_WR ? 4'hf : S_AXI_WSTRB),
+                .rd_i(slv_reg_rden_r && (rd_lane_s == lane_index)),
+                .rd_addr_i(axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB]),
+                .rd_dat_o(lane_rdat_s[(lane_index*32) +: 32]),
+                .s_axis_tdata_i(S_AXIS_TDATA),
+                .s_axis_tvalid_i(S_AXIS_TVALID),
+                .s_axis_tready_o(S_AXIS_TREADY),
+                .s_axis_tlast_i(S_AXIS_TLAST),
+                .m_axis_tdata_o(M_AXIS_TDATA),
+                .m_axis_tvalid_o(M_AXIS_TVALID),
+                .m_axis_tready_i(M_AXIS_TREADY),
+                .m_axis_tlast_o(M_AXIS_TLAST),
+                .win_push_i(WIN_PUSH[lane_index] | DMA_PUSH),
+                .win_dat_i(DMA_PUSH ? DMA_PUSH_DAT : WIN_WDATA),
+                .win_pop_i(WIN_POP[lane_index] | DMA_POP),
+                .win_dat_o(WIN_RDATA[(lane_index*32) +: 32]),
+                .lvl_o(DMA_LANE_LVL),
+                .dma_idle_i(DMA_IDLE),
+                .dma_evt_i(DMA_EVT),
+                .irq_o(lane_irq_s[lane_index])
+            );
+        end
+        else begin : register_only
+            axi_trivium_lane #(
+                .BITS_PER_CYCLE(BITS_PER_CYCLE),
+                .FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+                .KS_FIFO_DEPTH_LOG2(KS_FIFO_DEPTH_LOG2),
+                .NUM_LANES(NUM_LANES)
+            ) trivium_lane(
+                .clk_i(S_AXI_ACLK),
+                .n_rst_i(S_AXI_ARESETN),
+                .wr_i(slv_reg_wren_r && (wr_lane_s == lane_index)),
+                .wr_addr_i(axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB]),
+                .wr_dat_i(S_AXI_WDATA),
+                .wr_strb_i(S_AXI_WSTRB),
+                .rd_i(slv_reg_rden_r && (rd_lane_s == lane_index)),
+                .rd_addr_i(axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB]),
+                .rd_dat_o(lane_rdat_s[(lane_index*32) +: 32]),
+                .s_axis_tdata_i(32'h00000000),
+                .s_axis_tvalid_i(1'b0),
+                .s_axis_tready_o(),
+                .s_axis_tlast_i(1'b0),
+                .m_axis_tdata_o(),
+                .m_axis_tvalid_o(),
+                .m_axis_tready_i(1'b0),
+                .m_axis_tlast_o(),
+                .win_push_i(WIN_PUSH[lane_index]),
+                .win_dat_i(WIN_WDATA),
+                .win_pop_i(WIN_POP[lane_index]),
+                .win_dat_o(WIN_RDATA[(lane_index*32) +: 32]),
+                .lvl_o(),
+                .dma_idle_i(1'b0),
+                .dma_evt_i(1'b0),
+                .irq_o(lane_irq_s[lane_index])
+            );
+        end
+    end
+endgenerate
 
 /* 
  * Implement axi_awready generation
  * axi_awready is asserted for one S_AXI_ACLK clock cycle when both
  * S_AXI_AWVALID and S_AXI_WVALID are asserted. axi_awready is
- * de-asserted when reset is low.
+ * de-asserted when reset is low. Writes are held off while the DMA engine
+ * writes the registers of lane 0, so that none of them is lost.
  */
 always @(posedge S_AXI_ACLK) begin
     if (S_AXI_ARESETN == 1'b0)
         axi_awready <= 1'b0;
     else begin    
-        if (~axi_awready && S_AXI_AWVALID && S_AXI_WVALID) begin
+        if (~axi_awready && S_AXI_AWVALID && S_AXI_WVALID && ~DMA_LANE_HOLD) begin
           /* 
            * Slave is ready to accept write address when 
            * there is a valid write address and write data
@@ -237,7 +436,7 @@ always @(posedge S_AXI_ACLK) begin
     if (S_AXI_ARESETN == 1'b0)
         axi_awaddr <= 0;
     else begin    
-        if (~axi_awready && S_AXI_AWVALID && S_AXI_WVALID) begin
+        if (~axi_awready && S_AXI_AWVALID && S_AXI_WVALID && ~DMA_LANE_HOLD) begin
             /* Write Address latching */ 
             axi_awaddr <= S_AXI_AWADDR;
         end
@@ -254,7 +453,7 @@ always @(posedge S_AXI_ACLK) begin
     if (S_AXI_ARESETN == 1'b0)
         axi_wready <= 1'b0;
     else begin    
-        if (~axi_wready && S_AXI_WVALID && S_AXI_AWVALID) begin
+        if (~axi_wready && S_AXI_WVALID && S_AXI_AWVALID && ~DMA_LANE_HOLD) begin
             /* 
              * Slave is ready to accept write data when 
              * there is a valid write address and write data
@@ -270,154 +469,13 @@ end
 
 /* 
  * Implement memory mapped register select and write logic generation
- * The write data is accepted and written to memory mapped registers when
- * axi_awready, S_AXI_WVALID, axi_wready and S_AXI_WVALID are asserted. Write strobes are used to
- * select byte enables of slave registers while writing.
- * These registers are cleared when reset (active low) is applied.
+ * The write data is accepted and forwarded to the register bank of the addressed
+ * lane when axi_awready, S_AXI_WVALID, axi_wready and S_AXI_WVALID are asserted.
+ * Write strobes are used to select byte enables of slave registers while writing.
  * Slave register write enable is asserted when valid address and data are available
  * and the slave is ready to accept the write address and write data.
  */
 assign slv_reg_wren_r = axi_wready && S_AXI_WVALID && axi_awready && S_AXI_AWVALID;
-always @(posedge S_AXI_ACLK) begin
-    if (S_AXI_ARESETN == 1'b0) begin
-        /* Reset addressable registers driven here */
-        reg_conf_r <= 0;
-        reg_key_lo_r <= 0;
-        reg_key_mid_r <= 0;
-        reg_key_hi_r <= 0;
-        reg_iv_lo_r <= 0;
-        reg_iv_mid_r <= 0;
-        reg_iv_hi_r <= 0;
-        reg_idat_r <= 0;
-        
-        /* Reset any other registers driven here */
-        init_r <= 0;
-        stop_r <= 0;
-        proc_r <= 0;
-        gen_output_r <= 0;
-        ld_dat_r <= 0;
-        ld_sel_a_r <= 0;
-        ld_sel_b_r <= 0;
-    end 
-    else begin
-        if (slv_reg_wren_r) begin
-            case (axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB])
-                4'h0:       /* Configuration register */
-                    /* Currently only byte 0 of configuration register is writable */
-                    if (S_AXI_WSTRB[0] == 1'b1) begin
-                        if (S_AXI_WDATA[1] == 1'b1) begin                   /* Bit 1 resets core in any case */
-                            stop_r <= 1'b1;
-                            gen_output_r <= 0;
-                        end
-                        else if (S_AXI_WDATA[0] == 1'b1 & !busy_s) begin    /* Bit 0 triggers init if core is not busy */
-                            init_r <= 1'b1;
-                            gen_output_r <= 0;
-                        end
-                        else if (S_AXI_WDATA[2] == 1'b1 & !busy_s) begin    /* Bit 2 triggers processing if core is not busy */
-                            proc_r <= 1'b1;
-                            gen_output_r <= 1'b1;
-                        end
-                    end
-                4'h1: begin /* LO key register */
-                    /* Reconstruct key LO value written so far */
-                    ld_dat_r <= reg_key_lo_r;
-                    ld_sel_a_r[0] <= 1'b1;
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1) begin
-                        /* Incorporate the rest that is currently being written */
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            ld_dat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                            reg_key_lo_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end 
-                    end 
-                end
-                4'h2: begin /* MID key register */
-                    /* Reconstruct key MID value written so far */
-                    ld_dat_r <= reg_key_mid_r;
-                    ld_sel_a_r[1] <= 1'b1;
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1) begin
-                        /* Incorporate the rest that is currently being written */
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            ld_dat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                            reg_key_mid_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end 
-                    end 
-                end  
-                4'h3: begin /* HI key register */
-                    /* Reconstruct key HI value written so far */
-                    ld_dat_r <= reg_key_hi_r;
-                    ld_sel_a_r[2] <= 1'b1;
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1) begin
-                        /* Incorporate the rest that is currently being written */
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            ld_dat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                            reg_key_hi_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end 
-                    end 
-                end  
-                4'h4: begin /* LO IV register */
-                    /* Reconstruct IV LO value written so far */
-                    ld_dat_r <= reg_iv_lo_r;
-                    ld_sel_b_r[0] <= 1'b1;
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1) begin
-                        /* Incorporate the rest that is currently being written */
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            ld_dat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                            reg_iv_lo_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end 
-                    end 
-                end  
-                4'h5:begin /* MID IV register */
-                    /* Reconstruct IV MID value written so far */
-                    ld_dat_r <= reg_iv_mid_r;
-                    ld_sel_b_r[1] <= 1'b1;
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1) begin
-                        /* Incorporate the rest that is currently being written */
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            ld_dat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                            reg_iv_mid_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end 
-                    end 
-                end  
-                4'h6:begin /* LO IV register */
-                    /* Reconstruct IV HI value written so far */
-                    ld_dat_r <= reg_iv_hi_r;
-                    ld_sel_b_r[2] <= 1'b1;
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1) begin
-                        /* Incorporate the rest that is currently being written */
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            ld_dat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                            reg_iv_hi_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end 
-                    end 
-                end
-                4'h7:   /* Input data register */
-                    /* Respective byte enables are asserted as per write strobes */
-                    for (byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1)
-                        if (S_AXI_WSTRB[byte_index] == 1) begin
-                            reg_idat_r[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
-                        end  
-                default: begin
-                    reg_conf_r <= reg_conf_r;
-                    reg_key_lo_r <= reg_key_lo_r;
-                    reg_key_mid_r <= reg_key_mid_r;
-                    reg_key_hi_r <= reg_key_hi_r;
-                    reg_iv_lo_r <= reg_iv_lo_r;
-                    reg_iv_mid_r <= reg_iv_mid_r;
-                    reg_iv_hi_r <= reg_iv_hi_r;
-                    reg_idat_r <= reg_idat_r;
-                end
-            endcase
-        end
-        else begin
-            /* Reset all strobes/pulses that resulted from a register write */
-            init_r <= 0;
-            stop_r <= 0;
-            proc_r <= 0;
-            ld_sel_a_r <= 0;
-            ld_sel_b_r <= 0;
-        end
-    end
-end    
 
 /* 
  * Implement write response logic generation
@@ -507,19 +565,13 @@ end
 */
 assign slv_reg_rden_r = axi_arready & S_AXI_ARVALID & ~axi_rvalid;
 always @(*) begin
-    /* Address decoding for reading registers */
-    case (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB])
-        4'h0:       reg_data_out <= {16'h0000, 5'b00000, gen_output_r & ~busy_s, init_done_r, busy_s, 8'h00};
-        4'h1:       reg_data_out <= reg_key_lo_r;
-        4'h2:       reg_data_out <= reg_key_mid_r;
-        4'h3:       reg_data_out <= reg_key_hi_r;
-        4'h4:       reg_data_out <= reg_iv_lo_r;
-        4'h5:       reg_data_out <= reg_iv_mid_r;
-        4'h6:       reg_data_out <= reg_iv_hi_r;
-        4'h7:       reg_data_out <= reg_idat_r;
-        4'h8:       reg_data_out <= reg_odat_s;
-        default:    reg_data_out <= 0;
-    endcase
+    /* Select the read data of the DMA engine or the addressed lane */
+    if (rd_dma_s)
+        reg_data_out <= DMA_REG_RD_DAT;
+    else if (rd_lane_s < NUM_LANES)
+        reg_data_out <= lane_rdat_s[(rd_lane_s*32) +: 32];
+    else
+        reg_data_out <= 0;
 end
 
 /* Output register or memory read data */
@@ -537,22 +589,5 @@ always @(posedge S_AXI_ACLK) begin
     end
 end    
 
-/* 
- * This process monitors the initialization process of
- * the core. 
- */
-always @(posedge S_AXI_ACLK) begin
-    if (S_AXI_ARESETN == 1'b0 || stop_r == 1'b1) begin
-        init_active_r <= 0;
-        init_done_r <= 0; 
-    end
-    else begin
-        if (init_r == 1'b1 && init_done_r == 1'b0 && busy_s == 1'b0)
-            init_active_r <= 1'b1;
-        else if (init_active_r == 1'b1 && busy_s == 1'b0)
-            init_done_r <= 1'b1;
-    end
-end
-
 endmodule
 
@@ -0,0 +1,281 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Design Name:      /
+// Module Name:      axi_trivium_v1_0_S01_AXI
+// Project Name:     Trivium
+// Target Devices:   Zynq
+// Tool versions:    Vivado v2016.2
+// Description:      Full AXI4 slave exposing the data FIFOs of the lanes as a memory
+//                   window, such that words are moved in bursts rather than in single
+//                   AXI4LITE transactions. The address space is split in two halves:
+//                      Lower half: Push windows, a write beat queues the word in the
+//                                  input FIFO of the lane (reads return zero)
+//                      Upper half: Pop windows, a read beat removes the head of the
+//                                  output FIFO of the lane (writes are ignored)
+//                   Within each half, the window of lane i is located at byte offset
+//                   i*4096, so C_S_AXI_ADDR_WIDTH must be at least
+//                   13 + ceil(log2(NUM_LANES)).
+//                   Every beat of a burst transfers one word regardless of its address,
+//                   i.e. INCR, FIXED and WRAP bursts of up to 256 beats behave the same.
+//                   Like the data queue and output data registers, a push to a full input
+//                   FIFO is dropped and a pop of an empty output FIFO returns the current
+//                   head without removing it, so a burst should not exceed the levels read
+//                   from the control register. Only complete words are transferred, the
+//                   write strobes are ignored. Since every write beat is pushed in the order
+//                   it arrives, a CPU must access the windows as device memory: flushes of
+//                   a write-combining mapping may arrive out of order or contain beats with
+//                   null strobes, which would queue words in the wrong order or junk words.
+//                   While the Stream bit of a lane is set, its window has no effect.
+//                   One write and one read burst are processed at a time, at one beat per
+//                   clock. The slave is synchronous to the clock of the AXI4LITE slave.
+//
+// Dependencies:     /
+//
+//////////////////////////////////////////////////////////////////////////////////
+`timescale 1 ns / 1 ps
+
+module axi_trivium_v1_0_S01_AXI #
+(
+    /* Number of independent cipher lanes */
+    parameter integer NUM_LANES             = 1,
+    /* Width of ID for write address, write data, read address and read data */
+    parameter integer C_S_AXI_ID_WIDTH      = 1,
+    /* Width of S_AXI data bus */
+    parameter integer C_S_AXI_DATA_WIDTH    = 32,
+    /* Width of S_AXI address bus */
+    parameter integer C_S_AXI_ADDR_WIDTH    = 13
+)
+(
+    /* Global Clock Signal */
+    input wire  S_AXI_ACLK,
+    /* Global Reset Signal. This Signal is Active LOW */
+    input wire  S_AXI_ARESETN,
+    /* Write Address ID */
+    input wire [C_S_AXI_ID_WIDTH - 1:0] S_AXI_AWID,
+    /* Write address */
+    input wire [C_S_AXI_ADDR_WIDTH - 1:0] S_AXI_AWADDR,
+    /* Burst length. The burst length gives the exact number of transfers in a burst */
+    input wire [7:0] S_AXI_AWLEN,
+    /* Burst size. This signal indicates the size of each transfer in the burst */
+    input wire [2:0] S_AXI_AWSIZE,
+    /* Burst type. The burst type and the size information determine how the address is calculated */
+    input wire [1:0] S_AXI_AWBURST,
+    /* Lock type. Provides additional information about the atomic characteristics of the transfer */
+    input wire  S_AXI_AWLOCK,
+    /* Memory type. This signal indicates how transactions are required to progress through a system */
+    input wire [3:0] S_AXI_AWCACHE,
+    /* Protection type. This signal indicates the privilege and security level of the transaction */
+    input wire [2:0] S_AXI_AWPROT,
+    /* Quality of Service, QoS identifier sent for each write transaction */
+    input wire [3:0] S_AXI_AWQOS,
+    /* Region identifier. Permits a single physical interface on a slave to be used for multiple logical interfaces */
+    input wire [3:0] S_AXI_AWREGION,
+    /* Write address valid. This signal indicates that the channel is signaling valid write address */
+    input wire  S_AXI_AWVALID,
+    /* Write address ready. This signal indicates that the slave is ready to accept an address */
+    output wire  S_AXI_AWREADY,
+    /* Write Data */
+    input wire [C_S_AXI_DATA_WIDTH - 1:0] S_AXI_WDATA,
+    /* Write strobes. This signal indicates which byte lanes hold valid data */
+    input wire [(C_S_AXI_DATA_WIDTH/8) - 1:0] S_AXI_WSTRB,
+    /* Write last. This signal indicates the last transfer in a write burst */
+    input wire  S_AXI_WLAST,
+    /* Write valid. This signal indicates that valid write data and strobes are available */
+    input wire  S_AXI_WVALID,
+    /* Write ready. This signal indicates that the slave can accept the write data */
+    output wire  S_AXI_WREADY,
+    /* Response ID tag. This signal is the ID tag of the write response */
+    output wire [C_S_AXI_ID_WIDTH - 1:0] S_AXI_BID,
+    /* Write response. This signal indicates the status of the write transaction */
+    output wire [1:0] S_AXI_BRESP,
+    /* Write response valid. This signal indicates that the channel is signaling a valid write response */
+    output wire  S_AXI_BVALID,
+    /* Response ready. This signal indicates that the master can accept a write response */
+    input wire  S_AXI_BREADY,
+    /* Read address ID */
+    input wire [C_S_AXI_ID_WIDTH - 1:0] S_AXI_ARID,
+    /* Read address */
+    input wire [C_S_AXI_ADDR_WIDTH - 1:0] S_AXI_ARADDR,
+    /* Burst length. The burst length gives the exact number of transfers in a burst */
+    input wire [7:0] S_AXI_ARLEN,
+    /* Burst size. This signal indicates the size of each transfer in the burst */
+    input wire [2:0] S_AXI_ARSIZE,
+    /* Burst type. The burst type and the size information determine how the address is calculated */
+    input wire [1:0] S_AXI_ARBURST,
+    /* Lock type. Provides additional information about the atomic characteristics of the transfer */
+    input wire  S_AXI_ARLOCK,
+    /* Memory type. This signal indicates how transactions are required to progress through a system */
+    input wire [3:0] S_AXI_ARCACHE,
+    /* Protection type. This signal indicates the privilege and security level of the transaction */
+    input wire [2:0] S_AXI_ARPROT,
+    /* Quality of Service, QoS identifier sent for each read transaction */
+    input wire [3:0] S_AXI_ARQOS,
+    /* Region identifier. Permits a single physical interface on a slave to be used for multiple logical interfaces */
+    input wire [3:0] S_AXI_ARREGION,
+    /* Read address valid. This signal indicates that the channel is signaling valid read address */
+    input wire  S_AXI_ARVALID,
+    /* Read address ready. This signal indicates that the slave is ready to accept an address */
+    output wire  S_AXI_ARREADY,
+    /* Read ID tag. This signal is the identification tag for the read data group of signals */
+    output wire [C_S_AXI_ID_WIDTH - 1:0] S_AXI_RID,
+    /* Read Data */
+    output wire [C_S_AXI_DATA_WIDTH - 1:0] S_AXI_RDATA,
+    /* Read response. This signal indicates the status of the read transfer */
+    output wire [1:0] S_AXI_RRESP,
+    /* Read last. This signal indicates the last transfer in a read burst */
+    output wire  S_AXI_RLAST,
+    /* Read valid. This signal indicates that the channel is signaling the required read data */
+    output wire  S_AXI_RVALID,
+    /* Read ready. This signal indicates that the master can accept the read data and response information */
+    input wire  S_AXI_RREADY,
+
+    /* Lane FIFO interface */
+    output wire [NUM_LANES - 1:0]       WIN_PUSH,   /* Queue WIN_WDATA in the input FIFO of the lane */
+    output wire [31:0]                  WIN_WDATA,  /* Word to queue */
+    output wire [NUM_LANES - 1:0]       WIN_POP,    /* Remove the head of the output FIFO of the lane */
+    input wire  [(NUM_LANES*32) - 1:0]  WIN_RDATA   /* Heads of the output FIFOs of all lanes */
+);
+
+//////////////////////////////////////////////////////////////////////////////////
+// AXI4FULL signals
+//////////////////////////////////////////////////////////////////////////////////
+reg                             axi_awactive;   /* Write burst accepted, data beats pending */
+reg [C_S_AXI_ID_WIDTH - 1:0]    axi_bid;
+reg                             axi_bvalid;
+reg                             axi_aractive;   /* Read burst accepted, data beats pending */
+reg [7:0]                       axi_arcnt;      /* Read beats pending after the next one */
+reg [C_S_AXI_ID_WIDTH - 1:0]    axi_arid;
+reg [C_S_AXI_ID_WIDTH - 1:0]    axi_rid;
+reg [C_S_AXI_DATA_WIDTH - 1:0]  axi_rdata;
+reg                             axi_rlast;
+reg                             axi_rvalid;
+
+//////////////////////////////////////////////////////////////////////////////////
+// Window related signals and parameters
+//////////////////////////////////////////////////////////////////////////////////
+localparam integer WIN_ADDR_LSB = 12;
+
+reg    [C_S_AXI_ADDR_WIDTH - 1:0]  wr_lane_r;       /* Lane addressed by the current write burst */
+reg                                wr_push_r;       /* Current write burst addresses a push window */
+reg    [C_S_AXI_ADDR_WIDTH - 1:0]  rd_lane_r;       /* Lane addressed by the current read burst */
+reg                                rd_pop_r;        /* Current read burst addresses a pop window */
+wire                               wr_beat_s;       /* Write data beat accepted */
+wire                               rd_beat_s;       /* Next read data beat loaded into the output registers */
+reg    [31:0]                      rd_dat_s;        /* Head of the output FIFO of the addressed lane */
+genvar                             lane_index;      /* Iteration index used for lane signals */
+
+//////////////////////////////////////////////////////////////////////////////////
+// I/O Connection Assignments
+//////////////////////////////////////////////////////////////////////////////////
+assign S_AXI_AWREADY    = ~axi_awactive && ~axi_bvalid;
+assign S_AXI_WREADY     = axi_awactive;
+assign S_AXI_BID        = axi_bid;
+assign S_AXI_BRESP      = 2'b00;    /* 'OKAY' response */
+assign S_AXI_BVALID     = axi_bvalid;
+assign S_AXI_ARREADY    = ~axi_aractive;
+assign S_AXI_RID        = axi_rid;
+assign S_AXI_RDATA      = axi_rdata;
+assign S_AXI_RRESP      = 2'b00;    /* 'OKAY' response */
+assign S_AXI_RLAST      = axi_rlast;
+assign S_AXI_RVALID     = axi_rvalid;
+
+//////////////////////////////////////////////////////////////////////////////////
+// Lane FIFO accesses
+//////////////////////////////////////////////////////////////////////////////////
+assign wr_beat_s = axi_awactive && S_AXI_WVALID;
+assign rd_beat_s = axi_aractive && (~axi_rvalid || S_AXI_RREADY);
+assign WIN_WDATA = S_AXI_WDATA;
+
+generate
+    for (lane_index = 0; lane_index < NUM_LANES; lane_index = lane_index + 1) begin : lane
+        assign WIN_PUSH[lane_index] = wr_beat_s && wr_push_r && (wr_lane_r == lane_index);
+        assign WIN_POP[lane_index] = rd_beat_s && rd_pop_r && (rd_lane_r == lane_index);
+    end
+endgenerate
+
+always @(*) begin
+    /* Select the output FIFO head of the addressed lane */
+    if (rd_pop_r && rd_lane_r < NUM_LANES)
+        rd_dat_s <= WIN_RDATA[(rd_lane_r*32) +: 32];
+    else
+        rd_dat_s <= 0;
+end
+
+/*
+ * Implement write burst handling
+ * A write address is accepted while no burst is in progress and its response
+ * has been delivered. The data beats are then accepted one per clock until
+ * S_AXI_WLAST, each of them pushing a word, followed by the write response.
+ */
+always @(posedge S_AXI_ACLK) begin
+    if (S_AXI_ARESETN == 1'b0) begin
+        axi_awactive <= 1'b0;
+        axi_bid <= 0;
+        axi_bvalid <= 1'b0;
+        wr_lane_r <= 0;
+        wr_push_r <= 1'b0;
+    end
+    else begin
+        if (S_AXI_AWVALID && S_AXI_AWREADY) begin
+            axi_awactive <= 1'b1;
+            axi_bid <= S_AXI_AWID;
+            wr_push_r <= ~S_AXI_AWADDR[C_S_AXI_ADDR_WIDTH - 1];
+            wr_lane_r <= {1'b0, S_AXI_AWADDR[C_S_AXI_ADDR_WIDTH - 2:0]} >> WIN_ADDR_LSB;
+        end
+        else if (wr_beat_s && S_AXI_WLAST) begin
+            axi_awactive <= 1'b0;
+            axi_bvalid <= 1'b1;
+        end
+        else if (axi_bvalid && S_AXI_BREADY)
+            axi_bvalid <= 1'b0;
+    end
+end
+
+/*
+ * Implement read burst handling
+ * A read address is accepted while no burst is in progress. The data beats
+ * are loaded into the output registers one per clock as long as the master
+ * accepts them, each of them popping the head of the output FIFO, which
+ * is updated in time for the next beat. The ID is passed along with the
+ * beats, so the next address may be accepted while the last beat is pending.
+ */
+always @(posedge S_AXI_ACLK) begin
+    if (S_AXI_ARESETN == 1'b0) begin
+        axi_aractive <= 1'b0;
+        axi_arcnt <= 0;
+        axi_arid <= 0;
+        axi_rid <= 0;
+        axi_rdata <= 0;
+        axi_rlast <= 1'b0;
+        axi_rvalid <= 1'b0;
+        rd_lane_r <= 0;
+        rd_pop_r <= 1'b0;
+    end
+    else begin
+        if (S_AXI_ARVALID && S_AXI_ARREADY) begin
+            axi_aractive <= 1'b1;
+            axi_arcnt <= S_AXI_ARLEN;
+            axi_arid <= S_AXI_ARID;
+            rd_pop_r <= S_AXI_ARADDR[C_S_AXI_ADDR_WIDTH - 1];
+            rd_lane_r <= {1'b0, S_AXI_ARADDR[C_S_AXI_ADDR_WIDTH - 2:0]} >> WIN_ADDR_LSB;
+        end
+        else if (rd_beat_s) begin
+            axi_arcnt <= axi_arcnt - 1;
+            if (axi_arcnt == 0)
+                axi_aractive <= 1'b0;
+        end
+
+        if (rd_beat_s) begin
+            /* Valid read data is available at the read data bus */
+            axi_rvalid <= 1'b1;
+            axi_rid <= axi_arid;
+            axi_rdata <= rd_dat_s;
+            axi_rlast <= (axi_arcnt == 0);
+        end
+        else if (axi_rvalid && S_AXI_RREADY) begin
+            /* Read data is accepted by the master */
+            axi_rvalid <= 1'b0;
+        end
+    end
+end
+
+endmodule
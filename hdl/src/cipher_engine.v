@@ -12,18 +12,27 @@
 //                   are combined to form the key stream generation logic.
 //                   This module can be interfaced to preload keys, IVs and input
 //                   plaintext bits to obtain the corresponding ciphertext bits.
+//                   BITS_PER_CYCLE input bits are processed per clock, bit 0
+//                   being the first one in key stream order.
+//                   The 288-bit state is available as {reg_c, reg_b, reg_a} and may be
+//                   restored in the same format.
 //
 // Dependencies:     /
 //
 // Revision: 
 // Revision 0.01 - File Created
 // Revision 0.02 - Minor modification to initialize register C 
+// Revision 0.03 - Added BITS_PER_CYCLE parameter
+// Revision 0.04 - Added state save/restore ports
 //
 //////////////////////////////////////////////////////////////////////////////////
 `timescale 1ns / 1ps
 `default_nettype none
 
-module cipher_engine(
+module cipher_engine #(
+    parameter BITS_PER_CYCLE = 1    /* Number of bits processed per clock (1, 8, 16, 32 or 64) */
+)
+(
     /* Standard control signals */
     input   wire            clk_i,      /* System clock */
     input   wire            n_rst_i,    /* Asynchronous active low reset */
@@ -33,20 +42,23 @@ module cipher_engine(
     input   wire    [31:0]  ld_dat_i,   /* External data */
     input   wire    [2:0]   ld_reg_a_i, /* Load external value into A */
     input   wire    [2:0]   ld_reg_b_i, /* Load external value into B */
-    input   wire            dat_i,      /* Input bit */
-    output  wire            dat_o       /* Output bit */
+    input   wire            st_ld_i,    /* Restore the complete cipher state */
+    input   wire    [287:0] st_dat_i,   /* Cipher state to restore */
+    output  wire    [287:0] st_o,       /* Current cipher state */
+    input   wire    [(BITS_PER_CYCLE - 1):0]    dat_i,  /* Input bits */
+    output  wire    [(BITS_PER_CYCLE - 1):0]    dat_o   /* Output bits */
 );
 
 //////////////////////////////////////////////////////////////////////////////////
 // Signal definitions
 //////////////////////////////////////////////////////////////////////////////////
-wire    reg_a_out_s;    /* reg_a output */
-wire    reg_b_out_s;    /* reg_b output */
-wire    reg_c_out_s;    /* reg_c output */
-wire    z_a_s;          /* Partial key stream output from reg_a */
-wire    z_b_s;          /* Partial key stream output from reg_b */
-wire    z_c_s;          /* Partial key stream output from reg_c */
-wire    key_stream_s;   /* Key stream bit */
+wire    [(BITS_PER_CYCLE - 1):0]    reg_a_out_s;    /* reg_a output */
+wire    [(BITS_PER_CYCLE - 1):0]    reg_b_out_s;    /* reg_b output */
+wire    [(BITS_PER_CYCLE - 1):0]    reg_c_out_s;    /* reg_c output */
+wire    [(BITS_PER_CYCLE - 1):0]    z_a_s;          /* Partial key stream output from reg_a */
+wire    [(BITS_PER_CYCLE - 1):0]    z_b_s;          /* Partial key stream output from reg_b */
+wire    [(BITS_PER_CYCLE - 1):0]    z_c_s;          /* Partial key stream output from reg_c */
+wire    [(BITS_PER_CYCLE - 1):0]    key_stream_s;   /* Key stream bits */
 
 //////////////////////////////////////////////////////////////////////////////////
 // Module instantiations
@@ -54,7 +66,8 @@ wire    key_stream_s;   /* Key stream bit */
 shift_reg #(
         .REG_SZ(93),
         .FEED_FWD_IDX(65),
-        .FEED_BKWD_IDX(68)
+        .FEED_BKWD_IDX(68),
+        .BITS_PER_CYCLE(BITS_PER_CYCLE)
     ) 
     reg_a(
         .clk_i(clk_i),
@@ -62,6 +75,9 @@ shift_reg #(
         .ce_i(ce_i),
         .ld_i(ld_reg_a_i),
         .ld_dat_i(ld_dat_i),
+        .st_ld_i(st_ld_i),
+        .st_dat_i(st_dat_i[92:0]),
+        .st_o(st_o[92:0]),
         .dat_i(reg_c_out_s),
         .dat_o(reg_a_out_s),
         .z_o(z_a_s)
@@ -70,7 +86,8 @@ shift_reg #(
 shift_reg #(
         .REG_SZ(84),
         .FEED_FWD_IDX(68),
-        .FEED_BKWD_IDX(77)
+        .FEED_BKWD_IDX(77),
+        .BITS_PER_CYCLE(BITS_PER_CYCLE)
     ) 
     reg_b(
         .clk_i(clk_i),
@@ -78,6 +95,9 @@ shift_reg #(
         .ce_i(ce_i),
         .ld_i(ld_reg_b_i),
         .ld_dat_i(ld_dat_i),
+        .st_ld_i(st_ld_i),
+        .st_dat_i(st_dat_i[176:93]),
+        .st_o(st_o[176:93]),
         .dat_i(reg_a_out_s),
         .dat_o(reg_b_out_s),
         .z_o(z_b_s)
@@ -86,7 +106,8 @@ shift_reg #(
 shift_reg #(
         .REG_SZ(111),
         .FEED_FWD_IDX(65),
-        .FEED_BKWD_IDX(86)
+        .FEED_BKWD_IDX(86),
+        .BITS_PER_CYCLE(BITS_PER_CYCLE)
     ) 
     reg_c(
         .clk_i(clk_i),
@@ -94,6 +115,9 @@ shift_reg #(
         .ce_i(ce_i),
         .ld_i(ld_reg_b_i),    /* This is only necessary s.t. the reg will contain 1110000...00 */
         .ld_dat_i(0),
+        .st_ld_i(st_ld_i),
+        .st_dat_i(st_dat_i[287:177]),
+        .st_o(st_o[287:177]),
         .dat_i(reg_b_out_s),
         .dat_o(reg_c_out_s),
         .z_o(z_c_s)
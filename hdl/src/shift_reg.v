@@ -12,12 +12,21 @@
 //                   This component is designed in such a way that the logic required for
 //                   Trivium can be obtained by combining three such register, each with
 //                   a specific set of parameters.
+//                   The register may be advanced by BITS_PER_CYCLE positions per clock,
+//                   bit k of dat_i/dat_o/z_o belonging to the k-th of these steps. Since
+//                   the innermost tap of every Trivium register lies at least 65 positions
+//                   away from the input, all outputs of a step can be derived from the
+//                   current register contents for up to 64 bits per clock.
+//                   The complete register contents may be read and restored, such that
+//                   a cipher instance can be saved and resumed later on.
 //
 // Dependencies:     /
 //
 // Revision: 
 // Revision 0.01 - File Created
 // Revision 0.02 - Fixed the mandatory reset issue 
+// Revision 0.03 - Added BITS_PER_CYCLE parameter to unroll the register
+// Revision 0.04 - Added state save/restore ports
 //
 //////////////////////////////////////////////////////////////////////////////////
 `timescale 1ns / 1ps
@@ -26,7 +35,8 @@
 module shift_reg #(
     parameter REG_SZ = 93,
     parameter FEED_FWD_IDX = 65,
-    parameter FEED_BKWD_IDX = 68
+    parameter FEED_BKWD_IDX = 68,
+    parameter BITS_PER_CYCLE = 1    /* Number of shifts per clock (1, 8, 16, 32 or 64) */
 ) 
 (
     /* Standard control signals */
@@ -37,21 +47,35 @@ module shift_reg #(
    /* Input and output data related signals */
     input   wire    [2:0]   ld_i,       /* Load external value */
     input   wire    [31:0]  ld_dat_i,   /* External input data */
-    input   wire            dat_i,      /* Input bit from other register */
-    output  wire            dat_o,      /* Output bit  to other register */
-    output  wire            z_o         /* Output for the key stream */
+    input   wire            st_ld_i,    /* Restore the complete register contents */
+    input   wire    [(REG_SZ - 1):0]            st_dat_i,   /* Register contents to restore */
+    output  wire    [(REG_SZ - 1):0]            st_o,       /* Current register contents */
+    input   wire    [(BITS_PER_CYCLE - 1):0]    dat_i,  /* Input bits from other register */
+    output  wire    [(BITS_PER_CYCLE - 1):0]    dat_o,  /* Output bits to other register */
+    output  wire    [(BITS_PER_CYCLE - 1):0]    z_o     /* Output for the key stream */
 );
 
 //////////////////////////////////////////////////////////////////////////////////
 // Signal definitions
 //////////////////////////////////////////////////////////////////////////////////
-reg     [(REG_SZ - 1):0]    dat_r;      /* Shift register contents */
-wire                        reg_in_s;   /* Shift register input (feedback value) */
+reg     [(REG_SZ - 1):0]            dat_r;      /* Shift register contents */
+wire    [(BITS_PER_CYCLE - 1):0]    reg_in_s;   /* Shift register inputs (feedback values) */
+genvar k;
+integer i;
 
 //////////////////////////////////////////////////////////////////////////////////
-// Feedback calculation
+// Feedback and output calculations
 //////////////////////////////////////////////////////////////////////////////////
-assign reg_in_s = dat_i ^ dat_r[FEED_BKWD_IDX];
+generate
+    for (k = 0; k < BITS_PER_CYCLE; k = k + 1) begin : step
+        /* The k-th step sees every tap moved k positions towards the input */
+        assign reg_in_s[k] = dat_i[k] ^ dat_r[FEED_BKWD_IDX - k];
+        assign z_o[k] = (dat_r[REG_SZ - 1 - k] ^ dat_r[FEED_FWD_IDX - k]);
+        assign dat_o[k] = z_o[k] ^ (dat_r[REG_SZ - 2 - k] & dat_r[REG_SZ - 3 - k]);
+    end
+endgenerate
+
+assign st_o = dat_r;
 
 //////////////////////////////////////////////////////////////////////////////////
 // Shift register process
@@ -61,9 +85,13 @@ always @(posedge clk_i or negedge n_rst_i) begin
         dat_r <= 0;
     else begin
         if (ce_i) begin
-            /* Shift contents of register */
-            dat_r <= {dat_r[(REG_SZ - 2):0], reg_in_s};
+            /* Shift contents of register, the first step's input is shifted furthest */
+            dat_r[(REG_SZ - 1):BITS_PER_CYCLE] <= dat_r[(REG_SZ - BITS_PER_CYCLE - 1):0];
+            for (i = 0; i < BITS_PER_CYCLE; i = i + 1)
+                dat_r[BITS_PER_CYCLE - 1 - i] <= reg_in_s[i];
         end
+        else if (st_ld_i) /* Restore previously saved register contents */
+            dat_r <= st_dat_i;
         else if (ld_i != 3'b000) begin /* Load external values into register */
             if (ld_i[0])
                 dat_r[31:0] <= ld_dat_i;
@@ -80,10 +108,4 @@ always @(posedge clk_i or negedge n_rst_i) begin
     end
 end
 
-//////////////////////////////////////////////////////////////////////////////////
-// Output calculations
-//////////////////////////////////////////////////////////////////////////////////
-assign z_o = (dat_r[REG_SZ - 1] ^ dat_r[FEED_FWD_IDX]);
-assign dat_o = z_o ^ (dat_r[REG_SZ - 2] & dat_r[REG_SZ - 3]); 
-
 endmodule
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Design Name:      /
+// Module Name:      sync_fifo
+// Project Name:     Trivium
+// Target Devices:   Spartan-6, Zynq
+// Tool versions:    ISE 14.7, Vivado v2016.2
+// Description:      A small synchronous first-word-fall-through FIFO. The word at
+//                   the head of the FIFO is always present at dat_o, asserting
+//                   pop_i removes it. Pushing into a full FIFO and popping from
+//                   an empty FIFO are ignored. Asserting clr_i discards all
+//                   entries, any push or pop in the same cycle is ignored.
+//
+// Dependencies:     /
+//
+//////////////////////////////////////////////////////////////////////////////////
+`timescale 1ns / 1ps
+`default_nettype none
+
+module sync_fifo #(
+    parameter WIDTH = 32,           /* Width of a FIFO entry */
+    parameter DEPTH_LOG2 = 2        /* The FIFO holds 2^DEPTH_LOG2 entries */
+)
+(
+    /* Standard control signals */
+    input   wire                        clk_i,      /* System clock */
+    input   wire                        n_rst_i,    /* Asynchronous active low reset */
+
+    /* Data related signals */
+    input   wire                        clr_i,      /* Discard all entries */
+    input   wire                        push_i,     /* Append dat_i to the FIFO */
+    input   wire    [(WIDTH - 1):0]     dat_i,      /* Data to append */
+    input   wire                        pop_i,      /* Remove the head of the FIFO */
+    output  wire    [(WIDTH - 1):0]     dat_o,      /* Head of the FIFO */
+
+    /* Status signals */
+    output  wire                        full_o,     /* FIFO is full */
+    output  wire                        empty_o,    /* FIFO is empty */
+    output  reg     [DEPTH_LOG2:0]      lvl_o       /* Number of entries in the FIFO */
+);
+
+//////////////////////////////////////////////////////////////////////////////////
+// Signal definitions
+//////////////////////////////////////////////////////////////////////////////////
+reg     [(WIDTH - 1):0]         mem_r[0:((1 << DEPTH_LOG2) - 1)];   /* FIFO storage */
+reg     [(DEPTH_LOG2 - 1):0]    wr_ptr_r;   /* Write pointer */
+reg     [(DEPTH_LOG2 - 1):0]    rd_ptr_r;   /* Read pointer */
+wire                            push_s;     /* Accepted push */
+wire                            pop_s;      /* Accepted pop */
+
+//////////////////////////////////////////////////////////////////////////////////
+// Status and output calculations
+//////////////////////////////////////////////////////////////////////////////////
+assign full_o = (lvl_o == (1 << DEPTH_LOG2));
+assign empty_o = (lvl_o == 0);
+assign push_s = push_i & ~full_o;
+assign pop_s = pop_i & ~empty_o;
+assign dat_o = mem_r[rd_ptr_r];
+
+//////////////////////////////////////////////////////////////////////////////////
+// FIFO process
+//////////////////////////////////////////////////////////////////////////////////
+always @(posedge clk_i or negedge n_rst_i) begin
+    if (!n_rst_i) begin
+        wr_ptr_r <= 0;
+        rd_ptr_r <= 0;
+        lvl_o <= 0;
+    end
+    else if (clr_i) begin
+        wr_ptr_r <= 0;
+        rd_ptr_r <= 0;
+        lvl_o <= 0;
+    end
+    else begin
+        if (push_s) begin
+            mem_r[wr_ptr_r] <= dat_i;
+            wr_ptr_r <= wr_ptr_r + 1;
+        end
+
+        if (pop_s)
+            rd_ptr_r <= rd_ptr_r + 1;
+
+        /* Simultaneous push and pop leave the level unchanged */
+        if (push_s & ~pop_s)
+            lvl_o <= lvl_o + 1;
+        else if (pop_s & ~push_s)
+            lvl_o <= lvl_o - 1;
+    end
+end
+
+endmodule
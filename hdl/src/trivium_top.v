@@ -9,18 +9,56 @@
 // Tool versions:    ISE 14.7, Vivado v2016.2
 // Description:      The top module of the Trivium core. It simply realizes
 //                   a state machine that controls the cipher_engine component.
+//                   With BITS_PER_CYCLE set to N, the warm-up phase takes 1152/N
+//                   clock cycles and a 32-bit key stream word is generated in 32/N
+//                   cycles. For N = 64, every second word is taken from the upper
+//                   half of the previously generated key stream without clocking
+//                   the cipher.
+//                   As the key stream does not depend on the data, the engine
+//                   prefetches key stream words into a key stream FIFO whenever
+//                   there is room, including the time the core waits for data.
+//                   Input words are queued in an input FIFO, each one is XORed
+//                   with the head of the key stream FIFO and stored in the output
+//                   FIFO within a single cycle. Each word carries a 'last' flag
+//                   that is passed on unchanged along with the corresponding
+//                   result, such that message boundaries of a data stream are
+//                   preserved.
+//                   The cipher state (including a buffered key stream half) can be
+//                   read at any time and restored while the core is idle, which
+//                   resumes a previously saved instance without a warm-up phase.
+//                   Since the cipher runs ahead of the data, saving an instance
+//                   also requires the contents of the key stream FIFO. Asserting
+//                   hold_i stops the prefetching after the current word, after
+//                   which the FIFO can be read and written through the ks_* ports.
+//                   Loading key or IV discards the prefetched key stream.
+//                   Asserting skip_i while the core is ready and holds no input
+//                   fast-forwards the key stream by skip_cnt_i words. The words
+//                   are generated and discarded at the rate of the engine, i.e.
+//                   one word every max(32/N, 1) cycles, without any data. The
+//                   core is busy until the last word has been discarded.
 //
-// Dependencies:     /
+// Dependencies:     cipher_engine, sync_fifo
 //
 // Revision: 
 // Revision 0.01 - File Created 
 // Revision 0.02 - Modified core for use with AXI-Lite protocol
+// Revision 0.03 - Added BITS_PER_CYCLE parameter
+// Revision 0.04 - Added input and output FIFOs
+// Revision 0.05 - Added last flag to the data path
+// Revision 0.06 - Added state save/restore ports
+// Revision 0.07 - Added key stream prefetch FIFO
+// Revision 0.08 - Added key stream fast-forward
 //
 //////////////////////////////////////////////////////////////////////////////////
 `timescale 1ns / 1ps
 `default_nettype none
 
-module trivium_top(
+module trivium_top #(
+    parameter BITS_PER_CYCLE = 1,   /* Number of bits processed per clock (1, 8, 16, 32 or 64) */
+    parameter FIFO_DEPTH_LOG2 = 2,  /* Input and output FIFOs hold 2^FIFO_DEPTH_LOG2 words */
+    parameter KS_FIFO_DEPTH_LOG2 = 2    /* The key stream FIFO holds 2^KS_FIFO_DEPTH_LOG2 words */
+)
+(
     /* Module inputs */
     input   wire            clk_i,      /* System clock */
     input   wire            n_rst_i,    /* Asynchronous active low reset */
@@ -29,11 +67,32 @@ module trivium_top(
     input   wire    [2:0]   ld_reg_a_i, /* Load value into reg_a */
     input   wire    [2:0]   ld_reg_b_i, /* Load value into reg_b */   
     input   wire            init_i,     /* Initialize the cipher */
-    input   wire            proc_i,     /* Process input using current instance */
+    input   wire            proc_i,     /* Queue dat_i for processing using current instance */
+    input   wire            last_i,     /* dat_i is the last word of a message */
+    input   wire            pop_i,      /* Remove the current output word */
+    input   wire            st_ld_i,    /* Restore cipher state, only accepted while idle */
+    input   wire    [287:0] st_dat_i,   /* Cipher state to restore */
+    input   wire    [31:0]  ks_spare_i, /* Buffered key stream half to restore */
+    input   wire            ks_spare_vld_i, /* Validity of ks_spare_i */
+    input   wire            hold_i,     /* Do not start generating further key stream words */
+    input   wire            ks_wr_i,    /* Append ks_dat_i to the key stream FIFO */
+    input   wire    [31:0]  ks_dat_i,   /* Key stream word to append */
+    input   wire            ks_rd_i,    /* Remove the head of the key stream FIFO */
+    input   wire            skip_i,     /* Discard the next skip_cnt_i key stream words */
+    input   wire    [31:0]  skip_cnt_i, /* Number of key stream words to discard */
 
     /* Module outputs */
-    output  reg     [31:0]  dat_o,      /* Current cipher output */
-    output  wire            busy_o      /* Busy flag */     
+    output  wire    [31:0]  dat_o,      /* Current cipher output */
+    output  wire            last_o,     /* dat_o is the last word of a message */
+    output  wire            busy_o,     /* Busy flag */     
+    output  wire    [FIFO_DEPTH_LOG2:0] in_lvl_o,   /* Number of words waiting in input FIFO */
+    output  wire    [FIFO_DEPTH_LOG2:0] out_lvl_o,  /* Number of words available in output FIFO */
+    output  wire    [287:0] st_o,       /* Current cipher state */
+    output  wire    [31:0]  ks_spare_o, /* Current buffered key stream half */
+    output  wire            ks_spare_vld_o, /* Validity of ks_spare_o */
+    output  wire    [31:0]  ks_dat_o,   /* Head of the key stream FIFO */
+    output  wire    [KS_FIFO_DEPTH_LOG2:0]  ks_lvl_o,   /* Number of words in the key stream FIFO */
+    output  wire            ks_gen_o    /* A key stream word is partially generated */
 );
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -41,42 +100,180 @@ module trivium_top(
 //////////////////////////////////////////////////////////////////////////////////
 reg     [2:0]   next_state_s;   /* Next state of the FSM */
 reg     [2:0]   cur_state_r;    /* Current state of the FSM */
-reg     [10:0]  cntr_r;         /* Counter for warm-up and input processing */
-reg             cphr_en_r;      /* Cipher enable flag */
-reg     [31:0]  dat_r;          /* Buffered version of dat_i */
-wire            bit_out_s;      /* Cipher output bit */
-integer i;
+reg     [10:0]  cntr_r;         /* Counter for the warm-up phase */
+reg     [4:0]   gen_cntr_r;     /* Counter for the generation of a key stream word */
+reg     [31:0]  gen_r;          /* Key stream word currently being assembled */
+wire    [31:0]  gen_dat_s;      /* gen_r after adding the bits of one cycle */
+wire            gen_run_s;      /* Generate key stream bits in the current cycle */
+wire            cphr_en_s;      /* Cipher enable flag */
+wire    [(BITS_PER_CYCLE - 1):0]    cphr_out_s; /* Cipher output bits, i.e. key stream */
+reg     [31:0]  ks_spare_r;     /* Unused upper key stream half (BITS_PER_CYCLE = 64) */
+reg             ks_spare_vld_r; /* Flag indicating that ks_spare_r holds the next key stream word */
+wire    [31:0]  ks_spare_s;     /* Upper key stream half of the current cycle */
+wire            ks_push_s;      /* Store the current key stream word */
+wire            ks_pop_s;       /* Remove the head of the key stream FIFO */
+wire            ks_clr_s;       /* Discard the prefetched key stream */
+wire            ks_empty_s;     /* Key stream FIFO is empty */
+wire            ks_full_s;      /* Key stream FIFO is full */
+wire    [31:0]  in_dat_s;       /* Head of the input FIFO */
+wire            in_last_s;      /* Last flag at the head of the input FIFO */
+wire            in_empty_s;     /* Input FIFO is empty */
+wire            out_full_s;     /* Output FIFO is full */
+wire            proc_s;         /* Process the head of the input FIFO */
+wire            ld_s;           /* Key or IV is being loaded */
+wire            restore_s;      /* Restore the cipher state */
+reg     [31:0]  skip_cntr_r;    /* Number of key stream words left to discard */
+wire            skip_ld_s;      /* Start discarding skip_cnt_i key stream words */
+wire            skipping_s;     /* Key stream words are being discarded */
+wire            skip_pop_s;     /* Discard the head of the key stream FIFO */
 
 //////////////////////////////////////////////////////////////////////////////////
 // Local parameter definitions
 //////////////////////////////////////////////////////////////////////////////////
 parameter   IDLE_e = 0, 
             WARMUP_e = 1, 
-            WAIT_PROC_e = 2, 
-            PROC_e = 3;
+            READY_e = 2;
+
+localparam  WARMUP_CYCLES = 1152/BITS_PER_CYCLE;
+localparam  GEN_CYCLES = (BITS_PER_CYCLE < 32) ? 32/BITS_PER_CYCLE : 1;
 
 //////////////////////////////////////////////////////////////////////////////////
 // Module instantiations
 //////////////////////////////////////////////////////////////////////////////////
-cipher_engine cphr(
-    .clk_i(clk_i),
-    .n_rst_i(n_rst_i),
-    .ce_i(cphr_en_r),
-    .ld_dat_i(ld_dat_i),
-    .ld_reg_a_i(ld_reg_a_i),
-    .ld_reg_b_i(ld_reg_b_i),
-    .dat_i(dat_r[0]),
-    .dat_o(bit_out_s)
-);
+cipher_engine #(
+        .BITS_PER_CYCLE(BITS_PER_CYCLE)
+    )
+    cphr(
+        .clk_i(clk_i),
+        .n_rst_i(n_rst_i),
+        .ce_i(cphr_en_s),
+        .ld_dat_i(ld_dat_i),
+        .ld_reg_a_i(ld_reg_a_i),
+        .ld_reg_b_i(ld_reg_b_i),
+        .st_ld_i(restore_s),
+        .st_dat_i(st_dat_i),
+        .st_o(st_o),
+        .dat_i({BITS_PER_CYCLE{1'b0}}), /* Zero input yields the plain key stream */
+        .dat_o(cphr_out_s)
+    );
+
+sync_fifo #(
+        .WIDTH(32),
+        .DEPTH_LOG2(KS_FIFO_DEPTH_LOG2)
+    )
+    ks_fifo(
+        .clk_i(clk_i),
+        .n_rst_i(n_rst_i),
+        .clr_i(ks_clr_s),
+        .push_i(ks_push_s | ks_wr_i),
+        .dat_i(ks_wr_i ? ks_dat_i : gen_dat_s),
+        .pop_i(ks_pop_s),
+        .dat_o(ks_dat_o),
+        .full_o(ks_full_s),
+        .empty_o(ks_empty_s),
+        .lvl_o(ks_lvl_o)
+    );
+
+sync_fifo #(
+        .WIDTH(33),
+        .DEPTH_LOG2(FIFO_DEPTH_LOG2)
+    )
+    in_fifo(
+        .clk_i(clk_i),
+        .n_rst_i(n_rst_i),
+        .clr_i(1'b0),
+        .push_i(proc_i),
+        .dat_i({last_i, dat_i}),
+        .pop_i(proc_s),
+        .dat_o({in_last_s, in_dat_s}),
+        .full_o(),
+        .empty_o(in_empty_s),
+        .lvl_o(in_lvl_o)
+    );
+
+sync_fifo #(
+        .WIDTH(33),
+        .DEPTH_LOG2(FIFO_DEPTH_LOG2)
+    )
+    out_fifo(
+        .clk_i(clk_i),
+        .n_rst_i(n_rst_i),
+        .clr_i(1'b0),
+        .push_i(proc_s),
+        .dat_i({in_last_s, in_dat_s ^ ks_dat_o}),
+        .pop_i(pop_i),
+        .dat_o({last_o, dat_o}),
+        .full_o(out_full_s),
+        .empty_o(),
+        .lvl_o(out_lvl_o)
+    );
+
+//////////////////////////////////////////////////////////////////////////////////
+// Key stream width adaption
+//////////////////////////////////////////////////////////////////////////////////
+generate
+    if (BITS_PER_CYCLE < 32) begin : narrow
+        /* Collect the key stream in slices of BITS_PER_CYCLE bits */
+        assign gen_dat_s = {cphr_out_s, gen_r[31:BITS_PER_CYCLE]};
+        assign ks_spare_s = 0;
+    end
+    else if (BITS_PER_CYCLE == 32) begin : word
+        assign gen_dat_s = cphr_out_s;
+        assign ks_spare_s = 0;
+    end
+    else begin : dword
+        assign gen_dat_s = ks_spare_vld_r ? ks_spare_r : cphr_out_s[31:0];
+        assign ks_spare_s = cphr_out_s[63:32];
+    end
+endgenerate
+
+//////////////////////////////////////////////////////////////////////////////////
+// Key stream generation and data processing
+//////////////////////////////////////////////////////////////////////////////////
+assign ld_s = (ld_reg_a_i != 3'b000) || (ld_reg_b_i != 3'b000);
+assign ks_clr_s = ld_s || restore_s || (next_state_s == WARMUP_e);
+
+/* A new word is only started if there is room for it, a started word is always completed */
+assign gen_run_s = (cur_state_r == READY_e) && ~ks_clr_s &&
+                   ((gen_cntr_r != 0) || (~ks_full_s && (~hold_i || skipping_s)));
+/* A buffered key stream half does not require the cipher */
+assign cphr_en_s = (cur_state_r == WARMUP_e) || (gen_run_s && ~ks_spare_vld_r);
+assign ks_push_s = gen_run_s && (gen_cntr_r == GEN_CYCLES - 1);
+assign ks_gen_o = (gen_cntr_r != 0);
+
+/* Queued words wait until a fast-forward is complete */
+assign proc_s = (cur_state_r == READY_e) && ~ks_clr_s && ~skipping_s && ~in_empty_s && ~ks_empty_s && ~out_full_s;
+assign ks_pop_s = proc_s | ks_rd_i | skip_pop_s;
+
+//////////////////////////////////////////////////////////////////////////////////
+// Key stream fast-forward
+//////////////////////////////////////////////////////////////////////////////////
+assign skipping_s = (skip_cntr_r != 0);
+assign skip_ld_s = skip_i && (cur_state_r == READY_e) && ~ks_clr_s && in_empty_s && ~skipping_s;
+assign skip_pop_s = skipping_s && ~ks_empty_s;
+
+//////////////////////////////////////////////////////////////////////////////////
+// State save/restore
+//////////////////////////////////////////////////////////////////////////////////
+assign restore_s = st_ld_i && in_empty_s && ~init_i &&
+                   ((cur_state_r == IDLE_e) || (cur_state_r == READY_e));
+assign ks_spare_o = ks_spare_r;
+assign ks_spare_vld_o = ks_spare_vld_r;
 
 //////////////////////////////////////////////////////////////////////////////////
 // Initial register values
 //////////////////////////////////////////////////////////////////////////////////
-assign busy_o = cphr_en_r;
+assign busy_o = (cur_state_r == WARMUP_e) || ~in_empty_s || skipping_s;
 initial begin
     cur_state_r = IDLE_e;
     cntr_r = 0;
-    cphr_en_r = 1'b0;
+    gen_cntr_r = 0;
+    skip_cntr_r = 0;
+    ks_spare_vld_r = 1'b0;
+    
+    if (BITS_PER_CYCLE != 1 && BITS_PER_CYCLE != 8 && BITS_PER_CYCLE != 16 &&
+        BITS_PER_CYCLE != 32 && BITS_PER_CYCLE != 64)
+        $display("ERROR: Unsupported BITS_PER_CYCLE value %0d", BITS_PER_CYCLE);
 end
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -88,30 +285,26 @@ always @(*) begin
             /* Wait until the user initializes the module */
             if (init_i)
                 next_state_s = WARMUP_e;
+            else if (restore_s) /* Resume a saved instance */
+                next_state_s = READY_e;
             else
                 next_state_s = IDLE_e;
             
         WARMUP_e:
             /* Warm up the cipher */
-            if (cntr_r == 1151)
-                next_state_s = WAIT_PROC_e;
+            if (cntr_r == WARMUP_CYCLES - 1)
+                next_state_s = READY_e;
             else
                 next_state_s = WARMUP_e;
             
-        WAIT_PROC_e:
-            if (proc_i)         /* Calculation for current settings is being started */
-                next_state_s = PROC_e;
-            else if (init_i)    /* Warmup phase, probably for new key o */
+        READY_e:
+            /* Generate key stream and process queued words */
+            if (init_i)         /* Warmup phase, probably for new key o */
                 next_state_s = WARMUP_e;
+            else if (ld_s)      /* New key or IV, wait for initialization */
+                next_state_s = IDLE_e;
             else
-                next_state_s = WAIT_PROC_e;
-            
-        PROC_e:
-            /* Process all 32 input data bits */
-            if (cntr_r == 31)
-                next_state_s = WAIT_PROC_e;
-            else
-                next_state_s = PROC_e;
+                next_state_s = READY_e;
             
         default:
             next_state_s = cur_state_r;
@@ -126,60 +319,56 @@ always @(posedge clk_i or negedge n_rst_i) begin
         /* Reset registers driven here */
         cntr_r <= 0;
         cur_state_r <= IDLE_e;
-        cphr_en_r <= 1'b0;
-        dat_o <= 0;
-        dat_r <= 0;
+        gen_cntr_r <= 0;
+        gen_r <= 0;
+        ks_spare_r <= 0;
+        ks_spare_vld_r <= 1'b0;
+        skip_cntr_r <= 0;
     end
     else begin
         /* State save logic */
         cur_state_r <= next_state_s;
       
-        /* Output logic */
-        case (cur_state_r)
-            IDLE_e: begin
-                if (next_state_s == WARMUP_e) begin
-                    /* Enable cipher and initialize */
-                    cphr_en_r <= 1'b1;
-                end
-            end
-         
-            WARMUP_e: begin
-                if (next_state_s == WAIT_PROC_e) begin
-                    cntr_r <= 0;
-                    cphr_en_r <= 1'b0;
-                end
-                else begin
-                    /* Increment the warm-up phase counter */
-                    cntr_r <= cntr_r + 1;
-                end
-            end
-         
-            WAIT_PROC_e: begin
-                /* Wait until data to encrypt/decrypt is being presented */
-                if (next_state_s == PROC_e) begin
-                    cphr_en_r <= 1'b1;
-                    dat_r <= dat_i;
-                end
-                else if (next_state_s == WARMUP_e)
-                    cphr_en_r <= 1'b1;
-            end
-         
-            PROC_e: begin
-                if (next_state_s == WAIT_PROC_e) begin
-                    cphr_en_r <= 1'b0;
-                    cntr_r <= 0;
-                end
-                else
-                    cntr_r <= cntr_r + 1;
-                    
-                /* Shift the input data register */
-                dat_r <= {1'b0, dat_r[31:1]};
+        /* Warm-up phase counter */
+        if (cur_state_r == WARMUP_e && next_state_s == WARMUP_e)
+            cntr_r <= cntr_r + 1;
+        else
+            cntr_r <= 0;
+        
+        /* Fast-forward counter, a new key stream cancels the fast-forward */
+        if (ks_clr_s)
+            skip_cntr_r <= 0;
+        else if (skip_ld_s)
+            skip_cntr_r <= skip_cnt_i;
+        else if (skip_pop_s)
+            skip_cntr_r <= skip_cntr_r - 1;
+        
+        if (restore_s) begin
+            /* Restore the buffered key stream half along with the cipher state */
+            gen_cntr_r <= 0;
+            ks_spare_r <= ks_spare_i;
+            ks_spare_vld_r <= (BITS_PER_CYCLE > 32) & ks_spare_vld_i;
+        end
+        else if (ks_clr_s) begin
+            /* Drop a partially generated word along with the prefetched key stream */
+            gen_cntr_r <= 0;
+            ks_spare_vld_r <= 1'b0;
+        end
+        else if (gen_run_s) begin
+            /* Shift the key stream bits into the generator register */
+            gen_r <= gen_dat_s;
+            
+            if (gen_cntr_r == GEN_CYCLES - 1)
+                gen_cntr_r <= 0;
+            else
+                gen_cntr_r <= gen_cntr_r + 1;
             
-                /* Shift the output bits into the output register */
-                dat_o <= {bit_out_s, dat_o[31:1]};
+            /* Keep or consume the upper key stream half */
+            if (BITS_PER_CYCLE > 32) begin
+                ks_spare_r <= ks_spare_s;
+                ks_spare_vld_r <= ~ks_spare_vld_r;
             end
-         
-        endcase
+        end
     end
 end
 
@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////////////////////
+// Design Name:   axi_trivium_v1_0
+// Module Name:   axi_trivium_stream_tb
+// Project Name:  Trivium
+// Target Device: Spartan-6, Zynq
+// Tool versions: ISE 14.7, Vivado v2016.2
+// Description:   The packaged IP core is tested using the reference I/O files.
+//                Key and IV of each test are written via AXI4-Lite, after which
+//                all words of the test are streamed through the AXI4-Stream
+//                interfaces as a single message (TLAST on the final word). The
+//                ciphertext is checked against the reference and the number of
+//                cycles in which the plaintext stream was stalled is reported.
+//                For BITS_PER_CYCLE >= 32 the core must accept one word per
+//                clock cycle, any stall is treated as an error.
+//
+// Dependencies:  axi_trivium_v1_0
+//
+////////////////////////////////////////////////////////////////////////////////
+`timescale 1ns / 1ps
+module axi_trivium_stream_tb;
+
+////////////////////////////////////////////////////////////////////////////////
+// Parameter definitions
+////////////////////////////////////////////////////////////////////////////////
+parameter BITS_PER_CYCLE = 32;  /* Bits processed per clock by the UUT (1, 8, 16, 32 or 64) */
+parameter FIFO_DEPTH_LOG2 = 2;  /* The UUT FIFOs hold 2^FIFO_DEPTH_LOG2 words */
+parameter KS_FIFO_DEPTH_LOG2 = 2;   /* The UUT key stream FIFO holds 2^KS_FIFO_DEPTH_LOG2 words */
+parameter MAX_TESTS = 64;       /* Maximum number of tests in the reference files */
+parameter MAX_WORDS = 8192;     /* Maximum total number of words in the reference files */
+
+/* Register byte addresses and control bits */
+localparam REG_CONFIG = 0*4;
+localparam REG_KEY_LO = 1*4;
+localparam REG_IV_LO = 4*4;
+localparam CONF_INIT = 32'h01;
+localparam CONF_STOP = 32'h02;
+localparam CONF_STREAM = 32'h08;
+localparam CONF_IDONE_BIT = 9;
+
+////////////////////////////////////////////////////////////////////////////////
+// Signal definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* AXI4-Lite master signals */
+reg             clk_i;
+reg             n_rst_i;
+reg     [6:0]   awaddr;
+reg             awvalid;
+wire            awready;
+reg     [31:0]  wdata;
+reg     [3:0]   wstrb;
+reg             wvalid;
+wire            wready;
+wire    [1:0]   bresp;
+wire            bvalid;
+reg             bready;
+reg     [6:0]   araddr;
+reg             arvalid;
+wire            arready;
+wire    [31:0]  rdata;
+wire    [1:0]   rresp;
+wire            rvalid;
+reg             rready;
+
+/* AXI4-Stream signals */
+reg     [31:0]  s_tdata;
+reg             s_tvalid;
+wire            s_tready;
+reg             s_tlast;
+wire    [31:0]  m_tdata;
+wire            m_tvalid;
+reg             m_tready;
+wire            m_tlast;
+
+/* Reference data */
+reg     [79:0]  key_mem[0:(MAX_TESTS - 1)];     /* Key of each test */
+reg     [79:0]  iv_mem[0:(MAX_TESTS - 1)];      /* IV of each test */
+integer         offs_mem[0:(MAX_TESTS - 1)];    /* Index of the first word of each test */
+integer         len_mem[0:(MAX_TESTS - 1)];     /* Number of words of each test */
+reg     [31:0]  pt_mem[0:(MAX_WORDS - 1)];      /* Plaintext words */
+reg     [31:0]  ct_mem[0:(MAX_WORDS - 1)];      /* Ciphertext words */
+integer         num_tests_v;                    /* Number of tests */
+
+/* Other signals */
+integer cycle_v;        /* Free running cycle counter */
+integer cur_test_v;     /* Index of current test */
+integer in_cntr_v;      /* Number of words accepted by the UUT */
+integer out_cntr_v;     /* Number of words delivered by the UUT */
+integer stall_v;        /* Cycles in which a valid input word was not accepted */
+integer first_cycle_v;  /* Cycle of the first accepted word */
+integer last_cycle_v;   /* Cycle of the last delivered word */
+integer total_words_v;  /* Number of words of all tests */
+integer total_stall_v;  /* Number of stall cycles of all tests */
+reg     [31:0]  conf_r; /* Configuration register contents */
+
+////////////////////////////////////////////////////////////////////////////////
+// UUT Instantiation
+////////////////////////////////////////////////////////////////////////////////
+axi_trivium_v1_0 #(
+    .BITS_PER_CYCLE(BITS_PER_CYCLE),
+    .FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+    .KS_FIFO_DEPTH_LOG2(KS_FIFO_DEPTH_LOG2)
+)
+uut(
+    .s00_axis_tdata(s_tdata),
+    .s00_axis_tvalid(s_tvalid),
+    .s00_axis_tready(s_tready),
+    .s00_axis_tlast(s_tlast),
+    .m00_axis_tdata(m_tdata),
+    .m00_axis_tvalid(m_tvalid),
+    .m00_axis_tready(m_tready),
+    .m00_axis_tlast(m_tlast),
+    .s00_axi_aclk(clk_i),
+    .s00_axi_aresetn(n_rst_i),
+    .s00_axi_awaddr(awaddr),
+    .s00_axi_awprot(3'b000),
+    .s00_axi_awvalid(awvalid),
+    .s00_axi_awready(awready),
+    .s00_axi_wdata(wdata),
+    .s00_axi_wstrb(wstrb),
+    .s00_axi_wvalid(wvalid),
+    .s00_axi_wready(wready),
+    .s00_axi_bresp(bresp),
+    .s00_axi_bvalid(bvalid),
+    .s00_axi_bready(bready),
+    .s00_axi_araddr(araddr),
+    .s00_axi_arprot(3'b000),
+    .s00_axi_arvalid(arvalid),
+    .s00_axi_arready(arready),
+    .s00_axi_rdata(rdata),
+    .s00_axi_rresp(rresp),
+    .s00_axi_rvalid(rvalid),
+    .s00_axi_rready(rready),
+    .s01_axi_awvalid(1'b0),     /* FIFO windows are unused */
+    .s01_axi_wvalid(1'b0),
+    .s01_axi_bready(1'b0),
+    .s01_axi_arvalid(1'b0),
+    .s01_axi_rready(1'b0),
+    .m00_axi_awready(1'b0),     /* DMA engine is unused */
+    .m00_axi_wready(1'b0),
+    .m00_axi_bvalid(1'b0),
+    .m00_axi_arready(1'b0),
+    .m00_axi_rvalid(1'b0)
+);
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper task definitions
+////////////////////////////////////////////////////////////////////////////////
+/* Read all tests of the reference input and output files into memory */
+task load_vectors;
+    reg [8*24:1] cur_tok;
+    reg [79:0] cur_val;
+    integer fd_in;
+    integer fd_out;
+    integer scan_ret;
+    integer word_idx;
+begin
+    fd_in = $fopen("trivium_ref_in.txt", "r");
+    fd_out = $fopen("trivium_ref_out.txt", "r");
+    if (!fd_in || !fd_out) begin
+        $display("ERROR: Could not open reference files");
+        $finish;
+    end
+
+    num_tests_v = 0;
+    word_idx = 0;
+    scan_ret = $fscanf(fd_in, "%s", cur_tok);
+    while (scan_ret == 1 && cur_tok != ".") begin
+        /* Key and IV lead each test of the input file */
+        scan_ret = $sscanf(cur_tok, "%h", cur_val);
+        key_mem[num_tests_v] = cur_val;
+        scan_ret = $fscanf(fd_in, "%h", cur_val);
+        iv_mem[num_tests_v] = cur_val;
+        offs_mem[num_tests_v] = word_idx;
+
+        /* Plaintext words until the end of the test */
+        scan_ret = $fscanf(fd_in, "%s", cur_tok);
+        while (scan_ret == 1 && cur_tok != "-") begin
+            scan_ret = $sscanf(cur_tok, "%h", cur_val);
+            pt_mem[word_idx] = cur_val[31:0];
+            scan_ret = $fscanf(fd_out, "%h", cur_val);
+            ct_mem[word_idx] = cur_val[31:0];
+            word_idx = word_idx + 1;
+            scan_ret = $fscanf(fd_in, "%s", cur_tok);
+        end
+
+        /* Skip the end of test marker of the output file */
+        scan_ret = $fscanf(fd_out, "%s", cur_tok);
+        len_mem[num_tests_v] = word_idx - offs_mem[num_tests_v];
+        num_tests_v = num_tests_v + 1;
+        scan_ret = $fscanf(fd_in, "%s", cur_tok);
+    end
+
+    $fclose(fd_in);
+    $fclose(fd_out);
+end
+endtask
+
+/* Perform a single AXI4-Lite write */
+task axi_write;
+    input [6:0] addr;
+    input [31:0] dat;
+begin
+    @(posedge clk_i);
+    #1;
+    awaddr = addr;
+    wdata = dat;
+    wstrb = 4'hf;
+    awvalid = 1'b1;
+    wvalid = 1'b1;
+    bready = 1'b1;
+
+    /* Address and data are accepted together */
+    @(posedge clk_i);
+    while (!awready)
+        @(posedge clk_i);
+    #1;
+    awvalid = 1'b0;
+    wvalid = 1'b0;
+
+    /* Accept the write response */
+    while (!bvalid)
+        @(posedge clk_i);
+    @(posedge clk_i);
+    #1;
+    bready = 1'b0;
+end
+endtask
+
+/* Perform a single AXI4-Lite read */
+task axi_read;
+    input [6:0] addr;
+    output [31:0] dat;
+begin
+    @(posedge clk_i);
+    #1;
+    araddr = addr;
+    arvalid = 1'b1;
+
+    @(posedge clk_i);
+    while (!arready)
+        @(posedge clk_i);
+    #1;
+    arvalid = 1'b0;
+    rready = 1'b1;
+
+    while (!rvalid)
+        @(posedge clk_i);
+    dat = rdata;
+    @(posedge clk_i);
+    #1;
+    rready = 1'b0;
+end
+endtask
+
+/* Stream the plaintext of the current test into the UUT */
+task stream_in;
+begin
+    in_cntr_v = 0;
+    stall_v = 0;
+    @(posedge clk_i);
+    #1;
+    s_tvalid = 1'b1;
+    s_tdata = pt_mem[offs_mem[cur_test_v]];
+    s_tlast = (len_mem[cur_test_v] == 1);
+
+    while (in_cntr_v < len_mem[cur_test_v]) begin
+        @(posedge clk_i);
+        if (s_tready) begin
+            if (in_cntr_v == 0)
+                first_cycle_v = cycle_v;
+
+            in_cntr_v = in_cntr_v + 1;
+            #1;
+            if (in_cntr_v < len_mem[cur_test_v]) begin
+                s_tdata = pt_mem[offs_mem[cur_test_v] + in_cntr_v];
+                s_tlast = (in_cntr_v == len_mem[cur_test_v] - 1);
+            end
+            else begin
+                s_tvalid = 1'b0;
+                s_tlast = 1'b0;
+            end
+        end
+        else if (in_cntr_v != 0)
+            stall_v = stall_v + 1;
+    end
+end
+endtask
+
+/* Collect and check the ciphertext of the current test */
+task stream_out;
+begin
+    out_cntr_v = 0;
+    m_tready = 1'b1;
+
+    while (out_cntr_v < len_mem[cur_test_v]) begin
+        @(posedge clk_i);
+        if (m_tvalid) begin
+            if (m_tdata != ct_mem[offs_mem[cur_test_v] + out_cntr_v]) begin
+                $display("ERROR: Incorrect output in test %d, word %d!", cur_test_v, out_cntr_v);
+                $display("%08x != %08x", m_tdata, ct_mem[offs_mem[cur_test_v] + out_cntr_v]);
+                $finish;
+            end
+
+            if (m_tlast != (out_cntr_v == len_mem[cur_test_v] - 1)) begin
+                $display("ERROR: Incorrect TLAST in test %d, word %d!", cur_test_v, out_cntr_v);
+                $finish;
+            end
+
+            out_cntr_v = out_cntr_v + 1;
+        end
+    end
+
+    last_cycle_v = cycle_v;
+    #1;
+    m_tready = 1'b0;
+end
+endtask
+
+////////////////////////////////////////////////////////////////////////////////
+// Clock generation and cycle counter
+////////////////////////////////////////////////////////////////////////////////
+always begin
+    #10 clk_i = ~clk_i;
+end
+
+always @(posedge clk_i) begin
+    cycle_v <= cycle_v + 1;
+end
+
+////////////////////////////////////////////////////////////////////////////////
+// Stimulus process
+////////////////////////////////////////////////////////////////////////////////
+initial begin
+    /* Initialize Inputs */
+    clk_i = 0;
+    n_rst_i = 0;
+    awaddr = 0;
+    awvalid = 0;
+    wdata = 0;
+    wstrb = 0;
+    wvalid = 0;
+    bready = 0;
+    araddr = 0;
+    arvalid = 0;
+    rready = 0;
+    s_tdata = 0;
+    s_tvalid = 0;
+    s_tlast = 0;
+    m_tready = 0;
+
+    /* Initialize other signals/variables */
+    cycle_v = 0;
+    total_words_v = 0;
+    total_stall_v = 0;
+    load_vectors;
+
+    /* Wait 100 ns for global reset to finish */
+    #100;
+    n_rst_i = 1'b1;
+
+    for (cur_test_v = 0; cur_test_v < num_tests_v; cur_test_v = cur_test_v + 1) begin
+        /* Reset the core and load key and IV while in stream mode */
+        axi_write(REG_CONFIG, CONF_STREAM | CONF_STOP);
+        axi_write(REG_KEY_LO, key_mem[cur_test_v][31:0]);
+        axi_write(REG_KEY_LO + 4, key_mem[cur_test_v][63:32]);
+        axi_write(REG_KEY_LO + 8, {16'h0000, key_mem[cur_test_v][79:64]});
+        axi_write(REG_IV_LO, iv_mem[cur_test_v][31:0]);
+        axi_write(REG_IV_LO + 4, iv_mem[cur_test_v][63:32]);
+        axi_write(REG_IV_LO + 8, {16'h0000, iv_mem[cur_test_v][79:64]});
+
+        /* Initialize the cipher and wait for the warm-up phase to complete */
+        axi_write(REG_CONFIG, CONF_STREAM | CONF_INIT);
+        conf_r = 0;
+        while (!conf_r[CONF_IDONE_BIT])
+            axi_read(REG_CONFIG, conf_r);
+
+        /* Stream the message through the core */
+        fork
+            stream_in;
+            stream_out;
+        join
+
+        $display("Test %0d: %0d words, %0d stall cycles, %0d cycles from first input to last output",
+                 cur_test_v, len_mem[cur_test_v], stall_v, last_cycle_v - first_cycle_v + 1);
+        total_words_v = total_words_v + len_mem[cur_test_v];
+        total_stall_v = total_stall_v + stall_v;
+    end
+
+    if (BITS_PER_CYCLE >= 32 && total_stall_v != 0) begin
+        $display("ERROR: Core did not accept one word per cycle (%0d stall cycles)!", total_stall_v);
+        $finish;
+    end
+
+    $display("Streamed %0d words with %0d stall cycles", total_words_v, total_stall_v);
+    $display("Tests successfully completed!");
+    $finish;
+end
+
+endmodule
@@ -10,7 +10,15 @@
 // Description:   The module trivium_top is tested using reference I/O files. Each
 //                test incorporates the pre-loading with a new key and IV, as well
 //                as providing input words and checking the correctness of the
-//                encrypted output words.
+//                encrypted output words. The core configuration under test is
+//                selected through the BITS_PER_CYCLE, FIFO_DEPTH_LOG2 and
+//                KS_FIFO_DEPTH_LOG2 parameters. Input words are queued while earlier results are
+//                still being collected, so that the FIFOs of the core are exercised.
+//                The tests are streamed from the binary vector file VEC_FILE in a single pass,
+//                one record (key, IV, word count, plaintext and ciphertext words, see
+//                sw/libtrivium/trivium_vectors.hpp) being read via $fread per test.
+//                Every second test fast-forwards the key stream over the first half of
+//                its words and only encrypts the second half.
 //
 // Verilog Test Fixture created by ISE for module: trivium_top
 //
@@ -19,213 +27,24 @@
 // Revision:
 // Revision 0.01 - File Created
 // Revision 0.02 - Modifications to accomodate new core interface
+// Revision 0.03 - Added BITS_PER_CYCLE parameter
+// Revision 0.04 - Adapted to FIFO based core interface
+// Revision 0.05 - Added KS_FIFO_DEPTH_LOG2 parameter
+// Revision 0.06 - Test vectors are streamed from a binary vector file
+// Revision 0.07 - Added key stream fast-forward test
 // 
 ////////////////////////////////////////////////////////////////////////////////
 `timescale 1ns / 1ps
 module trivium_top_tb;
 
 ////////////////////////////////////////////////////////////////////////////////
-// Helper function definitions
+// Parameter definitions
 ////////////////////////////////////////////////////////////////////////////////
-/* Get the number of tests contained in a specified file */
-function [31:0] get_num_tests;
-    input [8*20:1] i_file_name;
-    reg [8*20:1] cur_line;
-    integer cur_num;
-    integer fd;
-    integer scan_ret;
-begin
-    cur_num = 0;
-    fd = $fopen(i_file_name, "r");
-    if (!fd) begin
-        $display("ERROR: Could not open '%s'", i_file_name);
-        get_num_tests = 0;
-    end
-    else begin
-        /* Iterate over lines */
-        scan_ret = $fscanf(fd, "%s", cur_line);
-        while (scan_ret) begin
-            if (cur_line == "-")
-                cur_num = cur_num + 1;
-            
-            scan_ret = $fscanf(fd, "%s", cur_line);
-        end
-      
-        $fclose(fd);
-        get_num_tests = cur_num;
-    end
-end
-endfunction
-
-/* Returns the key or IV of a particular test */
-function [79:0] get_key_iv;
-    input [8*20:1] i_file_name;
-    input [8*3:1] key_or_iv;
-    input [31:0] test_num;
-    reg [8*20:1] cur_line;
-    reg [79:0] ret_val;
-    integer cur_num;
-    integer fd;
-    integer scan_ret;
-    integer fpos;
-begin
-    cur_num = 0;
-    fd = $fopen(i_file_name, "r");
-    if (!fd) begin
-        $display("ERROR: Could not open '%s'", i_file_name);
-        $finish;
-    end
-    else begin
-        /* Iterate until specified test is found */
-        fpos = $ftell(fd);
-        scan_ret = $fscanf(fd, "%s", cur_line);
-        while (cur_num < test_num && scan_ret) begin
-            if (cur_line == "-")
-                cur_num = cur_num + 1;
-            
-            fpos = $ftell(fd);
-            scan_ret = $fscanf(fd, "%s", cur_line);
-        end
-      
-        if (cur_line == ".") begin
-            $display("ERROR: Incorrect test number specified: %d", test_num);
-            $fclose(fd);
-            $finish;
-        end
-      
-        /* Get key or IV and return, get back previous line to interpret as hex */   	
-        $fseek(fd, fpos, 0);
-        if (key_or_iv == "key")
-            scan_ret = $fscanf(fd, "%h", ret_val);
-        else if (key_or_iv == "iv") begin
-            scan_ret = $fscanf(fd, "%h", ret_val);
-            scan_ret = $fscanf(fd, "%h", ret_val);
-        end
-        else begin
-            $display("ERROR: Could not read requested value!");
-            $fclose(fd);
-            $finish;
-        end
-      
-        $fclose(fd);
-        get_key_iv = ret_val;
-    end
-end 
-endfunction
-
-/* Return the number of 32-bit words in specified test */
-function [31:0] get_num_words;
-    input [8*20:1] i_file_name;
-    input integer line_num;
-    input integer test_num;
-    reg [8*20:1] cur_line;
-    integer cur_num;
-    integer fd;
-    integer fpos;
-    integer scan_ret;
-begin
-    cur_num = 0;
-    fd = $fopen(i_file_name, "r");
-    if (!fd) begin
-        $display("ERROR: Could not open '%s'", i_file_name);
-        $finish;
-    end
-    else begin
-        /* Iterate until specified test is found */
-        fpos = $ftell(fd);
-        scan_ret = $fscanf(fd, "%s", cur_line);
-        while (cur_num < test_num && scan_ret) begin
-            if (cur_line == "-")
-                cur_num = cur_num + 1;
-            
-            fpos = $ftell(fd);
-            scan_ret = $fscanf(fd, "%s", cur_line);
-        end
-      
-        if (cur_line == ".") begin
-            $display("ERROR: Incorrect test number specified: %d", test_num);
-            $fclose(fd);
-            $finish;
-        end
-      
-        /* Skip the key and IV in case we are reading from input reference */
-        $fseek(fd, fpos, 0);
-        if (i_file_name == "trivium_ref_in.txt") begin
-            scan_ret = $fscanf(fd, "%s", cur_line);
-            scan_ret = $fscanf(fd, "%s", cur_line);
-        end
-      
-        /* Counter number of words in current test */
-        cur_num = 0;
-        cur_line = "";
-        scan_ret = $fscanf(fd, "%s", cur_line);
-        while (cur_line != "-") begin
-            cur_num = cur_num + 1;
-            scan_ret = $fscanf(fd, "%s", cur_line);
-        end
-      
-        $fclose(fd);
-        get_num_words = cur_num;
-    end
-end 
-endfunction
-
-/* Return 32-bit word from specified file */
-function [31:0] get_word;
-    input [8*20:1] i_file_name;
-    input integer line_num;
-    input integer test_num;
-    reg [8*20:1] cur_line;
-    reg [79:0] cur_word;
-    integer cur_num;
-    integer fd;
-    integer fpos;
-    integer scan_ret;
-begin
-    cur_num = 0;
-    fd = $fopen(i_file_name, "r");
-    if (!fd) begin
-        $display("ERROR: Could not open '%s'", i_file_name);
-        $finish;
-    end
-    else begin
-        /* Iterate until specified test is found */
-        fpos = $ftell(fd);
-        scan_ret = $fscanf(fd, "%s", cur_line);
-        while (cur_num < test_num && scan_ret) begin
-            if (cur_line == "-")
-                cur_num = cur_num + 1;
-           
-            fpos = $ftell(fd); 
-            scan_ret = $fscanf(fd, "%s", cur_line);
-        end
-      
-        if (cur_line == ".") begin
-            $display("ERROR: Incorrect test number specified: %d", test_num);
-            $fclose(fd);
-            $finish;
-        end
-      
-        /* Skip the key and IV in case we are reading from input reference */
-        $fseek(fd, fpos, 0);
-        if (i_file_name == "trivium_ref_in.txt") begin
-            scan_ret = $fscanf(fd, "%h", cur_word);
-            scan_ret = $fscanf(fd, "%h", cur_word);
-        end
-      
-        /* Skip to specified word */
-        cur_num = 0;
-        scan_ret = $fscanf(fd, "%h", cur_word);
-        while (cur_num < line_num && scan_ret) begin
-            cur_num = cur_num + 1;
-            scan_ret = $fscanf(fd, "%h", cur_word);
-        end
-      
-        $fclose(fd);
-        get_word = cur_word[31:0];
-    end
-end 
-endfunction
+parameter BITS_PER_CYCLE = 1;   /* Bits processed per clock by the UUT (1, 8, 16, 32 or 64) */
+parameter FIFO_DEPTH_LOG2 = 2;  /* The UUT FIFOs hold 2^FIFO_DEPTH_LOG2 words */
+parameter KS_FIFO_DEPTH_LOG2 = 2;   /* The UUT key stream FIFO holds 2^KS_FIFO_DEPTH_LOG2 words */
+parameter VEC_FILE = "trivium_ref.bin"; /* Binary test vector file */
+parameter MAX_WORDS = 65536;    /* Longest test supported, in 32-bit words */
 
 ////////////////////////////////////////////////////////////////////////////////
 // Signal definitions
@@ -240,10 +59,15 @@ reg     [2:0]   ld_reg_a_i;
 reg     [2:0]   ld_reg_b_i;   
 reg             init_i;
 reg             proc_i;
+reg             pop_i;
+reg             skip_i;
+reg     [31:0]  skip_cnt_i;
 
 /* Module outputs */
 wire    [31:0]  dat_o;
 wire            busy_o;     
+wire    [FIFO_DEPTH_LOG2:0] in_lvl_o;
+wire    [FIFO_DEPTH_LOG2:0] out_lvl_o;
 
 /* Other signals */
 reg start_tests_s;      /* Flag indicating the start of the tests */
@@ -251,12 +75,53 @@ reg     [95:0]  key_r;  /* Key used for encryption */
 reg     [95:0]  iv_r;   /* IV used for encryption */
 integer instr_v;        /* Current stimulus instruction index */
 integer dat_cntr_v;     /* Data counter variable */
+integer out_cntr_v;     /* Output word counter variable */
+integer num_words_v;    /* Number of words in current test */
 integer cur_test_v;     /* Index of current test */
+integer num_tests_v;    /* Number of tests in the vector file */
+integer fd_v;           /* Vector file */
+integer rd_ret_v;       /* Number of bytes read */
+reg     [7:0]   hdr_m [0:23];   /* File header or header of the current record */
+reg     [7:0]   dat_m [0:8*MAX_WORDS-1];    /* Plaintext and ciphertext of the current record */
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper function definitions
+////////////////////////////////////////////////////////////////////////////////
+/* Little-endian 32-bit value of four bytes of the header buffer */
+function [31:0] get_hdr_le32;
+    input integer i_off;
+begin
+    get_hdr_le32 = {hdr_m[i_off + 3], hdr_m[i_off + 2], hdr_m[i_off + 1], hdr_m[i_off]};
+end
+endfunction
+
+/* Key or IV of the current record, stored least significant byte first */
+function [79:0] get_key_iv;
+    input integer i_off;
+    integer i;
+begin
+    for (i = 0; i < 10; i = i + 1)
+        get_key_iv[(i*8)+:8] = hdr_m[i_off + i];
+end
+endfunction
+
+/* Return 32-bit word of the current record, words num_words_v and up are the ciphertext */
+function [31:0] get_word;
+    input integer i_word;
+begin
+    get_word = {dat_m[i_word*4 + 3], dat_m[i_word*4 + 2], dat_m[i_word*4 + 1], dat_m[i_word*4]};
+end
+endfunction
 
 ////////////////////////////////////////////////////////////////////////////////
 // UUT Instantiation
 ////////////////////////////////////////////////////////////////////////////////
-trivium_top uut(
+trivium_top #(
+    .BITS_PER_CYCLE(BITS_PER_CYCLE),
+    .FIFO_DEPTH_LOG2(FIFO_DEPTH_LOG2),
+    .KS_FIFO_DEPTH_LOG2(KS_FIFO_DEPTH_LOG2)
+)
+uut(
     .clk_i(clk_i),
     .n_rst_i(n_rst_i),
     .dat_i(dat_i),
@@ -265,8 +130,29 @@ trivium_top uut(
     .ld_reg_b_i(ld_reg_b_i),   
     .init_i(init_i),    
     .proc_i(proc_i),    
+    .last_i(1'b0),
+    .pop_i(pop_i),
+    .st_ld_i(1'b0),
+    .st_dat_i(288'd0),
+    .ks_spare_i(32'd0),
+    .ks_spare_vld_i(1'b0),
+    .hold_i(1'b0),
+    .ks_wr_i(1'b0),
+    .ks_dat_i(32'd0),
+    .ks_rd_i(1'b0),
+    .skip_i(skip_i),
+    .skip_cnt_i(skip_cnt_i),
     .dat_o(dat_o),
-    .busy_o(busy_o)     
+    .last_o(),
+    .busy_o(busy_o),
+    .in_lvl_o(in_lvl_o),
+    .out_lvl_o(out_lvl_o),
+    .st_o(),
+    .ks_spare_o(),
+    .ks_spare_vld_o(),
+    .ks_dat_o(),
+    .ks_lvl_o(),
+    .ks_gen_o()
 );
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -282,13 +168,33 @@ initial begin
     ld_reg_b_i = 0;   
     init_i = 0;
     proc_i = 0;
+    pop_i = 0;
+    skip_i = 0;
+    skip_cnt_i = 0;
     
     /* Initialize other signals/variables */
     start_tests_s = 0;
     instr_v = 0;
     dat_cntr_v = 0;
+    out_cntr_v = 0;
+    num_words_v = 0;
     cur_test_v = 0;
     
+    /* Open the vector file and check its header */
+    fd_v = $fopen(VEC_FILE, "rb");
+    if (!fd_v) begin
+        $display("ERROR: Could not open '%s'", VEC_FILE);
+        $finish;
+    end
+    
+    rd_ret_v = $fread(hdr_m, fd_v, 0, 16);
+    num_tests_v = get_hdr_le32(8);
+    if (rd_ret_v != 16 || {hdr_m[0], hdr_m[1], hdr_m[2], hdr_m[3]} != "TRVV" || get_hdr_le32(4) != 1 ||
+        get_hdr_le32(12) != 0 || num_tests_v <= 0) begin
+        $display("ERROR: '%s' is no vector file or contains no tests", VEC_FILE);
+        $finish;
+    end
+    
     /* Wait 100 ns for global reset to finish */
     #100;
     n_rst_i = 1'b1;
@@ -314,8 +220,12 @@ always @(posedge clk_i or negedge n_rst_i) begin
         ld_reg_b_i <= 0;   
         init_i <= 0;
         proc_i <= 0;   
+        pop_i <= 0;
+        skip_i <= 0;
+        skip_cnt_i <= 0;
         instr_v <= 0;
         dat_cntr_v <= 0;
+        out_cntr_v <= 0;
         key_r <= 0;
         iv_r <= 0;
     end
@@ -327,9 +237,22 @@ always @(posedge clk_i or negedge n_rst_i) begin
                     $finish;
                 end
 
-                /* Get the current key and IV */
-                key_r[79:0] <= get_key_iv("trivium_ref_in.txt", "key", cur_test_v);
-                iv_r[79:0] <= get_key_iv("trivium_ref_in.txt", "iv", cur_test_v);
+                /* Read the next record, the key and IV and then the plaintext and ciphertext words */
+                rd_ret_v = $fread(hdr_m, fd_v, 0, 24);
+                num_words_v = get_hdr_le32(20);
+                if (rd_ret_v != 24 || num_words_v <= 0 || num_words_v > MAX_WORDS) begin
+                    $display("ERROR: Invalid record for test %d (increase MAX_WORDS for longer tests)", cur_test_v);
+                    $finish;
+                end
+                
+                rd_ret_v = $fread(dat_m, fd_v, 0, 8*num_words_v);
+                if (rd_ret_v != 8*num_words_v) begin
+                    $display("ERROR: Vector file ends within test %d", cur_test_v);
+                    $finish;
+                end
+                
+                key_r[79:0] <= get_key_iv(0);
+                iv_r[79:0] <= get_key_iv(10);
 
                 instr_v <= instr_v + 1;
             end
@@ -370,45 +293,69 @@ always @(posedge clk_i or negedge n_rst_i) begin
                     instr_v <= instr_v + 1;
             end
          
-            4: begin    /* Instruction 4: Present a 32-bit value to encrypt */
+            4: begin    /* Instruction 4: Wait until the warm-up phase has completed */
                 init_i <= 0;
-                if (!busy_o) begin
-                    proc_i <= 1'b1;
-                    dat_i <= get_word("trivium_ref_in.txt", dat_cntr_v, cur_test_v);
+                if (!busy_o)
                     instr_v <= instr_v + 1;
+            end
+            
+            5: begin    /* Instruction 5: Fast-forward the key stream over the first half of odd tests */
+                if (cur_test_v % 2 == 0 || num_words_v < 2)
+                    instr_v <= instr_v + 2;
+                else begin
+                    skip_i <= 1'b1;
+                    skip_cnt_i <= num_words_v/2;
+                    if (busy_o)
+                        instr_v <= instr_v + 1;
                 end
             end
             
-            5: begin    /* Instruction 5: Wait until device busy */
-                if (busy_o) begin
-                    proc_i <= 0;
+            6: begin    /* Instruction 6: Wait until the skipped words have been discarded */
+                skip_i <= 0;
+                if (!busy_o) begin
+                    dat_cntr_v <= skip_cnt_i;
+                    out_cntr_v <= skip_cnt_i;
                     instr_v <= instr_v + 1;
                 end
             end
-         
-            6: begin    /* Instruction 6: Get ciphertext from device */
-                if (!busy_o) begin
-                   // Compare received ciphertext to reference
-                   if (dat_o != get_word("trivium_ref_out.txt", dat_cntr_v, cur_test_v)) begin
-                        $display("ERROR: Incorrect output in test %d, word %d!", cur_test_v, dat_cntr_v);
-                        $display("%04x != %04x, input = %04x", dat_o, get_word("trivium_ref_out.txt", dat_cntr_v, cur_test_v), get_word("trivium_ref_in.txt", dat_cntr_v, cur_test_v));
+            
+            7: begin    /* Instruction 7: Queue input words and collect the ciphertext */
+                /* Default values, FIFO levels are only evaluated after a previous push/pop took effect */
+                proc_i <= 0;
+                pop_i <= 0;
+                
+                /* Queue the next 32-bit value to encrypt */
+                if (!proc_i && dat_cntr_v < num_words_v && in_lvl_o < (1 << FIFO_DEPTH_LOG2)) begin
+                    proc_i <= 1'b1;
+                    dat_i <= get_word(dat_cntr_v);
+                    dat_cntr_v <= dat_cntr_v + 1;
+                end
+                
+                /* Get ciphertext from device */
+                if (!pop_i && out_lvl_o != 0) begin
+                    // Compare received ciphertext to reference
+                    if (dat_o != get_word(num_words_v + out_cntr_v)) begin
+                        $display("ERROR: Incorrect output in test %d, word %d!", cur_test_v, out_cntr_v);
+                        $display("%04x != %04x, input = %04x", dat_o, get_word(num_words_v + out_cntr_v), get_word(out_cntr_v));
                         $finish;
-                   end
-               
-                   // Check if there is more data to encrypt in current test
-                   if (dat_cntr_v < get_num_words("trivium_ref_in.txt", dat_cntr_v, cur_test_v) - 1) begin
-                        dat_cntr_v <= dat_cntr_v + 1;
-                        instr_v <= 4;
-                   end
-                   else begin
+                    end
+                    
+                    pop_i <= 1'b1;
+                    
+                    // Check if there is more ciphertext to collect in current test
+                    if (out_cntr_v == num_words_v - 1) begin
                         dat_cntr_v <= 0;
+                        out_cntr_v <= 0;
                         instr_v <= instr_v + 1;
-                   end
+                    end
+                    else
+                        out_cntr_v <= out_cntr_v + 1;
                 end
             end
-         
-            7: begin    /* Instruction 7: Check if all tests completed and decide what to do */
-                if (cur_test_v < get_num_tests("trivium_ref_in.txt") - 1) begin
+            
+            8: begin    /* Instruction 8: Check if all tests completed and decide what to do */
+                pop_i <= 0;
+                if (cur_test_v < num_tests_v - 1) begin
                     cur_test_v <= cur_test_v + 1;
                     instr_v <= 0;
                 end
@@ -419,6 +366,7 @@ always @(posedge clk_i or negedge n_rst_i) begin
             end
          
             default: begin
+                $fclose(fd_v);
                 $display("Tests successfully completed!");
                 $finish;
             end
@@ -0,0 +1,700 @@
+/*
+ * axi_trivium_sim - Cycle-accurate simulation of the AXI IP core with Verilator
+ *
+ * Usage: Vaxi_trivium_v1_0 [-n <tests>] [-q] [<vector_file>]
+ *
+ * The tests are run four times through lane 0 of axi_trivium_v1_0, once per
+ * data interface:
+ *  - reg:    Key, IV and data are transferred via AXI4-Lite like the Linux
+ *            driver does it. The control register is read to learn the FIFO
+ *            levels, then the available results are read and as many words
+ *            as there is room for are written to the data queue register.
+ *  - burst:  Like reg, but the results are read from the pop window and the
+ *            words written to the push window of the full AXI4 slave, each
+ *            as a single INCR burst.
+ *  - stream: Key and IV are written via AXI4-Lite, the data is streamed
+ *            through the AXI4-Stream interfaces as one message per test, with
+ *            the ciphertext stream always ready.
+ *  - dma:    The DMA engine encrypts each test from a memory model attached
+ *            to the AXI4 master. The test is split into two descriptors, the
+ *            first loading key and IV from a session block and writing to a
+ *            separate buffer, the second continuing the key stream in place.
+ *            The source buffers are not 4 KiB aligned, so bursts are split
+ *            at the boundaries. The tail register is written once per test,
+ *            then the control register is polled until the engine is idle.
+ * The AXI4-Lite master issues one transaction at a time, as the slave
+ * expects no outstanding transactions. Reported are the cycles per word, the
+ * cycles from the Init write until Init done is read back and the AXI4-Lite
+ * and burst transactions per word including key and IV setup (for dma, the
+ * bursts of the engine).
+ */
+#include <algorithm>            /* std::min() */
+#include <memory>               /* std::unique_ptr */
+#include <stdexcept>            /* std::runtime_error */
+#include <vector>               /* std::vector */
+#include "Vaxi_trivium_v1_0.h"  /* Verilated model */
+#include "sim_common.hpp"       /* Drivers, software model and report */
+
+namespace {
+
+/* Register byte addresses of lane 0 and control bits */
+constexpr std::uint32_t REG_CONFIG = 0*4;
+constexpr std::uint32_t REG_KEY_LO = 1*4;
+constexpr std::uint32_t REG_IV_LO = 4*4;
+constexpr std::uint32_t REG_ODAT = 8*4;
+constexpr std::uint32_t REG_DATQ = 11*4;
+constexpr std::uint32_t CONF_INIT = 0x01;
+constexpr std::uint32_t CONF_STOP = 0x02;
+constexpr std::uint32_t CONF_STREAM = 0x08;
+constexpr std::uint32_t CONF_IDONE = 1u << 9;
+constexpr std::uint32_t CONF_DIDLE = 1u << 11;
+constexpr std::uint32_t REG_ISR = 30*4;
+constexpr std::uint32_t ISR_DMA = 1u << 3;
+
+/* DMA engine register byte addresses and bits */
+constexpr std::uint32_t REG_DMA_CTRL = 12*4;
+constexpr std::uint32_t REG_DMA_BASE = 13*4;
+constexpr std::uint32_t REG_DMA_TAIL = 14*4;
+constexpr std::uint32_t REG_DMA_STAT = 31*4;
+constexpr std::uint32_t DMA_CTRL_EN = 0x01;
+constexpr std::uint32_t DMA_RING_LOG2 = 4;
+constexpr std::uint32_t DESC_KEY_IV = 0x01;
+constexpr std::uint32_t DESC_EVENT = 1u << 31;
+constexpr std::uint32_t DESC_DONE = 1u << 31;
+
+/* Memory layout of the DMA mode, the buffers start off 4 KiB boundaries */
+constexpr std::uint32_t MEM_RING = 0x00000;
+constexpr std::uint32_t MEM_SESSION = 0x01000;
+constexpr std::uint32_t MEM_SRC = 0x10000 + 0xf4;
+constexpr unsigned int MEM_LATENCY = 8; /* Cycles from a read address to its first beat */
+
+/* FIFO window byte addresses of lane 0 */
+constexpr std::uint32_t WIN_PUSH = 0;
+constexpr std::uint32_t WIN_POP = 1u << 12;
+
+using model_type = Vaxi_trivium_v1_0;
+using clock_type = sim::clocked<model_type>;
+
+/* AXI4-Lite master, one transaction at a time */
+class axi_lite {
+public:
+    axi_lite(model_type &top, clock_type &clk, sim::stats &st) : top_(top), clk_(clk), st_(st) {}
+
+    /*
+     * write - Write a register
+     *
+     * @addr: Byte address
+     * @dat: Value
+     *
+     * Additional information: Address and data are offered together, the
+     * slave accepts both in the same cycle.
+     */
+    void write(std::uint32_t addr, std::uint32_t dat) {
+        bool aw_done = false, w_done = false;
+        std::uint64_t t0 = clk_.cycles;
+
+        top_.s00_axi_awaddr = addr;
+        top_.s00_axi_wdata = dat;
+        top_.s00_axi_wstrb = 0xf;
+        top_.s00_axi_awvalid = 1;
+        top_.s00_axi_wvalid = 1;
+        top_.s00_axi_bready = 1;
+        while ((!aw_done || !w_done) && !timeout(t0)) {
+            clk_.settle();
+            bool aw = top_.s00_axi_awready, w = top_.s00_axi_wready;
+
+            clk_.tick();
+            if (aw) {
+                aw_done = true;
+                top_.s00_axi_awvalid = 0;
+            }
+
+            if (w) {
+                w_done = true;
+                top_.s00_axi_wvalid = 0;
+            }
+        }
+
+        for (bool b = false; !b && !timeout(t0);) {
+            clk_.settle();
+            b = top_.s00_axi_bvalid;
+            clk_.tick();
+        }
+
+        top_.s00_axi_bready = 0;
+        st_.lite_txns++;
+    }
+
+    /*
+     * read - Read a register
+     *
+     * @addr: Byte address
+     *
+     * Return value read
+     */
+    std::uint32_t read(std::uint32_t addr) {
+        std::uint64_t t0 = clk_.cycles;
+        std::uint32_t dat = 0;
+
+        top_.s00_axi_araddr = addr;
+        top_.s00_axi_arvalid = 1;
+        top_.s00_axi_rready = 1;
+        for (bool ar = false; !ar && !timeout(t0);) {
+            clk_.settle();
+            ar = top_.s00_axi_arready;
+            clk_.tick();
+        }
+
+        top_.s00_axi_arvalid = 0;
+        for (bool r = false; !r && !timeout(t0);) {
+            clk_.settle();
+            r = top_.s00_axi_rvalid;
+            dat = top_.s00_axi_rdata;
+            clk_.tick();
+        }
+
+        top_.s00_axi_rready = 0;
+        st_.lite_txns++;
+        return dat;
+    }
+
+    /* Load key and IV, leaving the lane in the given data mode and waiting for the warm-up phase */
+    void setup(const trivium::vec_record &rec, std::uint32_t mode) {
+        std::uint32_t key[3], iv[3];
+        std::uint64_t t0;
+
+        sim::key_words(rec.key, key);
+        sim::key_words(rec.iv, iv);
+
+        /* Stop the lane, which also clears Init done */
+        write(REG_CONFIG, mode | CONF_STOP);
+        for (unsigned int j = 0; j < 3; j++)
+            write(REG_KEY_LO + 4*j, key[j]);
+
+        for (unsigned int j = 0; j < 3; j++)
+            write(REG_IV_LO + 4*j, iv[j]);
+
+        t0 = clk_.cycles;
+        write(REG_CONFIG, mode | CONF_INIT);
+        while (!(read(REG_CONFIG) & CONF_IDONE) && !timeout(t0))
+            ;
+
+        st_.init_cycles += clk_.cycles - t0;
+    }
+
+    /* Checks whether an operation started at cycle t0 takes too long, counting it as an error once */
+    bool timeout(std::uint64_t t0) {
+        if (clk_.cycles - t0 <= sim::WATCHDOG_CYCLES)
+            return false;
+
+        if (!timed_out_) {
+            std::printf("ERROR: AXI4-Lite transaction or initialization timed out\n");
+            st_.errors++;
+            timed_out_ = true;
+        }
+
+        return true;
+    }
+
+    bool timed_out() const { return timed_out_; }
+
+private:
+    model_type  &top_;
+    clock_type  &clk_;
+    sim::stats  &st_;
+    bool        timed_out_ = false;
+};
+
+/* AXI4 master for the FIFO windows, one INCR burst at a time */
+class axi_full {
+public:
+    axi_full(model_type &top, clock_type &clk, sim::stats &st, axi_lite &lite)
+        : top_(top), clk_(clk), st_(st), lite_(lite) {}
+
+    /*
+     * write - Write a burst
+     *
+     * @addr: Byte address
+     * @dat: Words, at most 256
+     *
+     * Additional information: The address is offered first, the data beats
+     * follow back to back once it has been accepted.
+     */
+    void write(std::uint32_t addr, const std::vector<std::uint32_t> &dat) {
+        std::uint64_t t0 = clk_.cycles;
+
+        top_.s01_axi_awaddr = addr;
+        top_.s01_axi_awlen = static_cast<std::uint8_t>(dat.size() - 1);
+        top_.s01_axi_awsize = 2;
+        top_.s01_axi_awburst = 1;
+        top_.s01_axi_awvalid = 1;
+        for (bool aw = false; !aw && !lite_.timeout(t0);) {
+            clk_.settle();
+            aw = top_.s01_axi_awready;
+            clk_.tick();
+        }
+
+        top_.s01_axi_awvalid = 0;
+        top_.s01_axi_wstrb = 0xf;
+        for (std::size_t i = 0; i < dat.size() && !lite_.timeout(t0);) {
+            top_.s01_axi_wdata = dat[i];
+            top_.s01_axi_wlast = i == dat.size() - 1;
+            top_.s01_axi_wvalid = 1;
+            clk_.settle();
+            bool w = top_.s01_axi_wready;
+
+            clk_.tick();
+            if (w)
+                i++;
+        }
+
+        top_.s01_axi_wvalid = 0;
+        top_.s01_axi_wlast = 0;
+        top_.s01_axi_bready = 1;
+        for (bool b = false; !b && !lite_.timeout(t0);) {
+            clk_.settle();
+            b = top_.s01_axi_bvalid;
+            clk_.tick();
+        }
+
+        top_.s01_axi_bready = 0;
+        st_.burst_txns++;
+    }
+
+    /*
+     * read - Read a burst
+     *
+     * @addr: Byte address
+     * @num_words: Number of words, at most 256
+     * @dat: Words read
+     */
+    void read(std::uint32_t addr, std::size_t num_words, std::vector<std::uint32_t> &dat) {
+        std::uint64_t t0 = clk_.cycles;
+
+        dat.clear();
+        top_.s01_axi_araddr = addr;
+        top_.s01_axi_arlen = static_cast<std::uint8_t>(num_words - 1);
+        top_.s01_axi_arsize = 2;
+        top_.s01_axi_arburst = 1;
+        top_.s01_axi_arvalid = 1;
+        for (bool ar = false; !ar && !lite_.timeout(t0);) {
+            clk_.settle();
+            ar = top_.s01_axi_arready;
+            clk_.tick();
+        }
+
+        top_.s01_axi_arvalid = 0;
+        top_.s01_axi_rready = 1;
+        for (bool last = false; !last && !lite_.timeout(t0);) {
+            clk_.settle();
+            if (top_.s01_axi_rvalid) {
+                dat.push_back(top_.s01_axi_rdata);
+                last = top_.s01_axi_rlast;
+            }
+
+            clk_.tick();
+        }
+
+        top_.s01_axi_rready = 0;
+        if (dat.size() != num_words) {
+            std::printf("ERROR: Read burst of %zu words returned %zu words\n", num_words, dat.size());
+            st_.errors++;
+        }
+
+        st_.burst_txns++;
+    }
+
+private:
+    model_type  &top_;
+    clock_type  &clk_;
+    sim::stats  &st_;
+    axi_lite    &lite_;
+};
+
+/*
+ * AXI4 memory model for the DMA engine, serving one read and one write burst
+ * at a time. Read data follows the address after a fixed latency. Bursts
+ * crossing a 4 KiB boundary and misplaced WLAST are counted as errors.
+ */
+class axi_mem {
+public:
+    axi_mem(model_type &top, sim::stats &st) : top_(top), st_(st) {}
+
+    /* Word at a byte address, the memory grows as needed */
+    std::uint32_t &at(std::uint32_t addr) {
+        if (addr/4 >= mem_.size())
+            mem_.resize(addr/4 + 1);
+
+        return mem_[addr/4];
+    }
+
+    /*
+     * edge - Clock the model
+     *
+     * @after: Called after the rising edge rather than before it
+     *
+     * Additional information: Before the edge, the handshakes of all channels
+     * are sampled. After the edge, they take effect and the outputs towards
+     * the master are driven for the next cycle.
+     */
+    void edge(bool after) {
+        if (!after) {
+            top_.eval();
+            ar_ = top_.m00_axi_arvalid && top_.m00_axi_arready;
+            r_ = top_.m00_axi_rvalid && top_.m00_axi_rready;
+            aw_ = top_.m00_axi_awvalid && top_.m00_axi_awready;
+            w_ = top_.m00_axi_wvalid && top_.m00_axi_wready;
+            b_ = top_.m00_axi_bvalid && top_.m00_axi_bready;
+            ar_addr_ = top_.m00_axi_araddr;
+            ar_len_ = top_.m00_axi_arlen;
+            aw_addr_ = top_.m00_axi_awaddr;
+            aw_len_ = top_.m00_axi_awlen;
+            w_dat_ = top_.m00_axi_wdata;
+            w_last_ = top_.m00_axi_wlast;
+            return;
+        }
+
+        if (ar_) {
+            check_burst(ar_addr_, ar_len_);
+            rd_addr_ = ar_addr_;
+            rd_left_ = ar_len_ + 1u;
+            rd_wait_ = MEM_LATENCY;
+            st_.burst_txns++;
+        }
+        else if (r_) {
+            rd_addr_ += 4;
+            rd_left_--;
+        }
+        else if (rd_wait_)
+            rd_wait_--;
+
+        if (aw_) {
+            check_burst(aw_addr_, aw_len_);
+            wr_addr_ = aw_addr_;
+            wr_left_ = aw_len_ + 1u;
+            st_.burst_txns++;
+        }
+        else if (w_) {
+            at(wr_addr_) = w_dat_;
+            wr_addr_ += 4;
+            wr_left_--;
+            if (w_last_ != (wr_left_ == 0))
+                error("misplaced WLAST");
+
+            b_pend_ = wr_left_ == 0;
+        }
+        else if (b_)
+            b_pend_ = false;
+
+        top_.m00_axi_arready = !rd_left_;
+        top_.m00_axi_rvalid = rd_left_ && !rd_wait_;
+        top_.m00_axi_rdata = rd_left_ ? at(rd_addr_) : 0;
+        top_.m00_axi_rlast = rd_left_ == 1;
+        top_.m00_axi_rresp = 0;
+        top_.m00_axi_awready = !wr_left_ && !b_pend_;
+        top_.m00_axi_wready = wr_left_ != 0;
+        top_.m00_axi_bvalid = b_pend_;
+        top_.m00_axi_bresp = 0;
+        top_.eval();
+    }
+
+private:
+    void check_burst(std::uint32_t addr, unsigned int len) {
+        if ((addr & 0xfff) + 4*(len + 1) > 0x1000)
+            error("burst crosses a 4 KiB boundary");
+    }
+
+    void error(const char *p_msg) {
+        if (st_.errors < sim::MAX_REPORTS)
+            std::printf("ERROR: DMA engine: %s\n", p_msg);
+        st_.errors++;
+    }
+
+    model_type      &top_;
+    sim::stats      &st_;
+    std::vector<std::uint32_t> mem_;
+    bool            ar_ = false, r_ = false, aw_ = false, w_ = false, b_ = false, w_last_ = false;
+    std::uint32_t   ar_addr_ = 0, aw_addr_ = 0, w_dat_ = 0;
+    unsigned int    ar_len_ = 0, aw_len_ = 0;
+    std::uint32_t   rd_addr_ = 0, wr_addr_ = 0;
+    unsigned int    rd_left_ = 0, rd_wait_ = 0, wr_left_ = 0;
+    bool            b_pend_ = false;
+};
+
+/*
+ * run_reg - Run a test through the AXI4-Lite data registers
+ *
+ * @lite: AXI4-Lite master
+ * @clk: Clock of the model
+ * @rec: Test
+ * @st: Results
+ *
+ * Return true unless the test hung
+ */
+bool run_reg(axi_lite &lite, clock_type &clk, const trivium::vec_record &rec, sim::stats &st) {
+    sim::model mdl(rec);
+    std::size_t n = mdl.size(), in = 0, out = 0;
+    std::uint64_t t0;
+
+    lite.setup(rec, 0);
+    t0 = clk.cycles;
+    while (out < n && !lite.timed_out()) {
+        std::uint32_t conf = lite.read(REG_CONFIG);
+        unsigned int num_out = conf >> 24, num_free = (conf >> 16) & 0xff;
+
+        for (unsigned int i = 0; i < num_out && out < n; i++, out++)
+            mdl.check(lite.read(REG_ODAT), st.tests, st);
+
+        for (unsigned int i = 0; i < num_free && in < n; i++)
+            lite.write(REG_DATQ, mdl.pt(in++));
+
+        if (!num_out && !num_free)
+            lite.timeout(t0);
+    }
+
+    st.data_cycles += clk.cycles - t0;
+    st.words += n;
+    st.tests++;
+    return out == n;
+}
+
+/*
+ * run_burst - Run a test through the FIFO windows
+ *
+ * @lite: AXI4-Lite master
+ * @win: AXI4 master
+ * @clk: Clock of the model
+ * @rec: Test
+ * @st: Results
+ *
+ * Return true unless the test hung
+ */
+bool run_burst(axi_lite &lite, axi_full &win, clock_type &clk, const trivium::vec_record &rec, sim::stats &st) {
+    sim::model mdl(rec);
+    std::size_t n = mdl.size(), in = 0, out = 0;
+    std::vector<std::uint32_t> buf;
+    std::uint64_t t0;
+
+    lite.setup(rec, 0);
+    t0 = clk.cycles;
+    while (out < n && !lite.timed_out()) {
+        std::uint32_t conf = lite.read(REG_CONFIG);
+        std::size_t num_out = std::min<std::size_t>(conf >> 24, n - out);
+        std::size_t num_free = std::min<std::size_t>((conf >> 16) & 0xff, n - in);
+
+        if (num_out) {
+            win.read(WIN_POP, num_out, buf);
+            for (std::uint32_t w : buf)
+                mdl.check(w, st.tests, st);
+
+            out += num_out;
+        }
+
+        if (num_free) {
+            buf.clear();
+            for (std::size_t i = 0; i < num_free; i++)
+                buf.push_back(mdl.pt(in++));
+
+            win.write(WIN_PUSH, buf);
+        }
+
+        if (!num_out && !num_free)
+            lite.timeout(t0);
+    }
+
+    st.data_cycles += clk.cycles - t0;
+    st.words += n;
+    st.tests++;
+    return out == n;
+}
+
+/*
+ * run_dma - Run a test through the DMA engine
+ *
+ * @lite: AXI4-Lite master
+ * @mem: Memory model
+ * @clk: Clock of the model
+ * @rec: Test
+ * @tail: Tail index of the ring, advanced by the two descriptors of the test
+ * @st: Results
+ *
+ * Return true unless the test hung
+ */
+bool run_dma(axi_lite &lite, axi_mem &mem, clock_type &clk, const trivium::vec_record &rec, std::uint32_t &tail,
+             sim::stats &st) {
+    sim::model mdl(rec);
+    std::size_t n = mdl.size(), half = n/2;
+    std::uint32_t dst = (MEM_SRC + 4*n + 0xfff) & ~0xfffu, key[3], iv[3];
+    std::uint32_t desc[2] = {MEM_RING + 32*tail, MEM_RING + 32*((tail + 1) % (1u << DMA_RING_LOG2))};
+    std::uint64_t t0;
+
+    sim::key_words(rec.key, key);
+    sim::key_words(rec.iv, iv);
+    for (unsigned int j = 0; j < 3; j++) {
+        mem.at(MEM_SESSION + 4*j) = key[j];
+        mem.at(MEM_SESSION + 12 + 4*j) = iv[j];
+    }
+
+    for (std::size_t i = 0; i < n; i++)
+        mem.at(MEM_SRC + 4*i) = mdl.pt(i);
+
+    /* Key and IV from the session block to a separate buffer, then the rest in place */
+    const std::uint32_t words[2][8] = {
+        {DESC_KEY_IV, MEM_SRC, dst, static_cast<std::uint32_t>(half), MEM_SESSION, 0, 0, 0},
+        {DESC_EVENT, MEM_SRC + 4*static_cast<std::uint32_t>(half), MEM_SRC + 4*static_cast<std::uint32_t>(half),
+         static_cast<std::uint32_t>(n - half), 0, 0, 0, 0}
+    };
+    for (unsigned int d = 0; d < 2; d++)
+        for (unsigned int j = 0; j < 8; j++)
+            mem.at(desc[d] + 4*j) = words[d][j];
+
+    tail = (tail + 2) % (1u << DMA_RING_LOG2);
+    t0 = clk.cycles;
+    lite.write(REG_DMA_TAIL, tail);
+    while (!(lite.read(REG_CONFIG) & CONF_DIDLE) && !lite.timeout(t0))
+        ;
+
+    st.data_cycles += clk.cycles - t0;
+    if (!(lite.read(REG_ISR) & ISR_DMA) || lite.read(REG_DMA_STAT) ||
+        mem.at(desc[0] + 28) != DESC_DONE || mem.at(desc[1] + 28) != DESC_DONE) {
+        std::printf("ERROR: Test %llu: DMA event or status missing\n", static_cast<unsigned long long>(st.tests));
+        st.errors++;
+    }
+
+    lite.write(REG_ISR, ISR_DMA);
+    for (std::size_t i = 0; i < n; i++)
+        mdl.check(mem.at((i < half ? dst : MEM_SRC) + 4*i), st.tests, st);
+
+    st.words += n;
+    st.tests++;
+    return !lite.timed_out();
+}
+
+/*
+ * run_stream - Run a test through the AXI4-Stream interfaces
+ *
+ * @lite: AXI4-Lite master
+ * @top: Model
+ * @clk: Clock of the model
+ * @rec: Test
+ * @st: Results
+ *
+ * Return true unless the test hung
+ */
+bool run_stream(axi_lite &lite, model_type &top, clock_type &clk, const trivium::vec_record &rec, sim::stats &st) {
+    sim::model mdl(rec);
+    std::size_t n = mdl.size(), in = 0, out = 0;
+    std::uint64_t t0, progress;
+
+    lite.setup(rec, CONF_STREAM);
+    t0 = progress = clk.cycles;
+    top.m00_axis_tready = 1;
+    while (out < n) {
+        top.s00_axis_tvalid = in < n;
+        top.s00_axis_tdata = in < n ? mdl.pt(in) : 0;
+        top.s00_axis_tlast = in == n - 1;
+        clk.settle();
+
+        bool s_acc = top.s00_axis_tvalid && top.s00_axis_tready;
+        if (top.s00_axis_tvalid && !s_acc)
+            st.stall_cycles++;
+
+        if (top.m00_axis_tvalid) {
+            mdl.check(top.m00_axis_tdata, st.tests, st);
+            if (top.m00_axis_tlast != (out == n - 1)) {
+                std::printf("ERROR: Test %llu, word %zu: incorrect TLAST\n", static_cast<unsigned long long>(st.tests), out);
+                st.errors++;
+            }
+
+            out++;
+            progress = clk.cycles;
+        }
+
+        clk.tick();
+        if (s_acc)
+            in++;
+
+        if (clk.cycles - progress > sim::WATCHDOG_CYCLES) {
+            std::printf("ERROR: Test %llu: no output after word %zu\n", static_cast<unsigned long long>(st.tests), out);
+            st.errors++;
+            break;
+        }
+    }
+
+    top.s00_axis_tvalid = 0;
+    top.s00_axis_tlast = 0;
+    top.m00_axis_tready = 0;
+    st.data_cycles += clk.cycles - t0;
+    st.words += n;
+    st.tests++;
+    return out == n;
+}
+
+}
+
+int main(int argc, char **argv) {
+    sim::options opts;
+
+    if (!sim::parse_options(argc, argv, opts))
+        return EXIT_FAILURE;
+
+    std::unique_ptr<trivium::vec_file> p_vecs;
+    try {
+        p_vecs = std::make_unique<trivium::vec_file>(opts.p_vec_file);
+    }
+    catch (const std::runtime_error &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    auto p_ctx = std::make_unique<VerilatedContext>();
+    auto p_top = std::make_unique<model_type>(p_ctx.get());
+    model_type &top = *p_top;
+    clock_type clk(top, top.s00_axi_aclk);
+    std::uint64_t errors = 0;
+
+    /* The AXI reset is synchronous */
+    top.s00_axi_aresetn = 0;
+    clk.settle();
+    for (unsigned int i = 0; i < 4; i++)
+        clk.tick();
+
+    top.s00_axi_aresetn = 1;
+    clk.tick();
+
+    static const char *const p_names[] = {"axi-reg", "axi-burst", "axi-stream", "axi-dma"};
+    for (unsigned int mode = 0; mode < 4; mode++) {
+        sim::stats st;
+        axi_lite lite(top, clk, st);
+        axi_full win(top, clk, st, lite);
+        axi_mem mem(top, st);
+        std::uint32_t tail = 0;
+        std::uint64_t c0 = clk.cycles;
+        auto start = std::chrono::steady_clock::now();
+
+        if (mode == 3) {
+            clk.on_edge = [&mem](bool after) { mem.edge(after); };
+            lite.write(REG_DMA_BASE, MEM_RING);
+            lite.write(REG_DMA_CTRL, DMA_CTRL_EN | DMA_RING_LOG2 << 8);
+        }
+
+        for (const trivium::vec_record &rec : *p_vecs) {
+            if (st.tests == opts.max_tests)
+                break;
+
+            bool ok = mode == 0 ? run_reg(lite, clk, rec, st) :
+                      mode == 1 ? run_burst(lite, win, clk, rec, st) :
+                      mode == 2 ? run_stream(lite, top, clk, rec, st) : run_dma(lite, mem, clk, rec, tail, st);
+            if (!ok)
+                break;
+        }
+
+        clk.on_edge = nullptr;
+
+        sim::report(p_names[mode], st, clk.cycles - c0, sim::seconds_since(start), opts.header && mode == 0);
+        errors += st.errors;
+    }
+
+    top.final();
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
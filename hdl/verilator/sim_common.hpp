@@ -0,0 +1,209 @@
+#ifndef __SIM_COMMON_HPP
+#define __SIM_COMMON_HPP
+
+/*
+ * Common parts of the Verilator drivers of trivium_top and the AXI IP core
+ *
+ * The drivers stream the tests of a binary vector file (see
+ * sw/libtrivium/trivium_vectors.hpp) through the model. Every output word is
+ * compared right away against trivium::context of libtrivium, which runs in
+ * lockstep with the model, and the software model is in turn checked against
+ * the ciphertext of the vector file.
+ *
+ * The configuration of the model is passed by the Makefile, both as -G
+ * parameters to Verilator and as the macros below to the drivers.
+ */
+
+#include <chrono>       /* std::chrono::steady_clock */
+#include <cstdint>      /* Fixed size types */
+#include <cstdio>       /* std::printf() */
+#include <cstdlib>      /* std::strtoull() */
+#include <cstring>      /* std::memcpy() */
+#include <functional>   /* std::function */
+#include <unistd.h>     /* getopt() */
+#include "verilated.h"  /* Verilator runtime */
+#include "trivium.hpp"  /* Software model */
+#include "trivium_vectors.hpp"  /* Binary test vector format */
+
+#ifndef BITS_PER_CYCLE
+#define BITS_PER_CYCLE 1
+#endif
+#ifndef FIFO_DEPTH_LOG2
+#define FIFO_DEPTH_LOG2 2
+#endif
+#ifndef KS_FIFO_DEPTH_LOG2
+#define KS_FIFO_DEPTH_LOG2 2
+#endif
+
+namespace sim {
+
+constexpr std::uint64_t WATCHDOG_CYCLES = 100000;   /* Cycles without progress after which a test fails */
+constexpr unsigned int MAX_REPORTS = 10;            /* Mismatches reported in detail */
+
+/* Command line options */
+struct options {
+    const char      *p_vec_file;    /* Vector file */
+    std::uint64_t   max_tests;      /* Number of tests to run at most */
+    bool            header;         /* Print the header of the result table */
+};
+
+/* Results of a run */
+struct stats {
+    std::uint64_t   tests = 0;          /* Tests run */
+    std::uint64_t   words = 0;          /* Words encrypted */
+    std::uint64_t   init_cycles = 0;    /* Cycles from the init requests until the cores were ready */
+    std::uint64_t   data_cycles = 0;    /* Cycles from the first input word to the last output word of the tests */
+    std::uint64_t   lite_txns = 0;      /* AXI4-Lite transactions */
+    std::uint64_t   burst_txns = 0;     /* AXI4 burst transactions */
+    std::uint64_t   stall_cycles = 0;   /* Cycles in which an input word was offered but not accepted */
+    std::uint64_t   errors = 0;         /* Mismatching words and protocol errors */
+};
+
+/*
+ * parse_options - Parse the command line
+ *
+ * @argc: Number of arguments
+ * @argv: Arguments
+ * @opts: Resulting options
+ *
+ * Return true on success
+ */
+inline bool parse_options(int argc, char **argv, options &opts) {
+    int opt;
+
+    opts = {"trivium_ref.bin", UINT64_MAX, true};
+    while ((opt = getopt(argc, argv, "n:q")) != -1) {
+        switch (opt) {
+        case 'n':
+            opts.max_tests = std::strtoull(optarg, nullptr, 0);
+            break;
+        case 'q':
+            opts.header = false;
+            break;
+        default:
+            std::fprintf(stderr, "Usage: %s [-n <tests>] [-q] [<vector_file>]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (optind < argc)
+        opts.p_vec_file = argv[optind];
+
+    return true;
+}
+
+/* Clock of a model, counting the rising edges */
+template <class M>
+struct clocked {
+    M               &m;         /* Model */
+    CData           &clk;       /* Clock input of the model */
+    std::uint64_t   cycles = 0; /* Rising edges so far */
+    std::function<void(bool)> on_edge;  /* Bus models, called before (false) and after (true) each rising edge */
+
+    clocked(M &model, CData &clk_in) : m(model), clk(clk_in) {}
+
+    /* Propagate changed inputs through the combinational logic */
+    void settle() { m.eval(); }
+
+    /* One clock cycle, the outputs reflect the registers after the rising edge afterwards */
+    void tick() {
+        if (on_edge)
+            on_edge(false);
+
+        clk = 1;
+        m.eval();
+        clk = 0;
+        m.eval();
+        cycles++;
+        if (on_edge)
+            on_edge(true);
+    }
+};
+
+/* Little-endian 32-bit word of a byte buffer */
+inline std::uint32_t le32(const std::uint8_t *p) {
+    return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+           static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+/* Key or IV as the three 32-bit register words of the core, least significant word first */
+inline void key_words(std::span<const std::uint8_t, trivium::KEY_LEN> key, std::uint32_t *p_words) {
+    p_words[0] = le32(key.data());
+    p_words[1] = le32(key.data() + 4);
+    p_words[2] = static_cast<std::uint32_t>(key[8]) | static_cast<std::uint32_t>(key[9]) << 8;
+}
+
+/*
+ * model - Software model of a test
+ *
+ * The expected output words are produced in order as the hardware delivers
+ * them, i.e. in lockstep with the simulation.
+ */
+class model {
+public:
+    explicit model(const trivium::vec_record &rec) : rec_(rec), ctx_(rec.key, rec.iv) {}
+
+    /* Number of words of the test */
+    std::size_t size() const { return rec_.pt.size()/4; }
+
+    /* Plaintext word i */
+    std::uint32_t pt(std::size_t i) const { return le32(rec_.pt.data() + 4*i); }
+
+    /*
+     * Compares the next output word of the hardware against the model, and
+     * the model against the vector file. Mismatches are counted in st.
+     */
+    void check(std::uint32_t hw, std::uint64_t test, stats &st) {
+        std::uint8_t buf[4];
+
+        std::memcpy(buf, rec_.pt.data() + 4*idx_, 4);
+        ctx_.encrypt(buf);
+        std::uint32_t sw = le32(buf), ref = le32(rec_.ct.data() + 4*idx_);
+
+        if (hw != sw || sw != ref) {
+            if (st.errors < MAX_REPORTS)
+                std::printf("ERROR: Test %llu, word %zu: hardware %08x, model %08x, vector file %08x\n",
+                            static_cast<unsigned long long>(test), idx_, hw, sw, ref);
+            st.errors++;
+        }
+
+        idx_++;
+    }
+
+private:
+    const trivium::vec_record &rec_;
+    trivium::context ctx_;
+    std::size_t idx_ = 0;   /* Next word to check */
+};
+
+/*
+ * report - Print the results of a run as a row of the result table
+ *
+ * @p_model: Name of the model and mode
+ * @st: Results
+ * @cycles: Simulated cycles of the run
+ * @secs: Wall-clock time of the run
+ * @header: Print the header first
+ */
+inline void report(const char *p_model, const stats &st, std::uint64_t cycles, double secs, bool header) {
+    double words = st.words ? static_cast<double>(st.words) : 1.0;
+    double tests = st.tests ? static_cast<double>(st.tests) : 1.0;
+
+    if (header)
+        std::printf("%-10s %4s %4s %4s %8s %10s %10s %10s %10s %10s %8s\n", "model", "bits", "fifo", "ks",
+                    "tests", "words", "cyc/word", "init_cyc", "stall/word", "bus/word", "Mcyc/s");
+
+    std::printf("%-10s %4d %4d %4d %8llu %10llu %10.3f %10.1f %10.3f %10.3f %8.2f\n", p_model, BITS_PER_CYCLE,
+                FIFO_DEPTH_LOG2, KS_FIFO_DEPTH_LOG2, static_cast<unsigned long long>(st.tests),
+                static_cast<unsigned long long>(st.words), st.data_cycles/words, st.init_cycles/tests,
+                st.stall_cycles/words, (st.lite_txns + st.burst_txns)/words, secs > 0.0 ? cycles/secs*1e-6 : 0.0);
+}
+
+/* Wall-clock seconds since start */
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * trivium_top_sim - Cycle-accurate simulation of trivium_top with Verilator
+ *
+ * Usage: Vtrivium_top [-n <tests>] [-q] [<vector_file>]
+ *
+ * Every test loads key and IV one word per cycle, initializes the cipher and
+ * streams its words through the core: a word is queued whenever the input
+ * FIFO has room and a result is popped whenever the output FIFO holds one,
+ * like hdl/tb/trivium_top_tb.v does, just without its idle cycles. Each
+ * result is checked against the software model as it is popped.
+ *
+ * Reported are the cycles per word from the first queued word to the last
+ * popped one, the cycles from asserting init_i until the core is no longer
+ * busy and the cycles in which a word could not be queued because the input
+ * FIFO was full.
+ */
+#include <memory>               /* std::unique_ptr */
+#include <stdexcept>            /* std::runtime_error */
+#include "Vtrivium_top.h"       /* Verilated model */
+#include "sim_common.hpp"       /* Drivers, software model and report */
+
+int main(int argc, char **argv) {
+    sim::options opts;
+    sim::stats st;
+
+    if (!sim::parse_options(argc, argv, opts))
+        return EXIT_FAILURE;
+
+    std::unique_ptr<trivium::vec_file> p_vecs;
+    try {
+        p_vecs = std::make_unique<trivium::vec_file>(opts.p_vec_file);
+    }
+    catch (const std::runtime_error &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    auto p_ctx = std::make_unique<VerilatedContext>();
+    auto p_top = std::make_unique<Vtrivium_top>(p_ctx.get());
+    Vtrivium_top &top = *p_top;
+    sim::clocked<Vtrivium_top> clk(top, top.clk_i);
+    const unsigned int depth = 1u << FIFO_DEPTH_LOG2;
+
+    /* Reset */
+    top.n_rst_i = 0;
+    clk.settle();
+    clk.tick();
+    top.n_rst_i = 1;
+    clk.tick();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const trivium::vec_record &rec : *p_vecs) {
+        sim::model mdl(rec);
+        std::uint32_t key[3], iv[3];
+        std::uint64_t t0, progress;
+
+        if (st.tests == opts.max_tests)
+            break;
+
+        /* Load key and IV */
+        sim::key_words(rec.key, key);
+        sim::key_words(rec.iv, iv);
+        for (unsigned int j = 0; j < 3; j++) {
+            top.ld_reg_a_i = 1u << j;
+            top.ld_dat_i = key[j];
+            clk.tick();
+        }
+
+        top.ld_reg_a_i = 0;
+        for (unsigned int j = 0; j < 3; j++) {
+            top.ld_reg_b_i = 1u << j;
+            top.ld_dat_i = iv[j];
+            clk.tick();
+        }
+
+        top.ld_reg_b_i = 0;
+
+        /* Initialize the cipher and wait for the warm-up phase to complete */
+        t0 = clk.cycles;
+        top.init_i = 1;
+        do
+            clk.tick();
+        while (!top.busy_o && clk.cycles - t0 < sim::WATCHDOG_CYCLES);
+
+        top.init_i = 0;
+        while (top.busy_o && clk.cycles - t0 < sim::WATCHDOG_CYCLES)
+            clk.tick();
+
+        st.init_cycles += clk.cycles - t0;
+
+        /* Queue words and pop results in the same cycle where possible */
+        std::size_t n = mdl.size(), in = 0, out = 0;
+        t0 = progress = clk.cycles;
+        while (out < n) {
+            top.proc_i = in < n && top.in_lvl_o < depth;
+            if (top.proc_i)
+                top.dat_i = mdl.pt(in++);
+            else if (in < n)
+                st.stall_cycles++;
+
+            top.pop_i = top.out_lvl_o != 0;
+            if (top.pop_i) {
+                mdl.check(top.dat_o, st.tests, st);
+                out++;
+                progress = clk.cycles;
+            }
+
+            clk.tick();
+            if (clk.cycles - progress > sim::WATCHDOG_CYCLES) {
+                std::printf("ERROR: Test %llu: no output after word %zu\n",
+                            static_cast<unsigned long long>(st.tests), out);
+                st.errors++;
+                break;
+            }
+        }
+
+        top.proc_i = 0;
+        top.pop_i = 0;
+        st.data_cycles += clk.cycles - t0;
+        st.words += n;
+        st.tests++;
+
+        if (out < n)
+            break;
+    }
+
+    double secs = sim::seconds_since(start);
+    top.final();
+
+    sim::report("top", st, clk.cycles, secs, opts.header);
+    return st.errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
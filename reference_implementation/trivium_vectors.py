@@ -0,0 +1,96 @@
+import mmap, struct, sys
+
+# Binary test vector format, see sw/libtrivium/trivium_vectors.hpp
+#
+# File header: magic "TRVV", version and number of tests. Every record holds
+# key and IV (10 bytes each, least significant byte first), the number of
+# 32-bit words and the plaintext and ciphertext words. All fields are
+# little-endian, so plaintext and ciphertext are the bytes of the message in
+# the order they are written to the core.
+VEC_MAGIC = b"TRVV"
+VEC_VERSION = 1
+FILE_HEADER = struct.Struct("<4sIQ")
+RECORD_HEADER = struct.Struct("<10s10sI")
+
+class VectorFile:
+    # Map a binary vector file into memory and check its header
+    def __init__(self, fileName):
+        with open(fileName, "rb") as f:
+            self.data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(self.data) < FILE_HEADER.size:
+            raise ValueError(fileName + " is no vector file")
+
+        magic, version, self.numTests = FILE_HEADER.unpack_from(self.data, 0)
+        if magic != VEC_MAGIC or version != VEC_VERSION:
+            raise ValueError(fileName + " is no vector file")
+
+    def __len__(self):
+        return self.numTests
+
+    # Iterate over the tests as (key, iv, pt, ct), the data being memoryviews of the mapping
+    def __iter__(self):
+        view = memoryview(self.data)
+        off = FILE_HEADER.size
+        for testNum in range(self.numTests):
+            key, iv, numWords = RECORD_HEADER.unpack_from(self.data, off)
+            off += RECORD_HEADER.size
+            if off + 8*numWords > len(self.data):
+                raise ValueError("Test " + str(testNum) + " exceeds the vector file")
+
+            yield key, iv, view[off:off + 4*numWords], view[off + 4*numWords:off + 8*numWords]
+            off += 8*numWords
+
+    def close(self):
+        self.data.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+# Read tests from the text format of trivium.py as (key, iv, pt, ct)
+def readText(inName, outName):
+    with open(inName) as inFile, open(outName) as outFile:
+        while True:
+            line = inFile.readline().strip()
+            if line == "." or line == "":
+                return
+
+            key = bytes.fromhex(line.zfill(20))[::-1]
+            iv = bytes.fromhex(inFile.readline().strip().zfill(20))[::-1]
+            pt = b""
+            ct = b""
+            line = inFile.readline().strip()
+            while line != "-":
+                pt += bytes.fromhex(line.zfill(8))[::-1]
+                line = inFile.readline().strip()
+
+            line = outFile.readline().strip()
+            while line != "-":
+                ct += bytes.fromhex(line.zfill(8))[::-1]
+                line = outFile.readline().strip()
+
+            yield key, iv, pt, ct
+
+# Write tests given as (key, iv, pt, ct) to a binary vector file
+def writeVectors(fileName, tests):
+    tests = list(tests)
+    with open(fileName, "wb") as f:
+        f.write(FILE_HEADER.pack(VEC_MAGIC, VEC_VERSION, len(tests)))
+        for key, iv, pt, ct in tests:
+            f.write(RECORD_HEADER.pack(bytes(key), bytes(iv), len(pt)//4))
+            f.write(bytes(pt))
+            f.write(bytes(ct))
+
+# Convert the text test vectors into a binary vector file
+def main():
+    if len(sys.argv) != 4:
+        print("Usage: " + sys.argv[0] + " <ref_in> <ref_out> <vector_file>")
+        exit(1)
+
+    writeVectors(sys.argv[3], readText(sys.argv[1], sys.argv[2]))
+
+if __name__ == "__main__":
+    main()
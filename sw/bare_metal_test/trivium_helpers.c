@@ -39,16 +39,16 @@ int encrypt_word(Xuint32 *p_pt, Xuint32 *p_ct) {
     if (0 == p_pt || 0 == p_ct)
         return XST_FAILURE;
 
-    /* Make sure the core is ready */
-    if (1 == REG_GET(REG_CONFIG, BIT_BUSY))
+    /* Make sure there is room in the input FIFO */
+    if (0 == REG_GET_BYTE(REG_CONFIG, SHIFT_IFREE))
         return XST_FAILURE;
 
     /* Write plaintext to core */
     REG_WR(REG_DAT_I, *p_pt);
 
-    /* Start computation and wait until output valid */
+    /* Queue the word and wait until output available */
     REG_SET(REG_CONFIG, BIT_PROC);
-    while (0 == REG_GET(REG_CONFIG, BIT_OVAL));
+    while (0 == REG_GET_BYTE(REG_CONFIG, SHIFT_OLVL));
 
     /* Read result into output buffer */
     *p_ct = REG_RD(REG_DAT_O);
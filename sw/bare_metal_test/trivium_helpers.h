@@ -23,7 +23,8 @@
 #define BIT_PROC    2
 #define BIT_BUSY    8
 #define BIT_IDONE   9
-#define BIT_OVAL    10
+#define SHIFT_IFREE 16
+#define SHIFT_OLVL  24
 
 /* Helper macros */
 #define REG_WR(IDX, DAT)    (*(BASE_ADDR + IDX) = DAT)
@@ -31,6 +32,7 @@
 #define REG_SET(IDX, BIT)   (*(BASE_ADDR + IDX) |= 1 << BIT)
 #define REG_USET(IDX_BIT)   (*(BASE_ADDR + IDX) &= ~(1 << BIT))
 #define REG_GET(IDX, BIT)   ((*(BASE_ADDR + IDX) & (1 << BIT)) >> BIT)
+#define REG_GET_BYTE(IDX, SHIFT)    ((*(BASE_ADDR + IDX) >> SHIFT) & 0xFF)
 
 /* Trivium related helper function declarations */
 int new_instance(Xuint32 *p_key, Xuint32 *p_iv);
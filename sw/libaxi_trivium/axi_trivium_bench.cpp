@@ -0,0 +1,115 @@
+/*
+ * axi_trivium_bench - Measure the request rate of libaxi_trivium
+ *
+ * Usage: axi_trivium_bench [-d <uio_device>] [-m <messages>]
+ *
+ * Every thread repeatedly claims a lane, loads key and IV, encrypts a
+ * message and releases the lane, messages requests in total per thread.
+ * Reported are requests and words per second and the average time spent
+ * claiming a lane and initializing it, for 1 up to twice the number of
+ * lanes threads and several message sizes. Without -d, the device is an
+ * anonymous software model, which measures the overhead of the library and
+ * the claims rather than the core.
+ */
+#include <algorithm>    /* std::max() */
+#include <atomic>       /* std::atomic */
+#include <chrono>       /* std::chrono::steady_clock */
+#include <cstdio>       /* std::printf() */
+#include <cstdlib>      /* std::strtoul() */
+#include <memory>       /* std::unique_ptr */
+#include <thread>       /* std::thread */
+#include <vector>       /* std::vector */
+#include <unistd.h>     /* getopt() */
+#include "axi_trivium_model.hpp"    /* Software model */
+#include "axi_trivium_uio.hpp"  /* Library interface */
+
+using clk = std::chrono::steady_clock;
+
+/* Nanoseconds between two points in time */
+static inline std::uint64_t ns_between(clk::time_point start, clk::time_point end) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+/* Keeps the compiler from discarding results */
+static std::atomic<std::uint32_t> sink;
+
+int main(int argc, char **argv) {
+    const char *p_uio = nullptr;
+    unsigned int num_msgs = 20000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:m:")) != -1) {
+        switch (opt) {
+        case 'd':
+            p_uio = optarg;
+            break;
+        case 'm':
+            num_msgs = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        default:
+            std::fprintf(stderr, "Usage: %s [-d <uio_device>] [-m <messages>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::unique_ptr<axi_trivium::model> p_model;
+        std::unique_ptr<axi_trivium::device> p_dev;
+
+        if (p_uio)
+            p_dev = std::make_unique<axi_trivium::device>(p_uio);
+        else {
+            p_model = std::make_unique<axi_trivium::model>(nullptr);
+            p_dev = std::make_unique<axi_trivium::device>(*p_model);
+        }
+
+        std::printf("%-8s %8s %12s %12s %10s %10s\n", "threads", "words", "req/s", "Mwords/s", "claim_ns", "init_ns");
+        for (unsigned int num_threads = 1; num_threads <= 2*p_dev->num_lanes(); num_threads *= 2) {
+            for (std::size_t num_words : {4, 64, 1024}) {
+                std::atomic<std::uint64_t> claim_ns{0}, init_ns{0};
+                std::vector<std::thread> threads;
+
+                auto start = clk::now();
+                for (unsigned int t = 0; t < num_threads; t++) {
+                    threads.emplace_back([&, t] {
+                        std::vector<std::uint32_t> buf(num_words, t);
+                        std::uint8_t key[trivium::KEY_LEN] = {static_cast<std::uint8_t>(t)}, iv[trivium::IV_LEN] = {};
+                        std::uint64_t claim_sum = 0, init_sum = 0;
+
+                        for (unsigned int i = 0; i < num_msgs; i++) {
+                            auto t0 = clk::now();
+                            axi_trivium::lane ln = p_dev->claim();
+                            auto t1 = clk::now();
+
+                            iv[0] = static_cast<std::uint8_t>(i);
+                            ln.init(key, iv);
+                            auto t2 = clk::now();
+
+                            ln.encrypt(buf, buf);
+                            claim_sum += ns_between(t0, t1);
+                            init_sum += ns_between(t1, t2);
+                        }
+
+                        sink += buf[0];
+                        claim_ns += claim_sum;
+                        init_ns += init_sum;
+                    });
+                }
+
+                for (std::thread &th : threads)
+                    th.join();
+
+                double secs = std::chrono::duration<double>(clk::now() - start).count();
+                double reqs = static_cast<double>(num_threads)*num_msgs;
+                std::printf("%-8u %8zu %12.0f %12.2f %10.1f %10.1f\n", num_threads, num_words, reqs/secs,
+                            reqs*num_words/secs*1e-6, claim_ns/reqs, init_ns/reqs);
+            }
+        }
+    }
+    catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
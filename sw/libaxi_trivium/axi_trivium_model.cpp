@@ -0,0 +1,368 @@
+#include <cerrno>               /* errno */
+#include <new>                  /* Placement new */
+#include <stdexcept>            /* std::runtime_error */
+#include <string>               /* std::string */
+#include <thread>               /* std::this_thread::yield() */
+#include <fcntl.h>              /* O_* constants */
+#include <sys/mman.h>           /* mmap(), shm_open() */
+#include <sys/stat.h>           /* fstat() */
+#include <unistd.h>             /* ftruncate() */
+#include "trivium.hpp"          /* Cipher of the lanes */
+#include "axi_trivium_regs.h"   /* Register map of the IP core */
+#include "axi_trivium_model.hpp"    /* Library interface */
+
+namespace axi_trivium {
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Claims must work across processes");
+
+namespace {
+
+constexpr std::uint32_t SHM_MAGIC = 0x4d565254;     /* "TRVM", marks a completely initialized segment */
+constexpr unsigned int FIFO_MAX = 128;              /* Deepest FIFO whose level fits into a byte */
+constexpr unsigned int ATTACH_TRIES = 100000;       /* Yields waiting for the creator of a segment */
+
+/* A FIFO of the model */
+struct fifo {
+    std::uint32_t   dat[FIFO_MAX];  /* Entries */
+    unsigned int    head;           /* Oldest entry */
+    unsigned int    lvl;            /* Number of entries */
+
+    void push(std::uint32_t val) { dat[(head + lvl++) % FIFO_MAX] = val; }
+    std::uint32_t front() const { return dat[head]; }
+    void pop() { head = (head + 1) % FIFO_MAX; lvl--; }
+    void clear() { head = 0; lvl = 0; }
+};
+
+/* Register bank and cipher of a lane */
+struct shm_lane {
+    std::uint32_t   key[3];         /* Key registers */
+    std::uint32_t   iv[3];          /* IV registers */
+    std::uint32_t   idat;           /* Input data register */
+    std::uint32_t   ier;            /* Interrupt enable register */
+    std::uint32_t   isr;            /* Interrupt status register */
+    std::uint32_t   skip;           /* Skip count register */
+    bool            stream;         /* Stream bit */
+    bool            hold;           /* Hold bit */
+    bool            init_done;      /* Init done bit */
+    bool            skip_done;      /* Skip done bit */
+    fifo            in;             /* Input FIFO */
+    fifo            out;            /* Output FIFO */
+    trivium::context ctx;           /* Key stream */
+};
+
+/* Bytes of three key or IV registers, least significant byte first */
+inline void reg_bytes(const std::uint32_t *p_regs, std::uint8_t *p_bytes) {
+    for (unsigned int i = 0; i < trivium::KEY_LEN; i++)
+        p_bytes[i] = static_cast<std::uint8_t>(p_regs[i/4] >> (8*(i%4)));
+}
+
+}
+
+/* Layout of the shared-memory segment, followed by the claims and the lanes */
+struct model_shm {
+    std::atomic<std::uint32_t> magic;   /* SHM_MAGIC once the segment is initialized */
+    std::uint32_t   info;               /* Info register */
+    std::uint32_t   num_lanes;          /* Number of lanes */
+    std::uint32_t   depth;              /* FIFO depth */
+    std::uint64_t   len;                /* Size of the segment */
+};
+
+namespace {
+
+/* Offset of the claims and the lanes in the segment */
+constexpr std::size_t CLAIMS_OFF = (sizeof(model_shm) + 63) & ~std::size_t(63);
+
+inline std::size_t lanes_off(unsigned int num_lanes) {
+    return (CLAIMS_OFF + num_lanes*sizeof(std::atomic<std::uint32_t>) + 63) & ~std::size_t(63);
+}
+
+inline shm_lane *lane_at(model_shm *p_shm, unsigned int lane) {
+    return reinterpret_cast<shm_lane *>(reinterpret_cast<std::uint8_t *>(p_shm) + lanes_off(p_shm->num_lanes)) + lane;
+}
+
+/* Moves queued words into the output FIFO while it has room, encrypting them */
+void drain(shm_lane &ln, unsigned int depth) {
+    while (ln.in.lvl && ln.out.lvl < depth) {
+        std::uint32_t word = ln.in.front();
+        std::uint8_t buf[4];
+
+        ln.in.pop();
+        for (unsigned int i = 0; i < 4; i++)
+            buf[i] = static_cast<std::uint8_t>(word >> (8*i));
+
+        ln.ctx.encrypt(buf);
+        ln.out.push(static_cast<std::uint32_t>(buf[0]) | static_cast<std::uint32_t>(buf[1]) << 8 |
+                    static_cast<std::uint32_t>(buf[2]) << 16 | static_cast<std::uint32_t>(buf[3]) << 24);
+    }
+}
+
+/* Discards key stream words */
+void discard(shm_lane &ln, std::uint32_t num_words) {
+    std::uint8_t buf[256];
+
+    for (std::uint64_t left = 4ull*num_words; left; ) {
+        std::size_t n = left < sizeof(buf) ? static_cast<std::size_t>(left) : sizeof(buf);
+
+        ln.ctx.keystream(std::span(buf, n));
+        left -= n;
+    }
+}
+
+}
+
+/*
+ * model - Open or create a model
+ *
+ * @p_name: Name of the shared-memory segment, nullptr for an anonymous model
+ * @cfg: Configuration of a new model
+ *
+ * Additional information: The creator sizes the segment before initializing
+ * it and publishes the magic last, so processes attaching concurrently wait
+ * until the segment is complete.
+ */
+model::model(const char *p_name, const model_config &cfg) {
+    const std::string name = p_name ? p_name : "(anonymous)";
+    bool create = true;
+    int fd = -1;
+
+    if (cfg.num_lanes < 1 || cfg.num_lanes > REG_INFO_LANES_MASK || cfg.fifo_depth_log2 > 7 ||
+        (cfg.bits_per_cycle != 1 && cfg.bits_per_cycle != 8 && cfg.bits_per_cycle != 16 &&
+         cfg.bits_per_cycle != 32 && cfg.bits_per_cycle != 64))
+        throw std::invalid_argument("axi_trivium::model: invalid configuration");
+
+    std::size_t len = lanes_off(cfg.num_lanes) + cfg.num_lanes*sizeof(shm_lane);
+    if (p_name) {
+        fd = shm_open(p_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            create = false;
+            fd = shm_open(p_name, O_RDWR, 0);
+        }
+
+        if (fd < 0)
+            throw std::runtime_error("axi_trivium::model: could not open " + name);
+
+        if (create && ftruncate(fd, static_cast<off_t>(len))) {
+            close(fd);
+            shm_unlink(p_name);
+            throw std::runtime_error("axi_trivium::model: could not size " + name);
+        }
+
+        /* The creator may not have sized the segment yet */
+        struct stat st;
+        for (unsigned int i = 0; !create; i++) {
+            if (fstat(fd, &st) || i == ATTACH_TRIES) {
+                close(fd);
+                throw std::runtime_error("axi_trivium::model: " + name + " is not initialized");
+            }
+
+            if (static_cast<std::size_t>(st.st_size) >= sizeof(model_shm)) {
+                len = static_cast<std::size_t>(st.st_size);
+                break;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    void *p_map = mmap(nullptr, len, PROT_READ | PROT_WRITE, p_name ? MAP_SHARED : MAP_SHARED | MAP_ANONYMOUS, fd, 0);
+    if (fd >= 0)
+        close(fd);
+
+    if (p_map == MAP_FAILED) {
+        if (p_name && create)
+            shm_unlink(p_name);
+
+        throw std::runtime_error("axi_trivium::model: could not map " + name);
+    }
+
+    p_shm_ = static_cast<model_shm *>(p_map);
+    shm_len_ = len;
+    if (create) {
+        p_shm_->info = cfg.num_lanes | cfg.bits_per_cycle << REG_INFO_BITS_SHIFT |
+                       cfg.fifo_depth_log2 << REG_INFO_FIFO_SHIFT | cfg.ks_fifo_depth_log2 << REG_INFO_KS_SHIFT;
+        p_shm_->num_lanes = cfg.num_lanes;
+        p_shm_->depth = 1u << cfg.fifo_depth_log2;
+        p_shm_->len = len;
+        for (unsigned int i = 0; i < cfg.num_lanes; i++) {
+            new (claims() + i) std::atomic<std::uint32_t>(0);
+            new (lane_at(p_shm_, i)) shm_lane{};
+        }
+
+        p_shm_->magic.store(SHM_MAGIC, std::memory_order_release);
+    }
+    else {
+        unsigned int i = 0;
+        for (; p_shm_->magic.load(std::memory_order_acquire) != SHM_MAGIC && i < ATTACH_TRIES; i++)
+            std::this_thread::yield();
+
+        if (i == ATTACH_TRIES || p_shm_->len != len) {
+            munmap(p_map, len);
+            throw std::runtime_error("axi_trivium::model: " + name + " is no valid model");
+        }
+    }
+
+    num_lanes_ = p_shm_->num_lanes;
+}
+
+model::~model() {
+    munmap(p_shm_, shm_len_);
+}
+
+void model::unlink(const char *p_name) {
+    shm_unlink(p_name);
+}
+
+std::atomic<std::uint32_t> *model::claims() const {
+    return reinterpret_cast<std::atomic<std::uint32_t> *>(reinterpret_cast<std::uint8_t *>(p_shm_) + CLAIMS_OFF);
+}
+
+/*******************************************************************************
+ * Registers
+ ******************************************************************************/
+
+/*
+ * read - Read a register
+ *
+ * @lane: Lane
+ * @reg: Register within the bank of the lane
+ *
+ * Return register value
+ *
+ * Additional information: Like the core, reading the output data register
+ * removes the word from the output FIFO, which makes room for queued words.
+ */
+std::uint32_t model::read(unsigned int lane, unsigned int reg) {
+    if (lane >= num_lanes_)
+        return 0;
+
+    shm_lane &ln = *lane_at(p_shm_, lane);
+    std::uint32_t val;
+
+    switch (reg) {
+    case REG_CONFIG:
+        return ln.out.lvl << REG_CONFIG_OLVL_SHIFT | (p_shm_->depth - ln.in.lvl) << REG_CONFIG_IFREE_SHIFT |
+               static_cast<std::uint32_t>(ln.skip_done) << REG_CONFIG_BIT_SDONE |
+               static_cast<std::uint32_t>(ln.init_done) << REG_CONFIG_BIT_IDONE |
+               static_cast<std::uint32_t>(ln.in.lvl != 0) << REG_CONFIG_BIT_BUSY |
+               static_cast<std::uint32_t>(ln.hold) << REG_CONFIG_BIT_HOLD |
+               static_cast<std::uint32_t>(ln.stream) << REG_CONFIG_BIT_STREAM;
+    case REG_KEY_LO:
+    case REG_KEY_MID:
+    case REG_KEY_HI:
+        return ln.key[reg - REG_KEY_LO];
+    case REG_IV_LO:
+    case REG_IV_MID:
+    case REG_IV_HI:
+        return ln.iv[reg - REG_IV_LO];
+    case REG_DAT_I:
+        return ln.idat;
+    case REG_DAT_O:
+        if (!ln.out.lvl)
+            return 0;
+
+        val = ln.out.front();
+        if (!ln.stream) {
+            ln.out.pop();
+            drain(ln, p_shm_->depth);
+        }
+
+        return val;
+    case REG_INFO:
+        return p_shm_->info;
+    case REG_SKIP:
+        return ln.skip;
+    case REG_IER:
+        return ln.ier;
+    case REG_ISR:
+        return ln.isr | static_cast<std::uint32_t>(ln.out.lvl != 0) << IRQ_BIT_OAVAIL;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * write - Write a register
+ *
+ * @lane: Lane
+ * @reg: Register within the bank of the lane
+ * @val: Value
+ *
+ * Additional information: The control bits take effect in the order of
+ * priority of the core: Stop, Init, Restore, Skip and Process. A skip
+ * completes right away.
+ */
+void model::write(unsigned int lane, unsigned int reg, std::uint32_t val) {
+    if (lane >= num_lanes_)
+        return;
+
+    shm_lane &ln = *lane_at(p_shm_, lane);
+    bool busy = ln.in.lvl != 0;
+
+    switch (reg) {
+    case REG_CONFIG:
+        ln.stream = val & (1 << REG_CONFIG_BIT_STREAM);
+        ln.hold = val & (1 << REG_CONFIG_BIT_HOLD);
+        if (val & (1 << REG_CONFIG_BIT_STOP)) {
+            ln.init_done = false;
+            ln.skip_done = false;
+            ln.in.clear();
+            ln.out.clear();
+        }
+        else if ((val & (1 << REG_CONFIG_BIT_INIT)) && !busy) {
+            std::uint8_t key[trivium::KEY_LEN], iv[trivium::IV_LEN];
+
+            reg_bytes(ln.key, key);
+            reg_bytes(ln.iv, iv);
+            ln.ctx.init(key, iv);
+            ln.init_done = true;
+            ln.isr |= 1 << IRQ_BIT_IDONE;
+        }
+        else if ((val & (1 << REG_CONFIG_BIT_RESTORE)) && !busy) {
+            ln.init_done = true;
+            ln.isr |= 1 << IRQ_BIT_IDONE;
+        }
+        else if ((val & (1 << REG_CONFIG_BIT_SKIP)) && !busy) {
+            discard(ln, ln.skip);
+            ln.skip_done = true;
+            ln.isr |= 1 << IRQ_BIT_SDONE;
+        }
+        else if ((val & (1 << REG_CONFIG_BIT_PROC)) && !ln.stream && ln.in.lvl < p_shm_->depth) {
+            ln.in.push(ln.idat);
+            drain(ln, p_shm_->depth);
+        }
+        break;
+    case REG_KEY_LO:
+    case REG_KEY_MID:
+    case REG_KEY_HI:
+        ln.key[reg - REG_KEY_LO] = val;
+        break;
+    case REG_IV_LO:
+    case REG_IV_MID:
+    case REG_IV_HI:
+        ln.iv[reg - REG_IV_LO] = val;
+        break;
+    case REG_DAT_I:
+        ln.idat = val;
+        break;
+    case REG_SKIP:
+        ln.skip = val;
+        break;
+    case REG_DAT_Q:
+        ln.idat = val;
+        if (!ln.stream && ln.in.lvl < p_shm_->depth) {
+            ln.in.push(val);
+            drain(ln, p_shm_->depth);
+        }
+        break;
+    case REG_IER:
+        ln.ier = val & ((1 << IRQ_BIT_IDONE) | (1 << IRQ_BIT_OAVAIL) | (1 << IRQ_BIT_SDONE));
+        break;
+    case REG_ISR:
+        ln.isr &= ~val;
+        break;
+    default:
+        break;
+    }
+}
+
+}
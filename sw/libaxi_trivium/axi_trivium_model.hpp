@@ -0,0 +1,77 @@
+#ifndef __AXI_TRIVIUM_MODEL_HPP
+#define __AXI_TRIVIUM_MODEL_HPP
+
+/*
+ * libaxi_trivium - Software model of the IP core
+ *
+ * The model implements the register map of axi_trivium_v1_0 (see
+ * sw/linux_driver/axi_trivium_regs.h) on top of trivium::context, such that
+ * axi_trivium::device can be tested and benchmarked without an FPGA. Its
+ * registers and lanes live in a shared-memory segment: several processes
+ * opening a model of the same name share one simulated core, including the
+ * lane claims of axi_trivium::device.
+ *
+ * The model is functional, not cycle-accurate. Initialization completes
+ * immediately and a queued word is encrypted as soon as the output FIFO has
+ * room, so the input FIFO only fills while the output FIFO is full. The
+ * cipher state and key stream registers and the AXI4-Stream interfaces are
+ * not modelled: state registers read as zero and ignore writes, a restore
+ * merely sets Init done and the Stream bit disconnects the data registers.
+ */
+
+#include <atomic>       /* std::atomic */
+#include <cstddef>      /* std::size_t */
+#include <cstdint>      /* Fixed size types */
+
+namespace axi_trivium {
+
+/* Configuration of a model, as reported in its info register */
+struct model_config {
+    unsigned int num_lanes = 4;             /* Number of lanes (1 - 255) */
+    unsigned int bits_per_cycle = 32;       /* BITS_PER_CYCLE (1, 8, 16, 32 or 64), only reported */
+    unsigned int fifo_depth_log2 = 2;       /* Log2 of the FIFO depth (0 - 7) */
+    unsigned int ks_fifo_depth_log2 = 2;    /* Log2 of the key stream FIFO depth, only reported */
+};
+
+struct model_shm;
+
+class model {
+public:
+    /*
+     * Opens the model p_name (a POSIX shared memory name like "/trivium0"),
+     * creating it with the configuration cfg if it does not exist yet. An
+     * existing model keeps its configuration. With p_name == nullptr, the
+     * model is anonymous and only shared with child processes. Throws
+     * std::invalid_argument if cfg is invalid and std::runtime_error if the
+     * segment cannot be created or mapped.
+     */
+    explicit model(const char *p_name, const model_config &cfg = {});
+    ~model();
+
+    model(const model &) = delete;
+    model &operator=(const model &) = delete;
+
+    /* Removes the shared-memory segment p_name, models still open keep working */
+    static void unlink(const char *p_name);
+
+    /* Reads register reg of a lane, with the side effects of the core */
+    std::uint32_t read(unsigned int lane, unsigned int reg);
+
+    /* Writes register reg of a lane, with the side effects of the core */
+    void write(unsigned int lane, unsigned int reg, std::uint32_t val);
+
+    /* Number of lanes */
+    unsigned int num_lanes() const { return num_lanes_; }
+
+    /* Lane claims shared by all devices using the model, one word per lane */
+    std::atomic<std::uint32_t> *claims() const;
+
+private:
+    model_shm *p_shm_;          /* Shared-memory segment */
+    std::size_t shm_len_;       /* Size of the segment */
+    unsigned int num_lanes_;    /* Number of lanes, private copy of the segment field */
+};
+
+}
+
+#endif
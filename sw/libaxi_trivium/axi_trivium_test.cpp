@@ -0,0 +1,222 @@
+/*
+ * axi_trivium_test - Check libaxi_trivium against a binary vector file
+ *
+ * Usage: axi_trivium_test [-d <uio_device>] [-t <threads>] [<vector_file>]
+ *
+ * The tests of the vector file (see sw/libtrivium/trivium_vectors.hpp) are
+ * spread over several threads, which claim a lane per test. Each test is
+ * encrypted through one of the interfaces of axi_trivium::lane in turn: the
+ * byte and the word interface of encrypt(), each with the message split
+ * into two calls, submit()/collect() and skip() over the first half of the
+ * message followed by encrypt() of the second half. Without -d, the device is an
+ * anonymous software model with fewer lanes than threads, so the claims are
+ * contended. Afterwards two models of the same name are checked to share
+ * their lanes and claims.
+ */
+#include <algorithm>    /* std::equal() */
+#include <atomic>       /* std::atomic */
+#include <cstdio>       /* std::printf() */
+#include <cstdlib>      /* EXIT_SUCCESS and co. */
+#include <cstring>      /* std::memcmp() */
+#include <memory>       /* std::unique_ptr */
+#include <stdexcept>    /* std::runtime_error */
+#include <string>       /* std::to_string() */
+#include <thread>       /* std::thread */
+#include <vector>       /* std::vector */
+#include <unistd.h>     /* getopt(), getpid() */
+#include "trivium_vectors.hpp"  /* Binary test vector format */
+#include "axi_trivium_model.hpp"    /* Software model */
+#include "axi_trivium_uio.hpp"  /* Library interface */
+
+/* Little-endian words of a byte buffer */
+static std::vector<std::uint32_t> to_words(std::span<const std::uint8_t> bytes) {
+    std::vector<std::uint32_t> words(bytes.size()/4);
+
+    for (std::size_t i = 0; i < words.size(); i++)
+        words[i] = static_cast<std::uint32_t>(bytes[4*i]) | static_cast<std::uint32_t>(bytes[4*i + 1]) << 8 |
+                   static_cast<std::uint32_t>(bytes[4*i + 2]) << 16 | static_cast<std::uint32_t>(bytes[4*i + 3]) << 24;
+
+    return words;
+}
+
+/*
+ * run_test - Encrypt a test through a lane
+ *
+ * @ln: Claimed lane
+ * @rec: Test
+ * @mode: Interface to use (0: bytes, 1: words, 2: submit/collect, 3: skip)
+ *
+ * Return true if the result matches the ciphertext of the test
+ */
+static bool run_test(axi_trivium::lane &ln, const trivium::vec_record &rec, unsigned int mode) {
+    std::size_t half = rec.pt.size()/8*4;
+
+    ln.init(rec.key, rec.iv);
+    if (mode == 0) {
+        std::vector<std::uint8_t> out(rec.pt.size());
+
+        ln.encrypt(rec.pt.first(half), std::span(out).first(half));
+        ln.encrypt(rec.pt.subspan(half), std::span(out).subspan(half));
+        return !std::memcmp(out.data(), rec.ct.data(), out.size());
+    }
+
+    std::vector<std::uint32_t> in = to_words(rec.pt), out(in.size());
+    if (mode == 1) {
+        ln.encrypt(std::span(in).first(half/4), std::span(out).first(half/4));
+        ln.encrypt(std::span(in).subspan(half/4), std::span(out).subspan(half/4));
+    }
+    else if (mode == 3) {
+        /* Only the second half is encrypted */
+        std::vector<std::uint32_t> ct = to_words(rec.ct);
+
+        ln.skip(half/4);
+        ln.encrypt(std::span(in).subspan(half/4), std::span(out).subspan(half/4));
+        return std::equal(out.begin() + half/4, out.end(), ct.begin() + half/4);
+    }
+    else {
+        std::size_t in_idx = 0, out_idx = 0;
+        while (out_idx < out.size()) {
+            in_idx += ln.submit(std::span(in).subspan(in_idx));
+            out_idx += ln.collect(std::span(out).subspan(out_idx));
+        }
+    }
+
+    return out == to_words(rec.ct);
+}
+
+/*
+ * run_vectors - Run the tests of a vector file through a device
+ *
+ * @dev: Device
+ * @vecs: Vector file
+ * @num_threads: Number of threads
+ *
+ * Return number of failed tests
+ */
+static std::uint64_t run_vectors(axi_trivium::device &dev, const trivium::vec_file &vecs, unsigned int num_threads) {
+    std::atomic<std::uint64_t> errors{0};
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::uint64_t idx = 0;
+
+            for (const trivium::vec_record &rec : vecs) {
+                if (idx++ % num_threads != t)
+                    continue;
+
+                axi_trivium::lane ln = dev.claim();
+                if (!run_test(ln, rec, idx % 4)) {
+                    std::printf("ERROR: Test %llu failed on lane %u\n", static_cast<unsigned long long>(idx - 1), ln.index());
+                    errors++;
+                }
+            }
+        });
+    }
+
+    for (std::thread &th : threads)
+        th.join();
+
+    return errors;
+}
+
+/*
+ * shared_model_test - Check that two models of the same name share lanes and claims
+ *
+ * Return number of failed checks
+ */
+static unsigned int shared_model_test() {
+    std::string name = "/axi_trivium_test." + std::to_string(getpid());
+    unsigned int errors = 0;
+
+    axi_trivium::model::unlink(name.c_str());
+    {
+        axi_trivium::model_config cfg;
+        cfg.num_lanes = 2;
+
+        axi_trivium::model mdl_a(name.c_str(), cfg), mdl_b(name.c_str());
+        axi_trivium::device dev_a(mdl_a), dev_b(mdl_b);
+        std::uint8_t key[trivium::KEY_LEN] = {1}, iv[trivium::IV_LEN] = {2};
+        std::uint32_t pt[4] = {0, 1, 2, 3}, ct_a[4], ct_b[4];
+
+        errors += dev_b.num_lanes() != 2 || dev_b.info() != dev_a.info();
+
+        /* Both lanes claimed by one device leave none for the other */
+        axi_trivium::lane ln0 = dev_a.claim(), ln1 = dev_a.claim();
+        errors += dev_b.try_claim().has_value();
+
+        /* The state of a lane is visible through the other model */
+        ln0.init(key, iv);
+        ln0.encrypt(pt, ct_a);
+        unsigned int idx = ln0.index();
+        ln0.release();
+
+        std::optional<axi_trivium::lane> ln = dev_b.try_claim();
+        errors += !ln || ln->index() != idx;
+        if (ln) {
+            ln->init(key, iv);
+            ln->encrypt(pt, ct_b);
+            errors += std::memcmp(ct_a, ct_b, sizeof(ct_a)) != 0;
+        }
+    }
+
+    axi_trivium::model::unlink(name.c_str());
+    if (errors)
+        std::printf("ERROR: %u checks of the shared model failed\n", errors);
+
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    const char *p_uio = nullptr;
+    const char *p_vec_file = "../../reference_implementation/trivium_ref.bin";
+    unsigned int num_threads = 0;
+    std::uint64_t errors = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:t:")) != -1) {
+        switch (opt) {
+        case 'd':
+            p_uio = optarg;
+            break;
+        case 't':
+            num_threads = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 0));
+            break;
+        default:
+            std::fprintf(stderr, "Usage: %s [-d <uio_device>] [-t <threads>] [<vector_file>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind < argc)
+        p_vec_file = argv[optind];
+
+    try {
+        trivium::vec_file vecs(p_vec_file);
+        std::unique_ptr<axi_trivium::model> p_model;
+        std::unique_ptr<axi_trivium::device> p_dev;
+
+        if (p_uio)
+            p_dev = std::make_unique<axi_trivium::device>(p_uio);
+        else {
+            p_model = std::make_unique<axi_trivium::model>(nullptr);
+            p_dev = std::make_unique<axi_trivium::device>(*p_model);
+        }
+
+        if (!num_threads)
+            num_threads = p_dev->num_lanes() + 2;
+
+        errors += run_vectors(*p_dev, vecs, num_threads);
+        std::printf("%llu tests on %u lanes with %u threads, %llu errors\n", static_cast<unsigned long long>(vecs.size()),
+                    p_dev->num_lanes(), num_threads, static_cast<unsigned long long>(errors));
+
+        if (!p_uio)
+            errors += shared_model_test();
+    }
+    catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
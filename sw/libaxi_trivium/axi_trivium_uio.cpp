@@ -0,0 +1,382 @@
+#include <algorithm>            /* std::min() */
+#include <cstdlib>              /* std::strtoull() */
+#include <fstream>              /* std::ifstream */
+#include <stdexcept>            /* std::runtime_error */
+#include <string>               /* std::string */
+#include <thread>               /* std::this_thread::yield() */
+#include <fcntl.h>              /* open() */
+#include <sys/mman.h>           /* mmap() */
+#include <unistd.h>             /* close(), getpid() */
+#include "axi_trivium_regs.h"   /* Register map of the IP core */
+#include "axi_trivium_model.hpp"    /* Software model */
+#include "axi_trivium_uio.hpp"  /* Library interface */
+
+namespace axi_trivium {
+
+namespace {
+
+constexpr std::uint32_t POLL_LIMIT = 1u << 24;  /* Reads of the control register before a lane is considered hung */
+constexpr std::size_t CHUNK_WORDS = 64;         /* Words converted at a time by the byte interface */
+constexpr std::uint32_t SKIP_WORDS = 1u << 20;  /* Words discarded per skip command, completing well within POLL_LIMIT */
+constexpr std::size_t DEFAULT_MAP_LEN = 4096;   /* Window size if sysfs does not tell */
+
+/* Lets the sibling hyperthread run while spinning */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+inline std::uint32_t load_le32(const std::uint8_t *p) {
+    return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+           static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+inline void store_le32(std::uint8_t *p, std::uint32_t val) {
+    for (unsigned int i = 0; i < 4; i++)
+        p[i] = static_cast<std::uint8_t>(val >> (8*i));
+}
+
+/* Three register words of a key or IV, least significant byte first */
+inline void reg_words(std::span<const std::uint8_t, trivium::KEY_LEN> bytes, std::uint32_t *p_words) {
+    p_words[0] = load_le32(bytes.data());
+    p_words[1] = load_le32(bytes.data() + 4);
+    p_words[2] = static_cast<std::uint32_t>(bytes[8]) | static_cast<std::uint32_t>(bytes[9]) << 8;
+}
+
+/* Claim word of the calling process */
+inline std::uint32_t claim_token() {
+    return static_cast<std::uint32_t>(getpid());
+}
+
+}
+
+/*******************************************************************************
+ * Lanes
+ ******************************************************************************/
+
+lane::lane(lane &&other) noexcept : p_dev_(other.p_dev_), idx_(other.idx_) {
+    other.p_dev_ = nullptr;
+}
+
+lane &lane::operator=(lane &&other) noexcept {
+    if (this != &other) {
+        release();
+        p_dev_ = other.p_dev_;
+        idx_ = other.idx_;
+        other.p_dev_ = nullptr;
+    }
+
+    return *this;
+}
+
+lane::~lane() {
+    release();
+}
+
+void lane::release() {
+    if (p_dev_)
+        p_dev_->release(idx_);
+
+    p_dev_ = nullptr;
+}
+
+inline std::uint32_t lane::rd(unsigned int reg) const {
+    if (p_dev_->p_model_)
+        return p_dev_->p_model_->read(idx_, reg);
+
+    return p_dev_->p_regs_[idx_*LANE_STRIDE + reg];
+}
+
+inline void lane::wr(unsigned int reg, std::uint32_t val) const {
+    if (p_dev_->p_model_)
+        p_dev_->p_model_->write(idx_, reg, val);
+    else
+        p_dev_->p_regs_[idx_*LANE_STRIDE + reg] = val;
+}
+
+/*
+ * wait - Poll the control register until a condition is met
+ *
+ * @conf_mask: Bits of the control register, the condition is met as soon as
+ *             any of them is set
+ *
+ * Return control register value meeting the condition
+ */
+std::uint32_t lane::wait(std::uint32_t conf_mask) const {
+    for (std::uint32_t polls = 0; polls < POLL_LIMIT; polls++) {
+        std::uint32_t conf = rd(REG_CONFIG);
+
+        if (conf & conf_mask)
+            return conf;
+
+        cpu_relax();
+    }
+
+    throw std::runtime_error("axi_trivium::lane: lane " + std::to_string(idx_) + " does not respond");
+}
+
+/*
+ * init - Load key and IV
+ *
+ * @key: Key
+ * @iv: IV
+ *
+ * Additional information: Writing the control register clears the Stream and
+ * Hold bits, so the lane exchanges data via the registers and prefetches key
+ * stream afterwards.
+ */
+void lane::init(std::span<const std::uint8_t, trivium::KEY_LEN> key, std::span<const std::uint8_t, trivium::IV_LEN> iv) {
+    std::uint32_t key_w[3], iv_w[3];
+
+    wr(REG_CONFIG, 1 << REG_CONFIG_BIT_STOP);
+    if (rd(REG_CONFIG) & (1 << REG_CONFIG_BIT_BUSY))
+        throw std::runtime_error("axi_trivium::lane: lane " + std::to_string(idx_) + " does not stop");
+
+    reg_words(key, key_w);
+    reg_words(iv, iv_w);
+    wr(REG_KEY_LO, key_w[0]);
+    wr(REG_KEY_MID, key_w[1]);
+    wr(REG_KEY_HI, key_w[2]);
+    wr(REG_IV_LO, iv_w[0]);
+    wr(REG_IV_MID, iv_w[1]);
+    wr(REG_IV_HI, iv_w[2]);
+
+    wr(REG_CONFIG, 1 << REG_CONFIG_BIT_INIT);
+    wait(1 << REG_CONFIG_BIT_IDONE);
+}
+
+/*
+ * skip - Fast-forward the key stream
+ *
+ * @num_words: Number of key stream words to discard
+ *
+ * Additional information: The lane discards the words at the rate of the
+ * cipher. Long skips are split into several commands, such that even the
+ * slowest configuration completes each of them before wait() gives up.
+ */
+void lane::skip(std::uint64_t num_words) {
+    while (num_words) {
+        std::uint32_t n = static_cast<std::uint32_t>(std::min<std::uint64_t>(num_words, SKIP_WORDS));
+
+        wr(REG_SKIP, n);
+        wr(REG_CONFIG, 1 << REG_CONFIG_BIT_SKIP);
+        wait(1 << REG_CONFIG_BIT_SDONE);
+        num_words -= n;
+    }
+}
+
+std::size_t lane::submit(std::span<const std::uint32_t> words) {
+    std::uint32_t conf = rd(REG_CONFIG);
+    std::size_t n = std::min<std::size_t>((conf >> REG_CONFIG_IFREE_SHIFT) & REG_CONFIG_LVL_MASK, words.size());
+
+    for (std::size_t i = 0; i < n; i++)
+        wr(REG_DAT_Q, words[i]);
+
+    return n;
+}
+
+std::size_t lane::collect(std::span<std::uint32_t> words) {
+    std::uint32_t conf = rd(REG_CONFIG);
+    std::size_t n = std::min<std::size_t>((conf >> REG_CONFIG_OLVL_SHIFT) & REG_CONFIG_LVL_MASK, words.size());
+
+    for (std::size_t i = 0; i < n; i++)
+        words[i] = rd(REG_DAT_O);
+
+    return n;
+}
+
+/*
+ * encrypt_words - Stream words through the lane
+ *
+ * @p_in: Input words
+ * @p_out: Output words
+ * @num_words: Number of words
+ *
+ * Additional information: The same loop as encrypt() of the kernel driver,
+ * one read of the control register yields both FIFO levels. Every word then
+ * takes a single access to the data queue or output data register.
+ */
+void lane::encrypt_words(const std::uint32_t *p_in, std::uint32_t *p_out, std::size_t num_words) {
+    std::size_t in_idx = 0, out_idx = 0;
+
+    while (out_idx < num_words) {
+        std::uint32_t conf = rd(REG_CONFIG);
+        std::uint32_t in_free = (conf >> REG_CONFIG_IFREE_SHIFT) & REG_CONFIG_LVL_MASK;
+        std::uint32_t out_lvl = (conf >> REG_CONFIG_OLVL_SHIFT) & REG_CONFIG_LVL_MASK;
+
+        /* Wait for results if there are none and no further words can be queued */
+        if (out_lvl == 0 && (in_free == 0 || in_idx == num_words)) {
+            wait(REG_CONFIG_LVL_MASK << REG_CONFIG_OLVL_SHIFT);
+            continue;
+        }
+
+        for (; out_lvl > 0 && out_idx < num_words; out_lvl--, out_idx++)
+            p_out[out_idx] = rd(REG_DAT_O);
+
+        for (; in_free > 0 && in_idx < num_words; in_free--, in_idx++)
+            wr(REG_DAT_Q, p_in[in_idx]);
+    }
+}
+
+void lane::encrypt(std::span<const std::uint32_t> in, std::span<std::uint32_t> out) {
+    if (in.size() != out.size())
+        throw std::invalid_argument("axi_trivium::lane::encrypt: buffer sizes differ");
+
+    encrypt_words(in.data(), out.data(), in.size());
+}
+
+void lane::encrypt(std::span<const std::uint8_t> in, std::span<std::uint8_t> out) {
+    std::uint32_t in_w[CHUNK_WORDS], out_w[CHUNK_WORDS];
+
+    if (in.size() != out.size() || in.size() % 4)
+        throw std::invalid_argument("axi_trivium::lane::encrypt: buffer sizes differ or are no multiple of 4");
+
+    for (std::size_t off = 0; off < in.size(); off += 4*CHUNK_WORDS) {
+        std::size_t n = std::min(CHUNK_WORDS, (in.size() - off)/4);
+
+        for (std::size_t i = 0; i < n; i++)
+            in_w[i] = load_le32(in.data() + off + 4*i);
+
+        encrypt_words(in_w, out_w, n);
+        for (std::size_t i = 0; i < n; i++)
+            store_le32(out.data() + off + 4*i, out_w[i]);
+    }
+}
+
+/*******************************************************************************
+ * Devices
+ ******************************************************************************/
+
+/*
+ * device - Map the core bound to a UIO device
+ *
+ * @p_uio: Path of the UIO device
+ *
+ * Additional information: The register window is the first memory map of
+ * the device, which is mapped at offset 0.
+ */
+device::device(const char *p_uio) {
+    std::string path(p_uio), size_str;
+    std::size_t size = DEFAULT_MAP_LEN;
+
+    std::ifstream size_file("/sys/class/uio/" + path.substr(path.rfind('/') + 1) + "/maps/map0/size");
+    if (size_file >> size_str)
+        size = std::strtoull(size_str.c_str(), nullptr, 0);
+
+    int fd = open(p_uio, O_RDWR | O_SYNC);
+    if (fd < 0)
+        throw std::runtime_error("axi_trivium::device: could not open " + path);
+
+    p_map_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p_map_ == MAP_FAILED) {
+        p_map_ = nullptr;
+        throw std::runtime_error("axi_trivium::device: could not map " + path);
+    }
+
+    map_len_ = size;
+    p_regs_ = static_cast<volatile std::uint32_t *>(p_map_);
+    probe(size);
+}
+
+/*
+ * device - Map the core at a physical address
+ *
+ * @p_mem: Path of the memory device
+ * @addr: Physical base address of the core
+ * @size: Size of the register window
+ */
+device::device(const char *p_mem, std::uint64_t addr, std::size_t size) {
+    std::uint64_t page_off = addr & static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE) - 1);
+
+    int fd = open(p_mem, O_RDWR | O_SYNC);
+    if (fd < 0)
+        throw std::runtime_error(std::string("axi_trivium::device: could not open ") + p_mem);
+
+    p_map_ = mmap(nullptr, size + page_off, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(addr - page_off));
+    close(fd);
+    if (p_map_ == MAP_FAILED) {
+        p_map_ = nullptr;
+        throw std::runtime_error(std::string("axi_trivium::device: could not map ") + p_mem);
+    }
+
+    map_len_ = size + page_off;
+    p_regs_ = reinterpret_cast<volatile std::uint32_t *>(static_cast<std::uint8_t *>(p_map_) + page_off);
+    probe(size);
+}
+
+device::device(model &mdl) : p_model_(&mdl) {
+    info_ = mdl.read(0, REG_INFO);
+    num_lanes_ = mdl.num_lanes();
+    p_claims_ = mdl.claims();
+}
+
+device::~device() {
+    if (p_map_)
+        munmap(p_map_, map_len_);
+}
+
+/*
+ * probe - Read the info register of a mapped core and set up its lanes
+ *
+ * @size: Size of the register window
+ *
+ * Additional information: Like the kernel driver, only the lanes within the
+ * window are used.
+ */
+void device::probe(std::size_t size) {
+    info_ = p_regs_[REG_INFO];
+    num_lanes_ = std::min<std::size_t>(info_ & REG_INFO_LANES_MASK, size/(LANE_STRIDE*sizeof(std::uint32_t)));
+    if (!num_lanes_) {
+        munmap(p_map_, map_len_);
+        throw std::runtime_error("axi_trivium::device: no core found");
+    }
+
+    own_claims_ = std::make_unique<std::atomic<std::uint32_t>[]>(num_lanes_);
+    p_claims_ = own_claims_.get();
+}
+
+/*
+ * try_claim - Claim a free lane
+ *
+ * Return claimed lane, std::nullopt if there is none
+ *
+ * Additional information: Consecutive claims start searching at different
+ * lanes, so concurrent claimants rarely compete for the same claim word.
+ */
+std::optional<lane> device::try_claim() {
+    unsigned int start = next_.fetch_add(1, std::memory_order_relaxed);
+    std::uint32_t token = claim_token();
+
+    for (unsigned int i = 0; i < num_lanes_; i++) {
+        unsigned int idx = (start + i) % num_lanes_;
+        std::uint32_t expected = 0;
+
+        if (p_claims_[idx].load(std::memory_order_relaxed) == 0 &&
+            p_claims_[idx].compare_exchange_strong(expected, token, std::memory_order_acquire,
+                                                   std::memory_order_relaxed))
+            return lane(*this, idx);
+    }
+
+    return std::nullopt;
+}
+
+lane device::claim() {
+    for (;;) {
+        std::optional<lane> ln = try_claim();
+
+        if (ln)
+            return std::move(*ln);
+
+        std::this_thread::yield();
+    }
+}
+
+void device::release(unsigned int idx) {
+    p_claims_[idx].store(0, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,159 @@
+#ifndef __AXI_TRIVIUM_UIO_HPP
+#define __AXI_TRIVIUM_UIO_HPP
+
+/*
+ * libaxi_trivium - User-space polling driver for the IP core
+ *
+ * The registers of the core are mapped into the process via UIO (e.g.
+ * /dev/uio0, bound to the core with the uio_pdrv_genirq driver), via
+ * /dev/mem for testing or backed by the software model of
+ * axi_trivium_model.hpp. The register map is the one of the kernel driver,
+ * see sw/linux_driver/axi_trivium_regs.h. Data is exchanged by polling the
+ * control register, no system call is made after opening the device.
+ *
+ * Threads claim lanes of the device without locks: a claim is a single
+ * compare-and-swap on the claim word of a lane, and a lane is used
+ * exclusively by its claimant until released. The claim words of a hardware
+ * device belong to the device object, so the process that opens the core
+ * must be its only user. The claims of a model are part of its shared-memory
+ * segment and cover all processes using it.
+ *
+ * Key and IV are 10 bytes each, least significant byte first, and data words
+ * are encrypted like little-endian words written to /proc/axi_trivium.
+ */
+
+#include <atomic>       /* std::atomic */
+#include <cstddef>      /* std::size_t */
+#include <cstdint>      /* Fixed size types */
+#include <memory>       /* std::unique_ptr */
+#include <optional>     /* std::optional */
+#include <span>         /* std::span */
+#include "trivium.hpp"  /* KEY_LEN and IV_LEN */
+
+namespace axi_trivium {
+
+class device;
+class model;
+
+/*
+ * lane - A claimed lane of a device
+ *
+ * The claim is released when the lane is destroyed. Errors of the core,
+ * i.e. a lane that stays busy or produces no output, are reported by
+ * throwing std::runtime_error.
+ */
+class lane {
+public:
+    lane(lane &&other) noexcept;
+    lane &operator=(lane &&other) noexcept;
+    ~lane();
+
+    lane(const lane &) = delete;
+    lane &operator=(const lane &) = delete;
+
+    /* Index of the lane within the device */
+    unsigned int index() const { return idx_; }
+
+    /* Stops the lane, loads key and IV and waits for the warm-up phase to complete */
+    void init(std::span<const std::uint8_t, trivium::KEY_LEN> key, std::span<const std::uint8_t, trivium::IV_LEN> iv);
+
+    /* Discards the next num_words key stream words without transferring any data */
+    void skip(std::uint64_t num_words);
+
+    /*
+     * Queues words for processing, as many as the input FIFO has room for.
+     * Return number of words queued
+     */
+    std::size_t submit(std::span<const std::uint32_t> words);
+
+    /*
+     * Reads results from the output FIFO, at most words.size() of them.
+     * Return number of words read
+     */
+    std::size_t collect(std::span<std::uint32_t> words);
+
+    /*
+     * Encrypts or decrypts in into out, which must be of the same size,
+     * keeping the input FIFO filled while collecting the results. Throws
+     * std::invalid_argument if the sizes differ.
+     */
+    void encrypt(std::span<const std::uint32_t> in, std::span<std::uint32_t> out);
+
+    /* Like above for bytes, the size must be a multiple of 4 bytes */
+    void encrypt(std::span<const std::uint8_t> in, std::span<std::uint8_t> out);
+
+    /* Releases the claim early, the lane must not be used afterwards */
+    void release();
+
+private:
+    friend class device;
+
+    lane(device &dev, unsigned int idx) : p_dev_(&dev), idx_(idx) {}
+
+    std::uint32_t rd(unsigned int reg) const;
+    void wr(unsigned int reg, std::uint32_t val) const;
+    std::uint32_t wait(std::uint32_t conf_mask) const;
+    void encrypt_words(const std::uint32_t *p_in, std::uint32_t *p_out, std::size_t num_words);
+
+    device *p_dev_;         /* Device, nullptr once released */
+    unsigned int idx_;      /* Index of the lane */
+};
+
+/*
+ * device - Register window of an IP core
+ */
+class device {
+public:
+    /*
+     * Maps the core bound to a UIO device, e.g. "/dev/uio0". The size of the
+     * window is taken from sysfs. Throws std::runtime_error if the device
+     * cannot be mapped or holds no core.
+     */
+    explicit device(const char *p_uio);
+
+    /*
+     * Maps size bytes at physical address addr of a memory device, usually
+     * "/dev/mem". Throws std::runtime_error like above.
+     */
+    device(const char *p_mem, std::uint64_t addr, std::size_t size);
+
+    /* Uses a software model instead of a core, the model must outlive the device */
+    explicit device(model &mdl);
+
+    ~device();
+
+    device(const device &) = delete;
+    device &operator=(const device &) = delete;
+
+    /* Number of lanes */
+    unsigned int num_lanes() const { return num_lanes_; }
+
+    /* Contents of the info register */
+    std::uint32_t info() const { return info_; }
+
+    /* Claims any free lane, returns std::nullopt if all of them are claimed */
+    std::optional<lane> try_claim();
+
+    /* Claims any free lane, spinning until one is released */
+    lane claim();
+
+private:
+    friend class lane;
+
+    void probe(std::size_t size);
+    void release(unsigned int idx);
+
+    volatile std::uint32_t *p_regs_ = nullptr;  /* Mapped registers, nullptr for a model */
+    void *p_map_ = nullptr;                     /* Start of the mapping, which may precede the registers */
+    std::size_t map_len_ = 0;                   /* Size of the mapping */
+    model *p_model_ = nullptr;                  /* Software model, nullptr for a core */
+    std::unique_ptr<std::atomic<std::uint32_t>[]> own_claims_;  /* Claim words of a core */
+    std::atomic<std::uint32_t> *p_claims_ = nullptr;            /* Claim words in use, 0 for a free lane */
+    std::atomic<unsigned int> next_{0};         /* Lane the next claim starts searching at */
+    std::uint32_t info_ = 0;                    /* Info register */
+    unsigned int num_lanes_ = 0;                /* Number of lanes */
+};
+
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include <algorithm>    /* std::fill() */
+#include <bit>          /* std::endian */
+#include <cstring>      /* std::memcpy() */
+#include <stdexcept>    /* std::invalid_argument */
+#include "trivium.hpp"  /* Library interface */
+
+namespace trivium {
+
+/*******************************************************************************
+ * Register layout
+ ******************************************************************************/
+/*
+ * Bit q of a register, counting from bit 0 of word 0 to bit 63 of word 1, is
+ * the bit shifted into the register 128 - q steps ago. Position p of the
+ * register, e.g. p = 66 for s66 of register A or for s159 of register B, thus
+ * is bit 128 - p. The bits following position p are the values position p will
+ * have in the next steps, so 64 consecutive values of a tap are a single
+ * unaligned 64-bit read as long as p >= 64.
+ */
+namespace {
+
+using reg = std::array<std::uint64_t, 2>;
+
+/* Values of position p in the next 64 steps */
+template <unsigned int p>
+inline std::uint64_t tap(const reg &r) {
+    static_assert(p >= 64 && p < 128, "Tap too close to the register input");
+    constexpr unsigned int q = 128 - p;
+
+    return (r[0] >> q) | (r[1] << (64 - q));
+}
+
+/* Shift 64 new bits into a register, bit 0 first */
+inline void shift(reg &r, std::uint64_t in) {
+    r[0] = r[1];
+    r[1] = in;
+}
+
+/* Set position p of a register */
+inline void set_pos(reg &r, unsigned int p, unsigned int val) {
+    unsigned int q = 128 - p;
+
+    r[q/64] |= static_cast<std::uint64_t>(val & 1) << (q%64);
+}
+
+/* Little-endian byte order of a key stream word, matching the bit order of the data */
+inline std::uint64_t to_le(std::uint64_t val) {
+    if constexpr (std::endian::native == std::endian::big)
+        return __builtin_bswap64(val);
+
+    return val;
+}
+
+/*
+ * step - Advance the registers by 64 rounds
+ *
+ * @a: Register A
+ * @b: Register B
+ * @c: Register C
+ *
+ * Return the 64 key stream bits of these rounds, bit i being the bit of round i
+ *
+ * Additional information: The taps are the ones of the specification,
+ * relative to the first position of their register, e.g. s171 is position 78
+ * of register B. Callers processing many words keep the registers in local
+ * variables, otherwise every store to the data could alias them.
+ */
+inline std::uint64_t step(reg &a, reg &b, reg &c) {
+    std::uint64_t t1 = tap<66>(a) ^ tap<93>(a);
+    std::uint64_t t2 = tap<69>(b) ^ tap<84>(b);
+    std::uint64_t t3 = tap<66>(c) ^ tap<111>(c);
+    std::uint64_t z = t1 ^ t2 ^ t3;
+
+    /* Compute all feedback words before shifting any register */
+    std::uint64_t in_a = t3 ^ (tap<109>(c) & tap<110>(c)) ^ tap<69>(a);
+    std::uint64_t in_b = t1 ^ (tap<91>(a) & tap<92>(a)) ^ tap<78>(b);
+    std::uint64_t in_c = t2 ^ (tap<82>(b) & tap<83>(b)) ^ tap<87>(c);
+
+    shift(a, in_a);
+    shift(b, in_b);
+    shift(c, in_c);
+
+    return z;
+}
+
+}
+
+/*******************************************************************************
+ * Context
+ ******************************************************************************/
+
+context::context(std::span<const std::uint8_t, KEY_LEN> key, std::span<const std::uint8_t, IV_LEN> iv) {
+    init(key, iv);
+}
+
+/*
+ * init - Load key and IV and run the warm-up phase
+ *
+ * @key: Key, least significant byte first
+ * @iv: IV, least significant byte first
+ *
+ * Additional information: s1 - s80 hold the key and s94 - s173 the IV, while
+ * s286 - s288 are set. The 1152 warm-up rounds are 18 steps of 64 rounds.
+ */
+void context::init(std::span<const std::uint8_t, KEY_LEN> key, std::span<const std::uint8_t, IV_LEN> iv) {
+    a_ = {};
+    b_ = {};
+    c_ = {};
+
+    for (unsigned int i = 0; i < KEY_LEN*8; i++)
+        set_pos(a_, i + 1, key[i/8] >> (i%8));
+
+    for (unsigned int i = 0; i < IV_LEN*8; i++)
+        set_pos(b_, i + 1, iv[i/8] >> (i%8));
+
+    /* s286 - s288 are positions 109 - 111 of register C */
+    set_pos(c_, 109, 1);
+    set_pos(c_, 110, 1);
+    set_pos(c_, 111, 1);
+
+    for (unsigned int i = 0; i < WARMUP_ROUNDS/64; i++)
+        next64();
+
+    ks_ = 0;
+    ks_len_ = 0;
+    pos_ = 0;
+}
+
+/*
+ * next64 - Produce the next 64 key stream bits
+ *
+ * Return key stream word, bit i being key stream bit i
+ *
+ * Additional information: The key stream word is not taken into account by
+ * position().
+ */
+std::uint64_t context::next64() {
+    return step(a_, b_, c_);
+}
+
+/*
+ * encrypt - Encrypt or decrypt a buffer, continuing the key stream
+ *
+ * @in: Input
+ * @out: Output of the same size, may be identical to in
+ *
+ * Additional information: Bytes left over from the previous key stream word
+ * are used first, whole words are then XORed 8 bytes at a time.
+ */
+void context::encrypt(std::span<const std::uint8_t> in, std::span<std::uint8_t> out) {
+    std::size_t n = in.size(), i = 0;
+    std::uint64_t dat;
+
+    if (out.size() != n)
+        throw std::invalid_argument("trivium::context::encrypt: input and output sizes differ");
+
+    const std::uint8_t *p_in = in.data();
+    std::uint8_t *p_out = out.data();
+
+    /* Rest of the current key stream word */
+    for (; i < n && ks_len_; i++, ks_len_--) {
+        p_out[i] = p_in[i] ^ static_cast<std::uint8_t>(ks_);
+        ks_ >>= 8;
+    }
+
+    /* Whole words */
+    if (i + 8 <= n) {
+        reg a = a_, b = b_, c = c_;
+
+        for (; i + 8 <= n; i += 8) {
+            std::memcpy(&dat, p_in + i, 8);
+            dat ^= to_le(step(a, b, c));
+            std::memcpy(p_out + i, &dat, 8);
+        }
+
+        a_ = a;
+        b_ = b;
+        c_ = c;
+    }
+
+    /* Start a new key stream word for the tail */
+    if (i < n) {
+        ks_ = next64();
+        for (ks_len_ = 8; i < n; i++, ks_len_--) {
+            p_out[i] = p_in[i] ^ static_cast<std::uint8_t>(ks_);
+            ks_ >>= 8;
+        }
+    }
+
+    pos_ += n;
+}
+
+void context::encrypt(std::span<std::uint8_t> buf) {
+    encrypt(buf, buf);
+}
+
+/*
+ * keystream - Write the next key stream bytes
+ *
+ * @out: Output
+ */
+void context::keystream(std::span<std::uint8_t> out) {
+    std::fill(out.begin(), out.end(), 0);
+    encrypt(out, out);
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef __TRIVIUM_HPP
+#define __TRIVIUM_HPP
+
+/*
+ * libtrivium - Word-parallel software implementation of Trivium
+ *
+ * The cipher produces the same key stream as the IP core, the Linux driver
+ * and reference_implementation/trivium.py. Key and IV are 10 bytes each,
+ * least significant byte first, i.e. bit i of the key is bit (i % 8) of
+ * key[i / 8] and is loaded into s(i + 1). Key stream bit k is XORed onto
+ * bit (k % 8) of data byte k / 8, so a 32-bit word stored in little-endian
+ * order is encrypted exactly like a word written to the core.
+ *
+ * Each register is kept as the last 128 bits shifted into it, packed into two
+ * 64-bit words. As no feedback tap of Trivium is closer than 64 positions to
+ * the input of its register, 64 key stream bits are produced per step using
+ * a handful of shifts and logic operations.
+ */
+
+#include <array>        /* std::array */
+#include <cstddef>      /* std::size_t */
+#include <cstdint>      /* Fixed size types */
+#include <span>         /* std::span */
+
+namespace trivium {
+
+constexpr std::size_t KEY_LEN = 10;         /* Number of key bytes */
+constexpr std::size_t IV_LEN = 10;          /* Number of IV bytes */
+constexpr unsigned int WARMUP_ROUNDS = 1152;    /* Rounds discarded after loading key and IV */
+
+/*
+ * context - State of a single key stream
+ *
+ * The context is incremental: consecutive calls of encrypt() and keystream()
+ * continue the key stream, regardless of how the data is split into calls.
+ * It is trivially copyable, so a copy is a snapshot from which the key stream
+ * can be resumed later.
+ */
+class context {
+public:
+    /* Creates a context without key and IV, init() must be called before use */
+    context() = default;
+
+    /* Creates a context and loads key and IV */
+    context(std::span<const std::uint8_t, KEY_LEN> key, std::span<const std::uint8_t, IV_LEN> iv);
+
+    /* Loads key and IV and runs the warm-up phase, starting a new key stream */
+    void init(std::span<const std::uint8_t, KEY_LEN> key, std::span<const std::uint8_t, IV_LEN> iv);
+
+    /*
+     * Encrypts or decrypts in into out, which must be of the same size. The
+     * buffers may be identical for in-place operation but must not overlap
+     * otherwise. Throws std::invalid_argument if the sizes differ.
+     */
+    void encrypt(std::span<const std::uint8_t> in, std::span<std::uint8_t> out);
+
+    /* Encrypts or decrypts buf in place */
+    void encrypt(std::span<std::uint8_t> buf);
+
+    /* Writes the next key stream bytes into out */
+    void keystream(std::span<std::uint8_t> out);
+
+    /* Produces the next 64 key stream bits, bit i being key stream bit i */
+    std::uint64_t next64();
+
+    /* Number of key stream bytes used since init() */
+    std::uint64_t position() const { return pos_; }
+
+private:
+    /* Registers A (s1 - s93), B (s94 - s177) and C (s178 - s288), see trivium.cpp */
+    std::array<std::uint64_t, 2> a_{}, b_{}, c_{};
+    std::uint64_t ks_ = 0;          /* Key stream word being used up */
+    unsigned int ks_len_ = 0;       /* Number of unused bytes of ks_, taken from the least significant end */
+    std::uint64_t pos_ = 0;         /* Key stream bytes used since init() */
+};
+
+}
+
+#endif
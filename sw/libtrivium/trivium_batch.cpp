@@ -0,0 +1,323 @@
+#include <algorithm>            /* std::min() */
+#include <bit>                  /* std::endian */
+#include <cstring>              /* std::memcpy() */
+#include <new>                  /* std::align_val_t */
+#include <stdexcept>            /* std::invalid_argument */
+#include "trivium_batch.hpp"    /* Library interface */
+#include "trivium_slice.hpp"    /* Bitsliced kernel */
+
+namespace trivium {
+
+/*******************************************************************************
+ * Scalar engine and engine selection
+ ******************************************************************************/
+
+namespace slice {
+
+static const engine_ops scalar_ops = {"scalar", 64, run<std::uint64_t>};
+
+const engine_ops *engine_scalar() {
+    return &scalar_ops;
+}
+
+}
+
+namespace {
+
+constexpr std::size_t ALIGN = 64;   /* Alignment of the planes, enough for AVX-512 */
+constexpr std::size_t Z_BLOCKS = 4; /* Blocks of key stream planes generated before XORing them */
+
+/*
+ * cpu_supports - Check whether the CPU supports an engine
+ *
+ * @type: Engine, not engine::automatic
+ *
+ * Return true if the engine was built and the CPU supports its instructions
+ */
+bool cpu_supports(engine type) {
+    switch (type) {
+    case engine::scalar:
+        return true;
+#if defined(__x86_64__) || defined(__i386__)
+    case engine::avx2:
+        return slice::engine_avx2() && __builtin_cpu_supports("avx2");
+    case engine::avx512:
+        return slice::engine_avx512() && __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+/*
+ * select_engine - Find the engine to use
+ *
+ * @type: Requested engine
+ *
+ * Return engine operations
+ */
+const slice::engine_ops *select_engine(engine type) {
+    if (type == engine::automatic) {
+        if (cpu_supports(engine::avx512))
+            return slice::engine_avx512();
+
+        if (cpu_supports(engine::avx2))
+            return slice::engine_avx2();
+
+        return slice::engine_scalar();
+    }
+
+    if (!cpu_supports(type))
+        throw std::invalid_argument("trivium::batch: engine not supported on this CPU");
+
+    switch (type) {
+    case engine::avx2:
+        return slice::engine_avx2();
+    case engine::avx512:
+        return slice::engine_avx512();
+    default:
+        return slice::engine_scalar();
+    }
+}
+
+/* Little-endian byte order of a key stream word, matching the bit order of the data */
+inline std::uint64_t to_le(std::uint64_t val) {
+    if constexpr (std::endian::native == std::endian::big)
+        return __builtin_bswap64(val);
+
+    return val;
+}
+
+/*
+ * load_planes - Bitslice 80-bit values of 64 sessions into a register
+ *
+ * @p_reg: First plane of the register
+ * @words: 64-bit words per plane
+ * @k: Word of the planes holding the sessions
+ * @p_vals: Values of the sessions, least significant byte first, nullptr for missing sessions
+ *
+ * Additional information: Bit i of a value is position i + 1 of the register,
+ * i.e. plane HIST - 1 - i. The values form two 64x64 bit tiles, one row per
+ * session, which are transposed into one row per plane.
+ */
+void load_planes(std::uint64_t *p_reg, unsigned int words, unsigned int k, const std::uint8_t * const *p_vals) {
+    std::uint64_t lo[64], hi[64];
+
+    for (unsigned int j = 0; j < 64; j++) {
+        lo[j] = 0;
+        hi[j] = 0;
+        if (p_vals[j]) {
+            std::memcpy(&lo[j], p_vals[j], 8);
+            lo[j] = to_le(lo[j]);
+            hi[j] = p_vals[j][8] | static_cast<std::uint64_t>(p_vals[j][9]) << 8;
+        }
+    }
+
+    slice::transpose(lo);
+    slice::transpose(hi);
+    for (unsigned int i = 0; i < 64; i++)
+        p_reg[(slice::HIST - 1 - i)*words + k] = lo[i];
+
+    for (unsigned int i = 0; i < 16; i++)
+        p_reg[(slice::HIST - 1 - 64 - i)*words + k] = hi[i];
+}
+
+}
+
+/*******************************************************************************
+ * Batch
+ ******************************************************************************/
+
+void batch::aligned_delete::operator()(std::uint8_t *p) const {
+    ::operator delete[](p, std::align_val_t(ALIGN));
+}
+
+batch::planes batch::alloc_planes(std::size_t bytes) {
+    return planes(static_cast<std::uint8_t *>(::operator new[](bytes, std::align_val_t(ALIGN))));
+}
+
+batch::batch(std::size_t num_sessions, engine type)
+    : p_ops_(select_engine(type)), num_sessions_(num_sessions) {
+    std::size_t plane_bytes = p_ops_->width/8;
+
+    num_groups_ = (num_sessions + p_ops_->width - 1)/p_ops_->width;
+    group_bytes_ = 3*slice::REG_PLANES*plane_bytes;
+    regs_ = alloc_planes(num_groups_ ? num_groups_*group_bytes_ : ALIGN);
+    z_block_bytes_ = slice::BLK*plane_bytes;
+    z_ = alloc_planes(Z_BLOCKS*z_block_bytes_);
+    ks_.resize(num_groups_*p_ops_->width*slice::BLK_BYTES);
+    ks_off_ = slice::BLK_BYTES;
+    std::memset(regs_.get(), 0, num_groups_*group_bytes_);
+}
+
+const char *batch::engine_name() const {
+    return p_ops_->p_name;
+}
+
+bool batch::supported(engine type) {
+    return type == engine::automatic || cpu_supports(type);
+}
+
+/*
+ * init - Load key and IV of every session and run the warm-up phase
+ *
+ * @keys: Keys, least significant byte first
+ * @ivs: IVs, least significant byte first
+ *
+ * Additional information: Key bit i is position i + 1 of register A and IV
+ * bit i position i + 1 of register B, see load_planes(). Positions 109 - 111
+ * of register C are set in all sessions, including the unused ones of the
+ * last group. The warm-up runs on all sessions of a group at once.
+ */
+void batch::init(std::span<const key_type> keys, std::span<const iv_type> ivs) {
+    unsigned int width = p_ops_->width, words = width/64;
+
+    if (keys.size() != num_sessions_ || ivs.size() != num_sessions_)
+        throw std::invalid_argument("trivium::batch::init: need one key and one IV per session");
+
+    std::memset(regs_.get(), 0, num_groups_*group_bytes_);
+    for (std::size_t g = 0; g < num_groups_; g++) {
+        std::uint64_t *p_a = reinterpret_cast<std::uint64_t *>(regs_.get() + g*group_bytes_);
+        std::uint64_t *p_b = p_a + slice::REG_PLANES*words;
+        std::uint64_t *p_c = p_b + slice::REG_PLANES*words;
+
+        for (unsigned int k = 0; k < words; k++) {
+            const std::uint8_t *p_keys[64], *p_ivs[64];
+
+            for (unsigned int j = 0; j < 64; j++) {
+                std::size_t s = g*width + k*64 + j;
+
+                p_keys[j] = s < num_sessions_ ? keys[s].data() : nullptr;
+                p_ivs[j] = s < num_sessions_ ? ivs[s].data() : nullptr;
+            }
+
+            load_planes(p_a, words, k, p_keys);
+            load_planes(p_b, words, k, p_ivs);
+        }
+
+        for (unsigned int p = 109; p <= 111; p++)
+            std::memset(p_c + (slice::HIST - p)*words, 0xff, words*sizeof(std::uint64_t));
+
+        for (unsigned int i = 0; i < WARMUP_ROUNDS/slice::BLK; i++)
+            p_ops_->run(regs_.get() + g*group_bytes_, nullptr);
+    }
+
+    ks_off_ = slice::BLK_BYTES;
+}
+
+/*
+ * save_ks - Keep the key stream of the last block of a group for the next call
+ *
+ * @group: Group
+ */
+void batch::save_ks(std::size_t group) {
+    unsigned int width = p_ops_->width, words = width/64;
+    const std::uint64_t *p_z = reinterpret_cast<const std::uint64_t *>(z_.get());
+
+    for (unsigned int k = 0; k < words; k++) {
+        for (unsigned int j = 0; j < 64; j++) {
+            for (unsigned int r = 0; r < slice::BLK/64; r++) {
+                std::uint64_t ks = to_le(p_z[(r*64 + j)*words + k]);
+
+                std::memcpy(ks_.data() + (group*width + k*64 + j)*slice::BLK_BYTES + r*8, &ks, 8);
+            }
+        }
+    }
+}
+
+/*
+ * encrypt - Encrypt or decrypt len bytes per session
+ *
+ * @in: Input, size()*len bytes
+ * @out: Output, size()*len bytes, may be identical to in
+ * @len: Bytes per session
+ *
+ * Additional information: The unused key stream of the previous call is
+ * used first. Afterwards each group runs all of its blocks before the next
+ * group starts, so its registers stay in the cache. Whole blocks are XORed
+ * 8 bytes at a time straight from the transposed key stream planes, the key
+ * stream of a last partial block is kept for the next call. Since key stream
+ * block i of the planes is word i of each session, the Z_BLOCKS blocks in z_
+ * are simply consecutive planes.
+ */
+void batch::encrypt(std::span<const std::uint8_t> in, std::span<std::uint8_t> out, std::size_t len) {
+    unsigned int width = p_ops_->width, words = width/64;
+    const std::uint64_t *p_z = reinterpret_cast<const std::uint64_t *>(z_.get());
+    std::size_t rest, num_blocks, off;
+    std::uint64_t dat;
+
+    if (in.size() != num_sessions_*len || out.size() != num_sessions_*len)
+        throw std::invalid_argument("trivium::batch::encrypt: buffer size does not match");
+
+    const std::uint8_t *p_in = in.data();
+    std::uint8_t *p_out = out.data();
+
+    /* Key stream left over from the previous call */
+    rest = std::min<std::size_t>(slice::BLK_BYTES - ks_off_, len);
+    for (std::size_t s = 0; s < num_sessions_ && rest; s++)
+        for (std::size_t i = 0; i < rest; i++)
+            p_out[s*len + i] = p_in[s*len + i] ^ ks_[s*slice::BLK_BYTES + ks_off_ + i];
+
+    ks_off_ += rest;
+    if (rest == len)
+        return;
+
+    num_blocks = (len - rest)/slice::BLK_BYTES;
+    for (std::size_t g = 0; g < num_groups_; g++) {
+        std::size_t first = g*width, last = std::min<std::size_t>(first + width, num_sessions_);
+        std::uint8_t *p_regs = regs_.get() + g*group_bytes_;
+
+        /* Whole blocks, Z_BLOCKS at a time so that each session gets a contiguous run of key stream */
+        off = rest;
+        for (std::size_t b = 0; b < num_blocks; b += Z_BLOCKS) {
+            std::size_t n = std::min<std::size_t>(Z_BLOCKS, num_blocks - b);
+
+            for (std::size_t i = 0; i < n; i++)
+                p_ops_->run(p_regs, z_.get() + i*z_block_bytes_);
+
+            for (std::size_t s = first; s < last; s++) {
+                unsigned int j = (s - first)%64, k = (s - first)/64;
+
+                for (std::size_t i = 0; i < n*slice::BLK/64; i++) {
+                    std::memcpy(&dat, p_in + s*len + off + i*8, 8);
+                    dat ^= to_le(p_z[(i*64 + j)*words + k]);
+                    std::memcpy(p_out + s*len + off + i*8, &dat, 8);
+                }
+            }
+
+            off += n*slice::BLK_BYTES;
+        }
+
+        /* Partial block, its key stream is kept for the next call */
+        if (off < len) {
+            p_ops_->run(p_regs, z_.get());
+            save_ks(g);
+            for (std::size_t s = first; s < last; s++) {
+                const std::uint8_t *p_ks = ks_.data() + s*slice::BLK_BYTES;
+
+                for (std::size_t i = 0; i < len - off; i++)
+                    p_out[s*len + off + i] = p_in[s*len + off + i] ^ p_ks[i];
+            }
+        }
+    }
+
+    /* The last block may not have been used up */
+    ks_off_ = (len - rest)%slice::BLK_BYTES ? (len - rest)%slice::BLK_BYTES : slice::BLK_BYTES;
+}
+
+void batch::encrypt(std::span<std::uint8_t> buf, std::size_t len) {
+    encrypt(buf, buf, len);
+}
+
+/*
+ * keystream - Write the next len key stream bytes of every session
+ *
+ * @out: Output, size()*len bytes
+ * @len: Bytes per session
+ */
+void batch::keystream(std::span<std::uint8_t> out, std::size_t len) {
+    std::fill(out.begin(), out.end(), 0);
+    encrypt(out, out, len);
+}
+
+}
@@ -0,0 +1,106 @@
+#ifndef __TRIVIUM_BATCH_HPP
+#define __TRIVIUM_BATCH_HPP
+
+/*
+ * libtrivium - Bitsliced multi-session engine
+ *
+ * trivium::batch runs many independent sessions, each with its own key and
+ * IV, in lockstep. The sessions are bitsliced into groups of 64 (scalar),
+ * 256 (AVX2) or 512 (AVX-512) that are processed with one instruction per
+ * plane, which also amortizes the 1152 warm-up rounds across a group. The
+ * engine is chosen at runtime from the instruction sets the CPU supports.
+ *
+ * All sessions advance by the same number of bytes per call. Data is laid
+ * out session after session, i.e. the len bytes of session s start at offset
+ * s*len. The key stream of every session is the one trivium::context
+ * produces for its key and IV.
+ */
+
+#include <array>        /* std::array */
+#include <cstddef>      /* std::size_t */
+#include <cstdint>      /* Fixed size types */
+#include <memory>       /* std::unique_ptr */
+#include <span>         /* std::span */
+#include <vector>       /* std::vector */
+#include "trivium.hpp"  /* KEY_LEN and IV_LEN */
+
+namespace trivium {
+
+namespace slice {
+struct engine_ops;
+}
+
+/* Bitsliced engines */
+enum class engine {
+    automatic,  /* Widest engine supported by the CPU */
+    scalar,     /* 64-bit integer operations, always available */
+    avx2,       /* 256-bit AVX2 vectors */
+    avx512      /* 512-bit AVX-512F vectors */
+};
+
+using key_type = std::array<std::uint8_t, KEY_LEN>;
+using iv_type = std::array<std::uint8_t, IV_LEN>;
+
+class batch {
+public:
+    /*
+     * Creates a batch of num_sessions sessions without key and IV. Throws
+     * std::invalid_argument if the requested engine is not available.
+     */
+    explicit batch(std::size_t num_sessions, engine type = engine::automatic);
+
+    /*
+     * Loads key and IV of every session and runs the warm-up phase, starting
+     * new key streams. Throws std::invalid_argument unless there is one key
+     * and one IV per session.
+     */
+    void init(std::span<const key_type> keys, std::span<const iv_type> ivs);
+
+    /*
+     * Encrypts or decrypts len bytes per session from in into out, both
+     * holding size()*len bytes. The buffers may be identical for in-place
+     * operation but must not overlap otherwise. Throws std::invalid_argument
+     * if a buffer size does not match.
+     */
+    void encrypt(std::span<const std::uint8_t> in, std::span<std::uint8_t> out, std::size_t len);
+
+    /* Encrypts or decrypts len bytes per session in place */
+    void encrypt(std::span<std::uint8_t> buf, std::size_t len);
+
+    /* Writes the next len key stream bytes of every session into out */
+    void keystream(std::span<std::uint8_t> out, std::size_t len);
+
+    /* Number of sessions */
+    std::size_t size() const { return num_sessions_; }
+
+    /* Name of the engine in use */
+    const char *engine_name() const;
+
+    /* Checks whether an engine can be used on this CPU */
+    static bool supported(engine type);
+
+private:
+    /* Frees the 64-byte aligned plane storage */
+    struct aligned_delete {
+        void operator()(std::uint8_t *p) const;
+    };
+
+    using planes = std::unique_ptr<std::uint8_t[], aligned_delete>;
+
+    static planes alloc_planes(std::size_t bytes);
+    void save_ks(std::size_t group);
+
+    const slice::engine_ops *p_ops_;    /* Engine in use */
+    std::size_t num_sessions_;          /* Number of sessions */
+    std::size_t num_groups_;            /* Number of groups of p_ops_->width sessions */
+    std::size_t group_bytes_;           /* Size of the registers of a group */
+    planes regs_;                       /* Registers of all groups */
+    std::size_t z_block_bytes_;         /* Size of the key stream planes of a block */
+    planes z_;                          /* Transposed key stream planes of the last blocks */
+    std::vector<std::uint8_t> ks_;      /* Unused key stream of the last block, slice::BLK_BYTES per session */
+    unsigned int ks_off_;               /* First unused byte in the key stream of each session */
+};
+
+}
+
+#endif
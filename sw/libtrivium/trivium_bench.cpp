@@ -0,0 +1,141 @@
+/*
+ * trivium_bench - Measure the throughput of libtrivium
+ *
+ * Usage: trivium_bench [<min_bytes> [<total_bytes>]]
+ *
+ * Encrypts buffers of min_bytes, 4*min_bytes, ... up to 1 MiB in place until
+ * total_bytes have been processed per size and reports cycles per byte and
+ * throughput. Cycles are read from the time stamp counter on x86, elsewhere
+ * they are not available and only the throughput is reported. The cost of a
+ * key and IV setup, i.e. of the warm-up phase, is reported separately.
+ *
+ * Afterwards the bitsliced engines of trivium::batch that the CPU supports
+ * are compared with one trivium::context per session: sessions per second
+ * for short messages (setup and 64 bytes per session) and throughput for
+ * long ones (4 KiB per session).
+ */
+#include <chrono>       /* std::chrono::steady_clock */
+#include <cstdio>       /* std::printf() */
+#include <cstdlib>      /* std::strtoull() */
+#include <vector>       /* std::vector */
+#include "trivium.hpp"  /* Library interface */
+#include "trivium_batch.hpp"    /* Bitsliced multi-session engine */
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  /* __rdtsc() */
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+/* Time stamp counter, 0 if there is none */
+static inline std::uint64_t cycles() {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* Keeps the compiler from discarding results */
+static volatile std::uint8_t sink;
+
+int main(int argc, char **argv) {
+    std::size_t min_bytes = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 64;
+    std::size_t total_bytes = argc > 2 ? std::strtoull(argv[2], nullptr, 0) : (std::size_t)256 << 20;
+    std::array<std::uint8_t, trivium::KEY_LEN> key{0xd0, 0xa5, 0xb8, 0xb5, 0xbb, 0x4a, 0xc3, 0x75, 0x62, 0xea};
+    std::array<std::uint8_t, trivium::IV_LEN> iv{0x9f, 0x71, 0x9b, 0x04, 0xbd, 0x20, 0xca, 0x4a, 0xe6, 0x00};
+    trivium::context ctx;
+    const unsigned int num_inits = 100000;
+
+    if (!min_bytes)
+        min_bytes = 1;
+
+    /* Key and IV setup */
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t c0 = cycles();
+    for (unsigned int i = 0; i < num_inits; i++) {
+        iv[0] = static_cast<std::uint8_t>(i);
+        ctx.init(key, iv);
+    }
+    std::uint64_t c1 = cycles();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = static_cast<std::uint8_t>(ctx.next64());
+
+    std::printf("%-12s %12s %12s\n", "operation", "cycles", "ns");
+    std::printf("%-12s %12.1f %12.1f\n", "init", HAVE_TSC ? double(c1 - c0)/num_inits : 0.0, ns/num_inits);
+    std::printf("\n%-12s %12s %12s\n", "bytes", "cycles/byte", "MB/s");
+
+    for (std::size_t sz = min_bytes; sz <= ((std::size_t)1 << 20); sz *= 4) {
+        std::vector<std::uint8_t> buf(sz, 0x5a);
+        std::size_t iters = total_bytes/sz ? total_bytes/sz : 1;
+
+        ctx.init(key, iv);
+        start = std::chrono::steady_clock::now();
+        c0 = cycles();
+        for (std::size_t i = 0; i < iters; i++)
+            ctx.encrypt(buf);
+        c1 = cycles();
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sink = buf[0];
+
+        std::printf("%-12zu %12.3f %12.1f\n", sz, HAVE_TSC ? double(c1 - c0)/(double(iters)*sz) : 0.0,
+                    double(iters)*sz*1e3/ns);
+    }
+
+    /* Many sessions */
+    const std::size_t num_sessions = 4096, short_len = 64, long_len = 4096;
+    std::vector<trivium::key_type> keys(num_sessions, key);
+    std::vector<trivium::iv_type> ivs(num_sessions, iv);
+    std::vector<std::uint8_t> data(num_sessions*long_len, 0x5a);
+
+    for (std::size_t i = 0; i < num_sessions; i++) {
+        ivs[i][0] = static_cast<std::uint8_t>(i);
+        ivs[i][1] = static_cast<std::uint8_t>(i >> 8);
+    }
+
+    std::printf("\n%u sessions: %zu bytes each / %zu bytes each\n", (unsigned int)num_sessions, short_len, long_len);
+    std::printf("%-12s %12s %12s %12s\n", "engine", "sessions/s", "MB/s", "cycles/byte");
+
+    /* One context per session */
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < num_sessions; i++) {
+        ctx.init(keys[i], ivs[i]);
+        ctx.encrypt(std::span<std::uint8_t>(data).subspan(i*short_len, short_len));
+    }
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double sessions_s = num_sessions*1e9/ns;
+
+    start = std::chrono::steady_clock::now();
+    c0 = cycles();
+    for (std::size_t i = 0; i < num_sessions; i++)
+        ctx.encrypt(std::span<std::uint8_t>(data).subspan(i*long_len, long_len));
+    c1 = cycles();
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = data[0];
+    std::printf("%-12s %12.0f %12.1f %12.3f\n", "context", sessions_s, double(data.size())*1e3/ns,
+                HAVE_TSC ? double(c1 - c0)/data.size() : 0.0);
+
+    for (trivium::engine type : {trivium::engine::scalar, trivium::engine::avx2, trivium::engine::avx512}) {
+        if (!trivium::batch::supported(type))
+            continue;
+
+        trivium::batch bat(num_sessions, type);
+
+        start = std::chrono::steady_clock::now();
+        bat.init(keys, ivs);
+        bat.encrypt(std::span<std::uint8_t>(data).first(num_sessions*short_len), short_len);
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sessions_s = num_sessions*1e9/ns;
+
+        start = std::chrono::steady_clock::now();
+        c0 = cycles();
+        bat.encrypt(data, long_len);
+        c1 = cycles();
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sink = data[0];
+        std::printf("%-12s %12.0f %12.1f %12.3f\n", bat.engine_name(), sessions_s, double(data.size())*1e3/ns,
+                    HAVE_TSC ? double(c1 - c0)/data.size() : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,468 @@
+/*
+ * trivium_gen - Generate test vectors
+ *
+ * Usage: trivium_gen [-n <tests>] [-s <seed>] [-j <threads>] [-l <lengths>]
+ *                    [-e <percent>] [-b] [<ref_in> <ref_out> | <file>]
+ *
+ *   -n <tests>     Number of tests (default 10)
+ *   -s <seed>      Seed of the random number generator (default 1)
+ *   -j <threads>   Worker threads (default: one per CPU)
+ *   -l <lengths>   Distribution of the number of 32-bit words per test:
+ *                  fixed:<n>, uniform:<min>:<max> (default uniform:10:100)
+ *                  or geometric:<mean>
+ *   -e <percent>   Percentage of edge case tests (default 0), see below
+ *   -b             Write the binary format of trivium_vectors.hpp instead of
+ *                  the text files
+ *
+ * The text format is the one of reference_implementation/trivium.py that is
+ * read by the testbenches, written to trivium_ref_in.txt and
+ * trivium_ref_out.txt unless other names are given. The binary format is
+ * written to trivium_ref.bin by default.
+ *
+ * Every test draws its key, IV, length and plaintext from its own generator,
+ * seeded from the seed and the test number, so the output only depends on
+ * the seed and the options and not on the number of threads. The workers
+ * generate chunks of tests into memory, which are written in order.
+ *
+ * Edge cases: all-zero and all-one keys and IVs in every combination, keys
+ * and IVs with a single bit set, all-zero and all-one plaintexts (the former
+ * yielding the bare key stream) and single-word messages. If -e is given,
+ * the first tests cover every edge case once.
+ */
+#include <algorithm>    /* std::min() */
+#include <atomic>       /* std::atomic */
+#include <bit>          /* std::endian */
+#include <chrono>       /* std::chrono::steady_clock */
+#include <cmath>        /* std::log() */
+#include <cstdio>       /* std::fopen() */
+#include <cstdlib>      /* EXIT_SUCCESS and co. */
+#include <cstring>      /* std::memcpy() */
+#include <string>       /* std::string */
+#include <thread>       /* std::thread */
+#include <vector>       /* std::vector */
+#include <unistd.h>     /* getopt() */
+#include "trivium.hpp"  /* Library interface */
+#include "trivium_vectors.hpp"  /* Binary test vector format */
+
+namespace {
+
+constexpr std::uint64_t CHUNK_TESTS = 1024;     /* Tests generated by a worker at a time */
+constexpr std::uint32_t MAX_WORDS = 1u << 24;   /* Longest message of the geometric distribution */
+
+/* Edge cases */
+enum edge_case {
+    EDGE_ZERO_KEY_IV,       /* All-zero key and IV */
+    EDGE_ONE_KEY_IV,        /* All-one key and IV */
+    EDGE_ZERO_KEY_ONE_IV,   /* All-zero key, all-one IV */
+    EDGE_ONE_KEY_ZERO_IV,   /* All-one key, all-zero IV */
+    EDGE_KEY_BIT,           /* Single key bit set, all-zero IV */
+    EDGE_IV_BIT,            /* All-zero key, single IV bit set */
+    EDGE_ZERO_PT,           /* All-zero plaintext */
+    EDGE_ONE_PT,            /* All-one plaintext */
+    EDGE_ONE_WORD,          /* Single-word message */
+    EDGE_NUM
+};
+
+/* Distribution of the message lengths */
+struct len_dist {
+    enum { FIXED, UNIFORM, GEOMETRIC } type;
+    std::uint32_t   min;    /* Shortest message (fixed and uniform) */
+    std::uint32_t   max;    /* Longest message (uniform) */
+    double          mean;   /* Mean length (geometric) */
+};
+
+/* Generator options */
+struct options {
+    std::uint64_t   num_tests;
+    std::uint64_t   seed;
+    unsigned int    num_threads;
+    len_dist        lengths;
+    unsigned int    edge_pct;
+    bool            binary;
+};
+
+/* Output of a worker for one chunk */
+struct chunk_buf {
+    std::string     in;     /* Text input file or binary records */
+    std::string     out;    /* Text output file */
+};
+
+/*
+ * SplitMix64, see Steele et al., "Fast splittable pseudorandom number
+ * generators". It is used instead of the <random> distributions, whose output
+ * differs between standard libraries.
+ */
+inline std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+struct rng {
+    std::uint64_t state;
+
+    /* Independent generator of a test */
+    rng(std::uint64_t seed, std::uint64_t test) : state(mix64(seed ^ mix64(test + 1))) {}
+
+    std::uint64_t operator()() {
+        state += 0x9e3779b97f4a7c15ULL;
+        return mix64(state);
+    }
+
+    /* Uniform value in [lo, hi] */
+    std::uint32_t range(std::uint32_t lo, std::uint32_t hi) {
+        return lo + static_cast<std::uint32_t>(((*this)() >> 32)*(static_cast<std::uint64_t>(hi) - lo + 1) >> 32);
+    }
+
+    /* Uniform value in (0, 1] */
+    double unit() {
+        return static_cast<double>(((*this)() >> 11) + 1)*0x1p-53;
+    }
+};
+
+/* Little-endian byte order of a word */
+inline std::uint32_t to_le32(std::uint32_t val) {
+    if constexpr (std::endian::native == std::endian::big)
+        return __builtin_bswap32(val);
+
+    return val;
+}
+
+/*
+ * num_words - Draw the length of a message
+ *
+ * @dist: Distribution
+ * @r: Generator of the test
+ *
+ * Return number of 32-bit words, at least 1
+ *
+ * Additional information: The geometric distribution is 1 plus the number of
+ * failures before the first success with probability 1/mean, which has the
+ * requested mean, drawn by inversion.
+ */
+std::uint32_t num_words(const len_dist &dist, rng &r) {
+    switch (dist.type) {
+    case len_dist::UNIFORM:
+        return r.range(dist.min, dist.max);
+    case len_dist::GEOMETRIC: {
+        if (dist.mean <= 1.0)
+            return 1;
+
+        double n = std::floor(std::log(r.unit())/std::log1p(-1.0/dist.mean));
+        return n >= MAX_WORDS - 1 ? MAX_WORDS : static_cast<std::uint32_t>(n) + 1;
+    }
+    default:
+        return dist.min;
+    }
+}
+
+/* Lowercase hex digits of every byte */
+struct hex_table {
+    char digits[256][2];
+
+    hex_table() {
+        for (unsigned int i = 0; i < 256; i++) {
+            digits[i][0] = "0123456789abcdef"[i >> 4];
+            digits[i][1] = "0123456789abcdef"[i & 15];
+        }
+    }
+};
+
+const hex_table hex;
+
+/* Append bytes as hex number followed by a line feed, most significant (i.e. last) byte first */
+inline void put_hex(std::string &s, const std::uint8_t *p_bytes, std::size_t n) {
+    std::size_t off = s.size();
+
+    s.resize(off + 2*n + 1);
+    char *p = s.data() + off;
+    for (std::size_t i = n; i--; p += 2)
+        std::memcpy(p, hex.digits[p_bytes[i]], 2);
+
+    *p = '\n';
+}
+
+/*
+ * gen_test - Generate one test
+ *
+ * @opts: Options
+ * @test: Number of the test
+ * @ctx: Context to use
+ * @msg: Scratch buffer for the message
+ * @buf: Output
+ *
+ * Return number of 32-bit words of the test
+ */
+std::uint32_t gen_test(const options &opts, std::uint64_t test, trivium::context &ctx, std::vector<std::uint8_t> &msg,
+                       chunk_buf &buf) {
+    rng r(opts.seed, test);
+    trivium::vec_record_header hdr;
+    unsigned int edge = EDGE_NUM;
+    std::uint32_t len;
+
+    /* The first tests cover every edge case, afterwards they are drawn at random */
+    if (opts.edge_pct) {
+        if (test < EDGE_NUM)
+            edge = static_cast<unsigned int>(test);
+        else if (r.range(0, 99) < opts.edge_pct)
+            edge = r.range(0, EDGE_NUM - 1);
+    }
+
+    for (std::size_t i = 0; i < trivium::KEY_LEN; i += 8) {
+        std::uint64_t val = r();
+
+        std::memcpy(hdr.key + i, &val, std::min<std::size_t>(8, trivium::KEY_LEN - i));
+        val = r();
+        std::memcpy(hdr.iv + i, &val, std::min<std::size_t>(8, trivium::IV_LEN - i));
+    }
+
+    switch (edge) {
+    case EDGE_ZERO_KEY_IV:
+    case EDGE_ZERO_KEY_ONE_IV:
+    case EDGE_IV_BIT:
+        std::memset(hdr.key, 0, sizeof(hdr.key));
+        break;
+    case EDGE_ONE_KEY_IV:
+    case EDGE_ONE_KEY_ZERO_IV:
+        std::memset(hdr.key, 0xff, sizeof(hdr.key));
+        break;
+    case EDGE_KEY_BIT: {
+        unsigned int bit = r.range(0, trivium::KEY_LEN*8 - 1);
+
+        std::memset(hdr.key, 0, sizeof(hdr.key));
+        hdr.key[bit/8] = static_cast<std::uint8_t>(1u << (bit%8));
+        break;
+    }
+    }
+
+    switch (edge) {
+    case EDGE_ZERO_KEY_IV:
+    case EDGE_ONE_KEY_ZERO_IV:
+    case EDGE_KEY_BIT:
+        std::memset(hdr.iv, 0, sizeof(hdr.iv));
+        break;
+    case EDGE_ONE_KEY_IV:
+    case EDGE_ZERO_KEY_ONE_IV:
+        std::memset(hdr.iv, 0xff, sizeof(hdr.iv));
+        break;
+    case EDGE_IV_BIT: {
+        unsigned int bit = r.range(0, trivium::IV_LEN*8 - 1);
+
+        std::memset(hdr.iv, 0, sizeof(hdr.iv));
+        hdr.iv[bit/8] = static_cast<std::uint8_t>(1u << (bit%8));
+        break;
+    }
+    }
+
+    len = edge == EDGE_ONE_WORD ? 1 : num_words(opts.lengths, r);
+    hdr.num_words = to_le32(len);
+
+    /* Plaintext, 8 bytes per draw */
+    msg.resize(static_cast<std::size_t>(len)*4 + 4);
+    if (edge == EDGE_ZERO_PT || edge == EDGE_ONE_PT) {
+        std::memset(msg.data(), edge == EDGE_ZERO_PT ? 0 : 0xff, msg.size());
+    }
+    else {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(len)*4; i += 8) {
+            std::uint64_t val = r();
+
+            std::memcpy(msg.data() + i, &val, 8);
+        }
+    }
+
+    std::span<std::uint8_t> pt(msg.data(), static_cast<std::size_t>(len)*4);
+    ctx.init(std::span<const std::uint8_t, trivium::KEY_LEN>(hdr.key, trivium::KEY_LEN),
+             std::span<const std::uint8_t, trivium::IV_LEN>(hdr.iv, trivium::IV_LEN));
+
+    if (opts.binary) {
+        std::size_t off = buf.in.size();
+
+        buf.in.resize(off + sizeof(hdr) + 2*pt.size());
+        std::uint8_t *p = reinterpret_cast<std::uint8_t *>(buf.in.data()) + off;
+        std::memcpy(p, &hdr, sizeof(hdr));
+        std::memcpy(p + sizeof(hdr), pt.data(), pt.size());
+        ctx.encrypt(pt, std::span<std::uint8_t>(p + sizeof(hdr) + pt.size(), pt.size()));
+        return len;
+    }
+
+    put_hex(buf.in, hdr.key, trivium::KEY_LEN);
+    put_hex(buf.in, hdr.iv, trivium::IV_LEN);
+    for (std::size_t i = 0; i < pt.size(); i += 4)
+        put_hex(buf.in, pt.data() + i, 4);
+
+    ctx.encrypt(pt);
+    for (std::size_t i = 0; i < pt.size(); i += 4)
+        put_hex(buf.out, pt.data() + i, 4);
+
+    buf.in += "-\n";
+    buf.out += "-\n";
+    return len;
+}
+
+/*
+ * parse_lengths - Parse the -l option
+ *
+ * @p_arg: Argument
+ * @dist: Resulting distribution
+ *
+ * Return true on success
+ *
+ * Additional information: Every test needs at least one word, as the
+ * testbenches expect at least one result per test.
+ */
+bool parse_lengths(const char *p_arg, len_dist &dist) {
+    unsigned long min, max;
+    double mean;
+    char end;
+
+    if (std::sscanf(p_arg, "fixed:%lu%c", &min, &end) == 1) {
+        dist = {len_dist::FIXED, static_cast<std::uint32_t>(min), static_cast<std::uint32_t>(min), 0.0};
+        return min >= 1 && min <= MAX_WORDS;
+    }
+
+    if (std::sscanf(p_arg, "uniform:%lu:%lu%c", &min, &max, &end) == 2) {
+        dist = {len_dist::UNIFORM, static_cast<std::uint32_t>(min), static_cast<std::uint32_t>(max), 0.0};
+        return min >= 1 && min <= max && max <= MAX_WORDS;
+    }
+
+    if (std::sscanf(p_arg, "geometric:%lf%c", &mean, &end) == 1) {
+        dist = {len_dist::GEOMETRIC, 1, MAX_WORDS, mean};
+        return mean >= 1.0 && mean <= MAX_WORDS;
+    }
+
+    return false;
+}
+
+void usage(const char *p_name) {
+    std::fprintf(stderr,
+                 "Usage: %s [-n <tests>] [-s <seed>] [-j <threads>] [-l <lengths>] [-e <percent>] [-b]\n"
+                 "       %*s [<ref_in> <ref_out> | <file>]\n"
+                 "  <lengths>: fixed:<n>, uniform:<min>:<max> or geometric:<mean> words\n",
+                 p_name, static_cast<int>(std::strlen(p_name)), "");
+}
+
+}
+
+int main(int argc, char **argv) {
+    options opts = {10, 1, std::max(1u, std::thread::hardware_concurrency()),
+                    {len_dist::UNIFORM, 10, 100, 0.0}, 0, false};
+    const char *p_names[2];
+    std::FILE *p_files[2] = {nullptr, nullptr};
+    std::uint64_t total_words;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:j:l:e:b")) != -1) {
+        switch (opt) {
+        case 'n':
+            opts.num_tests = std::strtoull(optarg, nullptr, 0);
+            break;
+        case 's':
+            opts.seed = std::strtoull(optarg, nullptr, 0);
+            break;
+        case 'j':
+            opts.num_threads = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 'l':
+            if (!parse_lengths(optarg, opts.lengths)) {
+                std::fprintf(stderr, "Invalid length distribution '%s'\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'e':
+            opts.edge_pct = static_cast<unsigned int>(std::min(100ul, std::strtoul(optarg, nullptr, 0)));
+            break;
+        case 'b':
+            opts.binary = true;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opts.binary) {
+        p_names[0] = optind < argc ? argv[optind] : "trivium_ref.bin";
+        p_names[1] = nullptr;
+    }
+    else if (optind + 2 <= argc) {
+        p_names[0] = argv[optind];
+        p_names[1] = argv[optind + 1];
+    }
+    else {
+        p_names[0] = "trivium_ref_in.txt";
+        p_names[1] = "trivium_ref_out.txt";
+    }
+
+    for (unsigned int i = 0; i < 2; i++) {
+        if (p_names[i] && !(p_files[i] = std::fopen(p_names[i], "wb"))) {
+            std::fprintf(stderr, "Could not open %s\n", p_names[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opts.binary) {
+        trivium::vec_file_header hdr;
+
+        std::memcpy(hdr.magic, trivium::VEC_MAGIC, sizeof(hdr.magic));
+        hdr.version = to_le32(trivium::VEC_VERSION);
+        hdr.num_tests = opts.num_tests;
+        if constexpr (std::endian::native == std::endian::big)
+            hdr.num_tests = __builtin_bswap64(hdr.num_tests);
+
+        std::fwrite(&hdr, sizeof(hdr), 1, p_files[0]);
+    }
+
+    /* Rounds of one chunk per worker, written in order once all of them are done */
+    auto start = std::chrono::steady_clock::now();
+    std::vector<chunk_buf> bufs(opts.num_threads);
+    std::atomic<std::uint64_t> words{0};
+
+    for (std::uint64_t first = 0; first < opts.num_tests; first += opts.num_threads*CHUNK_TESTS) {
+        std::vector<std::thread> workers;
+
+        for (unsigned int t = 0; t < opts.num_threads; t++) {
+            std::uint64_t begin = std::min(first + t*CHUNK_TESTS, opts.num_tests);
+            std::uint64_t end = std::min(begin + CHUNK_TESTS, opts.num_tests);
+
+            bufs[t].in.clear();
+            bufs[t].out.clear();
+            workers.emplace_back([&opts, &words, &buf = bufs[t], begin, end] {
+                trivium::context ctx;
+                std::vector<std::uint8_t> msg;
+                std::uint64_t n = 0;
+
+                for (std::uint64_t test = begin; test < end; test++)
+                    n += gen_test(opts, test, ctx, msg, buf);
+
+                words += n;
+            });
+        }
+
+        for (unsigned int t = 0; t < opts.num_threads; t++) {
+            workers[t].join();
+            std::fwrite(bufs[t].in.data(), 1, bufs[t].in.size(), p_files[0]);
+            if (p_files[1])
+                std::fwrite(bufs[t].out.data(), 1, bufs[t].out.size(), p_files[1]);
+        }
+    }
+
+    if (!opts.binary) {
+        std::fputs(".\n", p_files[0]);
+        std::fputs(".\n", p_files[1]);
+    }
+
+    total_words = words;
+    for (unsigned int i = 0; i < 2; i++) {
+        if (p_files[i] && (std::ferror(p_files[i]) | std::fclose(p_files[i]))) {
+            std::fprintf(stderr, "Could not write %s\n", p_names[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%llu tests, %llu words in %.3f s (%.1f Mwords/s)\n",
+                 static_cast<unsigned long long>(opts.num_tests), static_cast<unsigned long long>(total_words), s,
+                 s > 0.0 ? total_words/s*1e-6 : 0.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#ifndef __TRIVIUM_SLICE_HPP
+#define __TRIVIUM_SLICE_HPP
+
+/*
+ * Internal header of the bitsliced engines behind trivium::batch
+ *
+ * A group of sessions is processed in lockstep, with bit j of a plane holding
+ * session j of the group. The plane width, i.e. the number of sessions per
+ * group, is the width of the vector type the engine is instantiated with:
+ * 64 for the scalar engine, 256 for AVX2 and 512 for AVX-512. The kernel is
+ * written once using the GCC vector extensions, each engine instantiates it in
+ * a translation unit compiled for its instruction set. Word k of a plane,
+ * i.e. sessions 64k to 64k + 63, is the k-th 64-bit element of the vector.
+ *
+ * Every register is kept as the last HIST planes shifted into it, followed by
+ * room for the BLK planes of the next block: s_p of a register is plane
+ * HIST - p before a block starts, and round i of the block writes plane
+ * HIST + i. No tap is further back than 111 rounds, so once a block is done,
+ * its last HIST planes are moved to the front and the next block can start.
+ *
+ * The key stream planes of a block are transposed in tiles of 64 rounds by
+ * 64 sessions before they are returned, so that afterwards word k of plane
+ * 64r + j holds key stream bits 64r to 64r + 63 of session 64k + j.
+ */
+
+#include <bit>          /* std::countr_zero() */
+#include <cstdint>      /* Fixed size types */
+#include <cstring>      /* std::memcpy() */
+
+namespace trivium::slice {
+
+constexpr unsigned int HIST = 128;          /* Planes of history kept per register */
+constexpr unsigned int BLK = 128;           /* Rounds per block, 1152 warm-up rounds are 9 blocks */
+constexpr unsigned int REG_PLANES = HIST + BLK; /* Planes allocated per register */
+constexpr unsigned int BLK_BYTES = BLK/8;   /* Key stream bytes per session and block */
+
+static_assert(BLK >= HIST, "The history must not overlap the planes it is moved from");
+
+/* Bitsliced engine, all buffers are aligned to 64 bytes */
+struct engine_ops {
+    const char      *p_name;    /* Name of the instruction set */
+    unsigned int    width;      /* Sessions per group, i.e. bits per plane */
+    /* Run one block on the 3*REG_PLANES planes of a group, storing the BLK transposed key stream planes unless p_z is nullptr */
+    void            (*run)(void *p_regs, void *p_z);
+};
+
+/* Vector types of the engines, unsigned so that right shifts are logical */
+using v256 = std::uint64_t __attribute__((vector_size(32)));
+using v512 = std::uint64_t __attribute__((vector_size(64)));
+
+/*
+ * transpose - Transpose the 64x64 bit tiles of 64 planes
+ *
+ * @m: Planes, afterwards bit i of element k of plane j is the former bit j
+ *     of element k of plane i
+ *
+ * Additional information: Each tile is transposed in place by swapping ever
+ * smaller off-diagonal blocks of size J, see Hacker's Delight, section 7-3.
+ * All tiles of the planes are transposed at once. The block size is a
+ * template parameter so that every shift has a constant count.
+ */
+template <class V, unsigned int J = 32>
+inline void transpose(V *m) {
+    constexpr std::uint64_t MASKS[] = {
+        0x5555555555555555ULL, 0x3333333333333333ULL, 0x0f0f0f0f0f0f0f0fULL,
+        0x00ff00ff00ff00ffULL, 0x0000ffff0000ffffULL, 0x00000000ffffffffULL
+    };
+    V mask = V{} | MASKS[std::countr_zero(J)];
+
+    for (unsigned int k = 0; k < 64; k = ((k | J) + 1) & ~J) {
+        V t = ((m[k] >> J) ^ m[k | J]) & mask;
+
+        m[k] ^= t << J;
+        m[k | J] ^= t;
+    }
+
+    if constexpr (J > 1)
+        transpose<V, J/2>(m);
+}
+
+/*
+ * run - Advance a group of sessions by one block
+ *
+ * @p_regs: Registers A, B and C of the group, REG_PLANES planes each
+ * @p_z: BLK key stream planes (only if OUT is set)
+ *
+ * Additional information: The taps are the ones of the specification,
+ * relative to the first position of their register, e.g. s171 is position 78
+ * of register B.
+ */
+template <class V, bool OUT>
+inline void run(void *p_regs, void *p_z) {
+    V *a = static_cast<V *>(p_regs);
+    V *b = a + REG_PLANES;
+    V *c = b + REG_PLANES;
+    V *z = static_cast<V *>(p_z);
+
+    for (unsigned int n = HIST; n < REG_PLANES; n++) {
+        V t1 = a[n - 66] ^ a[n - 93];
+        V t2 = b[n - 69] ^ b[n - 84];
+        V t3 = c[n - 66] ^ c[n - 111];
+
+        if constexpr (OUT)
+            z[n - HIST] = t1 ^ t2 ^ t3;
+
+        a[n] = t3 ^ (c[n - 109] & c[n - 110]) ^ a[n - 69];
+        b[n] = t1 ^ (a[n - 91] & a[n - 92]) ^ b[n - 78];
+        c[n] = t2 ^ (b[n - 82] & b[n - 83]) ^ c[n - 87];
+    }
+
+    std::memcpy(a, a + BLK, HIST*sizeof(V));
+    std::memcpy(b, b + BLK, HIST*sizeof(V));
+    std::memcpy(c, c + BLK, HIST*sizeof(V));
+
+    if constexpr (OUT) {
+        for (unsigned int r = 0; r < BLK/64; r++)
+            transpose(z + r*64);
+    }
+}
+
+/* Entry point of an engine, the warm-up passes no key stream planes */
+template <class V>
+void run(void *p_regs, void *p_z) {
+    if (p_z)
+        run<V, true>(p_regs, p_z);
+    else
+        run<V, false>(p_regs, nullptr);
+}
+
+/* Engines, nullptr if not built for this architecture */
+const engine_ops *engine_scalar();
+const engine_ops *engine_avx2();
+const engine_ops *engine_avx512();
+
+}
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * AVX2 engine of trivium::batch, 256 sessions per group. This file is
+ * compiled with -mavx2, its code only runs if the CPU supports AVX2.
+ */
+#include "trivium_slice.hpp"    /* Bitsliced kernel */
+
+namespace trivium::slice {
+
+#if defined(__AVX2__)
+static const engine_ops avx2_ops = {"avx2", 256, run<v256>};
+
+const engine_ops *engine_avx2() {
+    return &avx2_ops;
+}
+#else
+const engine_ops *engine_avx2() {
+    return nullptr;
+}
+#endif
+
+}
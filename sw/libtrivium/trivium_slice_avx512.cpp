@@ -0,0 +1,21 @@
+/*
+ * AVX-512 engine of trivium::batch, 512 sessions per group. This file is
+ * compiled with -mavx512f, its code only runs if the CPU supports AVX-512F.
+ */
+#include "trivium_slice.hpp"    /* Bitsliced kernel */
+
+namespace trivium::slice {
+
+#if defined(__AVX512F__)
+static const engine_ops avx512_ops = {"avx512", 512, run<v512>};
+
+const engine_ops *engine_avx512() {
+    return &avx512_ops;
+}
+#else
+const engine_ops *engine_avx512() {
+    return nullptr;
+}
+#endif
+
+}
@@ -0,0 +1,247 @@
+/*
+ * trivium_test - Check libtrivium against the reference test vectors
+ *
+ * Usage: trivium_test [<ref_in> <ref_out> | <vector_file>]
+ *
+ * The test vectors are the ones of reference_implementation/ that are also
+ * used by the testbenches: key and IV as 20 hex digits, followed by 32-bit
+ * plaintext words, one test ending with "-" and the file ending with ".".
+ * Alternatively, a binary vector file (see trivium_vectors.hpp) is read
+ * through trivium::vec_file. In addition, every test is repeated with the
+ * data split into random chunks and encrypted in place, which must give the
+ * same result. Finally, every bitsliced engine of trivium::batch the CPU
+ * supports encrypts the tests as sessions of a batch spanning several groups.
+ */
+#include <algorithm>    /* std::min() */
+#include <cstdio>       /* std::printf() */
+#include <cstdlib>      /* EXIT_SUCCESS and co. */
+#include <fstream>      /* std::ifstream */
+#include <random>       /* std::mt19937 */
+#include <stdexcept>    /* std::runtime_error */
+#include <string>       /* std::string */
+#include <vector>       /* std::vector */
+#include "trivium.hpp"  /* Library interface */
+#include "trivium_batch.hpp"    /* Bitsliced multi-session engine */
+#include "trivium_vectors.hpp"  /* Binary test vector format */
+
+/* A test of the reference vectors */
+struct ref_test {
+    trivium::key_type key;
+    trivium::iv_type iv;
+    std::vector<std::uint8_t> pt, ct;
+};
+
+/*
+ * hex_to_bytes - Convert a hex number into bytes, least significant byte first
+ *
+ * @hex: Hex digits, most significant digit first
+ * @p_out: Output bytes, hex.size()/2 of them
+ */
+static void hex_to_bytes(const std::string &hex, std::uint8_t *p_out) {
+    std::size_t n = hex.size()/2;
+
+    for (std::size_t i = 0; i < n; i++)
+        p_out[i] = static_cast<std::uint8_t>(std::stoul(hex.substr(hex.size() - 2*(i + 1), 2), nullptr, 16));
+}
+
+/*
+ * words_to_bytes - Store 32-bit words in little-endian order, like the driver writes them to the core
+ *
+ * @words: Words
+ *
+ * Return bytes
+ */
+static std::vector<std::uint8_t> words_to_bytes(const std::vector<std::uint32_t> &words) {
+    std::vector<std::uint8_t> bytes(words.size()*4);
+
+    for (std::size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = static_cast<std::uint8_t>(words[i/4] >> (8*(i%4)));
+
+    return bytes;
+}
+
+/*
+ * read_text - Read the text test vectors
+ *
+ * @p_in_name: Input file
+ * @p_out_name: Output file
+ * @tests: Tests read
+ *
+ * Return true on success
+ */
+static bool read_text(const char *p_in_name, const char *p_out_name, std::vector<ref_test> &tests) {
+    std::ifstream in_file(p_in_name), out_file(p_out_name);
+    std::string line;
+
+    if (!in_file || !out_file) {
+        std::fprintf(stderr, "Could not open %s or %s\n", p_in_name, p_out_name);
+        return false;
+    }
+
+    while (std::getline(in_file, line) && line != ".") {
+        ref_test test;
+        std::vector<std::uint32_t> pt, ct;
+
+        hex_to_bytes(line, test.key.data());
+        std::getline(in_file, line);
+        hex_to_bytes(line, test.iv.data());
+
+        while (std::getline(in_file, line) && line != "-")
+            pt.push_back(static_cast<std::uint32_t>(std::stoul(line, nullptr, 16)));
+
+        while (std::getline(out_file, line) && line != "-")
+            ct.push_back(static_cast<std::uint32_t>(std::stoul(line, nullptr, 16)));
+
+        test.pt = words_to_bytes(pt);
+        test.ct = words_to_bytes(ct);
+        tests.push_back(std::move(test));
+    }
+
+    return true;
+}
+
+/*
+ * read_binary - Read a binary vector file
+ *
+ * @p_name: File
+ * @tests: Tests read
+ *
+ * Return true on success
+ */
+static bool read_binary(const char *p_name, std::vector<ref_test> &tests) {
+    try {
+        trivium::vec_file vecs(p_name);
+
+        tests.reserve(vecs.size());
+        for (const trivium::vec_record &rec : vecs) {
+            ref_test test;
+
+            std::copy(rec.key.begin(), rec.key.end(), test.key.begin());
+            std::copy(rec.iv.begin(), rec.iv.end(), test.iv.begin());
+            test.pt.assign(rec.pt.begin(), rec.pt.end());
+            test.ct.assign(rec.ct.begin(), rec.ct.end());
+            tests.push_back(std::move(test));
+        }
+    }
+    catch (const std::runtime_error &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rng(1);
+    std::vector<ref_test> tests;
+    unsigned int num_tests = 0, num_errors = 0;
+    bool ok;
+
+    if (argc == 2)
+        ok = read_binary(argv[1], tests);
+    else
+        ok = read_text(argc > 2 ? argv[1] : "../../reference_implementation/trivium_ref_in.txt",
+                       argc > 2 ? argv[2] : "../../reference_implementation/trivium_ref_out.txt", tests);
+
+    if (!ok)
+        return EXIT_FAILURE;
+
+    for (const ref_test &test : tests) {
+        /* One call */
+        std::vector<std::uint8_t> res(test.pt.size());
+        trivium::context ctx(test.key, test.iv);
+        ctx.encrypt(test.pt, res);
+        if (res != test.ct) {
+            std::printf("Test %u: Mismatch\n", num_tests);
+            num_errors++;
+        }
+
+        /* Random chunks, in place */
+        res = test.pt;
+        ctx.init(test.key, test.iv);
+        for (std::size_t off = 0; off < res.size();) {
+            std::size_t len = std::min<std::size_t>(rng()%20, res.size() - off);
+            ctx.encrypt(std::span<std::uint8_t>(res).subspan(off, len));
+            off += len;
+        }
+
+        if (res != test.ct || ctx.position() != res.size()) {
+            std::printf("Test %u: Mismatch with chunked in-place encryption\n", num_tests);
+            num_errors++;
+        }
+
+        /* Resuming from a copy, taken within the first key stream word unless the message is shorter */
+        res = test.pt;
+        std::size_t split = std::min<std::size_t>(5, res.size());
+        ctx.init(test.key, test.iv);
+        ctx.encrypt(std::span<std::uint8_t>(res).first(split));
+        trivium::context snapshot = ctx;
+        snapshot.encrypt(std::span<std::uint8_t>(res).subspan(split));
+        if (res != test.ct) {
+            std::printf("Test %u: Mismatch after resuming from a copy\n", num_tests);
+            num_errors++;
+        }
+
+        num_tests++;
+    }
+
+    /* Batches of sessions cycling through the tests, with the data of each session padded to the longest test */
+    const std::size_t num_sessions = 1100;
+    std::size_t len = 0;
+    for (const ref_test &test : tests)
+        len = std::max(len, test.pt.size());
+
+    std::vector<trivium::key_type> keys(num_sessions);
+    std::vector<trivium::iv_type> ivs(num_sessions);
+    std::vector<std::uint8_t> buf(num_sessions*len);
+    for (std::size_t s = 0; s < num_sessions && !tests.empty(); s++) {
+        const ref_test &test = tests[s%tests.size()];
+
+        keys[s] = test.key;
+        ivs[s] = test.iv;
+    }
+
+    for (trivium::engine type : {trivium::engine::scalar, trivium::engine::avx2, trivium::engine::avx512}) {
+        if (tests.empty() || !trivium::batch::supported(type))
+            continue;
+
+        trivium::batch bat(num_sessions, type);
+        bat.init(keys, ivs);
+
+        /* Lay out the data session after session and encrypt it in chunks of varying size */
+        std::vector<std::uint8_t> res(num_sessions*len, 0);
+        for (std::size_t s = 0; s < num_sessions; s++)
+            std::copy(tests[s%tests.size()].pt.begin(), tests[s%tests.size()].pt.end(), res.begin() + s*len);
+
+        for (std::size_t off = 0; off < len;) {
+            std::size_t chunk = std::min<std::size_t>(rng()%40, len - off);
+
+            for (std::size_t s = 0; s < num_sessions; s++)
+                std::copy_n(res.begin() + s*len + off, chunk, buf.begin() + s*chunk);
+
+            bat.encrypt(std::span<std::uint8_t>(buf).first(num_sessions*chunk), chunk);
+            for (std::size_t s = 0; s < num_sessions; s++)
+                std::copy_n(buf.begin() + s*chunk, chunk, res.begin() + s*len + off);
+
+            off += chunk;
+        }
+
+        unsigned int mismatches = 0;
+        for (std::size_t s = 0; s < num_sessions; s++) {
+            const ref_test &test = tests[s%tests.size()];
+
+            if (!std::equal(test.ct.begin(), test.ct.end(), res.begin() + s*len))
+                mismatches++;
+        }
+
+        if (mismatches) {
+            std::printf("Batch (%s): %u of %zu sessions mismatch\n", bat.engine_name(), mismatches, num_sessions);
+            num_errors++;
+        }
+
+        num_tests++;
+    }
+
+    std::printf("%u tests, %u errors\n", num_tests, num_errors);
+    return (num_tests && !num_errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
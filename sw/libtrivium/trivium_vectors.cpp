@@ -0,0 +1,117 @@
+#include <bit>                  /* std::endian */
+#include <cstring>              /* std::memcpy() */
+#include <stdexcept>            /* std::runtime_error */
+#include <string>               /* std::string */
+#include <fcntl.h>              /* open() */
+#include <sys/mman.h>           /* mmap() */
+#include <sys/stat.h>           /* fstat() */
+#include <unistd.h>             /* close() */
+#include "trivium_vectors.hpp"  /* Library interface */
+
+namespace trivium {
+
+namespace {
+
+/* Number of words of the record starting at p_rec */
+inline std::uint32_t rec_words(const std::uint8_t *p_rec) {
+    std::uint32_t val;
+
+    std::memcpy(&val, p_rec + offsetof(vec_record_header, num_words), sizeof(val));
+    if constexpr (std::endian::native == std::endian::big)
+        return __builtin_bswap32(val);
+
+    return val;
+}
+
+/* Size of the record starting at p_rec */
+inline std::size_t rec_size(const std::uint8_t *p_rec) {
+    return sizeof(vec_record_header) + 8*static_cast<std::size_t>(rec_words(p_rec));
+}
+
+}
+
+/*******************************************************************************
+ * Records
+ ******************************************************************************/
+
+vec_record vec_file::iterator::operator*() const {
+    std::size_t len = 4*static_cast<std::size_t>(rec_words(p_rec_));
+    const std::uint8_t *p_pt = p_rec_ + sizeof(vec_record_header);
+
+    return {std::span<const std::uint8_t, KEY_LEN>(p_rec_ + offsetof(vec_record_header, key), KEY_LEN),
+            std::span<const std::uint8_t, IV_LEN>(p_rec_ + offsetof(vec_record_header, iv), IV_LEN),
+            std::span<const std::uint8_t>(p_pt, len), std::span<const std::uint8_t>(p_pt + len, len)};
+}
+
+vec_file::iterator &vec_file::iterator::operator++() {
+    p_rec_ += rec_size(p_rec_);
+    return *this;
+}
+
+/*******************************************************************************
+ * File
+ ******************************************************************************/
+
+/*
+ * vec_file - Map a vector file
+ *
+ * @p_name: Name of the file
+ *
+ * Additional information: The records are walked once to check that all of
+ * them lie within the file, which only touches their headers. Afterwards the
+ * iterators need no bounds checks.
+ */
+vec_file::vec_file(const char *p_name) {
+    struct stat st;
+    vec_file_header hdr;
+    int fd;
+
+    fd = open(p_name, O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error(std::string("trivium::vec_file: could not open ") + p_name);
+
+    if (fstat(fd, &st) || static_cast<std::size_t>(st.st_size) < sizeof(hdr)) {
+        close(fd);
+        throw std::runtime_error(std::string("trivium::vec_file: ") + p_name + " is no vector file");
+    }
+
+    map_len_ = static_cast<std::size_t>(st.st_size);
+    void *p_map = mmap(nullptr, map_len_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p_map == MAP_FAILED)
+        throw std::runtime_error(std::string("trivium::vec_file: could not map ") + p_name);
+
+    p_data_ = static_cast<const std::uint8_t *>(p_map);
+    madvise(p_map, map_len_, MADV_SEQUENTIAL);
+
+    std::memcpy(&hdr, p_data_, sizeof(hdr));
+    num_tests_ = hdr.num_tests;
+    if constexpr (std::endian::native == std::endian::big) {
+        hdr.version = __builtin_bswap32(hdr.version);
+        num_tests_ = __builtin_bswap64(num_tests_);
+    }
+
+    std::size_t off = sizeof(hdr);
+    bool valid = !std::memcmp(hdr.magic, VEC_MAGIC, sizeof(hdr.magic)) && hdr.version == VEC_VERSION;
+    for (std::uint64_t i = 0; valid && i < num_tests_; i++) {
+        std::size_t rest = map_len_ - off;
+
+        valid = rest >= sizeof(vec_record_header) &&
+                (rest - sizeof(vec_record_header))/8 >= rec_words(p_data_ + off);
+        if (valid)
+            off += rec_size(p_data_ + off);
+    }
+
+    if (!valid) {
+        munmap(p_map, map_len_);
+        throw std::runtime_error(std::string("trivium::vec_file: ") + p_name + " is no valid vector file");
+    }
+
+    p_end_ = p_data_ + off;
+}
+
+vec_file::~vec_file() {
+    munmap(const_cast<std::uint8_t *>(p_data_), map_len_);
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef __TRIVIUM_VECTORS_HPP
+#define __TRIVIUM_VECTORS_HPP
+
+/*
+ * libtrivium - Binary test vector format
+ *
+ * A vector file starts with a vec_file_header, followed by one record per
+ * test: a vec_record_header holding key, IV and the number of 32-bit words,
+ * then the plaintext words and finally the ciphertext words. All fields are
+ * little-endian. Key and IV are least significant byte first as everywhere
+ * else in the library, and the words are stored in the order the driver
+ * writes them to the core, so the plaintext and ciphertext of a record are
+ * simply the bytes of the message. Every record is a multiple of 4 bytes.
+ *
+ * The text format of reference_implementation/ holds the same information:
+ * key and IV as 20 hex digits and every word as 8 hex digits, most
+ * significant digit first.
+ */
+
+#include <cstddef>      /* std::size_t */
+#include <cstdint>      /* Fixed size types */
+#include <iterator>     /* std::forward_iterator_tag */
+#include <span>         /* std::span */
+#include "trivium.hpp"  /* KEY_LEN and IV_LEN */
+
+namespace trivium {
+
+constexpr char VEC_MAGIC[4] = {'T', 'R', 'V', 'V'};    /* First bytes of a vector file */
+constexpr std::uint32_t VEC_VERSION = 1;                /* Version of the format */
+
+/* Start of a vector file */
+struct vec_file_header {
+    char            magic[4];       /* VEC_MAGIC */
+    std::uint32_t   version;        /* VEC_VERSION */
+    std::uint64_t   num_tests;      /* Number of records that follow */
+};
+
+/* Start of a record, followed by num_words plaintext and num_words ciphertext words */
+struct vec_record_header {
+    std::uint8_t    key[KEY_LEN];   /* Key, least significant byte first */
+    std::uint8_t    iv[IV_LEN];     /* IV, least significant byte first */
+    std::uint32_t   num_words;      /* Number of 32-bit words of the message */
+};
+
+static_assert(sizeof(vec_file_header) == 16, "Unexpected padding in vec_file_header");
+static_assert(sizeof(vec_record_header) == 24, "Unexpected padding in vec_record_header");
+
+/* A record of a vector file, pointing into the mapped file */
+struct vec_record {
+    std::span<const std::uint8_t, KEY_LEN> key;     /* Key, least significant byte first */
+    std::span<const std::uint8_t, IV_LEN> iv;       /* IV, least significant byte first */
+    std::span<const std::uint8_t> pt;               /* Plaintext, 4 bytes per word */
+    std::span<const std::uint8_t> ct;               /* Ciphertext, 4 bytes per word */
+};
+
+/*
+ * vec_file - Binary vector file mapped into memory
+ *
+ * The records are read straight from the mapping, so that iterating over a
+ * file costs neither copies nor parsing. The file must not be modified while
+ * it is mapped.
+ */
+class vec_file {
+public:
+    /* Forward iterator over the records */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = vec_record;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const vec_record *;
+        using reference = vec_record;
+
+        iterator() = default;
+        explicit iterator(const std::uint8_t *p_rec) : p_rec_(p_rec) {}
+
+        vec_record operator*() const;
+        iterator &operator++();
+        iterator operator++(int) { iterator it = *this; ++*this; return it; }
+        bool operator==(const iterator &other) const { return p_rec_ == other.p_rec_; }
+
+    private:
+        const std::uint8_t *p_rec_ = nullptr;   /* Header of the current record */
+    };
+
+    /*
+     * Maps a vector file and checks its header and the sizes of all records.
+     * Throws std::runtime_error if the file cannot be mapped or is invalid.
+     */
+    explicit vec_file(const char *p_name);
+    ~vec_file();
+
+    vec_file(const vec_file &) = delete;
+    vec_file &operator=(const vec_file &) = delete;
+
+    /* Number of tests */
+    std::uint64_t size() const { return num_tests_; }
+
+    iterator begin() const { return iterator(p_data_ + sizeof(vec_file_header)); }
+    iterator end() const { return iterator(p_end_); }
+
+private:
+    const std::uint8_t *p_data_;    /* Start of the mapping */
+    const std::uint8_t *p_end_;     /* End of the last record */
+    std::size_t map_len_;           /* Size of the mapping */
+    std::uint64_t num_tests_;       /* Number of records */
+};
+
+}
+
+#endif
@@ -3,70 +3,337 @@
 #include <linux/proc_fs.h>          /* Managing /proc entry */
 #include <linux/platform_device.h>  /* Platform_device struct and related functions */
 #include <linux/errno.h>            /* Linux error codes */
-#include <linux/slab.h>             /* kzfree() */
+#include <linux/slab.h>             /* kmem_cache_alloc() and co. */
+#include <linux/delay.h>            /* udelay() */
+#include <linux/vmalloc.h>          /* vmalloc_user() for the shared rings */
+#include <linux/mm.h>               /* remap_vmalloc_range() */
+#include <linux/bitmap.h>           /* Bitmap used to group batch jobs */
+#include <linux/ktime.h>            /* Batch and dispatch latency measurement */
+#include <linux/math64.h>           /* div_u64() */
+#include <linux/scatterlist.h>      /* sg_copy_to_buffer() and co. */
+#include <linux/fs.h>               /* vfs_setpos() */
+#include <linux/iopoll.h>           /* readl_poll_timeout() */
+#include <crypto/internal/skcipher.h>   /* skcipher algorithm registration */
+#include <crypto/engine.h>          /* Crypto engine queueing the requests */
 #include <asm/io.h>                 /* ioremap and co. */
 #include <asm/uaccess.h>            /* copy_from_user() and copy_to_user() */
 #include "axi_trivium.h"            /* Type declarations and variable definitions */
+#define CREATE_TRACE_POINTS
+#include "axi_trivium_trace.h"      /* Tracepoints */
+
+/*******************************************************************************
+ * Module parameters
+ ******************************************************************************/
+static unsigned int wait_mode = WAIT_MODE_HYBRID;
+module_param(wait_mode, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(wait_mode, "Waiting for the core: 0 = poll, 1 = interrupt, 2 = spin then sleep (default)");
+
+static unsigned int spin_us = 50;
+module_param(spin_us, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(spin_us, "Microseconds to spin before sleeping in wait mode 2 (default 50)");
+
+static unsigned int dispatch_mode = DISPATCH_AUTO;
+module_param(dispatch_mode, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dispatch_mode, "Placement of requests: 0 = core, 1 = automatic (default), 2 = software where possible");
+
+static unsigned int sw_max_bytes = 64;
+module_param(sw_max_bytes, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(sw_max_bytes, "Requests up to this size are encrypted in software in mode 1 (default 64)");
+
+static unsigned int sw_queue_depth = 2;
+module_param(sw_queue_depth, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(sw_queue_depth, "Encrypt in software in mode 1 if this many callers use the lane, 0 = never (default 2)");
 
 /*******************************************************************************
  * Platform driver specific function
  ******************************************************************************/
 /*
- * axi_trivium_probe - Map device and create /proc entry
+ * unmap_win - Unmap the FIFO windows of a core
+ *
+ * @p_core: Core, the lanes fall back to the registers
+ */
+static void unmap_win(struct core_info *p_core) {
+    unsigned int i;
+
+    for (i = 0; i < p_core->num_lanes; i++) {
+        p_core->p_lanes[i].p_push_addr = NULL;
+        p_core->p_lanes[i].p_pop_addr = NULL;
+    }
+
+    if (p_core->p_push_base)
+        iounmap(p_core->p_push_base);
+
+    if (p_core->p_pop_base)
+        iounmap(p_core->p_pop_base);
+
+    if (p_core->p_win_res)
+        release_mem_region(p_core->p_win_res->start, resource_size(p_core->p_win_res));
+
+    p_core->p_push_base = NULL;
+    p_core->p_pop_base = NULL;
+    p_core->p_win_res = NULL;
+}
+
+/*
+ * map_win - Map the FIFO windows of a core
+ *
+ * @p_dev: Platform device structure derived from device tree
+ * @p_core: Core whose lanes have been set up
+ *
+ * Additional info: The FIFO windows are the optional second memory region of
+ * the device tree node. Both halves are mapped like the registers: the core
+ * pushes every write beat in the order it arrives, regardless of its address
+ * and write strobes, which a write-combining mapping does not guarantee, and
+ * the pop windows must not be read speculatively. Without the region, or if
+ * it cannot be mapped or does not cover all lanes, data is transferred
+ * through the registers.
+ */
+static void map_win(struct platform_device *p_dev, struct core_info *p_core) {
+    struct resource *p_res;
+    resource_size_t half;
+    unsigned int i;
+
+    p_res = platform_get_resource(p_dev, IORESOURCE_MEM, 1);
+    if (!p_res)
+        return;
+
+    if (WIN_REGION_LANES(resource_size(p_res)) < p_core->num_lanes) {
+        dev_warn(&p_dev->dev, "FIFO window region too small, using the registers\n");
+        return;
+    }
+
+    if (!request_mem_region(p_res->start, resource_size(p_res), p_dev->name)) {
+        dev_warn(&p_dev->dev, "Could not setup FIFO window region, using the registers\n");
+        return;
+    }
+
+    p_core->p_win_res = p_res;
+    half = resource_size(p_res)/2;
+    p_core->p_push_base = ioremap(p_res->start, half);
+    p_core->p_pop_base = ioremap(p_res->start + half, half);
+    if (!p_core->p_push_base || !p_core->p_pop_base) {
+        dev_warn(&p_dev->dev, "Could not ioremap FIFO windows at 0x%08lx, using the registers\n", (unsigned long)p_res->start);
+        unmap_win(p_core);
+        return;
+    }
+
+    for (i = 0; i < p_core->num_lanes; i++) {
+        p_core->p_lanes[i].p_push_addr = (unsigned int *)p_core->p_push_base + i*WIN_STRIDE;
+        p_core->p_lanes[i].p_pop_addr = (unsigned int *)p_core->p_pop_base + i*WIN_STRIDE;
+    }
+}
+
+/*
+ * unmap_dma - Disable the DMA engine of a core and free its ring
+ *
+ * @p_core: Core, requests fall back to the lane registers
+ */
+static void unmap_dma(struct core_info *p_core) {
+    if (!p_core->p_dma_ring)
+        return;
+
+    reg_wr(&p_core->p_lanes[0], REG_DMA_CTRL, 0);
+    dma_free_coherent(p_core->p_dev, DMA_ALLOC_SZ, p_core->p_dma_ring, p_core->dma_ring_addr);
+    p_core->p_dma_ring = NULL;
+    p_core->p_dma_sess = NULL;
+}
+
+/*
+ * map_dma - Set up the DMA engine of a core
+ *
+ * @p_dev: Platform device structure derived from device tree
+ * @p_core: Core whose lanes have been set up
+ *
+ * Additional info: The engine is detected through its ring base register,
+ * which reads zero on cores without it. The ring and the key and IV block
+ * share one coherent allocation below 4 GiB, as the engine drives 32-bit
+ * addresses. Without the engine, or if the allocation fails, requests are
+ * encrypted through the lane registers.
+ */
+static void map_dma(struct platform_device *p_dev, struct core_info *p_core) {
+    struct lane_info *p_lane = &p_core->p_lanes[0];
+
+    reg_wr(p_lane, REG_DMA_BASE, ~0u);
+    if (!reg_rd(p_lane, REG_DMA_BASE))
+        return;
+
+    reg_wr(p_lane, REG_DMA_BASE, 0);
+    if (dma_set_mask_and_coherent(&p_dev->dev, DMA_BIT_MASK(32))) {
+        dev_warn(&p_dev->dev, "No 32-bit DMA available, using the registers\n");
+        return;
+    }
+
+    p_core->p_dma_ring = dma_alloc_coherent(&p_dev->dev, DMA_ALLOC_SZ, &p_core->dma_ring_addr, GFP_KERNEL);
+    if (!p_core->p_dma_ring) {
+        dev_warn(&p_dev->dev, "Could not allocate DMA descriptor ring, using the registers\n");
+        return;
+    }
+
+    /* The allocation is page aligned, so the block following the ring is aligned as well */
+    BUILD_BUG_ON((DMA_RING_ENTRIES*sizeof(struct dma_desc)) % DMA_DESC_SESS_ALIGN);
+    p_core->p_dma_sess = (__le32 *)(p_core->p_dma_ring + DMA_RING_ENTRIES);
+    p_core->dma_sess_addr = p_core->dma_ring_addr + DMA_RING_ENTRIES*sizeof(struct dma_desc);
+
+    /* Start with an empty ring */
+    p_core->dma_tail = 0;
+    reg_wr(p_lane, REG_DMA_CTRL, 0);
+    reg_wr(p_lane, REG_DMA_BASE, (unsigned int)p_core->dma_ring_addr);
+    reg_wr(p_lane, REG_DMA_HEAD, 0);
+    reg_wr(p_lane, REG_DMA_TAIL, 0);
+    reg_wr(p_lane, REG_DMA_STAT, 1 << REG_DMA_STAT_BIT_ERR);
+    reg_wr(p_lane, REG_DMA_CTRL, (1 << REG_DMA_CTRL_BIT_EN) | (DMA_RING_LOG2 << REG_DMA_CTRL_LOG2_SHIFT));
+}
+
+/*
+ * axi_trivium_probe - Map a device and add it to the cores of the front end
  *
  * @p_dev: Platform device structure derived from device tree
  *
  * Returns 0 on success, error code otherwise
  *
- * Additional info: Note that this driver does not manage a hot-pluggable device
- * or multiple instances of a device. It is therefore possible to implement all
- * global related setup tasks (e.g. initializing a mutex) in the probe function
- * as it will only be called once.
+ * Additional info: The probe function is called for every matching node of
+ * the device tree. Each core gets its own lanes, interrupt and crypto engine,
+ * while the /proc entry, the character device and the crypto API algorithm
+ * are shared by all cores, see axi_trivium_init(). The number of lanes is
+ * read from the info register of the core. If the device tree provides no
+ * interrupt, the driver polls the core regardless of the wait_mode parameter.
  */
 static int axi_trivium_probe(struct platform_device *p_dev) {
-    struct proc_dir_entry *p_proc_entry;
+    struct core_info *p_core;
+    unsigned int i;
     int ret_val = 0;
 
-    /* Initialize mutex */
-    mutex_init(&ip_mtx);
+    p_core = (struct core_info *)devm_kzalloc(&p_dev->dev, sizeof(struct core_info), GFP_KERNEL);
+    if (!p_core)
+        return -ENOMEM;
+
+    p_core->p_dev = &p_dev->dev;
 
     /* Get resource information for device */
-    ip_info.p_res = platform_get_resource(p_dev, IORESOURCE_MEM, 0);
-    if (!ip_info.p_res) {
+    p_core->p_res = platform_get_resource(p_dev, IORESOURCE_MEM, 0);
+    if (!p_core->p_res) {
         dev_err(&p_dev->dev, "No memory resource information available\n");
         return -ENODEV;
     }
 
     /* Get memory size for ioremap and request memory region for mapping */
-    ip_info.remap_sz = ip_info.p_res->end - ip_info.p_res->start + 1; 
-    if (!request_mem_region(ip_info.p_res->start, ip_info.remap_sz, p_dev->name)) {
+    p_core->remap_sz = p_core->p_res->end - p_core->p_res->start + 1; 
+    if (!request_mem_region(p_core->p_res->start, p_core->remap_sz, p_dev->name)) {
         dev_err(&p_dev->dev, "Could not setup memory region for remap\n");
         return -ENXIO;
     }
 
     /* Map the physical MMIO space of the core to virtual kernel space memory */
-    ip_info.p_base_addr = ioremap(ip_info.p_res->start, ip_info.remap_sz);
-    if (ip_info.p_base_addr == NULL) {
-        dev_err(&p_dev->dev, "Could not ioremap MMIO at 0x%08lx\n", (unsigned long)ip_info.p_res->start);
+    p_core->p_base_addr = ioremap(p_core->p_res->start, p_core->remap_sz);
+    if (p_core->p_base_addr == NULL) {
+        dev_err(&p_dev->dev, "Could not ioremap MMIO at 0x%08lx\n", (unsigned long)p_core->p_res->start);
         ret_val = -ENOMEM;
         goto err_ioremap;
     }
 
-    /* Create entry in /proc for device */
-    p_proc_entry = proc_create(DRIVER_NAME, 0, NULL, &proc_fops);
-    if (p_proc_entry == NULL) {
-        dev_err(&p_dev->dev, "Could not create /proc entry\n");
+    /* Set up the lanes, making sure all register banks are within the mapped region */
+    p_core->info = ioread32(p_core->p_base_addr + REG_INFO);
+    p_core->num_lanes = p_core->info & REG_INFO_LANES_MASK;
+    if (p_core->num_lanes == 0)
+        p_core->num_lanes = 1;
+
+    if (p_core->num_lanes*LANE_STRIDE*sizeof(unsigned int) > p_core->remap_sz) {
+        p_core->num_lanes = p_core->remap_sz/(LANE_STRIDE*sizeof(unsigned int));
+        dev_warn(&p_dev->dev, "Memory region too small, using %u lanes\n", p_core->num_lanes);
+    }
+
+    p_core->p_lanes = (struct lane_info *)kcalloc(p_core->num_lanes, sizeof(struct lane_info), GFP_KERNEL);
+    if (!p_core->p_lanes) {
         ret_val = -ENOMEM;
-        goto err_proc_entry;   
+        goto err_lanes;
+    }
+
+    for (i = 0; i < p_core->num_lanes; i++) {
+        p_core->p_lanes[i].p_core = p_core;
+        p_core->p_lanes[i].p_base_addr = p_core->p_base_addr + i*LANE_STRIDE;
+        mutex_init(&p_core->p_lanes[i].mtx);
+        init_completion(&p_core->p_lanes[i].done);
+        spin_lock_init(&p_core->p_lanes[i].irq_lock);
+        INIT_LIST_HEAD(&p_core->p_lanes[i].sched_q);
+        spin_lock_init(&p_core->p_lanes[i].sched_lock);
+        INIT_WORK(&p_core->p_lanes[i].sched_work, batch_work);
+        atomic_set(&p_core->p_lanes[i].queued, 0);
+
+        /* Start with all interrupts disabled and cleared */
+        reg_wr(&p_core->p_lanes[i], REG_IER, 0);
+        reg_wr(&p_core->p_lanes[i], REG_ISR, (1 << IRQ_BIT_IDONE) | (1 << IRQ_BIT_OAVAIL) | (1 << IRQ_BIT_DMA));
+    }
+
+    /* Data is moved in bursts if the core has FIFO windows, or by the core itself if it has a DMA engine */
+    map_win(p_dev, p_core);
+    map_dma(p_dev, p_core);
+
+    /* Request the interrupt, fall back to polling if there is none */
+    p_core->irq = platform_get_irq(p_dev, 0);
+    if (p_core->irq >= 0) {
+        ret_val = request_irq(p_core->irq, axi_trivium_irq, 0, DRIVER_NAME, p_core);
+        if (ret_val) {
+            dev_err(&p_dev->dev, "Could not request IRQ %d\n", p_core->irq);
+            goto err_irq;
+        }
+    } else
+        dev_info(&p_dev->dev, "No interrupt available, polling the core\n");
+
+    /* Crypto API requests sent to this core are queued through its own crypto engine */
+    p_core->p_crypt_inst = (struct axi_trivium_inst *)kmem_cache_alloc(drv_info.p_inst_cache, GFP_KERNEL);
+    if (!p_core->p_crypt_inst) {
+        ret_val = -ENOMEM;
+        goto err_crypt_inst;
     }
 
+    mutex_init(&p_core->p_crypt_inst->mtx);
+    INIT_LIST_HEAD(&p_core->p_crypt_inst->batches);
+    p_core->p_crypt_inst->p_key = p_core->p_crypt_inst->key;
+    p_core->p_crypt_inst->p_iv = p_core->p_crypt_inst->iv;
+
+    p_core->p_engine = crypto_engine_alloc_init(&p_dev->dev, true);
+    if (!p_core->p_engine) {
+        dev_err(&p_dev->dev, "Could not allocate crypto engine\n");
+        ret_val = -ENOMEM;
+        goto err_engine;
+    }
+
+    ret_val = crypto_engine_start(p_core->p_engine);
+    if (ret_val) {
+        dev_err(&p_dev->dev, "Could not start crypto engine\n");
+        goto err_engine_start;
+    }
+
+    /* Make the core available to the front end */
+    platform_set_drvdata(p_dev, p_core);
+    mutex_lock(&drv_info.mtx);
+    list_add_tail(&p_core->node, &drv_info.cores);
+    mutex_unlock(&drv_info.mtx);
+
+    /* Failing to create the statistics file is not fatal */
+    p_core->p_debugfs = debugfs_create_file(dev_name(&p_dev->dev), S_IRUGO, drv_info.p_debugfs, p_core, &debugfs_core_fops);
+
+    dev_info(&p_dev->dev, "Core with %u lanes%s%s added\n", p_core->num_lanes, p_core->p_win_res ? " and FIFO windows" : "",
+             p_core->p_dma_ring ? " and DMA engine" : "");
     return 0;
 
 /* Error cases */
-err_proc_entry:
-    iounmap(ip_info.p_base_addr);
+err_engine_start:
+    crypto_engine_exit(p_core->p_engine);
+err_engine:
+    memzero_explicit(p_core->p_crypt_inst, sizeof(struct axi_trivium_inst));
+    kmem_cache_free(drv_info.p_inst_cache, p_core->p_crypt_inst);
+err_crypt_inst:
+    if (p_core->irq >= 0)
+        free_irq(p_core->irq, p_core);
+err_irq:
+    unmap_dma(p_core);
+    unmap_win(p_core);
+    kfree(p_core->p_lanes);
+err_lanes:
+    iounmap(p_core->p_base_addr);
 err_ioremap:
-    release_mem_region(ip_info.p_res->start, ip_info.remap_sz);
+    release_mem_region(p_core->p_res->start, p_core->remap_sz);
 
     return ret_val;
 }
@@ -77,10 +344,30 @@ err_ioremap:
  * @p_dev: Platform device structure derived from device tree
  *
  * Returns 0 on success, error code otherwise
+ *
+ * Additional info: Binding and unbinding via sysfs is disabled, so a core is
+ * only removed when the module is unloaded, i.e. when no instance exists.
  */
 static int axi_trivium_remove(struct platform_device *p_dev) {
-    iounmap(ip_info.p_base_addr);
-    release_mem_region(ip_info.p_res->start, ip_info.remap_sz);
+    struct core_info *p_core = (struct core_info *)platform_get_drvdata(p_dev);
+
+    debugfs_remove(p_core->p_debugfs);
+    mutex_lock(&drv_info.mtx);
+    list_del(&p_core->node);
+    mutex_unlock(&drv_info.mtx);
+
+    crypto_engine_exit(p_core->p_engine);
+    buf_release(&p_core->p_crypt_inst->p_buf, &p_core->p_crypt_inst->buf_cap);
+    memzero_explicit(p_core->p_crypt_inst, sizeof(struct axi_trivium_inst));
+    kmem_cache_free(drv_info.p_inst_cache, p_core->p_crypt_inst);
+    if (p_core->irq >= 0)
+        free_irq(p_core->irq, p_core);
+
+    unmap_dma(p_core);
+    unmap_win(p_core);
+    kfree(p_core->p_lanes);
+    iounmap(p_core->p_base_addr);
+    release_mem_region(p_core->p_res->start, p_core->remap_sz);
     return 0;
 }
 
@@ -90,7 +377,14 @@ static int axi_trivium_remove(struct platform_device *p_dev) {
  * @p_dev: Platform device structure derived from device tree
  */
 static void axi_trivium_shutdown(struct platform_device *p_dev) {
-    reg_set(&ip_info, REG_CONFIG, REG_CONFIG_BIT_STOP);
+    struct core_info *p_core = (struct core_info *)platform_get_drvdata(p_dev);
+    unsigned int i;
+
+    if (p_core->p_dma_ring)
+        reg_wr(&p_core->p_lanes[0], REG_DMA_CTRL, 0);
+
+    for (i = 0; i < p_core->num_lanes; i++)
+        reg_set(&p_core->p_lanes[i], REG_CONFIG, REG_CONFIG_BIT_STOP);
 }
 
 /*******************************************************************************
@@ -104,15 +398,42 @@ static void axi_trivium_shutdown(struct platform_device *p_dev) {
  * @p_file - File pointer
  *
  * Return 0 if successful, error code otherwise
+ *
+ * Additional information: The instance is assigned the lane with the fewest
+ * users among all cores, see lane_get(). Before each request it may move to a
+ * less loaded lane, see lane_select().
  */
 static int proc_axi_trivium_open(struct inode *p_node, struct file *p_file) {
-    /* Create a new software instance */
-    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)kzalloc(sizeof(struct axi_trivium_inst), GFP_KERNEL);
+    /* Create a new software instance, objects of the cache are always zeroed */
+    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)kmem_cache_alloc(drv_info.p_inst_cache, GFP_KERNEL);
     if (!p_inst)
         return -ENOMEM;
 
-    /* Store instance */
+    /* Assign a lane */
+    INIT_LIST_HEAD(&p_inst->batches);
+    mutex_init(&p_inst->mtx);
+    spin_lock_init(&p_inst->req_lock);
+    mutex_init(&p_inst->rd_mtx);
+    mutex_init(&p_inst->wr_mtx);
+    init_waitqueue_head(&p_inst->req_wq);
+    INIT_WORK(&p_inst->req_work, file_req_work);
+    if (lane_get(p_inst)) {
+        /* Objects return to the cache zeroed, like in proc_axi_trivium_close() */
+        memzero_explicit(p_inst, sizeof(struct axi_trivium_inst));
+        kmem_cache_free(drv_info.p_inst_cache, p_inst);
+        return -ENODEV;
+    }
+
+    /* Make the statistics of the session visible in debugfs */
+    p_inst->pid = task_pid_nr(current);
+    get_task_comm(p_inst->comm, current);
+    mutex_lock(&drv_info.mtx);
+    list_add_tail(&p_inst->node, &drv_info.sessions);
+    mutex_unlock(&drv_info.mtx);
+
+    /* Store instance, non-blocking reads and writes never wait for the core, so io_uring may issue them inline */
     p_file->private_data = p_inst;
+    p_file->f_mode |= FMODE_NOWAIT;
 
     return 0;
 }
@@ -128,21 +449,30 @@ static int proc_axi_trivium_open(struct inode *p_node, struct file *p_file) {
 static int proc_axi_trivium_close(struct inode *p_node, struct file *p_file) {
     /* Remove current software instance */
     struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_file->private_data;
+    unsigned int i;
+
     if (p_inst) {
-        /* Free any allocated buffers */
-        if (p_inst->p_key)
-            kzfree(p_inst->p_key);
+        /* Queued requests are processed before the lane is released */
+        flush_work(&p_inst->req_work);
+
+        mutex_lock(&drv_info.mtx);
+        list_del(&p_inst->node);
+        mutex_unlock(&drv_info.mtx);
 
-        if (p_inst->p_iv)
-            kzfree(p_inst->p_iv);
+        /* Release the lane */
+        lane_put(p_inst);
 
-        if (p_inst->p_pt)
-            kzfree(p_inst->p_pt);
+        /* Free the request buffers */
+        for (i = 0; i < FILE_REQS_MAX; i++)
+            buf_release(&p_inst->reqs[i].p_buf, &p_inst->reqs[i].buf_cap);
 
-        if (p_inst->p_ct)
-            kzfree(p_inst->p_ct);
+        /* Mappings hold a reference to the file, so the ring is no longer in use */
+        if (p_inst->p_ring)
+            vfree(p_inst->p_ring);
 
-        kzfree(p_inst);
+        /* Zeroize key, IV and saved state, which also prepares the object for reuse */
+        memzero_explicit(p_inst, sizeof(struct axi_trivium_inst));
+        kmem_cache_free(drv_info.p_inst_cache, p_inst);
     }
 
     p_file->private_data = NULL;
@@ -155,234 +485,2649 @@ static int proc_axi_trivium_close(struct inode *p_node, struct file *p_file) {
  * @p_file - File pointer
  * @p_buf - Input buffer from user-space
  * @sz - Number of bytes to write
+ * @p_off - Pointer to the file position, i.e. the key stream position in bytes
+ *
+ * Return number of bytes written if successful, error code otherwise
+ *
+ * Additional information: The /proc entry does not forward write_iter(), so
+ * the request is passed on as a single segment, see
+ * proc_axi_trivium_write_iter().
+ */
+static ssize_t proc_axi_trivium_write(struct file *p_file, const char __user *p_buf, size_t sz, loff_t *p_off) {
+    struct iovec iov = { .iov_base = (void __user *)p_buf, .iov_len = sz };
+    struct kiocb iocb;
+    struct iov_iter iter;
+    ssize_t ret_val;
+
+    init_sync_kiocb(&iocb, p_file);
+    iocb.ki_pos = *p_off;
+    iov_iter_init(&iter, WRITE, &iov, 1, sz);
+    ret_val = proc_axi_trivium_write_iter(&iocb, &iter);
+    *p_off = iocb.ki_pos;
+
+    return ret_val;
+}
+
+/*
+ * proc_axi_trivium_read - Handler for read operation on /proc entry
+ *
+ * @p_file - File pointer
+ * @p_buf - Output buffer to user-space
+ * @sz - Number of bytes to read
  * @p_off - Pointer to an offset value into the file (not used here)
  *
+ * Return number of bytes read if successful, error code otherwise
+ *
+ * Additional information: See proc_axi_trivium_write().
+ */
+static ssize_t proc_axi_trivium_read(struct file *p_file, char __user *p_buf, size_t sz, loff_t *p_off) {
+    struct iovec iov = { .iov_base = p_buf, .iov_len = sz };
+    struct kiocb iocb;
+    struct iov_iter iter;
+
+    init_sync_kiocb(&iocb, p_file);
+    iov_iter_init(&iter, READ, &iov, 1, sz);
+
+    return proc_axi_trivium_read_iter(&iocb, &iter);
+}
+
+/*
+ * file_req_drop - Frees the entry of the oldest unread result of a file
+ *
+ * @p_inst - Instance whose requests have all been processed
+ *
  * Return 0 if successful, error code otherwise
  *
+ * Additional information: Called by a blocking write holding the writer
+ * mutex. The reader mutex keeps a concurrent read from copying the result
+ * while it is dropped, a reader holding it does not wait since all results
+ * are available.
+ */
+static int file_req_drop(struct axi_trivium_inst *p_inst) {
+    if (mutex_lock_interruptible(&p_inst->rd_mtx))
+        return -ERESTARTSYS;
+
+    /* A concurrent read may have made room meanwhile */
+    spin_lock(&p_inst->req_lock);
+    if (p_inst->req_tail - p_inst->req_head == FILE_REQS_MAX)
+        p_inst->req_head++;
+    spin_unlock(&p_inst->req_lock);
+
+    mutex_unlock(&p_inst->rd_mtx);
+    return 0;
+}
+
+/*
+ * proc_axi_trivium_write_iter - Handler for write operation on a file
+ *
+ * @p_iocb - I/O control block, ki_pos being the key stream position in bytes
+ * @p_from - Input data from user-space
+ *
+ * Return number of bytes written if successful, error code otherwise
+ *
  * Additional information:
- *  - First set of writes are for key and IV
+ *  - First set of writes are for key and IV, they do not move the file position
  *  - Any subsequent writes for an instance are regarded as encryption requests
- *  - The encryption result can be read using the read operation on the /proc file
+ *  - The encryption results can be read using the read operation on the file,
+ *    in the order of the requests. Up to FILE_REQS_MAX requests may be written
+ *    before their results have to be read
+ *  - The key stream of an instance continues across encryption requests, if the
+ *    lane was used by another instance in the meantime, the saved cipher state
+ *    of the instance is restored instead of repeating the warm-up phase
+ *  - An encryption request starts at the key stream position given by the file
+ *    position, which must be a multiple of DAT_LEN_MUL. Sequential writes simply
+ *    continue the key stream, lseek() and pwrite() move it, see inst_seek()
+ *  - Requests may be encrypted in software, see dispatch_sw()
+ *  - A blocking write waits for the requests in flight and encrypts the data
+ *    before returning, errors are returned by the write. If FILE_REQS_MAX
+ *    results are unread, the oldest one is dropped rather than waiting for a
+ *    read that a single-threaded caller would never issue, so unread CT data
+ *    is lost as with a single buffer, see file_req_drop()
+ *  - A non-blocking write (O_NONBLOCK or IOCB_NOWAIT, e.g. from io_uring) only
+ *    queues the request for file_req_work() and returns -EAGAIN if
+ *    FILE_REQS_MAX results are unread or if the request buffer would have to
+ *    grow and memory is not available without sleeping. Errors are returned
+ *    by the read of the result
  */
-static ssize_t proc_axi_trivium_write(struct file *p_file, const char __user *p_buf, size_t sz, loff_t *p_off) {
-    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_file->private_data;
-    int ret_val = 0;
+static ssize_t proc_axi_trivium_write_iter(struct kiocb *p_iocb, struct iov_iter *p_from) {
+    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_iocb->ki_filp->private_data;
+    size_t sz = iov_iter_count(p_from);
+    bool nowait = file_nowait(p_iocb);
+    struct file_req *p_req;
+    ssize_t ret_val = sz;
+
+    if (nowait) {
+        if (!mutex_trylock(&p_inst->wr_mtx))
+            return -EAGAIN;
+    } else if (mutex_lock_interruptible(&p_inst->wr_mtx))
+        return -ERESTARTSYS;
 
     if (!p_inst->p_key) {
-        /* Key data expected, check format */
+        /* Key data expected, check format and copy key data from user buffer to instance */
         if (sz != KEY_LEN)
-            return -ENOEXEC;
-
-        /* Make sure a multiple of 32 bit is allocated for writing to registers */
-        p_inst->p_key = (unsigned char *)kzalloc((sz/3)*sizeof(unsigned int), GFP_KERNEL);
-        if (!p_inst->p_key)
-            return -ENOMEM;
-
-        /* Copy key data from user buffer to instance */
-        if (copy_from_user(p_inst->p_key, p_buf, sz))
-            return -EFAULT;
+            ret_val = -ENOEXEC;
+        else if (copy_from_iter(p_inst->key, sz, p_from) != sz)
+            ret_val = -EFAULT;
+        else
+            p_inst->p_key = p_inst->key;
     } else if (!p_inst->p_iv) {
-        /* IV data expected, check format */
+        /* IV data expected, check format and copy IV from user buffer to instance */
         if (sz != IV_LEN)
-            return -ENOEXEC;
+            ret_val = -ENOEXEC;
+        else if (copy_from_iter(p_inst->iv, sz, p_from) != sz)
+            ret_val = -EFAULT;
+        else
+            p_inst->p_iv = p_inst->iv;
+    } else if (sz%DAT_LEN_MUL) {
+        /* Plaintext data is expected to be multiple of input register size */
+        ret_val = -ENOEXEC;
+    } else if (p_iocb->ki_pos < 0 || (p_iocb->ki_pos & (DAT_LEN_MUL - 1))) {
+        /* So is the key stream position */
+        ret_val = -EINVAL;
+    } else if (nowait && !file_req_writable(p_inst)) {
+        /* All entries hold unread results */
+        ret_val = -EAGAIN;
+    } else if (!nowait && wait_event_interruptible(p_inst->req_wq, file_req_idle(p_inst))) {
+        /* Results are read in the order of the requests, so queued requests are processed first */
+        ret_val = -ERESTARTSYS;
+    } else if (!nowait && !file_req_writable(p_inst) && file_req_drop(p_inst)) {
+        /* Room is made by the writer itself, no reader has to come along */
+        ret_val = -ERESTARTSYS;
+    } else {
+        /* The entry is neither processed nor read until req_tail moves past it */
+        p_req = &p_inst->reqs[p_inst->req_tail % FILE_REQS_MAX];
+        if (!nowait)
+            ret_val = buf_reserve(&p_req->p_buf, &p_req->buf_cap, sz, GFP_KERNEL);
+        else if (buf_reserve(&p_req->p_buf, &p_req->buf_cap, sz, GFP_NOWAIT | __GFP_NOWARN))
+            ret_val = -EAGAIN;  /* Growing the buffer would have to wait for reclaim */
+        else
+            ret_val = 0;
 
-        /* Make sure a multiple of 32 bit is allocated for writing to registers */
-        p_inst->p_iv = (unsigned char *)kzalloc((sz/3)*sizeof(unsigned int), GFP_KERNEL);
-        if (!p_inst->p_iv)
-            return -ENOMEM;
+        if (!ret_val && copy_from_iter(p_req->p_buf, sz, p_from) != sz)
+            ret_val = -EFAULT;
 
-        /* Copy IV from user buffer to instance */
-        if (copy_from_user(p_inst->p_iv, p_buf, sz))
-            return -EFAULT;
-    } else {
-        /* Plaintext data is expected to be multiple of input register size */
-        if (sz%DAT_LEN_MUL)
-            return -ENOEXEC;
+        if (!ret_val) {
+            p_req->sz = sz;
+            p_req->rd_idx = 0;
+            p_req->pos = div_u64(p_iocb->ki_pos, DAT_LEN_MUL);
+            p_req->ret_val = 0;
+
+            /* This case denotes the actual encryption request, done right away unless the caller must not wait */
+            if (!nowait)
+                ret_val = file_req_run(p_inst, p_req);
+        }
+
+        if (!ret_val) {
+            spin_lock(&p_inst->req_lock);
+            p_inst->req_tail++;
+            if (!nowait)
+                p_inst->req_done = p_inst->req_tail;
+            spin_unlock(&p_inst->req_lock);
+
+            if (nowait)
+                queue_work(drv_info.p_wq, &p_inst->req_work);
+            else
+                wake_up_interruptible(&p_inst->req_wq);
+
+            p_iocb->ki_pos += sz;
+            ret_val = sz;
+        }
+    }
+
+    mutex_unlock(&p_inst->wr_mtx);
+    return ret_val;
+}
+
+/*
+ * proc_axi_trivium_read_iter - Handler for read operation on a file
+ *
+ * @p_iocb - I/O control block (the file position is not used here)
+ * @p_to - Output buffer to user-space
+ *
+ * Return number of bytes read if successful, error code otherwise
+ *
+ * Additional information:
+ *  - The results of the requests are returned in the order of the requests,
+ *    a read may end within a result and may span several results
+ *  - A read returns the results available so far, a blocking read only waits
+ *    if none is available yet while a non-blocking one returns -EAGAIN
+ *  - The error of a failed request is returned once in place of its result
+ *  - Reading without any request whose result is unread returns -ENOEXEC
+ *  - Reads do not move the file position, pread() returns the results like
+ *    read()
+ */
+static ssize_t proc_axi_trivium_read_iter(struct kiocb *p_iocb, struct iov_iter *p_to) {
+    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_iocb->ki_filp->private_data;
+    bool nowait = file_nowait(p_iocb);
+    unsigned int head, done, tail;
+    struct file_req *p_req;
+    ssize_t ret_val = 0;
+    size_t cnt;
 
-        /* Allocate buffers, note that unread CT data will be lost */
-        p_inst->p_pt = (unsigned char *)kzalloc(sz*sizeof(unsigned char), GFP_KERNEL);
+    if (nowait) {
+        if (!mutex_trylock(&p_inst->rd_mtx))
+            return -EAGAIN;
+    } else if (mutex_lock_interruptible(&p_inst->rd_mtx))
+        return -ERESTARTSYS;
 
-        if (p_inst->p_ct) {
-            kzfree(p_inst->p_ct);
-            p_inst->p_ct = NULL;
-            p_inst->ct_idx = 0;
+    while (iov_iter_count(p_to)) {
+        spin_lock(&p_inst->req_lock);
+        head = p_inst->req_head;
+        done = p_inst->req_done;
+        tail = p_inst->req_tail;
+        spin_unlock(&p_inst->req_lock);
+
+        /* Check if requested read is possible */
+        if (head == tail) {
+            if (!ret_val)
+                ret_val = -ENOEXEC;
+            break;
         }
 
-        p_inst->p_ct = (unsigned char *)kzalloc(sz*sizeof(unsigned char), GFP_KERNEL);
-        p_inst->buf_sz = sz;
+        /* Return the results read so far before waiting for the next one */
+        if (head == done) {
+            if (ret_val)
+                break;
 
-        if (copy_from_user(p_inst->p_pt, p_buf, sz))
-            return -EFAULT;
+            if (nowait)
+                ret_val = -EAGAIN;
+            else if (wait_event_interruptible(p_inst->req_wq, file_req_readable(p_inst)))
+                ret_val = -ERESTARTSYS;
+            else
+                continue;
 
-        /* This case denotes the actual encryption request, obtain access to IP */
-        mutex_lock(&ip_mtx);
-        ret_val = context_swap(&ip_info, p_inst);
-        if (ret_val)
-            return ret_val;
+            break;
+        }
 
-        ret_val = encrypt(&ip_info, p_inst);
-        if (ret_val)
-            return ret_val;
+        p_req = &p_inst->reqs[head % FILE_REQS_MAX];
+        if (p_req->ret_val) {
+            /* Report the error of a failed request once, after the results preceding it */
+            if (ret_val)
+                break;
 
-        /* Free the IP for other processes */
-        mutex_unlock(&ip_mtx);
-        kzfree(p_inst->p_pt);
-        p_inst->p_pt = NULL;
+            ret_val = p_req->ret_val;
+        } else {
+            /* Copy as many bytes of the result as requested */
+            cnt = min(iov_iter_count(p_to), (size_t)(p_req->sz - p_req->rd_idx));
+            if (copy_to_iter(p_req->p_buf + p_req->rd_idx, cnt, p_to) != cnt) {
+                if (!ret_val)
+                    ret_val = -EFAULT;
+                break;
+            }
+
+            p_req->rd_idx += cnt;
+            ret_val += cnt;
+            if (p_req->rd_idx < p_req->sz)
+                break;
+        }
+
+        /* Free the entry once everything has been read, the buffer is kept for the next request */
+        spin_lock(&p_inst->req_lock);
+        p_inst->req_head++;
+        spin_unlock(&p_inst->req_lock);
+        wake_up_interruptible(&p_inst->req_wq);
+
+        if (ret_val < 0)
+            break;
     }
 
-    return sz;
+    mutex_unlock(&p_inst->rd_mtx);
+    return ret_val;
 }
 
 /*
- * proc_axi_trivium_read - Handler for read operation on /proc entry
+ * proc_axi_trivium_poll - Handler for poll operation on a file
  *
  * @p_file - File pointer
- * @p_buf - Output buffer to user-space
- * @sz - Number of bytes to read
- * @p_off - Pointer to an offset value into the file (not used here)
+ * @p_wait - Poll table
  *
- * Return 0 if successful, error code otherwise
+ * Return the events that are ready
  *
- * Additional information:
- *  - Keep track of number of bytes read from CT buffer
- *  - Free the buffer once everything has been read
+ * Additional information: A file is readable once the next result is
+ * available and writable as long as fewer than FILE_REQS_MAX results are
+ * unread, see proc_axi_trivium_write_iter().
  */
-static ssize_t proc_axi_trivium_read(struct file *p_file, char __user *p_buf, size_t sz, loff_t *p_off) {
+static __poll_t proc_axi_trivium_poll(struct file *p_file, poll_table *p_wait) {
     struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_file->private_data;
+    __poll_t mask = 0;
 
-    /* Check if requested read is possible */
-    if (sz > p_inst->buf_sz - p_inst->ct_idx || !p_inst->p_ct)
-        return -ENOEXEC;
+    poll_wait(p_file, &p_inst->req_wq, p_wait);
 
-    /* Copy requested number of bytes*/
-    if (copy_to_user(p_buf, p_inst->p_ct + p_inst->ct_idx, sz))
-        return -EFAULT;
+    if (file_req_readable(p_inst))
+        mask |= EPOLLIN | EPOLLRDNORM;
 
-    /* Update index and clear buffer if everything has been read */
-    p_inst->ct_idx += sz;
-    if (p_inst->ct_idx == p_inst->buf_sz) {
-        kzfree(p_inst->p_ct);
-        p_inst->p_ct = NULL;
-        p_inst->ct_idx = 0;
-    }
+    if (file_req_writable(p_inst))
+        mask |= EPOLLOUT | EPOLLWRNORM;
 
-    return sz;
+    return mask;
 }
 
-/*******************************************************************************
- * Trivium specific functions
- ******************************************************************************/
-
 /*
- * context_swap - Swap the current instance in hardware with a specified one
+ * proc_axi_trivium_llseek - Handler for seek operation on /proc entry
  *
- * @p_ip_info: IP core information
- * @p_new_inst: Data for new Trivium instance
+ * @p_file - File pointer
+ * @off - Offset relative to whence
+ * @whence - SEEK_SET or SEEK_CUR
  *
- * Return 0 on success, error code otherwise
+ * Return new file position if successful, error code otherwise
  *
- * Additional information: This function should only be called if the mutex
- * for the IP core has been acquired.
+ * Additional information: The file position is the key stream position of the
+ * next encryption request in bytes, see proc_axi_trivium_write(). It must be a
+ * multiple of DAT_LEN_MUL. The key stream has no end, so SEEK_END is rejected.
  */
-static int context_swap(struct core_info *p_ip_info, struct axi_trivium_inst *p_new_inst) {
-    /* Make sure everything required is present */
-    if (!p_ip_info || !p_new_inst)
+static loff_t proc_axi_trivium_llseek(struct file *p_file, loff_t off, int whence) {
+    loff_t pos;
+
+    switch (whence) {
+    case SEEK_SET:
+        pos = off;
+        break;
+    case SEEK_CUR:
+        pos = p_file->f_pos + off;
+        break;
+    default:
         return -EINVAL;
-    else {
-        if (!p_new_inst->p_key || !p_new_inst->p_iv)
-            return -EINVAL;
     }
 
-    /* Stop the core */
-    reg_set(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_STOP);
-
-    /* Check if core is ready */
-    if (1 == reg_get(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_BUSY))
-        return -EIO;
+    if (pos < 0 || (pos & (DAT_LEN_MUL - 1)))
+        return -EINVAL;
 
-    /* Set key and IV */
-    reg_wr(p_ip_info, REG_KEY_LO, *((unsigned int *)(p_new_inst->p_key)));
-    reg_wr(p_ip_info, REG_KEY_MID, *((unsigned int *)(p_new_inst->p_key) + 1));
-    reg_wr(p_ip_info, REG_KEY_HI, *((unsigned int *)(p_new_inst->p_key) + 2));
+    return vfs_setpos(p_file, pos, MAX_LFS_FILESIZE);
+}
 
-    reg_wr(p_ip_info, REG_IV_LO, *((unsigned int *)(p_new_inst->p_iv)));
-    reg_wr(p_ip_info, REG_IV_MID, *((unsigned int *)(p_new_inst->p_iv) + 1));
-    reg_wr(p_ip_info, REG_IV_HI, *((unsigned int *)(p_new_inst->p_iv) + 2));
+/*
+ * file_req_run - Encrypt a request written to a file
+ *
+ * @p_inst: Trivium instance of the file
+ * @p_req: Request, encrypted in place
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int file_req_run(struct axi_trivium_inst *p_inst, struct file_req *p_req) {
+    unsigned int num_words = p_req->sz/DAT_LEN_MUL;
+    int ret_val;
 
-    /* Initialize and wait for completion */
-    reg_set(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_INIT);
-    while (0 == reg_get(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_IDONE));
+    mutex_lock(&p_inst->mtx);
+    lane_select(p_inst);
+    ret_val = inst_seek(p_inst, p_req->pos);
+    if (!ret_val) {
+        if (dispatch_sw(p_inst, num_words))
+            sw_encrypt(p_inst, (unsigned int *)p_req->p_buf, (unsigned int *)p_req->p_buf, num_words);
+        else
+            ret_val = hw_encrypt(p_inst, (unsigned int *)p_req->p_buf, (unsigned int *)p_req->p_buf, num_words, true);
+    }
 
-    return 0;
+    mutex_unlock(&p_inst->mtx);
+    return ret_val;
 }
 
 /*
- * encrypt - Encrypt current plaintext buffer
+ * file_req_work - Worker processing the queued requests of a file
  *
- * @p_ip_info: IP core information
- * @p_inst: Data for Trivium instance, include plaintext buffer
- *
- * Return 0 on success, error code otherwise
+ * @p_work: Work item of the instance
  *
- * Additional information: This function should only be called if the mutex
- * for the IP core has been acquired and the context has been switched.
+ * Additional information: The requests are processed in order, readers and
+ * pollers are woken after each one. The writer submitting the next request
+ * meanwhile copies its data, so submission overlaps with the encryption.
  */
-static int encrypt(struct core_info *p_ip_info, struct axi_trivium_inst *p_inst) {
-    int i;
+static void file_req_work(struct work_struct *p_work) {
+    struct axi_trivium_inst *p_inst = container_of(p_work, struct axi_trivium_inst, req_work);
+    struct file_req *p_req;
+    bool pending;
 
-    /* Make sure everything required is present */
-    if (!p_ip_info || !p_inst)
-        return -EINVAL;
-    else {
-        if (!p_inst->p_pt || !p_inst->p_ct)
-            return -EINVAL;
+    for (;;) {
+        spin_lock(&p_inst->req_lock);
+        pending = (p_inst->req_done != p_inst->req_tail);
+        p_req = &p_inst->reqs[p_inst->req_done % FILE_REQS_MAX];
+        spin_unlock(&p_inst->req_lock);
+
+        if (!pending)
+            break;
+
+        p_req->ret_val = file_req_run(p_inst, p_req);
+
+        spin_lock(&p_inst->req_lock);
+        p_inst->req_done++;
+        spin_unlock(&p_inst->req_lock);
+        wake_up_interruptible(&p_inst->req_wq);
     }
+}
+
+/*
+ * dev_axi_trivium_ioctl - Handler for ioctl operation on the character device
+ *
+ * @p_file - File pointer
+ * @cmd - Command, see axi_trivium_ioctl.h
+ * @arg - Command argument
+ *
+ * Return value of the respective command, error code otherwise
+ */
+static long dev_axi_trivium_ioctl(struct file *p_file, unsigned int cmd, unsigned long arg) {
+    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_file->private_data;
 
-    /* Encrypt word for word */
-    for (i = 0; i < (p_inst->buf_sz)/DAT_LEN_MUL; i++) {
-        /* Make sure the core is ready */
-        if (1 == reg_get(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_BUSY))
-            return -EIO;
+    switch (cmd) {
+        case AXI_TRIVIUM_IOC_SETUP:
+            return ring_setup(p_inst, (struct axi_trivium_setup __user *)arg);
 
-        /* Write plaintext to core */
-        reg_wr(p_ip_info, REG_DAT_I, *(((unsigned int *)p_inst->p_pt) + i));
+        case AXI_TRIVIUM_IOC_DOORBELL:
+            return ring_process(p_inst);
 
-        /* Start computation and wait until output valid */
-        reg_set(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_PROC);
-        while (0 == reg_get(p_ip_info, REG_CONFIG, REG_CONFIG_BIT_OVAL));
+        case AXI_TRIVIUM_IOC_BATCH:
+            return batch_submit(p_inst, (struct axi_trivium_batch __user *)arg);
 
-        /* Read result into output buffer */
-        *(((unsigned int *)p_inst->p_ct) + i) = reg_rd(p_ip_info, REG_DAT_O);
+        default:
+            return -ENOTTY;
     }
+}
 
-    return 0;
+/*
+ * dev_axi_trivium_mmap - Handler for mmap operation on the character device
+ *
+ * @p_file - File pointer
+ * @p_vma - Virtual memory area to map the ring into
+ *
+ * Return 0 if successful, error code otherwise
+ */
+static int dev_axi_trivium_mmap(struct file *p_file, struct vm_area_struct *p_vma) {
+    struct axi_trivium_inst *p_inst = (struct axi_trivium_inst *)p_file->private_data;
+    int ret_val;
+
+    /* The ring must have been set up and is mapped as a whole, see ring_setup() */
+    mutex_lock(&p_inst->mtx);
+    if (!p_inst->p_ring || p_vma->vm_pgoff || p_vma->vm_end - p_vma->vm_start > p_inst->ring_sz)
+        ret_val = -EINVAL;
+    else
+        ret_val = remap_vmalloc_range(p_vma, p_inst->p_ring, 0);
+
+    mutex_unlock(&p_inst->mtx);
+    return ret_val;
 }
 
 /*******************************************************************************
- * Driver registration and information
+ * Shared ring functions
  ******************************************************************************/
-/* Table used to match this driver with an entry in the device tree */
-static const struct of_device_id axi_trivium_of_match[] = {
-    {.compatible = "fuzzylogic,axi_trivium_1.0"},
-    {}
-};
 
-MODULE_DEVICE_TABLE(of, axi_trivium_of_match);
+/*
+ * ring_setup - Set key and IV of an instance and allocate its shared ring
+ *
+ * @p_inst: Trivium instance
+ * @p_user_setup: Setup parameters from user-space, mmap_sz is returned
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: The writer mutex keeps out concurrent setups and
+ * key writes, the instance mutex ring_process() and dev_axi_trivium_mmap(),
+ * which see the ring only once its geometry is complete. mmap_sz is returned
+ * before anything is set, so a failed setup leaves the session untouched.
+ * User memory is not accessed while holding the instance mutex, which mmap()
+ * takes with the mmap lock held.
+ */
+static int ring_setup(struct axi_trivium_inst *p_inst, struct axi_trivium_setup __user *p_user_setup) {
+    struct axi_trivium_setup setup;
+    struct axi_trivium_ring_hdr *p_hdr;
+    unsigned long cq_off, buf_off, ring_sz;
+    int ret_val = 0;
 
-/* Platform driver structure for the AXI4-Lite Trivium core */
-static struct platform_driver axi_trivium_driver = {
-    .driver = {
-        .name = DRIVER_NAME,
-        .owner = THIS_MODULE,
-        .of_match_table = axi_trivium_of_match
-    },
-    .probe = axi_trivium_probe,
-    .remove = axi_trivium_remove,
-    .shutdown = axi_trivium_shutdown
-};
+    if (copy_from_user(&setup, p_user_setup, sizeof(setup)))
+        return -EFAULT;
+
+    /* Check geometry */
+    if (setup.num_entries == 0 || setup.num_entries > AXI_TRIVIUM_RING_MAX_ENTRIES ||
+        (setup.num_entries & (setup.num_entries - 1)))
+        return -EINVAL;
+
+    if (setup.buf_sz == 0 || setup.buf_sz > AXI_TRIVIUM_RING_MAX_BUF_SZ || setup.buf_sz%DAT_LEN_MUL)
+        return -EINVAL;
+
+    /* Queues follow the header, data buffers start on a page boundary */
+    cq_off = sizeof(struct axi_trivium_ring_hdr) + setup.num_entries*sizeof(struct axi_trivium_sqe);
+    buf_off = PAGE_ALIGN(cq_off + setup.num_entries*sizeof(struct axi_trivium_cqe));
+    ring_sz = PAGE_ALIGN(buf_off + setup.num_entries*(unsigned long)setup.buf_sz);
+
+    if (mutex_lock_interruptible(&p_inst->wr_mtx))
+        return -ERESTARTSYS;
+
+    /* A session is set up only once */
+    if (p_inst->p_key || p_inst->p_ring) {
+        ret_val = -EBUSY;
+        goto unlock;
+    }
+
+    setup.mmap_sz = ring_sz;
+    if (copy_to_user(p_user_setup, &setup, sizeof(setup))) {
+        ret_val = -EFAULT;
+        goto unlock;
+    }
+
+    p_hdr = (struct axi_trivium_ring_hdr *)vmalloc_user(ring_sz);
+    if (!p_hdr) {
+        ret_val = -ENOMEM;
+        goto unlock;
+    }
+
+    /* vmalloc_user() returns zeroed memory, so all queues are empty */
+    p_hdr->num_entries = setup.num_entries;
+    p_hdr->buf_sz = setup.buf_sz;
+    p_hdr->sq_off = sizeof(struct axi_trivium_ring_hdr);
+    p_hdr->cq_off = cq_off;
+    p_hdr->buf_off = buf_off;
+
+    mutex_lock(&p_inst->mtx);
+
+    /* Same register layout as for writes to /proc */
+    memcpy(p_inst->key, setup.key, KEY_LEN);
+    memcpy(p_inst->iv, setup.iv, IV_LEN);
+    p_inst->p_key = p_inst->key;
+    p_inst->p_iv = p_inst->iv;
+
+    /* The geometry is complete before the ring is published */
+    p_inst->ring_sz = ring_sz;
+    p_inst->ring_entries = setup.num_entries;
+    p_inst->ring_buf_sz = setup.buf_sz;
+    p_inst->ring_buf_off = buf_off;
+    p_inst->p_ring = p_hdr;
+
+    mutex_unlock(&p_inst->mtx);
+
+unlock:
+    mutex_unlock(&p_inst->wr_mtx);
+    return ret_val;
+}
+
+/*
+ * ring_process - Encrypt all pending submissions of an instance's ring
+ *
+ * @p_inst: Trivium instance
+ *
+ * Return number of completions added, error code otherwise
+ *
+ * Additional information: The ring is shared with user-space, so every entry
+ * is read only once and checked before it is used. The geometry and the
+ * indices owned by the driver are taken from private copies rather than from
+ * the shared header. Each message is encrypted in place, continuing the key
+ * stream of the instance.
+ */
+static int ring_process(struct axi_trivium_inst *p_inst) {
+    struct axi_trivium_ring_hdr *p_hdr;
+    struct axi_trivium_sqe *p_sq;
+    struct axi_trivium_cqe *p_cq;
+    unsigned int sq_tail, mask, buf_idx, len;
+    unsigned char *p_buf;
+    u64 user_data;
+    ktime_t start;
+    bool aborted = false;
+    int ret_val, res, num_done = 0;
+
+    /* The ring and its geometry are published together, see ring_setup() */
+    start = ktime_get();
+    mutex_lock(&p_inst->mtx);
+    p_hdr = p_inst->p_ring;
+    if (!p_hdr) {
+        mutex_unlock(&p_inst->mtx);
+        return -EINVAL;
+    }
+
+    p_sq = (struct axi_trivium_sqe *)((unsigned char *)p_hdr + sizeof(struct axi_trivium_ring_hdr));
+    p_cq = (struct axi_trivium_cqe *)(p_sq + p_inst->ring_entries);
+    mask = p_inst->ring_entries - 1;
+
+    /* Entries written by user-space become visible with the tail */
+    sq_tail = READ_ONCE(p_hdr->sq_tail);
+    smp_rmb();
+
+    lane_select(p_inst);
+    atomic_inc(&p_inst->p_lane->queued);
+    lane_lock(p_inst->p_lane, &p_inst->stats);
+    ret_val = lane_claim(p_inst);
+
+    /* Stop when the completion queue is full */
+    while (p_inst->sq_head != sq_tail && p_inst->cq_tail - READ_ONCE(p_hdr->cq_head) <= mask) {
+        user_data = READ_ONCE(p_sq[p_inst->sq_head & mask].user_data);
+        buf_idx = READ_ONCE(p_sq[p_inst->sq_head & mask].buf_idx);
+        len = READ_ONCE(p_sq[p_inst->sq_head & mask].len);
+
+        if (ret_val)
+            res = ret_val;
+        else if (buf_idx > mask || len > p_inst->ring_buf_sz || len%DAT_LEN_MUL)
+            res = -EINVAL;
+        else {
+            p_buf = (unsigned char *)p_hdr + p_inst->ring_buf_off + buf_idx*p_inst->ring_buf_sz;
+            res = encrypt(p_inst->p_lane, (unsigned int *)p_buf, (unsigned int *)p_buf, len/DAT_LEN_MUL);
+            if (!res) {
+                /* Later writes and pwrite()s continue after the entry, see inst_seek() */
+                p_inst->ks_pos += len/DAT_LEN_MUL;
+                res = len;
+            } else {
+                /* The key stream position is lost, so the remaining entries fail as well */
+                lane_abort(p_inst->p_lane);
+                aborted = true;
+                ret_val = res;
+            }
+        }
+
+        /* The latency of an entry is counted from the doorbell */
+        stats_request(&p_inst->p_lane->p_core->stats, &p_inst->stats, ktime_to_ns(ktime_sub(ktime_get(), start)));
+        p_cq[p_inst->cq_tail & mask].user_data = user_data;
+        p_cq[p_inst->cq_tail & mask].res = res;
+        p_inst->sq_head++;
+        p_inst->cq_tail++;
+        num_done++;
+
+        /* Publish the completion before the new tail */
+        smp_wmb();
+        WRITE_ONCE(p_hdr->sq_head, p_inst->sq_head);
+        WRITE_ONCE(p_hdr->cq_tail, p_inst->cq_tail);
+    }
+
+    lane_unlock(p_inst->p_lane);
+    atomic_dec(&p_inst->p_lane->queued);
+    if (aborted)
+        inst_rewind(p_inst);
+
+    mutex_unlock(&p_inst->mtx);
+
+    return num_done;
+}
+
+/*******************************************************************************
+ * Batch functions
+ ******************************************************************************/
+
+/*
+ * batch_submit - Process a batch of jobs and wait for its completion
+ *
+ * @p_inst: Trivium instance submitting the batch
+ * @p_user_batch: Batch parameters from user-space, latency_ns is returned
+ *
+ * Return 0 if the batch has been processed, error code otherwise. The result
+ * of each job is returned in its res field.
+ *
+ * Additional information: Descriptors and input data are copied into the
+ * kernel, as the worker runs outside of the submitting process. Jobs are
+ * ordered such that jobs with the same key and IV follow each other in
+ * submission order, the worker then initializes the lane once per group.
+ * The mutex of the instance is held until the batch has completed, so the
+ * instance cannot move to another lane while it has batches queued.
+ */
+static int batch_submit(struct axi_trivium_inst *p_inst, struct axi_trivium_batch __user *p_user_batch) {
+    struct axi_trivium_batch batch;
+    struct axi_trivium_job *p_job;
+    struct batch_info *p_batch;
+    struct lane_info *p_lane;
+    DECLARE_BITMAP(placed, AXI_TRIVIUM_BATCH_MAX_JOBS);
+    unsigned long total = 0;
+    unsigned int i, j, n = 0;
+    ktime_t start;
+    int ret_val = 0;
+
+    if (copy_from_user(&batch, p_user_batch, sizeof(batch)))
+        return -EFAULT;
+
+    if (batch.num_jobs == 0 || batch.num_jobs > AXI_TRIVIUM_BATCH_MAX_JOBS)
+        return -EINVAL;
+
+    p_batch = (struct batch_info *)kzalloc(sizeof(struct batch_info), GFP_KERNEL);
+    if (!p_batch)
+        return -ENOMEM;
+
+    p_batch->num_jobs = batch.num_jobs;
+    p_batch->p_jobs = (struct axi_trivium_job *)kcalloc(batch.num_jobs, sizeof(struct axi_trivium_job), GFP_KERNEL);
+    p_batch->p_offs = (unsigned long *)kcalloc(batch.num_jobs, sizeof(unsigned long), GFP_KERNEL);
+    p_batch->p_order = (unsigned int *)kcalloc(batch.num_jobs, sizeof(unsigned int), GFP_KERNEL);
+    if (!p_batch->p_jobs || !p_batch->p_offs || !p_batch->p_order) {
+        ret_val = -ENOMEM;
+        goto out;
+    }
+
+    if (copy_from_user(p_batch->p_jobs, u64_to_user_ptr(batch.jobs), batch.num_jobs*sizeof(struct axi_trivium_job))) {
+        ret_val = -EFAULT;
+        goto out;
+    }
+
+    /* Check the jobs and lay out their data back to back */
+    for (i = 0; i < batch.num_jobs; i++) {
+        p_job = &p_batch->p_jobs[i];
+        if (p_job->len%DAT_LEN_MUL || p_job->len > AXI_TRIVIUM_BATCH_MAX_BYTES - total) {
+            ret_val = -EINVAL;
+            goto out;
+        }
+
+        p_batch->p_offs[i] = total;
+        total += p_job->len;
+    }
+
+    p_batch->p_dat = (unsigned char *)kvmalloc(total ? total : DAT_LEN_MUL, GFP_KERNEL);
+    if (!p_batch->p_dat) {
+        ret_val = -ENOMEM;
+        goto out;
+    }
+
+    for (i = 0; i < batch.num_jobs; i++) {
+        p_job = &p_batch->p_jobs[i];
+        if (copy_from_user(p_batch->p_dat + p_batch->p_offs[i], u64_to_user_ptr(p_job->in), p_job->len)) {
+            ret_val = -EFAULT;
+            goto out;
+        }
+    }
+
+    /* Group jobs by key and IV, keeping the submission order within a group */
+    bitmap_zero(placed, AXI_TRIVIUM_BATCH_MAX_JOBS);
+    for (i = 0; i < batch.num_jobs; i++) {
+        if (test_bit(i, placed))
+            continue;
+
+        for (j = i; j < batch.num_jobs; j++) {
+            if (!test_bit(j, placed) &&
+                !memcmp(p_batch->p_jobs[i].key, p_batch->p_jobs[j].key, KEY_LEN) &&
+                !memcmp(p_batch->p_jobs[i].iv, p_batch->p_jobs[j].iv, IV_LEN)) {
+                p_batch->p_order[n++] = j;
+                set_bit(j, placed);
+            }
+        }
+    }
+
+    /* Queue the batch on the lane of the instance */
+    mutex_lock(&p_inst->mtx);
+    lane_select(p_inst);
+    p_lane = p_inst->p_lane;
+    init_completion(&p_batch->done);
+    p_batch->inst.p_lane = p_lane;
+    p_batch->p_stats = &p_inst->stats;
+    start = ktime_get();
+
+    spin_lock(&p_lane->sched_lock);
+    if (list_empty(&p_inst->batches))
+        list_add_tail(&p_inst->sched_node, &p_lane->sched_q);
+
+    list_add_tail(&p_batch->node, &p_inst->batches);
+    spin_unlock(&p_lane->sched_lock);
+
+    queue_work(drv_info.p_wq, &p_lane->sched_work);
+    wait_for_completion(&p_batch->done);
+    mutex_unlock(&p_inst->mtx);
+    batch.latency_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    /* Return the results, the latency of each job is that of the batch */
+    for (i = 0; i < batch.num_jobs; i++) {
+        p_job = &p_batch->p_jobs[i];
+        stats_request(&p_lane->p_core->stats, &p_inst->stats, batch.latency_ns);
+        if (p_job->res > 0 &&
+            copy_to_user(u64_to_user_ptr(p_job->out), p_batch->p_dat + p_batch->p_offs[i], p_job->len))
+            p_job->res = -EFAULT;
+
+        if (put_user(p_job->res, &((struct axi_trivium_job __user *)u64_to_user_ptr(batch.jobs))[i].res))
+            ret_val = -EFAULT;
+    }
+
+    if (copy_to_user(p_user_batch, &batch, sizeof(batch)))
+        ret_val = -EFAULT;
+
+out:
+    batch_free(p_batch);
+    return ret_val;
+}
+
+/*
+ * batch_run_group - Process the next group of jobs of a batch
+ *
+ * @p_lane: Lane to use
+ * @p_batch: Batch
+ *
+ * Return true if all jobs of the batch have been processed, false otherwise
+ *
+ * Additional information: A group is a run of jobs with the same key and IV,
+ * its jobs continue the key stream of their predecessor. If a job fails, the
+ * position in the key stream is lost and the remaining jobs of the group fail
+ * as well. The lane does not keep the state of the group afterwards.
+ */
+static bool batch_run_group(struct lane_info *p_lane, struct batch_info *p_batch) {
+    struct axi_trivium_inst *p_inst = &p_batch->inst;
+    struct axi_trivium_job *p_job = &p_batch->p_jobs[p_batch->p_order[p_batch->next]];
+    unsigned int idx, *p_dat;
+    int ret_val;
+
+    memcpy(p_inst->key, p_job->key, KEY_LEN);
+    memcpy(p_inst->iv, p_job->iv, IV_LEN);
+    p_inst->p_key = p_inst->key;
+    p_inst->p_iv = p_inst->iv;
+    p_inst->state_valid = 0;
+
+    atomic_inc(&p_lane->queued);
+    lane_lock(p_lane, p_batch->p_stats);
+    ret_val = lane_claim(p_inst);
+
+    do {
+        idx = p_batch->p_order[p_batch->next];
+        p_job = &p_batch->p_jobs[idx];
+        p_dat = (unsigned int *)(p_batch->p_dat + p_batch->p_offs[idx]);
+        if (!ret_val && p_job->len) {
+            ret_val = encrypt(p_lane, p_dat, p_dat, p_job->len/DAT_LEN_MUL);
+            if (ret_val)
+                lane_abort(p_lane);
+        }
+
+        p_job->res = ret_val ? ret_val : p_job->len;
+        p_batch->next++;
+    } while (p_batch->next < p_batch->num_jobs &&
+             !memcmp(p_inst->key, p_batch->p_jobs[p_batch->p_order[p_batch->next]].key, KEY_LEN) &&
+             !memcmp(p_inst->iv, p_batch->p_jobs[p_batch->p_order[p_batch->next]].iv, IV_LEN));
+
+    p_lane->p_owner = NULL;
+    lane_unlock(p_lane);
+    atomic_dec(&p_lane->queued);
+
+    return p_batch->next == p_batch->num_jobs;
+}
+
+/*
+ * batch_work - Worker processing the pending batches of a lane
+ *
+ * @p_work: Work item of the lane
+ *
+ * Additional information: The instances with pending batches are served
+ * round-robin, one group of jobs per turn, so a client submitting large
+ * batches does not starve the others. The batches of an instance are
+ * processed in submission order.
+ */
+static void batch_work(struct work_struct *p_work) {
+    struct lane_info *p_lane = container_of(p_work, struct lane_info, sched_work);
+    struct axi_trivium_inst *p_inst;
+    struct batch_info *p_batch;
+    bool finished;
+
+    spin_lock(&p_lane->sched_lock);
+    while (!list_empty(&p_lane->sched_q)) {
+        p_inst = list_first_entry(&p_lane->sched_q, struct axi_trivium_inst, sched_node);
+        p_batch = list_first_entry(&p_inst->batches, struct batch_info, node);
+        list_move_tail(&p_inst->sched_node, &p_lane->sched_q);
+        spin_unlock(&p_lane->sched_lock);
+
+        finished = batch_run_group(p_lane, p_batch);
+
+        spin_lock(&p_lane->sched_lock);
+        if (finished) {
+            list_del(&p_batch->node);
+            if (list_empty(&p_inst->batches))
+                list_del(&p_inst->sched_node);
+
+            complete(&p_batch->done);
+        }
+    }
+    spin_unlock(&p_lane->sched_lock);
+}
+
+/*
+ * batch_free - Zeroize and free a batch
+ *
+ * @p_batch: Batch
+ */
+static void batch_free(struct batch_info *p_batch) {
+    unsigned long total = 0;
+    unsigned int i;
+
+    if (p_batch->p_dat) {
+        for (i = 0; i < p_batch->num_jobs; i++)
+            total += p_batch->p_jobs[i].len;
+
+        memzero_explicit(p_batch->p_dat, total);
+        kvfree(p_batch->p_dat);
+    }
+
+    if (p_batch->p_jobs)
+        kzfree(p_batch->p_jobs);
+
+    kfree(p_batch->p_offs);
+    kfree(p_batch->p_order);
+    kzfree(p_batch);
+}
+
+/*******************************************************************************
+ * Crypto API functions
+ ******************************************************************************/
+
+/*
+ * skcipher_trivium_init - Set up a transform
+ *
+ * @p_tfm: Transform
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int skcipher_trivium_init(struct crypto_skcipher *p_tfm) {
+    struct trivium_tfm_ctx *p_ctx = crypto_skcipher_ctx(p_tfm);
+
+    p_ctx->enginectx.op.prepare_request = NULL;
+    p_ctx->enginectx.op.unprepare_request = NULL;
+    p_ctx->enginectx.op.do_one_request = skcipher_trivium_do_one_request;
+    crypto_skcipher_set_reqsize(p_tfm, sizeof(struct trivium_req_ctx));
+
+    return 0;
+}
+
+/*
+ * skcipher_trivium_exit - Tear down a transform
+ *
+ * @p_tfm: Transform
+ */
+static void skcipher_trivium_exit(struct crypto_skcipher *p_tfm) {
+    struct trivium_tfm_ctx *p_ctx = crypto_skcipher_ctx(p_tfm);
+
+    memzero_explicit(p_ctx->key, sizeof(p_ctx->key));
+}
+
+/*
+ * skcipher_trivium_setkey - Set the key of a transform
+ *
+ * @p_tfm: Transform
+ * @p_key: Key, least significant byte first (same format as for /proc)
+ * @key_len: Key length in bytes
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int skcipher_trivium_setkey(struct crypto_skcipher *p_tfm, const u8 *p_key, unsigned int key_len) {
+    struct trivium_tfm_ctx *p_ctx = crypto_skcipher_ctx(p_tfm);
+
+    if (key_len != KEY_LEN)
+        return -EINVAL;
+
+    memcpy(p_ctx->key, p_key, KEY_LEN);
+    return 0;
+}
+
+/*
+ * skcipher_trivium_crypt - Queue an encryption or decryption request
+ *
+ * @p_req: Request, the IV is expected in the same format as the key
+ *
+ * Return -EINPROGRESS on success, error code otherwise
+ *
+ * Additional information: Encryption and decryption are the same operation
+ * for a stream cipher. The request is queued in the crypto engine of the core
+ * with the least loaded lane.
+ */
+static int skcipher_trivium_crypt(struct skcipher_request *p_req) {
+    struct trivium_req_ctx *p_req_ctx = skcipher_request_ctx(p_req);
+    struct lane_info *p_lane;
+
+    mutex_lock(&drv_info.mtx);
+    p_lane = lane_least_loaded(NULL);
+    mutex_unlock(&drv_info.mtx);
+    if (!p_lane)
+        return -ENODEV;
+
+    p_req_ctx->p_core = p_lane->p_core;
+    return crypto_transfer_skcipher_request_to_engine(p_req_ctx->p_core->p_engine, p_req);
+}
+
+/*
+ * skcipher_trivium_do_one_request - Process a request queued in the crypto engine
+ *
+ * @p_engine: Crypto engine
+ * @p_areq: Request
+ *
+ * Return 0, the result is reported via crypto_finalize_skcipher_request()
+ *
+ * Additional information: Every request starts a new key stream from key and
+ * IV. If the core has a DMA engine, it encrypts the scatterlists directly,
+ * see dma_encrypt(). Otherwise, or if they do not suit the engine, the data
+ * is gathered into the buffer of the core's crypto instance, padded to a
+ * multiple of the word size, encrypted on the least loaded lane of the core
+ * or in software and scattered back to the destination. The engine
+ * processes one request at a time, so the instance is not shared.
+ * Afterwards the lane no longer holds a state of the instance, so a state
+ * saved for another instance is not overwritten.
+ */
+static int skcipher_trivium_do_one_request(struct crypto_engine *p_engine, void *p_areq) {
+    struct skcipher_request *p_req = container_of(p_areq, struct skcipher_request, base);
+    struct trivium_tfm_ctx *p_ctx = crypto_skcipher_ctx(crypto_skcipher_reqtfm(p_req));
+    struct core_info *p_core = ((struct trivium_req_ctx *)skcipher_request_ctx(p_req))->p_core;
+    struct axi_trivium_inst *p_inst = p_core->p_crypt_inst;
+    unsigned int num_words = DIV_ROUND_UP(p_req->cryptlen, DAT_LEN_MUL);
+    unsigned int *p_buf;
+    int ret_val = 0;
+
+    if (num_words) {
+        memcpy(p_inst->key, p_ctx->key, KEY_LEN);
+        memcpy(p_inst->iv, p_req->iv, IV_LEN);
+
+        /* Start a new key stream */
+        p_inst->p_lane = lane_least_loaded(p_core);
+        p_inst->state_valid = 0;
+        p_inst->sw_valid = 0;
+        p_inst->ks_len = 0;
+        if (p_core->p_dma_ring && !p_core->dma_hung && !dispatch_sw(p_inst, num_words)) {
+            ret_val = dma_encrypt(p_core, p_inst, p_req);
+            if (ret_val != -EOPNOTSUPP)
+                goto finalize;
+
+            ret_val = 0;
+        }
+
+        ret_val = buf_reserve(&p_inst->p_buf, &p_inst->buf_cap, num_words*DAT_LEN_MUL, GFP_KERNEL);
+        if (ret_val)
+            goto finalize;
+
+        p_buf = (unsigned int *)p_inst->p_buf;
+        sg_copy_to_buffer(p_req->src, sg_nents(p_req->src), p_buf, p_req->cryptlen);
+        if (dispatch_sw(p_inst, num_words))
+            sw_encrypt(p_inst, p_buf, p_buf, num_words);
+        else
+            ret_val = hw_encrypt(p_inst, p_buf, p_buf, num_words, false);
+
+        if (!ret_val)
+            sg_copy_from_buffer(p_req->dst, sg_nents(p_req->dst), p_buf, p_req->cryptlen);
+    }
+
+finalize:
+    crypto_finalize_skcipher_request(p_engine, p_req, ret_val);
+    return 0;
+}
+
+/*
+ * dma_encrypt - Encrypt a crypto API request with the DMA engine of a core
+ *
+ * @p_core: Core with a DMA engine
+ * @p_inst: Crypto instance of the core, holding key and IV of the request
+ * @p_req: Request
+ *
+ * Return 0 on success, -EOPNOTSUPP if the request does not suit the engine,
+ * other error code otherwise
+ *
+ * Additional information: Each contiguous piece of source and destination
+ * becomes one descriptor. The first descriptor starts the key stream from
+ * key and IV, the others continue it, and only the last one raises the DMA
+ * event. The engine drives lane 0, so the state of its previous owner is
+ * saved first, like in lane_claim(). The length and all pieces must be
+ * multiples of the word size and the descriptors must fit into the ring,
+ * otherwise the request is left to the caller without touching the data. If
+ * the engine is not idle within DMA_TIMEOUT_US, it is disabled, which aborts
+ * the current descriptor, and the ring is reset before the buffers are
+ * unmapped.
+ */
+static int dma_encrypt(struct core_info *p_core, struct axi_trivium_inst *p_inst, struct skcipher_request *p_req) {
+    struct lane_info *p_lane = &p_core->p_lanes[0];
+    enum dma_data_direction src_dir = (p_req->src == p_req->dst) ? DMA_BIDIRECTIONAL : DMA_TO_DEVICE;
+    struct scatterlist *p_src = p_req->src, *p_dst = p_req->dst;
+    unsigned int src_off = 0, dst_off = 0, left = p_req->cryptlen, num_desc = 0, len, conf, i;
+    int src_nents, dst_nents, src_mapped, dst_mapped = 0, src_cnt, dst_cnt, ret_val = 0;
+    struct dma_desc *p_desc = NULL;
+    dma_addr_t src_addr, dst_addr;
+    ktime_t begin;
+
+    if (!left || left % DAT_LEN_MUL)
+        return -EOPNOTSUPP;
+
+    src_nents = sg_nents_for_len(p_req->src, left);
+    dst_nents = sg_nents_for_len(p_req->dst, left);
+    if (src_nents < 0 || dst_nents < 0)
+        return -EINVAL;
+
+    src_mapped = dma_map_sg(p_core->p_dev, p_req->src, src_nents, src_dir);
+    if (!src_mapped)
+        return -ENOMEM;
+
+    if (src_dir != DMA_BIDIRECTIONAL) {
+        dst_mapped = dma_map_sg(p_core->p_dev, p_req->dst, dst_nents, DMA_FROM_DEVICE);
+        if (!dst_mapped) {
+            ret_val = -ENOMEM;
+            goto unmap;
+        }
+    }
+
+    begin = ktime_get();
+    atomic_inc(&p_lane->queued);
+    lane_lock(p_lane, &p_inst->stats);
+
+    /* Split the request where a mapped piece of the source or the destination ends */
+    src_cnt = src_mapped;
+    dst_cnt = dst_mapped ? dst_mapped : src_mapped;
+    while (left) {
+        if (!src_cnt || !dst_cnt || num_desc == DMA_RING_ENTRIES - 1) {
+            ret_val = -EOPNOTSUPP;
+            break;
+        }
+
+        src_addr = sg_dma_address(p_src) + src_off;
+        dst_addr = sg_dma_address(p_dst) + dst_off;
+        len = min3(sg_dma_len(p_src) - src_off, sg_dma_len(p_dst) - dst_off, left);
+        if ((src_addr | dst_addr | len) % DAT_LEN_MUL) {
+            ret_val = -EOPNOTSUPP;
+            break;
+        }
+
+        if (len) {
+            p_desc = &p_core->p_dma_ring[(p_core->dma_tail + num_desc) % DMA_RING_ENTRIES];
+            p_desc->ctrl = cpu_to_le32(num_desc ? DMA_DESC_SESS_CONT : DMA_DESC_SESS_KEY);
+            p_desc->src = cpu_to_le32((u32)src_addr);
+            p_desc->dst = cpu_to_le32((u32)dst_addr);
+            p_desc->len = cpu_to_le32(len/DAT_LEN_MUL);
+            p_desc->sess = cpu_to_le32((u32)p_core->dma_sess_addr);
+            p_desc->status = 0;
+            num_desc++;
+            left -= len;
+        }
+
+        src_off += len;
+        if (src_off == sg_dma_len(p_src) && --src_cnt) {
+            p_src = sg_next(p_src);
+            src_off = 0;
+        }
+
+        dst_off += len;
+        if (dst_off == sg_dma_len(p_dst) && --dst_cnt) {
+            p_dst = sg_next(p_dst);
+            dst_off = 0;
+        }
+    }
+
+    if (!ret_val) {
+        for (i = 0; i < DMA_SESS_WORDS/2; i++) {
+            p_core->p_dma_sess[i] = cpu_to_le32(*((unsigned int *)p_inst->p_key + i));
+            p_core->p_dma_sess[DMA_SESS_WORDS/2 + i] = cpu_to_le32(*((unsigned int *)p_inst->p_iv + i));
+        }
+
+        p_desc->ctrl |= cpu_to_le32(1u << DMA_DESC_BIT_EVT);
+
+        /* The engine overwrites the state held by the lane */
+        if (p_lane->p_owner) {
+            state_save(p_lane, p_lane->p_owner);
+            lane_stats_add(p_lane, STAT_STATE_SAVES, 1);
+            p_lane->p_owner = NULL;
+        }
+
+        /* The ring is coherent and iowrite32() orders the descriptors before the doorbell */
+        p_core->dma_tail = (p_core->dma_tail + num_desc) % DMA_RING_ENTRIES;
+        reg_wr(p_lane, REG_DMA_TAIL, p_core->dma_tail);
+        ret_val = lane_wait(p_lane, 1 << REG_CONFIG_BIT_DIDLE, IRQ_BIT_DMA);
+
+        /* The buffers stay mapped until the engine is done with them */
+        if (readl_poll_timeout(p_lane->p_base_addr + REG_CONFIG, conf, conf & (1 << REG_CONFIG_BIT_DIDLE),
+                               DMA_POLL_US, DMA_TIMEOUT_US)) {
+            /* Abort the descriptor being processed, drop the remaining ones and flush the FIFOs of the lane */
+            dev_err(p_core->p_dev, "DMA engine timeout\n");
+            reg_wr(p_lane, REG_DMA_CTRL, 0);
+            if (readl_poll_timeout(p_lane->p_base_addr + REG_CONFIG, conf, conf & (1 << REG_CONFIG_BIT_DIDLE),
+                                   DMA_POLL_US, DMA_TIMEOUT_US)) {
+                dev_err(p_core->p_dev, "DMA engine does not stop, using the lane registers\n");
+                p_core->dma_hung = 1;
+            } else {
+                p_core->dma_tail = 0;
+                reg_wr(p_lane, REG_DMA_HEAD, 0);
+                reg_wr(p_lane, REG_DMA_TAIL, 0);
+                reg_wr(p_lane, REG_DMA_CTRL, (1 << REG_DMA_CTRL_BIT_EN) | (DMA_RING_LOG2 << REG_DMA_CTRL_LOG2_SHIFT));
+            }
+
+            lane_abort(p_lane);
+            ret_val = -ETIMEDOUT;
+        } else if (reg_get(p_lane, REG_DMA_STAT, REG_DMA_STAT_BIT_ERR)) {
+            /* Drop the remaining descriptors and restart the engine */
+            dev_err(p_core->p_dev, "DMA engine bus error\n");
+            reg_wr(p_lane, REG_DMA_CTRL, 0);
+            reg_wr(p_lane, REG_DMA_HEAD, p_core->dma_tail);
+            reg_wr(p_lane, REG_DMA_STAT, 1 << REG_DMA_STAT_BIT_ERR);
+            reg_wr(p_lane, REG_DMA_CTRL, (1 << REG_DMA_CTRL_BIT_EN) | (DMA_RING_LOG2 << REG_DMA_CTRL_LOG2_SHIFT));
+            ret_val = -EIO;
+        }
+
+        lane_stats_add(p_lane, STAT_CTX_SWAPS, 1);
+        lane_stats_add(p_lane, STAT_DMA_DESCS, num_desc);
+        if (!ret_val) {
+            lane_stats_add(p_lane, STAT_HW_WORDS, p_req->cryptlen/DAT_LEN_MUL);
+            lane_stats_add(p_lane, STAT_BYTES, p_req->cryptlen);
+        }
+    }
+
+    lane_unlock(p_lane);
+    atomic_dec(&p_lane->queued);
+    if (ret_val != -EOPNOTSUPP)
+        stats_request(&p_core->stats, &p_inst->stats, ktime_to_ns(ktime_sub(ktime_get(), begin)));
+
+    if (dst_mapped)
+        dma_unmap_sg(p_core->p_dev, p_req->dst, dst_nents, DMA_FROM_DEVICE);
+
+unmap:
+    dma_unmap_sg(p_core->p_dev, p_req->src, src_nents, src_dir);
+    return ret_val;
+}
+
+/*******************************************************************************
+ * Software Trivium engine
+ ******************************************************************************/
+
+/*
+ * trivium_sw_ext - Extract 32 consecutive bits of a register
+ *
+ * @p_w: Register words
+ * @off: Bit offset of the first bit
+ *
+ * Return the bits, bit k being the tap value of step k
+ */
+static inline u32 trivium_sw_ext(const u32 *p_w, unsigned int off) {
+    return (u32)((((u64)p_w[off/32 + 1] << 32) | p_w[off/32]) >> (off%32));
+}
+
+/* Values of tap s_p of a register during the next 32 steps, p being relative to the register */
+#define SW_A(p_sw, p)   trivium_sw_ext((p_sw)->a, 96 - (p))
+#define SW_B(p_sw, p)   trivium_sw_ext((p_sw)->b, 96 - (p))
+#define SW_C(p_sw, p)   trivium_sw_ext((p_sw)->c, 128 - (p))
+
+/*
+ * trivium_sw_step - Advance the software engine by 32 rounds
+ *
+ * @p_sw: Software engine state
+ *
+ * Return 32 key stream bits, bit 0 being the first one
+ *
+ * Additional information: All taps of a register are at least 66 positions
+ * away from its input, so the 32 values a tap takes during the next rounds
+ * are still in the register and all rounds are computed at once.
+ */
+static inline u32 trivium_sw_step(struct trivium_sw *p_sw) {
+    u32 t1, t2, t3, z;
+
+    t1 = SW_A(p_sw, 66) ^ SW_A(p_sw, 93);
+    t2 = SW_B(p_sw, 69) ^ SW_B(p_sw, 84);
+    t3 = SW_C(p_sw, 66) ^ SW_C(p_sw, 111);
+    z = t1 ^ t2 ^ t3;
+
+    t1 ^= (SW_A(p_sw, 91) & SW_A(p_sw, 92)) ^ SW_B(p_sw, 78);
+    t2 ^= (SW_B(p_sw, 82) & SW_B(p_sw, 83)) ^ SW_C(p_sw, 87);
+    t3 ^= (SW_C(p_sw, 109) & SW_C(p_sw, 110)) ^ SW_A(p_sw, 69);
+
+    /* The new bits enter at the top, the oldest word drops out */
+    p_sw->a[0] = p_sw->a[1];
+    p_sw->a[1] = p_sw->a[2];
+    p_sw->a[2] = t3;
+    p_sw->b[0] = p_sw->b[1];
+    p_sw->b[1] = p_sw->b[2];
+    p_sw->b[2] = t1;
+    p_sw->c[0] = p_sw->c[1];
+    p_sw->c[1] = p_sw->c[2];
+    p_sw->c[2] = p_sw->c[3];
+    p_sw->c[3] = t2;
+
+    return z;
+}
+
+/*
+ * trivium_sw_bit - Locate a state bit in the software engine
+ *
+ * @p_sw: Software engine state
+ * @idx: Index of the state bit, 0 for s1 up to 287 for s288
+ * @p_pos: Returns the bit position within the word
+ *
+ * Return pointer to the word holding the bit
+ */
+static u32 *trivium_sw_bit(struct trivium_sw *p_sw, unsigned int idx, unsigned int *p_pos) {
+    unsigned int pos;
+    u32 *p_w;
+
+    if (idx < 93) {
+        p_w = p_sw->a;
+        pos = 95 - idx;
+    } else if (idx < 177) {
+        p_w = p_sw->b;
+        pos = 95 - (idx - 93);
+    } else {
+        p_w = p_sw->c;
+        pos = 127 - (idx - 177);
+    }
+
+    *p_pos = pos%32;
+    return &p_w[pos/32];
+}
+
+/*
+ * trivium_sw_load - Load the software engine from the cipher state registers
+ *
+ * @p_sw: Software engine state
+ * @p_state: Contents of the first STATE_CIPHER_REGS state registers
+ */
+static void trivium_sw_load(struct trivium_sw *p_sw, const unsigned int *p_state) {
+    unsigned int i, pos;
+    u32 *p_w;
+
+    memset(p_sw, 0, sizeof(struct trivium_sw));
+    for (i = 0; i < 32*STATE_CIPHER_REGS; i++) {
+        if ((p_state[i/32] >> (i%32)) & 1) {
+            p_w = trivium_sw_bit(p_sw, i, &pos);
+            *p_w |= 1U << pos;
+        }
+    }
+}
+
+/*
+ * trivium_sw_store - Convert the software engine state to the state register format
+ *
+ * @p_sw: Software engine state
+ * @p_state: Returns the contents of the first STATE_CIPHER_REGS state registers
+ */
+static void trivium_sw_store(struct trivium_sw *p_sw, unsigned int *p_state) {
+    unsigned int i, pos;
+    u32 *p_w;
+
+    memset(p_state, 0, STATE_CIPHER_REGS*sizeof(unsigned int));
+    for (i = 0; i < 32*STATE_CIPHER_REGS; i++) {
+        p_w = trivium_sw_bit(p_sw, i, &pos);
+        if ((*p_w >> pos) & 1)
+            p_state[i/32] |= 1U << (i%32);
+    }
+}
+
+/*
+ * trivium_sw_init - Initialize the software engine with key and IV
+ *
+ * @p_sw: Software engine state
+ * @p_key: Key, padded to a multiple of 32 bit
+ * @p_iv: IV, padded to a multiple of 32 bit
+ *
+ * Additional information: Key and IV are interpreted as 32-bit words, just
+ * like when they are written to the key and IV registers of the core.
+ */
+static void trivium_sw_init(struct trivium_sw *p_sw, const unsigned char *p_key, const unsigned char *p_iv) {
+    unsigned int state[STATE_CIPHER_REGS] = {0};
+    unsigned int i;
+
+    /* Key in s1 - s80, IV in s94 - s173 and ones in s286 - s288 */
+    for (i = 0; i < 80; i++) {
+        if ((*((const unsigned int *)p_key + i/32) >> (i%32)) & 1)
+            state[i/32] |= 1U << (i%32);
+
+        if ((*((const unsigned int *)p_iv + i/32) >> (i%32)) & 1)
+            state[(93 + i)/32] |= 1U << ((93 + i)%32);
+    }
+
+    state[8] |= 0xe0000000;
+    trivium_sw_load(p_sw, state);
+    memzero_explicit(state, sizeof(state));
+
+    for (i = 0; i < SW_WARMUP_STEPS; i++)
+        trivium_sw_step(p_sw);
+}
+
+/*
+ * trivium_sw_crypt - Encrypt words with the software engine
+ *
+ * @p_sw: Software engine state
+ * @p_pt: Plaintext words
+ * @p_ct: Ciphertext words, may be identical to p_pt for in-place encryption
+ * @num_words: Number of words to encrypt
+ */
+static void trivium_sw_crypt(struct trivium_sw *p_sw, const unsigned int *p_pt, unsigned int *p_ct, unsigned int num_words) {
+    unsigned int i;
+
+    for (i = 0; i < num_words; i++)
+        p_ct[i] = p_pt[i] ^ trivium_sw_step(p_sw);
+}
+
+/*
+ * trivium_sw_selftest - Check the software engine against the reference output
+ *
+ * Return 0 if the engine is correct, -EINVAL otherwise
+ *
+ * Additional information: The vector is the first test of
+ * reference_implementation/trivium_ref_out.txt. The state is converted to the
+ * register format and back halfway, as done when a request moves between the
+ * core and the software engine. The measured times seed the latency averages.
+ */
+static int trivium_sw_selftest(void) {
+    static const unsigned char key[12] = {0xd0, 0xa5, 0xb8, 0xb5, 0xbb, 0x4a, 0xc3, 0x75, 0x62, 0xea};
+    static const unsigned char iv[12] = {0x9f, 0x71, 0x9b, 0x04, 0xbd, 0x20, 0xca, 0x4a, 0xe6, 0x00};
+    static const unsigned int pt[4] = {0xc3ea3af3, 0x222524ea, 0x03ea1ef0, 0x4d517441};
+    static const unsigned int ct[4] = {0xce17e3ec, 0x8a6d178c, 0xc21be49f, 0xd649e4fd};
+    unsigned int state[STATE_CIPHER_REGS], buf[4];
+    unsigned int *p_buf;
+    struct trivium_sw sw;
+    ktime_t start;
+
+    start = ktime_get();
+    trivium_sw_init(&sw, key, iv);
+    ewma_lat_add(&drv_info.sw_init_ns, ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+    trivium_sw_crypt(&sw, pt, buf, 2);
+    trivium_sw_store(&sw, state);
+    trivium_sw_load(&sw, state);
+    trivium_sw_crypt(&sw, pt + 2, buf + 2, 2);
+    if (memcmp(buf, ct, sizeof(ct)))
+        return -EINVAL;
+
+    /* Throughput for 1 KiB */
+    p_buf = (unsigned int *)kzalloc(1024, GFP_KERNEL);
+    if (p_buf) {
+        start = ktime_get();
+        trivium_sw_crypt(&sw, p_buf, p_buf, 1024/DAT_LEN_MUL);
+        ewma_lat_add(&drv_info.sw_kib_ns, ktime_to_ns(ktime_sub(ktime_get(), start)));
+        kfree(p_buf);
+    }
+
+    return 0;
+}
+
+/*
+ * dispatch_sw - Decide whether to encrypt a request in software
+ *
+ * @p_inst: Trivium instance
+ * @num_words: Number of words to encrypt
+ *
+ * Return true if the request should be encrypted by sw_encrypt(), false if
+ * it should be encrypted by the core
+ *
+ * Additional information: A state held by the core stays there. Otherwise, in
+ * the automatic mode, small requests and requests for a lane with at least
+ * sw_queue_depth callers go to software. Other requests go to software if the
+ * averages of the measured latencies predict it to be faster, including the
+ * warm-up or restore of the state in the core and the software engine.
+ */
+static bool dispatch_sw(struct axi_trivium_inst *p_inst, unsigned int num_words) {
+    struct lane_info *p_lane = p_inst->p_lane;
+    u64 bytes = (u64)num_words*DAT_LEN_MUL;
+    u64 hw_ns, sw_ns;
+
+    if (!drv_info.sw_ok || dispatch_mode == DISPATCH_HW || READ_ONCE(p_lane->p_owner) == p_inst)
+        return false;
+
+    if (dispatch_mode == DISPATCH_SW || bytes <= sw_max_bytes)
+        return true;
+
+    if (sw_queue_depth && atomic_read(&p_lane->queued) >= sw_queue_depth)
+        return true;
+
+    /* Without measurements of the core there is nothing to compare */
+    if (!ewma_lat_read(&p_lane->p_core->hw_claim_ns) || !ewma_lat_read(&p_lane->p_core->hw_kib_ns))
+        return false;
+
+    hw_ns = ewma_lat_read(&p_lane->p_core->hw_claim_ns) + div_u64(ewma_lat_read(&p_lane->p_core->hw_kib_ns)*bytes, 1024);
+    sw_ns = div_u64(ewma_lat_read(&drv_info.sw_kib_ns)*bytes, 1024);
+    if (!p_inst->sw_valid && !p_inst->state_valid)
+        sw_ns += ewma_lat_read(&drv_info.sw_init_ns);
+
+    return sw_ns < hw_ns;
+}
+
+/*
+ * sw_resume - Make the software engine hold the key stream of an instance
+ *
+ * @p_inst: Trivium instance not held by the core
+ *
+ * Additional information: A state saved from the core is taken over, without
+ * a saved state the engine starts with key and IV.
+ */
+static void sw_resume(struct axi_trivium_inst *p_inst) {
+    ktime_t start;
+
+    if (p_inst->sw_valid)
+        return;
+
+    if (p_inst->state_valid)
+        trivium_sw_load(&p_inst->sw, p_inst->state);
+    else {
+        start = ktime_get();
+        trivium_sw_init(&p_inst->sw, p_inst->p_key, p_inst->p_iv);
+        p_inst->ks_len = 0;
+        p_inst->state[STATE_KS_SPARE_VLD] = 0;
+        ewma_lat_add(&drv_info.sw_init_ns, ktime_to_ns(ktime_sub(ktime_get(), start)));
+    }
+
+    p_inst->state_valid = 0;
+    p_inst->sw_valid = 1;
+}
+
+/*
+ * sw_encrypt - Encrypt words in software, continuing the key stream of an instance
+ *
+ * @p_inst: Trivium instance not held by the core
+ * @p_pt: Plaintext words
+ * @p_ct: Ciphertext words, may be identical to p_pt for in-place encryption
+ * @num_words: Number of words to encrypt
+ *
+ * Additional information: A state saved from the core is taken over, the key
+ * stream words prefetched by the core and its buffered word are used up
+ * before the engine generates new ones. The remainder of them is handed back
+ * to the core along with the engine state by lane_claim(). Output is
+ * bit-identical to the core.
+ */
+static void sw_encrypt(struct axi_trivium_inst *p_inst, const unsigned int *p_pt, unsigned int *p_ct, unsigned int num_words) {
+    unsigned int i, n;
+    ktime_t begin, start;
+
+    begin = ktime_get();
+    sw_resume(p_inst);
+    start = ktime_get();
+
+    /* Prefetched key stream first */
+    n = min(p_inst->ks_len, num_words);
+    for (i = 0; i < n; i++)
+        p_ct[i] = p_pt[i] ^ p_inst->ks[i];
+
+    if (n) {
+        p_inst->ks_len -= n;
+        memmove(p_inst->ks, p_inst->ks + n, p_inst->ks_len*sizeof(unsigned int));
+    }
+
+    if (i < num_words && p_inst->state[STATE_KS_SPARE_VLD]) {
+        p_ct[i] = p_pt[i] ^ p_inst->state[STATE_KS_SPARE];
+        p_inst->state[STATE_KS_SPARE_VLD] = 0;
+        i++;
+    }
+
+    trivium_sw_crypt(&p_inst->sw, p_pt + i, p_ct + i, num_words - i);
+    p_inst->ks_pos += num_words;
+    if (num_words)
+        ewma_lat_add(&drv_info.sw_kib_ns, div_u64(ktime_to_ns(ktime_sub(ktime_get(), start))*1024, num_words*DAT_LEN_MUL));
+
+    stats_add(&drv_info.sw_stats, STAT_SW_WORDS, num_words);
+    stats_add(&drv_info.sw_stats, STAT_BYTES, num_words*DAT_LEN_MUL);
+    stats_add(&p_inst->stats, STAT_SW_WORDS, num_words);
+    stats_add(&p_inst->stats, STAT_BYTES, num_words*DAT_LEN_MUL);
+    stats_request(&drv_info.sw_stats, &p_inst->stats, ktime_to_ns(ktime_sub(ktime_get(), begin)));
+}
+
+/*
+ * hw_encrypt - Encrypt words with the core, continuing the key stream of an instance
+ *
+ * @p_inst: Trivium instance
+ * @p_pt: Plaintext words
+ * @p_ct: Ciphertext words, may be identical to p_pt for in-place encryption
+ * @num_words: Number of words to encrypt
+ * @keep: Keep the state in the lane, otherwise the lane forgets the instance
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int hw_encrypt(struct axi_trivium_inst *p_inst, const unsigned int *p_pt, unsigned int *p_ct, unsigned int num_words, bool keep) {
+    struct lane_info *p_lane = p_inst->p_lane;
+    ktime_t begin, start, claimed, done;
+    bool owner, aborted = false;
+    int ret_val;
+
+    begin = ktime_get();
+    atomic_inc(&p_lane->queued);
+    lane_lock(p_lane, &p_inst->stats);
+    start = ktime_get();
+    owner = (p_lane->p_owner == p_inst);
+    ret_val = lane_claim(p_inst);
+    claimed = ktime_get();
+    if (!ret_val) {
+        ret_val = encrypt(p_lane, p_pt, p_ct, num_words);
+        aborted = (ret_val != 0);
+        if (aborted)
+            lane_abort(p_lane);
+    }
+
+    done = ktime_get();
+    if (!keep)
+        p_lane->p_owner = NULL;
+
+    /* Free the lane for other processes */
+    lane_unlock(p_lane);
+    atomic_dec(&p_lane->queued);
+
+    stats_request(&p_lane->p_core->stats, &p_inst->stats, ktime_to_ns(ktime_sub(ktime_get(), begin)));
+    if (aborted) {
+        /* The key stream position is lost, a repeated request starts over */
+        inst_rewind(p_inst);
+    } else if (!ret_val) {
+        p_inst->ks_pos += num_words;
+        if (!owner)
+            ewma_lat_add(&p_lane->p_core->hw_claim_ns, ktime_to_ns(ktime_sub(claimed, start)));
+
+        if (num_words)
+            ewma_lat_add(&p_lane->p_core->hw_kib_ns, div_u64(ktime_to_ns(ktime_sub(done, claimed))*1024, num_words*DAT_LEN_MUL));
+    }
+
+    return ret_val;
+}
+
+/*
+ * skip_sw - Decide whether the software engine fast-forwards a key stream
+ *
+ * @p_inst: Trivium instance
+ * @num_words: Number of key stream words to discard
+ *
+ * Return true if sw_skip() should be used, false if hw_skip() should be used
+ *
+ * Additional information: Unlike encryption, a fast-forward costs the core
+ * no bus access per word, so only short skips of a state not held by the
+ * core are done in software, apart from the software dispatch mode.
+ */
+static bool skip_sw(struct axi_trivium_inst *p_inst, u64 num_words) {
+    if (!drv_info.sw_ok || dispatch_mode == DISPATCH_HW || READ_ONCE(p_inst->p_lane->p_owner) == p_inst)
+        return false;
+
+    return dispatch_mode == DISPATCH_SW || num_words*DAT_LEN_MUL <= sw_max_bytes;
+}
+
+/*
+ * sw_skip - Discard key stream words of an instance in software
+ *
+ * @p_inst: Trivium instance not held by the core
+ * @num_words: Number of key stream words to discard
+ */
+static void sw_skip(struct axi_trivium_inst *p_inst, u64 num_words) {
+    u64 n;
+
+    sw_resume(p_inst);
+    stats_add(&drv_info.sw_stats, STAT_SKIPPED_WORDS, num_words);
+    stats_add(&p_inst->stats, STAT_SKIPPED_WORDS, num_words);
+    p_inst->ks_pos += num_words;
+
+    /* Prefetched key stream first */
+    n = min_t(u64, p_inst->ks_len, num_words);
+    if (n) {
+        p_inst->ks_len -= n;
+        memmove(p_inst->ks, p_inst->ks + n, p_inst->ks_len*sizeof(unsigned int));
+        num_words -= n;
+    }
+
+    if (num_words && p_inst->state[STATE_KS_SPARE_VLD]) {
+        p_inst->state[STATE_KS_SPARE_VLD] = 0;
+        num_words--;
+    }
+
+    for (; num_words; num_words--) {
+        trivium_sw_step(&p_inst->sw);
+        if (!(num_words & 0xffff))
+            cond_resched();
+    }
+}
+
+/*
+ * hw_skip - Discard key stream words of an instance with the core
+ *
+ * @p_inst: Trivium instance
+ * @num_words: Number of key stream words to discard
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int hw_skip(struct axi_trivium_inst *p_inst, u64 num_words) {
+    struct lane_info *p_lane = p_inst->p_lane;
+    int ret_val;
+
+    atomic_inc(&p_lane->queued);
+    lane_lock(p_lane, &p_inst->stats);
+    ret_val = lane_claim(p_inst);
+    if (!ret_val)
+        ret_val = lane_skip(p_lane, num_words);
+
+    lane_unlock(p_lane);
+    atomic_dec(&p_lane->queued);
+
+    if (!ret_val)
+        p_inst->ks_pos += num_words;
+
+    return ret_val;
+}
+
+/*
+ * inst_seek - Move the key stream of an instance to a position
+ *
+ * @p_inst: Trivium instance, its mutex must be held
+ * @pos: Key stream position in words
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: Moving forward discards the key stream words in
+ * between, which the core does at the rate of the cipher without transferring
+ * any data, see lane_skip(). Moving backward starts over with key and IV. If
+ * the fast-forward fails or is interrupted, the instance starts over as well,
+ * so that a repeated request reaches the position again.
+ */
+static int inst_seek(struct axi_trivium_inst *p_inst, u64 pos) {
+    int ret_val = 0;
+
+    if (pos < p_inst->ks_pos)
+        inst_rewind(p_inst);
+
+    if (pos == p_inst->ks_pos)
+        return 0;
+
+    if (skip_sw(p_inst, pos - p_inst->ks_pos))
+        sw_skip(p_inst, pos - p_inst->ks_pos);
+    else
+        ret_val = hw_skip(p_inst, pos - p_inst->ks_pos);
+
+    if (ret_val)
+        inst_rewind(p_inst);
+
+    return ret_val;
+}
+
+/*
+ * inst_rewind - Return an instance to the start of its key stream
+ *
+ * @p_inst: Trivium instance, its mutex must be held
+ *
+ * Additional information: The saved and software states are dropped and the
+ * lane forgets the instance, so the next request starts with key and IV.
+ */
+static void inst_rewind(struct axi_trivium_inst *p_inst) {
+    mutex_lock(&p_inst->p_lane->mtx);
+    if (p_inst->p_lane->p_owner == p_inst)
+        p_inst->p_lane->p_owner = NULL;
+    mutex_unlock(&p_inst->p_lane->mtx);
+
+    p_inst->state_valid = 0;
+    p_inst->sw_valid = 0;
+    p_inst->ks_len = 0;
+    p_inst->state[STATE_KS_SPARE_VLD] = 0;
+    p_inst->ks_pos = 0;
+}
+
+/*******************************************************************************
+ * Instance and buffer management
+ ******************************************************************************/
+
+/*
+ * inst_ctor - Constructor of the instance cache objects
+ *
+ * @p_obj: Object to construct
+ *
+ * Additional information: Objects are zeroized before being returned to the
+ * cache, so zeroing them once when the slab is populated suffices and
+ * allocations need not clear the saved state and key stream arrays again.
+ */
+static void inst_ctor(void *p_obj) {
+    memset(p_obj, 0, sizeof(struct axi_trivium_inst));
+}
+
+/*
+ * buf_reserve - Make sure a session or request buffer holds a given size
+ *
+ * @pp_buf: Buffer, NULL if none has been allocated yet
+ * @p_cap: Allocated size of the buffer
+ * @sz: Required size in bytes
+ * @gfp: Allocation flags, GFP_KERNEL or GFP_NOWAIT
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: The buffer grows geometrically, starting at a page,
+ * so a session only reallocates for requests larger than any before. Large
+ * buffers are backed by individual pages and do not need contiguous memory,
+ * unless the allocation must not sleep, in which case kvmalloc() only tries
+ * contiguous memory. The contents of the buffer are not preserved.
+ */
+static int buf_reserve(unsigned char **pp_buf, size_t *p_cap, size_t sz, gfp_t gfp) {
+    size_t cap;
+    unsigned char *p_new;
+
+    if (sz <= *p_cap)
+        return 0;
+
+    cap = *p_cap ? *p_cap : PAGE_SIZE;
+    while (cap < sz)
+        cap <<= 1;
+
+    p_new = (unsigned char *)kvmalloc(cap, gfp);
+    if (!p_new)
+        return -ENOMEM;
+
+    buf_release(pp_buf, p_cap);
+    *pp_buf = p_new;
+    *p_cap = cap;
+    return 0;
+}
+
+/*
+ * buf_release - Zeroize and free a session or request buffer
+ *
+ * @pp_buf: Buffer, may be NULL
+ * @p_cap: Allocated size of the buffer
+ */
+static void buf_release(unsigned char **pp_buf, size_t *p_cap) {
+    if (*pp_buf) {
+        memzero_explicit(*pp_buf, *p_cap);
+        kvfree(*pp_buf);
+    }
+
+    *pp_buf = NULL;
+    *p_cap = 0;
+}
+
+/*******************************************************************************
+ * Trivium specific functions
+ ******************************************************************************/
+
+/*
+ * lane_get - Assign a lane to an instance
+ *
+ * @p_inst: Trivium instance
+ *
+ * Return 0 on success, -ENODEV if no core is available
+ *
+ * Additional information: The instance is assigned the lane with the fewest
+ * users among all cores, such that concurrent instances run on separate lanes
+ * if possible.
+ */
+static int lane_get(struct axi_trivium_inst *p_inst) {
+    struct core_info *p_core;
+    unsigned int i;
+
+    p_inst->p_lane = NULL;
+    mutex_lock(&drv_info.mtx);
+    list_for_each_entry(p_core, &drv_info.cores, node)
+        for (i = 0; i < p_core->num_lanes; i++)
+            if (!p_inst->p_lane || p_core->p_lanes[i].num_users < p_inst->p_lane->num_users)
+                p_inst->p_lane = &p_core->p_lanes[i];
+
+    if (p_inst->p_lane)
+        p_inst->p_lane->num_users++;
+    mutex_unlock(&drv_info.mtx);
+
+    return p_inst->p_lane ? 0 : -ENODEV;
+}
+
+/*
+ * lane_put - Release the lane of an instance
+ *
+ * @p_inst: Trivium instance
+ */
+static void lane_put(struct axi_trivium_inst *p_inst) {
+    /* Make sure the lane no longer refers to this instance */
+    mutex_lock(&p_inst->p_lane->mtx);
+    if (p_inst->p_lane->p_owner == p_inst)
+        p_inst->p_lane->p_owner = NULL;
+    mutex_unlock(&p_inst->p_lane->mtx);
+
+    mutex_lock(&drv_info.mtx);
+    p_inst->p_lane->num_users--;
+    mutex_unlock(&drv_info.mtx);
+}
+
+/*
+ * lane_compatible - Check whether an instance may continue on another core
+ *
+ * @p_inst: Trivium instance
+ * @p_core: Candidate core
+ *
+ * Return true if the key stream of the instance continues correctly on the
+ * given core, false otherwise
+ *
+ * Additional information: The saved state can be restored on any core, but
+ * key stream words prefetched by the current core are only meaningful to a
+ * core with the same configuration, since the prefetch depth determines how
+ * far the saved state runs ahead of the data.
+ */
+static bool lane_compatible(struct axi_trivium_inst *p_inst, struct core_info *p_core) {
+    if (p_inst->p_lane->p_core == p_core)
+        return true;
+
+    if (!(p_inst->state_valid || p_inst->sw_valid) ||
+            (!p_inst->ks_len && !p_inst->state[STATE_KS_SPARE_VLD]))
+        return true;
+
+    return (p_inst->p_lane->p_core->info >> REG_INFO_CFG_SHIFT) == (p_core->info >> REG_INFO_CFG_SHIFT);
+}
+
+/*
+ * lane_select - Move an instance to a less loaded lane before a request
+ *
+ * @p_inst: Trivium instance, its mutex must be held
+ *
+ * Additional information: An instance whose state is still held by its lane
+ * stays there, as this avoids saving and restoring the state. So does an
+ * instance whose lane is idle. Otherwise the instance moves to the lane with
+ * the fewest queued requests (ties are broken by the number of users) among
+ * the compatible cores, see lane_compatible().
+ */
+static void lane_select(struct axi_trivium_inst *p_inst) {
+    struct lane_info *p_lane = p_inst->p_lane;
+    struct lane_info *p_cand;
+    struct core_info *p_core;
+    unsigned int i;
+
+    if (READ_ONCE(p_lane->p_owner) == p_inst || !atomic_read(&p_lane->queued))
+        return;
+
+    mutex_lock(&drv_info.mtx);
+    list_for_each_entry(p_core, &drv_info.cores, node) {
+        if (!lane_compatible(p_inst, p_core))
+            continue;
+
+        for (i = 0; i < p_core->num_lanes; i++) {
+            p_cand = &p_core->p_lanes[i];
+            if (atomic_read(&p_cand->queued) < atomic_read(&p_lane->queued) ||
+                    (atomic_read(&p_cand->queued) == atomic_read(&p_lane->queued) &&
+                    p_cand->num_users < p_lane->num_users))
+                p_lane = p_cand;
+        }
+    }
+
+    if (p_lane != p_inst->p_lane) {
+        p_inst->p_lane->num_users--;
+        p_lane->num_users++;
+    }
+    mutex_unlock(&drv_info.mtx);
+
+    /* The old lane must not keep a reference to this instance */
+    if (p_lane != p_inst->p_lane) {
+        mutex_lock(&p_inst->p_lane->mtx);
+        if (p_inst->p_lane->p_owner == p_inst)
+            p_inst->p_lane->p_owner = NULL;
+        mutex_unlock(&p_inst->p_lane->mtx);
+        p_inst->p_lane = p_lane;
+    }
+}
+
+/*
+ * lane_least_loaded - Find the lane with the fewest queued requests
+ *
+ * @p_core: Core to search, NULL to search all cores (drv_info.mtx must be held)
+ *
+ * Return the lane found, NULL if there is none
+ */
+static struct lane_info *lane_least_loaded(struct core_info *p_core) {
+    struct lane_info *p_lane = NULL;
+    unsigned int i;
+
+    if (!p_core) {
+        list_for_each_entry(p_core, &drv_info.cores, node) {
+            struct lane_info *p_cand = lane_least_loaded(p_core);
+
+            if (!p_lane || atomic_read(&p_cand->queued) < atomic_read(&p_lane->queued))
+                p_lane = p_cand;
+        }
+
+        return p_lane;
+    }
+
+    for (i = 0; i < p_core->num_lanes; i++)
+        if (!p_lane || atomic_read(&p_core->p_lanes[i].queued) < atomic_read(&p_lane->queued))
+            p_lane = &p_core->p_lanes[i];
+
+    return p_lane;
+}
+
+/*
+ * lane_claim - Make the lane of an instance hold the state of that instance
+ *
+ * @p_inst: Trivium instance
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired. The state of the previous owner is saved,
+ * the instance either resumes its own saved state or starts with key and IV.
+ */
+static int lane_claim(struct axi_trivium_inst *p_inst) {
+    struct lane_info *p_lane = p_inst->p_lane;
+    int ret_val;
+
+    if (p_lane->p_owner == p_inst)
+        return 0;
+
+    /* Hand a state advanced by the software engine back to the core */
+    if (p_inst->sw_valid) {
+        trivium_sw_store(&p_inst->sw, p_inst->state);
+        p_inst->sw_valid = 0;
+        p_inst->state_valid = 1;
+    }
+
+    /* Save the state of the previous owner before taking over the lane */
+    if (p_lane->p_owner) {
+        state_save(p_lane, p_lane->p_owner);
+        lane_stats_add(p_lane, STAT_STATE_SAVES, 1);
+    }
+
+    if (p_inst->state_valid) {
+        trace_axi_trivium_state_restore_start(p_lane);
+        ret_val = state_restore(p_lane, p_inst);
+        trace_axi_trivium_state_restore_end(p_lane, ret_val);
+        lane_stats_add(p_lane, STAT_STATE_RESTORES, 1);
+    } else {
+        trace_axi_trivium_context_swap_start(p_lane);
+        ret_val = context_swap(p_lane, p_inst);
+        trace_axi_trivium_context_swap_end(p_lane, ret_val);
+        lane_stats_add(p_lane, STAT_CTX_SWAPS, 1);
+    }
+
+    if (!ret_val)
+        p_lane->p_owner = p_inst;
+
+    return ret_val;
+}
+
+/*
+ * context_swap - Swap the current instance in a lane with a specified one
+ *
+ * @p_lane: Lane of the IP core
+ * @p_new_inst: Data for new Trivium instance
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired.
+ */
+static int context_swap(struct lane_info *p_lane, struct axi_trivium_inst *p_new_inst) {
+    /* Make sure everything required is present */
+    if (!p_lane || !p_new_inst)
+        return -EINVAL;
+    else {
+        if (!p_new_inst->p_key || !p_new_inst->p_iv)
+            return -EINVAL;
+    }
+
+    /* Stop the core */
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_STOP);
+
+    /* Check if core is ready */
+    if (1 == reg_get(p_lane, REG_CONFIG, REG_CONFIG_BIT_BUSY))
+        return -EIO;
+
+    /* Set key and IV */
+    reg_wr(p_lane, REG_KEY_LO, *((unsigned int *)(p_new_inst->p_key)));
+    reg_wr(p_lane, REG_KEY_MID, *((unsigned int *)(p_new_inst->p_key) + 1));
+    reg_wr(p_lane, REG_KEY_HI, *((unsigned int *)(p_new_inst->p_key) + 2));
+
+    reg_wr(p_lane, REG_IV_LO, *((unsigned int *)(p_new_inst->p_iv)));
+    reg_wr(p_lane, REG_IV_MID, *((unsigned int *)(p_new_inst->p_iv) + 1));
+    reg_wr(p_lane, REG_IV_HI, *((unsigned int *)(p_new_inst->p_iv) + 2));
+
+    /* Initialize and wait for completion, a previous state save may have stopped the prefetching */
+    reg_unset(p_lane, REG_CONFIG, REG_CONFIG_BIT_HOLD);
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_INIT);
+
+    return lane_wait(p_lane, 1 << REG_CONFIG_BIT_IDONE, IRQ_BIT_IDONE);
+}
+
+/*
+ * state_save - Save the cipher state of the instance currently held by a lane
+ *
+ * @p_lane: Lane of the IP core
+ * @p_inst: Trivium instance owning the lane
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired. As encrypt() collects all results before
+ * returning, the lane is idle at this point. Since the lane prefetches key
+ * stream, the contents of its key stream FIFO are part of the state.
+ */
+static void state_save(struct lane_info *p_lane, struct axi_trivium_inst *p_inst) {
+    unsigned int i;
+
+    /* Stop prefetching and wait for the current key stream word */
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_HOLD);
+    while (1 == reg_get(p_lane, REG_KS_STAT, REG_KS_STAT_BIT_GEN));
+
+    for (i = 0; i < STATE_REGS; i++)
+        p_inst->state[i] = reg_rd(p_lane, REG_STATE + i);
+
+    p_inst->ks_len = reg_rd(p_lane, REG_KS_STAT) & REG_KS_STAT_LVL_MASK;
+    if (p_inst->ks_len > KS_WORDS_MAX)
+        p_inst->ks_len = KS_WORDS_MAX;
+
+    for (i = 0; i < p_inst->ks_len; i++)
+        p_inst->ks[i] = reg_rd(p_lane, REG_KS_FIFO);
+
+    p_inst->state_valid = 1;
+}
+
+/*
+ * state_restore - Load the saved cipher state of an instance into a lane
+ *
+ * @p_lane: Lane of the IP core
+ * @p_inst: Trivium instance with a saved cipher state
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired. Restoring the state takes a few register
+ * accesses instead of the 1152 warm-up rounds of context_swap().
+ */
+static int state_restore(struct lane_info *p_lane, struct axi_trivium_inst *p_inst) {
+    unsigned int i;
+
+    /* Make sure everything required is present */
+    if (!p_lane || !p_inst || !p_inst->state_valid)
+        return -EINVAL;
+
+    /* Stop the core */
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_STOP);
+
+    /* Check if core is ready */
+    if (1 == reg_get(p_lane, REG_CONFIG, REG_CONFIG_BIT_BUSY))
+        return -EIO;
+
+    /* Write the saved state and load it into the cipher, holding back the prefetching */
+    for (i = 0; i < STATE_REGS; i++)
+        reg_wr(p_lane, REG_STATE + i, p_inst->state[i]);
+
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_HOLD);
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_RESTORE);
+
+    /* Put back the prefetched key stream and resume prefetching */
+    for (i = 0; i < p_inst->ks_len; i++)
+        reg_wr(p_lane, REG_KS_FIFO, p_inst->ks[i]);
+
+    reg_unset(p_lane, REG_CONFIG, REG_CONFIG_BIT_HOLD);
+
+    return 0;
+}
+
+/*
+ * encrypt - Encrypt a plaintext buffer
+ *
+ * @p_lane: Lane of the IP core
+ * @p_pt: Plaintext words
+ * @p_ct: Ciphertext words, may be identical to p_pt for in-place encryption
+ * @num_words: Number of words to encrypt
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired and the context has been switched. Results
+ * never overtake the plaintext, so each word is read before it is overwritten.
+ * One read of the configuration register yields both FIFO levels, the results
+ * and plaintext words are then transferred with a single bus access per word
+ * through the output data and data queue registers, or in bursts through the
+ * FIFO windows if the core has them.
+ */
+static int encrypt(struct lane_info *p_lane, const unsigned int *p_pt, unsigned int *p_ct, unsigned int num_words) {
+    unsigned int in_idx, out_idx, conf, in_free, out_lvl;
+    int ret_val = 0;
+
+    /* Make sure everything required is present */
+    if (!p_lane || !p_pt || !p_ct)
+        return -EINVAL;
+
+    trace_axi_trivium_encrypt_start(p_lane, num_words);
+
+    /* Keep the input FIFO filled while collecting the results */
+    in_idx = 0;
+    out_idx = 0;
+    while (out_idx < num_words) {
+        conf = reg_rd(p_lane, REG_CONFIG);
+        in_free = (conf >> REG_CONFIG_IFREE_SHIFT) & REG_CONFIG_LVL_MASK;
+        out_lvl = (conf >> REG_CONFIG_OLVL_SHIFT) & REG_CONFIG_LVL_MASK;
+
+        /* Wait for results if there are none and no further words can be queued */
+        if (out_lvl == 0 && (in_free == 0 || in_idx == num_words)) {
+            ret_val = lane_wait(p_lane, REG_CONFIG_LVL_MASK << REG_CONFIG_OLVL_SHIFT, IRQ_BIT_OAVAIL);
+            if (ret_val)
+                break;
+
+            continue;
+        }
+
+        /* Read available results into output buffer */
+        out_lvl = min(out_lvl, num_words - out_idx);
+        fifo_pop(p_lane, p_ct + out_idx, out_lvl);
+        out_idx += out_lvl;
+
+        /* Queue plaintext words */
+        in_free = min(in_free, num_words - in_idx);
+        fifo_push(p_lane, p_pt + in_idx, in_free);
+        in_idx += in_free;
+    }
+
+    lane_stats_add(p_lane, STAT_HW_WORDS, out_idx);
+    lane_stats_add(p_lane, STAT_BYTES, out_idx*DAT_LEN_MUL);
+    trace_axi_trivium_encrypt_end(p_lane, ret_val);
+
+    return ret_val;
+}
+
+/*
+ * lane_abort - Reset a lane after a failed or interrupted transfer
+ *
+ * @p_lane: Lane of the IP core
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired. Plaintext and results of the transfer may
+ * still be in the FIFOs, so the lane is stopped, which empties them, and
+ * forgets its owner instead of saving a state with words in flight. The
+ * owner has to start over, see inst_rewind().
+ */
+static void lane_abort(struct lane_info *p_lane) {
+    reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_STOP);
+    p_lane->p_owner = NULL;
+}
+
+/*
+ * lane_skip - Discard key stream words
+ *
+ * @p_lane: Lane of the IP core
+ * @num_words: Number of key stream words to discard
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: This function should only be called if the mutex
+ * for the lane has been acquired and the context has been switched. The lane
+ * discards up to 2^32 - 1 words per command at the rate of the cipher, the
+ * prefetched key stream words being used up first.
+ */
+static int lane_skip(struct lane_info *p_lane, u64 num_words) {
+    unsigned int n;
+    int ret_val = 0;
+
+    trace_axi_trivium_skip_start(p_lane, num_words);
+
+    while (num_words && !ret_val) {
+        n = (unsigned int)min_t(u64, num_words, U32_MAX);
+        reg_wr(p_lane, REG_SKIP, n);
+        reg_set(p_lane, REG_CONFIG, REG_CONFIG_BIT_SKIP);
+
+        ret_val = lane_wait(p_lane, 1 << REG_CONFIG_BIT_SDONE, IRQ_BIT_SDONE);
+        if (!ret_val) {
+            lane_stats_add(p_lane, STAT_SKIPPED_WORDS, n);
+            num_words -= n;
+        }
+    }
+
+    trace_axi_trivium_skip_end(p_lane, ret_val);
+
+    return ret_val;
+}
+
+/*
+ * lane_wait - Wait until a condition of a lane is met
+ *
+ * @p_lane: Lane of the IP core
+ * @conf_mask: Bits of the configuration register, the condition is met as soon
+ *             as any of them is set
+ * @irq_bit: Interrupt signalling the condition
+ *
+ * Return 0 on success, error code otherwise
+ *
+ * Additional information: Depending on the wait_mode parameter, the function
+ * busy-waits, sleeps until the interrupt occurs or spins for spin_us
+ * microseconds before going to sleep. The interrupt is enabled only while
+ * sleeping, the handler masks it again.
+ */
+static int lane_wait(struct lane_info *p_lane, unsigned int conf_mask, unsigned char irq_bit) {
+    unsigned int stat = (irq_bit == IRQ_BIT_OAVAIL) ? STAT_OVAL_POLLS : STAT_IDONE_POLLS;
+    unsigned long flags, polls = 1;
+    unsigned int i;
+    int ret_val = 0;
+
+    /* Busy-wait if requested or if there is no interrupt */
+    if (wait_mode == WAIT_MODE_POLL || p_lane->p_core->irq < 0) {
+        while (0 == (reg_rd(p_lane, REG_CONFIG) & conf_mask)) {
+            cpu_relax();
+            polls++;
+        }
+
+        lane_stats_add(p_lane, stat, polls);
+        return 0;
+    }
+
+    /* Short operations complete before sleeping pays off */
+    if (wait_mode == WAIT_MODE_HYBRID) {
+        for (i = 0; i < spin_us; i++, polls++) {
+            if (reg_rd(p_lane, REG_CONFIG) & conf_mask) {
+                lane_stats_add(p_lane, stat, polls);
+                return 0;
+            }
+
+            udelay(1);
+        }
+    }
+
+    lane_stats_add(p_lane, stat, polls - 1);
+    lane_stats_add(p_lane, STAT_IRQ_WAITS, 1);
+
+    while (!ret_val) {
+        /* Clear a stale event and enable the interrupt */
+        reinit_completion(&p_lane->done);
+        spin_lock_irqsave(&p_lane->irq_lock, flags);
+        reg_wr(p_lane, REG_ISR, 1 << irq_bit);
+        reg_set(p_lane, REG_IER, irq_bit);
+        spin_unlock_irqrestore(&p_lane->irq_lock, flags);
+
+        /* The condition may have been met before the interrupt was enabled */
+        if (reg_rd(p_lane, REG_CONFIG) & conf_mask)
+            break;
+
+        ret_val = wait_for_completion_interruptible(&p_lane->done);
+        if (!ret_val && (reg_rd(p_lane, REG_CONFIG) & conf_mask))
+            break;
+    }
+
+    /* Mask the interrupt again */
+    spin_lock_irqsave(&p_lane->irq_lock, flags);
+    reg_unset(p_lane, REG_IER, irq_bit);
+    spin_unlock_irqrestore(&p_lane->irq_lock, flags);
+
+    return ret_val;
+}
+
+/*
+ * lane_lock - Acquire the mutex of a lane for a request
+ *
+ * @p_lane: Lane of the IP core
+ * @p_stats: Statistics of the session issuing the request, may be NULL
+ *
+ * Additional information: The waiting time is added to the statistics of the
+ * core and the session. Until lane_unlock(), the counters updated while
+ * processing the request are attributed to the session as well.
+ */
+static void lane_lock(struct lane_info *p_lane, struct trivium_stats *p_stats) {
+    ktime_t start = ktime_get();
+    u64 wait_ns;
+
+    trace_axi_trivium_lock_acquire(p_lane);
+    mutex_lock(&p_lane->mtx);
+    p_lane->locked = ktime_get();
+    p_lane->p_stats = p_stats;
+
+    wait_ns = ktime_to_ns(ktime_sub(p_lane->locked, start));
+    lane_stats_add(p_lane, STAT_LOCK_WAIT_NS, wait_ns);
+    stats_hist(&p_lane->p_core->stats, HIST_LOCK, wait_ns);
+    stats_hist(p_stats, HIST_LOCK, wait_ns);
+    trace_axi_trivium_lock_acquired(p_lane, wait_ns);
+}
+
+/*
+ * lane_unlock - Release the mutex of a lane acquired by lane_lock()
+ *
+ * @p_lane: Lane of the IP core
+ */
+static void lane_unlock(struct lane_info *p_lane) {
+    trace_axi_trivium_lock_release(p_lane, ktime_to_ns(ktime_sub(ktime_get(), p_lane->locked)));
+    p_lane->p_stats = NULL;
+    mutex_unlock(&p_lane->mtx);
+}
+
+/*
+ * axi_trivium_irq - Interrupt handler of the IP core
+ *
+ * @irq: Interrupt number
+ * @p_data: Core information
+ *
+ * Return IRQ_HANDLED if any lane raised the interrupt, IRQ_NONE otherwise
+ *
+ * Additional information: Pending events are masked and cleared, the task
+ * waiting on the respective lane enables them again if required.
+ */
+static irqreturn_t axi_trivium_irq(int irq, void *p_data) {
+    struct core_info *p_core = (struct core_info *)p_data;
+    unsigned int i, pending;
+    irqreturn_t ret_val = IRQ_NONE;
+
+    for (i = 0; i < p_core->num_lanes; i++) {
+        spin_lock(&p_core->p_lanes[i].irq_lock);
+        pending = reg_rd(&p_core->p_lanes[i], REG_ISR) & reg_rd(&p_core->p_lanes[i], REG_IER);
+        if (pending) {
+            reg_wr(&p_core->p_lanes[i], REG_IER, reg_rd(&p_core->p_lanes[i], REG_IER) & ~pending);
+            reg_wr(&p_core->p_lanes[i], REG_ISR, pending);
+            complete(&p_core->p_lanes[i].done);
+            ret_val = IRQ_HANDLED;
+        }
+        spin_unlock(&p_core->p_lanes[i].irq_lock);
+    }
+
+    return ret_val;
+}
+
+/*******************************************************************************
+ * Statistics
+ ******************************************************************************/
+
+/*
+ * stats_hist - Add a latency to a histogram
+ *
+ * @p_stats: Statistics, may be NULL
+ * @hist: Histogram, HIST_REQ or HIST_LOCK
+ * @ns: Latency in ns
+ */
+static void stats_hist(struct trivium_stats *p_stats, unsigned int hist, u64 ns) {
+    u64 us = div_u64(ns, 1000);
+    unsigned int bucket = us ? min(ilog2(us) + 1, HIST_BUCKETS - 1) : 0;
+
+    if (p_stats)
+        atomic64_inc(&p_stats->hist[hist][bucket]);
+}
+
+/*
+ * stats_request - Count a completed request
+ *
+ * @p_dev: Statistics of the core or the software engine, may be NULL
+ * @p_sess: Statistics of the session, may be NULL
+ * @ns: Latency of the request in ns
+ */
+static void stats_request(struct trivium_stats *p_dev, struct trivium_stats *p_sess, u64 ns) {
+    stats_add(p_dev, STAT_REQUESTS, 1);
+    stats_add(p_sess, STAT_REQUESTS, 1);
+    stats_hist(p_dev, HIST_REQ, ns);
+    stats_hist(p_sess, HIST_REQ, ns);
+}
+
+/*
+ * stats_show - Print statistics to a debugfs file
+ *
+ * @p_seq: Sequence file
+ * @p_stats: Statistics
+ *
+ * Additional information: Counters are printed as "name value", histogram
+ * buckets as "name lower_us upper_us count", an upper bound of 0 denoting
+ * the open-ended last bucket.
+ */
+static void stats_show(struct seq_file *p_seq, struct trivium_stats *p_stats) {
+    unsigned int i, j;
+
+    for (i = 0; i < STAT_NUM; i++)
+        seq_printf(p_seq, "%s %lld\n", stat_names[i], (long long)atomic64_read(&p_stats->cnt[i]));
+
+    for (i = 0; i < HIST_NUM; i++) {
+        for (j = 0; j < HIST_BUCKETS; j++)
+            seq_printf(p_seq, "%s %u %u %lld\n", hist_names[i], j ? 1U << (j - 1) : 0,
+                       j < HIST_BUCKETS - 1 ? 1U << j : 0, (long long)atomic64_read(&p_stats->hist[i][j]));
+    }
+}
+
+/*
+ * debugfs_core_show - Print the statistics of a core
+ *
+ * @p_seq: Sequence file, its private data is the core
+ * @p_data: Unused
+ *
+ * Return 0
+ */
+static int debugfs_core_show(struct seq_file *p_seq, void *p_data) {
+    struct core_info *p_core = (struct core_info *)p_seq->private;
+
+    seq_printf(p_seq, "lanes %u\n", p_core->num_lanes);
+    stats_show(p_seq, &p_core->stats);
+    return 0;
+}
+
+/*
+ * debugfs_core_open - Open the statistics file of a core
+ *
+ * @p_node: File inode
+ * @p_file: File pointer
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int debugfs_core_open(struct inode *p_node, struct file *p_file) {
+    return single_open(p_file, debugfs_core_show, p_node->i_private);
+}
+
+/*
+ * debugfs_sw_show - Print the statistics of the software engine
+ *
+ * @p_seq: Sequence file
+ * @p_data: Unused
+ *
+ * Return 0
+ */
+static int debugfs_sw_show(struct seq_file *p_seq, void *p_data) {
+    seq_printf(p_seq, "selftest %s\n", drv_info.sw_ok ? "passed" : "failed");
+    stats_show(p_seq, &drv_info.sw_stats);
+    return 0;
+}
+
+/*
+ * debugfs_sw_open - Open the statistics file of the software engine
+ *
+ * @p_node: File inode
+ * @p_file: File pointer
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int debugfs_sw_open(struct inode *p_node, struct file *p_file) {
+    return single_open(p_file, debugfs_sw_show, NULL);
+}
+
+/*
+ * debugfs_sessions_show - Print the statistics of all open sessions
+ *
+ * @p_seq: Sequence file
+ * @p_data: Unused
+ *
+ * Return 0
+ *
+ * Additional information: Each session starts with a line "session pid comm
+ * device lane" naming the lane it is currently assigned to.
+ */
+static int debugfs_sessions_show(struct seq_file *p_seq, void *p_data) {
+    struct axi_trivium_inst *p_inst;
+    struct lane_info *p_lane;
+
+    mutex_lock(&drv_info.mtx);
+    list_for_each_entry(p_inst, &drv_info.sessions, node) {
+        p_lane = p_inst->p_lane;
+        seq_printf(p_seq, "session %d %s %s %u\n", p_inst->pid, p_inst->comm,
+                   dev_name(p_lane->p_core->p_dev), (unsigned int)(p_lane - p_lane->p_core->p_lanes));
+        stats_show(p_seq, &p_inst->stats);
+    }
+    mutex_unlock(&drv_info.mtx);
+
+    return 0;
+}
+
+/*
+ * debugfs_sessions_open - Open the statistics file of the sessions
+ *
+ * @p_node: File inode
+ * @p_file: File pointer
+ *
+ * Return 0 on success, error code otherwise
+ */
+static int debugfs_sessions_open(struct inode *p_node, struct file *p_file) {
+    return single_open(p_file, debugfs_sessions_show, NULL);
+}
+
+/*******************************************************************************
+ * Driver registration and information
+ ******************************************************************************/
+/* Table used to match this driver with an entry in the device tree */
+static const struct of_device_id axi_trivium_of_match[] = {
+    {.compatible = "fuzzylogic,axi_trivium_1.0"},
+    {}
+};
+
+MODULE_DEVICE_TABLE(of, axi_trivium_of_match);
+
+/* Platform driver structure for the AXI4-Lite Trivium core */
+static struct platform_driver axi_trivium_driver = {
+    .driver = {
+        .name = DRIVER_NAME,
+        .owner = THIS_MODULE,
+        .of_match_table = axi_trivium_of_match,
+        .suppress_bind_attrs = true     /* Cores must not disappear while instances use them */
+    },
+    .probe = axi_trivium_probe,
+    .remove = axi_trivium_remove,
+    .shutdown = axi_trivium_shutdown
+};
+
+/*
+ * axi_trivium_init - Set up the front end and register the platform driver
+ *
+ * Returns 0 on success, error code otherwise
+ *
+ * Additional info: The front end serves all cores probed by the platform
+ * driver. Instances are assigned to lanes of any core, see lane_get() and
+ * lane_select().
+ */
+static int __init axi_trivium_init(void) {
+    struct proc_dir_entry *p_proc_entry;
+    int ret_val;
+
+    mutex_init(&drv_info.mtx);
+    INIT_LIST_HEAD(&drv_info.cores);
+    INIT_LIST_HEAD(&drv_info.sessions);
+
+    /* Instances are allocated from a dedicated cache, see inst_ctor() */
+    drv_info.p_inst_cache = kmem_cache_create(DRIVER_NAME "_inst", sizeof(struct axi_trivium_inst), 0, 0, inst_ctor);
+    if (!drv_info.p_inst_cache)
+        return -ENOMEM;
+
+    /* Requests only fall back to software if the engine reproduces the reference output */
+    drv_info.sw_ok = !trivium_sw_selftest();
+    if (!drv_info.sw_ok)
+        pr_err(DRIVER_NAME ": Software engine failed its self test, using the cores only\n");
+
+    /* Batches are processed by one worker per lane */
+    drv_info.p_wq = alloc_workqueue(DRIVER_NAME, WQ_UNBOUND, 0);
+    if (!drv_info.p_wq) {
+        ret_val = -ENOMEM;
+        goto err_wq;
+    }
+
+    /* Statistics of the software engine and the sessions, each core adds its own file */
+    drv_info.p_debugfs = debugfs_create_dir(DRIVER_NAME, NULL);
+    debugfs_create_file("software", S_IRUGO, drv_info.p_debugfs, NULL, &debugfs_sw_fops);
+    debugfs_create_file("sessions", S_IRUGO, drv_info.p_debugfs, NULL, &debugfs_sessions_fops);
+
+    /* Cores register with the front end when they are probed */
+    ret_val = platform_driver_register(&axi_trivium_driver);
+    if (ret_val)
+        goto err_driver;
+
+    /* Create entry in /proc */
+    p_proc_entry = proc_create(DRIVER_NAME, 0, NULL, &proc_fops);
+    if (p_proc_entry == NULL) {
+        pr_err(DRIVER_NAME ": Could not create /proc entry\n");
+        ret_val = -ENOMEM;
+        goto err_proc_entry;   
+    }
+
+    /* Create the character device for ring based sessions */
+    ret_val = misc_register(&misc_dev);
+    if (ret_val) {
+        pr_err(DRIVER_NAME ": Could not register character device\n");
+        goto err_misc_dev;
+    }
+
+    /* Register with the crypto API, requests are queued through the crypto engines of the cores */
+    ret_val = crypto_register_skcipher(&skcipher_trivium_alg);
+    if (ret_val) {
+        pr_err(DRIVER_NAME ": Could not register skcipher\n");
+        goto err_skcipher;
+    }
+
+    return 0;
+
+/* Error cases */
+err_skcipher:
+    misc_deregister(&misc_dev);
+err_misc_dev:
+    remove_proc_entry(DRIVER_NAME, NULL);
+err_proc_entry:
+    platform_driver_unregister(&axi_trivium_driver);
+err_driver:
+    debugfs_remove_recursive(drv_info.p_debugfs);
+    destroy_workqueue(drv_info.p_wq);
+err_wq:
+    kmem_cache_destroy(drv_info.p_inst_cache);
+
+    return ret_val;
+}
+
+/*
+ * axi_trivium_exit - Remove the front end and all cores
+ */
+static void __exit axi_trivium_exit(void) {
+    crypto_unregister_skcipher(&skcipher_trivium_alg);
+    misc_deregister(&misc_dev);
+    remove_proc_entry(DRIVER_NAME, NULL);
+    platform_driver_unregister(&axi_trivium_driver);
+    debugfs_remove_recursive(drv_info.p_debugfs);
+    destroy_workqueue(drv_info.p_wq);
+    kmem_cache_destroy(drv_info.p_inst_cache);
+}
 
-/* Register the platform driver with the kernel */
-module_platform_driver(axi_trivium_driver);
+/* Register the front end and the platform driver with the kernel */
+module_init(axi_trivium_init);
+module_exit(axi_trivium_exit);
 
 /* Module information */
 MODULE_AUTHOR("Christian P. Feist (aka FuzzyLogic)");
@@ -1,33 +1,249 @@
 #ifndef __AXI_TRIVIUM_H
 #define __AXI_TRIVIUM_H
 
-#include <linux/mutex.h>    /* Mutex declaratino */
-#include <asm/io.h>         /* ioreadX() and iowriteX() functions */ 
+#include <linux/mutex.h>        /* Mutex declaratino */
+#include <linux/completion.h>   /* Completion used to wait for interrupts */
+#include <linux/spinlock.h>     /* Spinlock protecting the interrupt registers */
+#include <linux/interrupt.h>    /* irqreturn_t */
+#include <linux/miscdevice.h>   /* Misc character device */
+#include <linux/list.h>         /* Scheduler queues */
+#include <linux/workqueue.h>    /* Worker processing the batches */
+#include <linux/wait.h>         /* Waiting for the requests of a file */
+#include <linux/poll.h>         /* Readiness of a file for poll() */
+#include <linux/uio.h>          /* struct iov_iter */
+#include <linux/fs.h>           /* struct kiocb */
+#include <linux/atomic.h>       /* Queue depth of the lanes */
+#include <linux/average.h>      /* Moving averages of the measured latencies */
+#include <linux/ktime.h>        /* ktime_t */
+#include <linux/sched.h>        /* TASK_COMM_LEN */
+#include <linux/seq_file.h>     /* Statistics files in debugfs */
+#include <linux/debugfs.h>      /* Statistics files in debugfs */
+#include <linux/io.h>           /* __iowrite32_copy() and __ioread32_copy() */
+#include <linux/dma-mapping.h>  /* Descriptor ring and scatterlists of the DMA engine */
+#include <asm/io.h>             /* ioreadX() and iowriteX() functions */ 
+#include <crypto/engine.h>      /* struct crypto_engine_ctx */
+#include <crypto/skcipher.h>    /* struct skcipher_alg */
+#include "axi_trivium_ioctl.h"  /* User-space interface of the character device */
+#include "axi_trivium_regs.h"   /* Register map of the IP core */
 
 /*******************************************************************************
  * Type declarations
  ******************************************************************************/
 
+struct axi_trivium_inst;
+struct core_info;
+
+/* Counters of the statistics, see stat_names */
+#define STAT_REQUESTS       0   /* Completed requests */
+#define STAT_BYTES          1   /* Bytes encrypted */
+#define STAT_HW_WORDS       2   /* Words encrypted by a core */
+#define STAT_SW_WORDS       3   /* Words encrypted by the software engine */
+#define STAT_CTX_SWAPS      4   /* Initializations of a lane with key and IV */
+#define STAT_STATE_SAVES    5   /* Cipher states saved from a lane */
+#define STAT_STATE_RESTORES 6   /* Cipher states restored into a lane */
+#define STAT_IDONE_POLLS    7   /* Reads of the configuration register waiting for IDONE or SDONE */
+#define STAT_OVAL_POLLS     8   /* Reads of the configuration register waiting for output */
+#define STAT_IRQ_WAITS      9   /* Times the caller slept until the interrupt */
+#define STAT_LOCK_WAIT_NS   10  /* Time spent waiting for the lane mutex */
+#define STAT_SKIPPED_WORDS  11  /* Key stream words discarded to reach a file position */
+#define STAT_DMA_DESCS      12  /* Descriptors processed by the DMA engine */
+#define STAT_NUM            13
+
+/* Latency histograms with power of two buckets in us: < 1, 1 - 2, 2 - 4, ..., >= 2^(HIST_BUCKETS - 2) */
+#define HIST_REQ            0   /* Request latency, including waiting for the lane */
+#define HIST_LOCK           1   /* Waiting time for the lane mutex */
+#define HIST_NUM            2
+#define HIST_BUCKETS        16
+
+/* Performance counters of a device or a session */
+struct trivium_stats {
+    atomic64_t  cnt[STAT_NUM];                  /* Counters */
+    atomic64_t  hist[HIST_NUM][HIST_BUCKETS];   /* Latency histograms */
+};
+
+/* A single lane of the IP core with its own register bank */
+struct lane_info {
+    struct core_info        *p_core;        /* Core the lane belongs to */
+    unsigned long           *p_base_addr;   /* Base address of the lane's register bank */
+    unsigned int            *p_push_addr;   /* Push window of the lane, NULL if the core has none */
+    unsigned int            *p_pop_addr;    /* Pop window of the lane, NULL if the core has none */
+    struct mutex            mtx;            /* Serializes access to the lane */
+    unsigned int            num_users;      /* Number of instances assigned to the lane */
+    struct axi_trivium_inst *p_owner;       /* Instance whose state is currently held by the lane */
+    struct completion       done;           /* Signalled by the interrupt handler */
+    spinlock_t              irq_lock;       /* Protects the interrupt registers of the lane */
+    struct list_head        sched_q;        /* Instances with pending batches, served round-robin */
+    spinlock_t              sched_lock;     /* Protects sched_q and the batch lists of its instances */
+    struct work_struct      sched_work;     /* Worker processing the batches of the lane */
+    atomic_t                queued;         /* Number of callers waiting for or holding the lane */
+    struct trivium_stats    *p_stats;       /* Session statistics of the holder of mtx, may be NULL */
+    ktime_t                 locked;         /* Time mtx was acquired */
+};
+
+/* State of the software Trivium engine, s_p of a register is kept at bit (32*n - p) of its n words */
+struct trivium_sw {
+    u32     a[3];   /* Register A, s1 - s93 */
+    u32     b[3];   /* Register B, s94 - s177 */
+    u32     c[4];   /* Register C, s178 - s288 */
+};
+
+/* Descriptor of the DMA engine, little-endian */
+struct dma_desc {
+    __le32  ctrl;       /* Session (DMA_DESC_SESS_*) and event flag */
+    __le32  src;        /* Source bus address */
+    __le32  dst;        /* Destination bus address */
+    __le32  len;        /* Length in words */
+    __le32  sess;       /* Bus address of the key and IV or state block, DMA_DESC_SESS_ALIGN aligned */
+    __le32  rsvd[2];
+    __le32  status;     /* Written by the engine on completion */
+};
+
+/* The descriptor ring of the DMA engine holds 2^DMA_RING_LOG2 entries, one of which stays unused */
+#define DMA_RING_LOG2       6
+#define DMA_RING_ENTRIES    (1 << DMA_RING_LOG2)
+/* The ring is followed by the key and IV block, in the format of the key and IV registers */
+#define DMA_SESS_WORDS      6
+#define DMA_ALLOC_SZ        (DMA_RING_ENTRIES*sizeof(struct dma_desc) + DMA_SESS_WORDS*sizeof(__le32))
+/* Polling interval and timeout in us while waiting for the engine to become idle */
+#define DMA_POLL_US         10
+#define DMA_TIMEOUT_US      1000000
+
+/* Maximum number of encryption requests of a file in flight, a power of two */
+#define FILE_REQS_MAX       16
+
+/* An encryption request written to a file, see proc_axi_trivium_write_iter() */
+struct file_req {
+    unsigned char   *p_buf;     /* Data buffer, encrypted in place and kept for later requests */
+    size_t          buf_cap;    /* Allocated size of the data buffer */
+    unsigned int    sz;         /* Number of bytes of the request */
+    unsigned int    rd_idx;     /* Number of result bytes read so far */
+    u64             pos;        /* Key stream position in words */
+    int             ret_val;    /* 0 if successful, error code otherwise */
+};
+
+/* Moving average of latencies in ns, with 4 fractional bits and a weight of 1/8 for new samples */
+DECLARE_EWMA(lat, 4, 8)
+
+/* Number of registers holding the cipher state, including the key stream spare */
+#define STATE_REGS          11
+/* Maximum number of prefetched key stream words of a lane */
+#define KS_WORDS_MAX        128
+
 /* Represents a user instance of the AXI4-Lite Trivium core */
 struct axi_trivium_inst {
-    unsigned char   *p_key;     /* Key used in this instance */
-    unsigned char   *p_iv;      /* IV used in this instance */
-    unsigned char   *p_pt;      /* Plaintext buffer */
-    unsigned char   *p_ct;      /* Ciphertext buffer */
-    unsigned int    buf_sz;     /* PT/CT buffer size */ 
-    unsigned int    ct_idx;     /* Index into CT buffer */
+    struct lane_info *p_lane;   /* Lane assigned to this instance */
+    unsigned int    state[STATE_REGS];  /* Cipher state saved while the lane is used by another instance */
+    unsigned int    ks[KS_WORDS_MAX];   /* Key stream prefetched by the lane before the state was saved */
+    unsigned int    ks_len;             /* Number of words in ks */
+    unsigned char   state_valid;        /* Flag indicating whether state holds a saved cipher state */
+    struct trivium_sw sw;               /* Cipher state advanced by the software engine */
+    unsigned char   sw_valid;           /* Flag indicating whether sw supersedes the registers in state */
+    u64             ks_pos;             /* Number of key stream words used since key and IV were set */
+    struct mutex    mtx;                /* Serializes the requests of the instance */
+    unsigned char   key[12];    /* Key storage, padded to a multiple of 32 bit for writing to registers */
+    unsigned char   iv[12];     /* IV storage, padded to a multiple of 32 bit for writing to registers */
+    unsigned char   *p_key;     /* Key used in this instance, NULL until set */
+    unsigned char   *p_iv;      /* IV used in this instance, NULL until set */
+    unsigned char   *p_buf;     /* Session buffer, encrypted in place (crypto API only) */
+    size_t          buf_cap;    /* Allocated size of the session buffer */
+    struct file_req reqs[FILE_REQS_MAX];    /* Requests of a file, indexed modulo FILE_REQS_MAX */
+    unsigned int    req_head;       /* Next request to read, free-running like req_done and req_tail */
+    unsigned int    req_done;       /* Next request to process */
+    unsigned int    req_tail;       /* Next request to submit */
+    spinlock_t      req_lock;       /* Protects the request indices */
+    struct mutex    rd_mtx;         /* Serializes the readers of a file */
+    struct mutex    wr_mtx;         /* Serializes the writers of a file */
+    wait_queue_head_t req_wq;       /* Woken when a request has been processed or read */
+    struct work_struct req_work;    /* Worker processing the queued requests */
+    struct axi_trivium_ring_hdr *p_ring;    /* Ring shared with user space (character device only) */
+    unsigned long   ring_sz;    /* Size of the shared ring */
+    unsigned int    ring_entries;   /* Number of ring entries, private copy of the header field */
+    unsigned int    ring_buf_sz;    /* Size of a data buffer, private copy of the header field */
+    unsigned long   ring_buf_off;   /* Offset of the first data buffer, private copy of the header field */
+    unsigned int    sq_head;        /* Next submission to process, private copy of the header field */
+    unsigned int    cq_tail;        /* Next completion to add, private copy of the header field */
+    struct list_head batches;       /* Pending batches of the instance */
+    struct list_head sched_node;    /* Entry in the scheduler queue of the lane, if batches are pending */
+    struct list_head node;          /* Entry in the session list of the driver (files only) */
+    pid_t           pid;            /* Process that opened the session */
+    char            comm[TASK_COMM_LEN];    /* Name of that process */
+    struct trivium_stats stats;     /* Statistics of the session */
+};
+
+/* A batch of jobs submitted by AXI_TRIVIUM_IOC_BATCH */
+struct batch_info {
+    struct list_head        node;       /* Entry in the batch list of the submitting instance */
+    struct axi_trivium_job  *p_jobs;    /* Job descriptors, res is filled in by the worker */
+    unsigned long           *p_offs;    /* Offset of the data of each job in p_dat */
+    unsigned int            *p_order;   /* Job indices, grouped by key and IV in submission order */
+    unsigned int            num_jobs;   /* Number of jobs */
+    unsigned int            next;       /* Next entry of p_order to process */
+    unsigned char           *p_dat;     /* Data of all jobs, encrypted in place */
+    struct axi_trivium_inst inst;       /* Instance holding key and IV of the group being processed */
+    struct completion       done;       /* Signalled once all jobs have been processed */
+    struct trivium_stats    *p_stats;   /* Statistics of the submitting session */
 };
 
-/* Information about the IP core */
+/* Context of a crypto API transform */
+struct trivium_tfm_ctx {
+    struct crypto_engine_ctx enginectx; /* Crypto engine operations, must come first */
+    unsigned char       key[12];        /* Key, padded to a multiple of 32 bit */
+};
+
+/* Context of a crypto API request */
+struct trivium_req_ctx {
+    struct core_info    *p_core;        /* Core whose crypto engine processes the request */
+};
+
+/* Information about an IP core, allocated for every matching device */
 struct core_info {
+    struct list_head    node;           /* Entry in the core list of the driver */
+    struct device       *p_dev;         /* Device of the core */
     unsigned long       *p_base_addr;   /* Base address of the IP core */
     struct resource     *p_res;         /* Device resource structure */
     unsigned long       remap_sz;       /* Device memory size */  
+    struct resource     *p_win_res;     /* FIFO window resource, NULL if unused */
+    void                *p_push_base;   /* Push windows */
+    void                *p_pop_base;    /* Pop windows */
+    struct dma_desc     *p_dma_ring;    /* Descriptor ring of the DMA engine, NULL if the core has none */
+    dma_addr_t          dma_ring_addr;  /* Bus address of the ring */
+    __le32              *p_dma_sess;    /* Key and IV block following the ring */
+    dma_addr_t          dma_sess_addr;  /* Bus address of the key and IV block */
+    unsigned int        dma_tail;       /* Next ring entry to fill, protected by the mutex of lane 0 */
+    unsigned char       dma_hung;       /* The engine did not stop after a timeout and is no longer used */
+    int                 irq;            /* Interrupt number, negative if polling is used */
+    unsigned int        info;           /* Contents of the info register */
+    unsigned int        num_lanes;      /* Number of lanes of the core */
+    struct lane_info    *p_lanes;       /* Lanes of the core */
+    struct crypto_engine *p_engine;     /* Crypto engine queueing crypto API requests for this core */
+    struct axi_trivium_inst *p_crypt_inst;  /* Instance used by the crypto engine, which runs one request at a time */
+    struct ewma_lat     hw_claim_ns;    /* Time to claim a lane for another instance */
+    struct ewma_lat     hw_kib_ns;      /* Time to encrypt 1 KiB with the core */
+    struct trivium_stats stats;         /* Statistics of the core */
+    struct dentry       *p_debugfs;     /* Statistics file of the core */
+};
+
+/* Front end shared by all cores */
+struct driver_info {
+    struct mutex        mtx;            /* Protects the core list and the assignment of lanes */
+    struct list_head    cores;          /* Cores probed so far */
+    struct kmem_cache   *p_inst_cache;  /* Cache of instance objects */
+    struct workqueue_struct *p_wq;      /* Workqueue running the batch workers of the lanes */
+    unsigned char       sw_ok;          /* Software engine passed its self test */
+    struct ewma_lat     sw_init_ns;     /* Time to initialize the software engine */
+    struct ewma_lat     sw_kib_ns;      /* Time to encrypt 1 KiB with the software engine */
+    struct list_head    sessions;       /* Open files, protected by mtx */
+    struct trivium_stats sw_stats;      /* Statistics of the software engine */
+    struct dentry       *p_debugfs;     /* Statistics directory */
 };
 
 /*******************************************************************************
  * Function declarations
  ******************************************************************************/
+static void     map_win(struct platform_device *, struct core_info *);
+static void     unmap_win(struct core_info *);
+static void     map_dma(struct platform_device *, struct core_info *);
+static void     unmap_dma(struct core_info *);
 static int      axi_trivium_probe(struct platform_device *);
 static int      axi_trivium_remove(struct platform_device *);
 static void     axi_trivium_shutdown(struct platform_device *);
@@ -35,75 +251,305 @@ static int      proc_axi_trivium_open(struct inode *, struct file *);
 static int      proc_axi_trivium_close(struct inode *, struct file *);
 static ssize_t  proc_axi_trivium_write(struct file *, const char __user *, size_t, loff_t *);
 static ssize_t  proc_axi_trivium_read(struct file *, char __user *, size_t, loff_t *);
-static int      context_swap(struct core_info *, struct axi_trivium_inst *);
-static int      encrypt(struct core_info *, struct axi_trivium_inst *);
+static ssize_t  proc_axi_trivium_write_iter(struct kiocb *, struct iov_iter *);
+static ssize_t  proc_axi_trivium_read_iter(struct kiocb *, struct iov_iter *);
+static __poll_t proc_axi_trivium_poll(struct file *, poll_table *);
+static loff_t   proc_axi_trivium_llseek(struct file *, loff_t, int);
+static int      file_req_run(struct axi_trivium_inst *, struct file_req *);
+static void     file_req_work(struct work_struct *);
+static long     dev_axi_trivium_ioctl(struct file *, unsigned int, unsigned long);
+static int      dev_axi_trivium_mmap(struct file *, struct vm_area_struct *);
+static int      ring_setup(struct axi_trivium_inst *, struct axi_trivium_setup __user *);
+static int      ring_process(struct axi_trivium_inst *);
+static int      skcipher_trivium_init(struct crypto_skcipher *);
+static void     skcipher_trivium_exit(struct crypto_skcipher *);
+static int      skcipher_trivium_setkey(struct crypto_skcipher *, const u8 *, unsigned int);
+static int      skcipher_trivium_crypt(struct skcipher_request *);
+static int      skcipher_trivium_do_one_request(struct crypto_engine *, void *);
+static int      dma_encrypt(struct core_info *, struct axi_trivium_inst *, struct skcipher_request *);
+static void     inst_ctor(void *);
+static int      buf_reserve(unsigned char **, size_t *, size_t, gfp_t);
+static void     buf_release(unsigned char **, size_t *);
+static int      batch_submit(struct axi_trivium_inst *, struct axi_trivium_batch __user *);
+static bool     batch_run_group(struct lane_info *, struct batch_info *);
+static void     batch_work(struct work_struct *);
+static void     batch_free(struct batch_info *);
+static void     trivium_sw_load(struct trivium_sw *, const unsigned int *);
+static void     trivium_sw_store(struct trivium_sw *, unsigned int *);
+static void     trivium_sw_init(struct trivium_sw *, const unsigned char *, const unsigned char *);
+static void     trivium_sw_crypt(struct trivium_sw *, const unsigned int *, unsigned int *, unsigned int);
+static int      trivium_sw_selftest(void);
+static bool     dispatch_sw(struct axi_trivium_inst *, unsigned int);
+static void     sw_resume(struct axi_trivium_inst *);
+static void     sw_encrypt(struct axi_trivium_inst *, const unsigned int *, unsigned int *, unsigned int);
+static int      hw_encrypt(struct axi_trivium_inst *, const unsigned int *, unsigned int *, unsigned int, bool);
+static bool     skip_sw(struct axi_trivium_inst *, u64);
+static void     sw_skip(struct axi_trivium_inst *, u64);
+static int      hw_skip(struct axi_trivium_inst *, u64);
+static int      inst_seek(struct axi_trivium_inst *, u64);
+static void     inst_rewind(struct axi_trivium_inst *);
+static int      lane_get(struct axi_trivium_inst *);
+static bool     lane_compatible(struct axi_trivium_inst *, struct core_info *);
+static void     lane_select(struct axi_trivium_inst *);
+static struct lane_info *lane_least_loaded(struct core_info *);
+static void     lane_put(struct axi_trivium_inst *);
+static int      lane_claim(struct axi_trivium_inst *);
+static int      context_swap(struct lane_info *, struct axi_trivium_inst *);
+static void     state_save(struct lane_info *, struct axi_trivium_inst *);
+static int      state_restore(struct lane_info *, struct axi_trivium_inst *);
+static int      encrypt(struct lane_info *, const unsigned int *, unsigned int *, unsigned int);
+static void     lane_abort(struct lane_info *);
+static int      lane_skip(struct lane_info *, u64);
+static irqreturn_t axi_trivium_irq(int, void *);
+static int      lane_wait(struct lane_info *, unsigned int, unsigned char);
+static void     lane_lock(struct lane_info *, struct trivium_stats *);
+static void     lane_unlock(struct lane_info *);
+static void     stats_hist(struct trivium_stats *, unsigned int, u64);
+static void     stats_request(struct trivium_stats *, struct trivium_stats *, u64);
+static void     stats_show(struct seq_file *, struct trivium_stats *);
+static int      debugfs_core_show(struct seq_file *, void *);
+static int      debugfs_core_open(struct inode *, struct file *);
+static int      debugfs_sw_show(struct seq_file *, void *);
+static int      debugfs_sw_open(struct inode *, struct file *);
+static int      debugfs_sessions_show(struct seq_file *, void *);
+static int      debugfs_sessions_open(struct inode *, struct file *);
 
 /*******************************************************************************
  * Global variables and definitions
  ******************************************************************************/
-/* IP core registers */
-#define REG_CONFIG  0   /* Configuration register */
-#define REG_KEY_LO  1   /* Register for lowest 32 bits of key */
-#define REG_KEY_MID 2   /* Register for middle 32 bits of key */
-#define REG_KEY_HI  3   /* Register for highest 16 bits of key */
-#define REG_IV_LO   4   /* Register for lowest 32 bits of IV */
-#define REG_IV_MID  5   /* Register for middle 32 bits of IV */
-#define REG_IV_HI   6   /* Register for highest 16 bits of key */
-#define REG_DAT_I   7   /* Input data register */
-#define REG_DAT_O   8   /* Cipher output data register */
-
-/* Config register bits */
-#define REG_CONFIG_BIT_INIT     0   /* Initialize the core after specifying key and IV */
-#define REG_CONFIG_BIT_STOP     1   /* Stop the core and reset the instance */
-#define REG_CONFIG_BIT_PROC     2   /* Start processing input data */
-#define REG_CONFIG_BIT_BUSY     8   /* Read-only bit indicating wheter core is currently busy */
-#define REG_CONFIG_BIT_IDONE    9   /* Read-only bit indicating whether initialization phase has completed */
-#define REG_CONFIG_BIT_OVAL     10  /* Read-only bit indicateing whether output computation has completed */
-
-/* Inline helper functions to read and write registers */
-static inline void reg_wr(struct core_info *p_ip_info, unsigned long reg, unsigned int dat) {
-    if (p_ip_info)
-        iowrite32(dat, p_ip_info->p_base_addr + reg);
+/* Ways of waiting for the core, selected by the wait_mode module parameter */
+#define WAIT_MODE_POLL          0   /* Busy-wait on the configuration register */
+#define WAIT_MODE_IRQ           1   /* Sleep until the interrupt occurs */
+#define WAIT_MODE_HYBRID        2   /* Busy-wait for spin_us microseconds, then sleep */
+
+/* Placement of requests, selected by the dispatch_mode module parameter */
+#define DISPATCH_HW             0   /* Always use the core */
+#define DISPATCH_AUTO           1   /* Choose based on request size, queue depth and measured latencies */
+#define DISPATCH_SW             2   /* Use the software engine unless the core holds the state */
+
+/* Entries of the saved state following the cipher state registers */
+#define STATE_CIPHER_REGS       9   /* Registers holding the 288 state bits s1 - s288, s1 being bit 0 */
+#define STATE_KS_SPARE          9   /* Buffered key stream word, follows the prefetched words */
+#define STATE_KS_SPARE_VLD      10  /* Validity of the buffered key stream word */
+
+/* The software engine generates 32 key stream bits per step */
+#define SW_WARMUP_STEPS         36  /* 1152 warm-up rounds */
+
+/* Inline helper functions to read and write registers of a lane */
+static inline void reg_wr(struct lane_info *p_lane, unsigned long reg, unsigned int dat) {
+    if (p_lane)
+        iowrite32(dat, p_lane->p_base_addr + reg);
 }
 
-static inline unsigned int reg_rd(struct core_info *p_ip_info, unsigned long reg) {
-    if (p_ip_info)
-        return ioread32(p_ip_info->p_base_addr + reg);
+static inline unsigned int reg_rd(struct lane_info *p_lane, unsigned long reg) {
+    if (p_lane)
+        return ioread32(p_lane->p_base_addr + reg);
 
     return 0;
 }
 
-static inline void reg_set(struct core_info *p_ip_info, unsigned long reg, unsigned char bit_pos) {
-    if (p_ip_info)
-        iowrite32(ioread32(p_ip_info->p_base_addr + reg) | (1 << bit_pos), p_ip_info->p_base_addr + reg);
+/* Repeated accesses to a single register, e.g. to transfer several FIFO entries */
+static inline void reg_wr_rep(struct lane_info *p_lane, unsigned long reg, const unsigned int *p_dat, unsigned int cnt) {
+    if (p_lane)
+        iowrite32_rep(p_lane->p_base_addr + reg, p_dat, cnt);
+}
+
+static inline void reg_rd_rep(struct lane_info *p_lane, unsigned long reg, unsigned int *p_dat, unsigned int cnt) {
+    if (p_lane)
+        ioread32_rep(p_lane->p_base_addr + reg, p_dat, cnt);
+}
+
+/*
+ * Transfers of several words through the data FIFOs of a lane, via the FIFO
+ * windows if the core has them and the data registers otherwise. The barrier
+ * orders the pushed words before the next read of the FIFO levels.
+ */
+static inline void fifo_push(struct lane_info *p_lane, const unsigned int *p_dat, unsigned int cnt) {
+    if (p_lane && p_lane->p_push_addr) {
+        __iowrite32_copy(p_lane->p_push_addr, p_dat, cnt);
+        wmb();
+    } else
+        reg_wr_rep(p_lane, REG_DAT_Q, p_dat, cnt);
+}
+
+static inline void fifo_pop(struct lane_info *p_lane, unsigned int *p_dat, unsigned int cnt) {
+    if (p_lane && p_lane->p_pop_addr)
+        __ioread32_copy(p_dat, p_lane->p_pop_addr, cnt);
+    else
+        reg_rd_rep(p_lane, REG_DAT_O, p_dat, cnt);
+}
+
+static inline void reg_set(struct lane_info *p_lane, unsigned long reg, unsigned char bit_pos) {
+    if (p_lane)
+        iowrite32(ioread32(p_lane->p_base_addr + reg) | (1 << bit_pos), p_lane->p_base_addr + reg);
 }
 
-static inline void reg_unset(struct core_info *p_ip_info, unsigned long reg, unsigned char bit_pos) {
-    if (p_ip_info)
-        iowrite32(ioread32(p_ip_info->p_base_addr + reg) & ~(1 << bit_pos), p_ip_info->p_base_addr + reg);
+static inline void reg_unset(struct lane_info *p_lane, unsigned long reg, unsigned char bit_pos) {
+    if (p_lane)
+        iowrite32(ioread32(p_lane->p_base_addr + reg) & ~(1 << bit_pos), p_lane->p_base_addr + reg);
 }
 
-static inline unsigned char reg_get(struct core_info *p_ip_info, unsigned long reg, unsigned char bit_pos) {
-    if (p_ip_info)
-        return (unsigned char)((ioread32(p_ip_info->p_base_addr + reg) & (1 << bit_pos)) >> bit_pos);
+static inline unsigned char reg_get(struct lane_info *p_lane, unsigned long reg, unsigned char bit_pos) {
+    if (p_lane)
+        return (unsigned char)((ioread32(p_lane->p_base_addr + reg) & (1 << bit_pos)) >> bit_pos);
 
     return 0;
 }
 
+/* Inline helper functions to update statistics, NULL pointers are ignored */
+static inline void stats_add(struct trivium_stats *p_stats, unsigned int stat, u64 val) {
+    if (p_stats)
+        atomic64_add(val, &p_stats->cnt[stat]);
+}
+
+/* Counts towards the core of a lane and the session holding it */
+static inline void lane_stats_add(struct lane_info *p_lane, unsigned int stat, u64 val) {
+    stats_add(&p_lane->p_core->stats, stat, val);
+    stats_add(p_lane->p_stats, stat, val);
+}
+
+/* Non-blocking file operations return -EAGAIN instead of waiting */
+static inline bool file_nowait(struct kiocb *p_iocb) {
+    return (p_iocb->ki_filp->f_flags & O_NONBLOCK) || (p_iocb->ki_flags & IOCB_NOWAIT);
+}
+
+/* Room for another request of a file */
+static inline bool file_req_writable(struct axi_trivium_inst *p_inst) {
+    bool ret_val;
+
+    spin_lock(&p_inst->req_lock);
+    ret_val = (p_inst->req_tail - p_inst->req_head < FILE_REQS_MAX);
+    spin_unlock(&p_inst->req_lock);
+
+    return ret_val;
+}
+
+/* No request of a file is still being processed */
+static inline bool file_req_idle(struct axi_trivium_inst *p_inst) {
+    bool ret_val;
+
+    spin_lock(&p_inst->req_lock);
+    ret_val = (p_inst->req_done == p_inst->req_tail);
+    spin_unlock(&p_inst->req_lock);
+
+    return ret_val;
+}
+
+/* The result of the next request of a file to read is available */
+static inline bool file_req_readable(struct axi_trivium_inst *p_inst) {
+    bool ret_val;
+
+    spin_lock(&p_inst->req_lock);
+    ret_val = (p_inst->req_head != p_inst->req_done);
+    spin_unlock(&p_inst->req_lock);
+
+    return ret_val;
+}
+
+/* Names of the counters in debugfs */
+static const char * const stat_names[STAT_NUM] = {
+    "requests",
+    "bytes",
+    "hw_words",
+    "sw_words",
+    "ctx_swaps",
+    "state_saves",
+    "state_restores",
+    "idone_polls",
+    "oval_polls",
+    "irq_waits",
+    "lock_wait_ns",
+    "skipped_words",
+    "dma_descs"
+};
+
+/* Names of the histograms in debugfs */
+static const char * const hist_names[HIST_NUM] = {
+    "request_us",
+    "lock_wait_us"
+};
+
 /* Driver related */
 #define DRIVER_NAME     "axi_trivium"   /* Driver name appearing in procfs */
 #define KEY_LEN         10              /* Number of key bytes */
 #define IV_LEN          10              /* Number of IV bytes */
 #define DAT_LEN_MUL     4               /* Data on write must be multiple of this number of bytes */
 
-struct core_info        ip_info;        /* Global IP core info struct */
-struct mutex            ip_mtx;         /* Global core mutex */
+struct driver_info      drv_info;       /* Global front end info struct */
 
+/* The /proc entry lacks read_iter() and write_iter(), read() and write() wrap them */
 static const struct file_operations proc_fops = {
     .open = proc_axi_trivium_open,
     .release = proc_axi_trivium_close,
     .write = proc_axi_trivium_write,
-    .read = proc_axi_trivium_read
+    .read = proc_axi_trivium_read,
+    .poll = proc_axi_trivium_poll,
+    .llseek = proc_axi_trivium_llseek
+};
+
+/* The character device shares the file operations of the /proc entry, e.g. for io_uring */
+static const struct file_operations dev_fops = {
+    .owner = THIS_MODULE,
+    .open = proc_axi_trivium_open,
+    .release = proc_axi_trivium_close,
+    .write_iter = proc_axi_trivium_write_iter,
+    .read_iter = proc_axi_trivium_read_iter,
+    .poll = proc_axi_trivium_poll,
+    .llseek = proc_axi_trivium_llseek,
+    .unlocked_ioctl = dev_axi_trivium_ioctl,
+    .mmap = dev_axi_trivium_mmap
+};
+
+/* Statistics files in debugfs */
+static const struct file_operations debugfs_core_fops = {
+    .owner = THIS_MODULE,
+    .open = debugfs_core_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release
+};
+
+static const struct file_operations debugfs_sw_fops = {
+    .owner = THIS_MODULE,
+    .open = debugfs_sw_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release
+};
+
+static const struct file_operations debugfs_sessions_fops = {
+    .owner = THIS_MODULE,
+    .open = debugfs_sessions_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release
+};
+
+static struct miscdevice misc_dev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = DRIVER_NAME,
+    .fops = &dev_fops
+};
+
+/* Trivium as an asynchronous stream cipher of the crypto API */
+static struct skcipher_alg skcipher_trivium_alg = {
+    .base = {
+        .cra_name = "trivium",
+        .cra_driver_name = "trivium-" DRIVER_NAME,
+        .cra_priority = 300,    /* Hardware implementation, preferred over software ones */
+        .cra_flags = CRYPTO_ALG_ASYNC,
+        .cra_blocksize = 1,
+        .cra_ctxsize = sizeof(struct trivium_tfm_ctx),
+        .cra_module = THIS_MODULE
+    },
+    .init = skcipher_trivium_init,
+    .exit = skcipher_trivium_exit,
+    .setkey = skcipher_trivium_setkey,
+    .encrypt = skcipher_trivium_crypt,
+    .decrypt = skcipher_trivium_crypt,
+    .min_keysize = KEY_LEN,
+    .max_keysize = KEY_LEN,
+    .ivsize = IV_LEN
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef __AXI_TRIVIUM_IOCTL_H
+#define __AXI_TRIVIUM_IOCTL_H
+
+/*
+ * User-space interface of the /dev/axi_trivium character device. This header
+ * is shared between the driver and user-space applications.
+ *
+ * A session is set up with AXI_TRIVIUM_IOC_SETUP, which loads key and IV and
+ * allocates a shared ring of num_entries entries. The ring is mapped with
+ * mmap() at offset 0 and has the following layout:
+ *
+ *      0:          struct axi_trivium_ring_hdr
+ *      sq_off:     struct axi_trivium_sqe[num_entries] (submission queue)
+ *      cq_off:     struct axi_trivium_cqe[num_entries] (completion queue)
+ *      buf_off:    num_entries data buffers of buf_sz bytes each
+ *
+ * To encrypt a message, user space writes the plaintext into a data buffer,
+ * fills the submission entry at index sq_tail % num_entries and increments
+ * sq_tail. AXI_TRIVIUM_IOC_DOORBELL processes all pending submissions, the
+ * ciphertext replaces the plaintext in the data buffer and a completion entry
+ * is appended at cq_tail. User space consumes completions by incrementing
+ * cq_head. The driver stops processing submissions while the completion queue
+ * is full. Head and tail values are free running, i.e. they are only reduced
+ * modulo num_entries when indexing the queues.
+ *
+ * Independently of a ring session, AXI_TRIVIUM_IOC_BATCH submits a vector of
+ * jobs, each with its own key, IV, input and output buffer, and returns once
+ * all of them have been processed. Jobs with the same key and IV form a single
+ * key stream in submission order, just like consecutive writes to
+ * /proc/axi_trivium, so the lane is initialized only once per distinct key and
+ * IV. Batches of all open files assigned to the same lane are served
+ * round-robin, one key stream at a time.
+ */
+
+#include <linux/types.h>    /* Fixed size types */
+#include <linux/ioctl.h>    /* _IOWR() and co. */
+
+/* Limits of the ring geometry */
+#define AXI_TRIVIUM_RING_MAX_ENTRIES    1024        /* Maximum number of entries, must be a power of two */
+#define AXI_TRIVIUM_RING_MAX_BUF_SZ     65536       /* Maximum size of a data buffer in bytes */
+
+/* Limits of a batch */
+#define AXI_TRIVIUM_BATCH_MAX_JOBS      256         /* Maximum number of jobs */
+#define AXI_TRIVIUM_BATCH_MAX_BYTES     (1 << 20)   /* Maximum total input size in bytes */
+
+/* Parameters of AXI_TRIVIUM_IOC_SETUP */
+struct axi_trivium_setup {
+    __u8    key[10];        /* Key, least significant byte first */
+    __u8    iv[10];         /* IV, least significant byte first */
+    __u32   num_entries;    /* Number of ring entries, power of two */
+    __u32   buf_sz;         /* Size of each data buffer, multiple of 4 bytes */
+    __u32   mmap_sz;        /* Returned: Size of the area to map */
+};
+
+/* Shared ring header */
+struct axi_trivium_ring_hdr {
+    __u32   sq_head;        /* Next submission processed by the driver (written by the driver) */
+    __u32   sq_tail;        /* Next free submission entry (written by user space) */
+    __u32   cq_head;        /* Next completion consumed by user space (written by user space) */
+    __u32   cq_tail;        /* Next free completion entry (written by the driver) */
+    __u32   num_entries;    /* Number of entries of both queues and number of data buffers */
+    __u32   buf_sz;         /* Size of each data buffer */
+    __u32   sq_off;         /* Offset of the submission queue */
+    __u32   cq_off;         /* Offset of the completion queue */
+    __u32   buf_off;        /* Offset of the first data buffer */
+    __u32   reserved[7];
+};
+
+/* Submission queue entry */
+struct axi_trivium_sqe {
+    __u64   user_data;      /* Passed on unchanged to the completion entry */
+    __u32   buf_idx;        /* Index of the data buffer holding the plaintext */
+    __u32   len;            /* Number of bytes to encrypt, multiple of 4 */
+};
+
+/* Completion queue entry */
+struct axi_trivium_cqe {
+    __u64   user_data;      /* user_data of the submission entry */
+    __s32   res;            /* Number of bytes encrypted in place or negative error code */
+    __u32   reserved;
+};
+
+/* Job of AXI_TRIVIUM_IOC_BATCH */
+struct axi_trivium_job {
+    __u8    key[10];        /* Key, least significant byte first */
+    __u8    iv[10];         /* IV, least significant byte first */
+    __u32   len;            /* Number of bytes to encrypt, multiple of 4 */
+    __u64   in;             /* User-space address of the input */
+    __u64   out;            /* User-space address of the output, may equal in */
+    __s32   res;            /* Returned: Number of bytes encrypted or negative error code */
+    __u32   reserved;
+};
+
+/* Parameters of AXI_TRIVIUM_IOC_BATCH */
+struct axi_trivium_batch {
+    __u64   jobs;           /* User-space address of the job array */
+    __u32   num_jobs;       /* Number of jobs */
+    __u32   reserved;
+    __u64   latency_ns;     /* Returned: Time from submission until all jobs were processed */
+};
+
+/* Commands */
+#define AXI_TRIVIUM_IOC_MAGIC       'T'
+#define AXI_TRIVIUM_IOC_SETUP       _IOWR(AXI_TRIVIUM_IOC_MAGIC, 1, struct axi_trivium_setup)
+#define AXI_TRIVIUM_IOC_DOORBELL    _IO(AXI_TRIVIUM_IOC_MAGIC, 2)
+#define AXI_TRIVIUM_IOC_BATCH       _IOWR(AXI_TRIVIUM_IOC_MAGIC, 3, struct axi_trivium_batch)
+
+#endif
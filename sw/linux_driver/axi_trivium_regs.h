@@ -0,0 +1,92 @@
+#ifndef __AXI_TRIVIUM_REGS_H
+#define __AXI_TRIVIUM_REGS_H
+
+/*
+ * Register map of the IP core, see hdl/ip/axi_trivium_v1_0_S00_AXI.v. This
+ * header is shared between the driver and the user-space library in
+ * sw/libaxi_trivium, which accesses the registers through UIO. Register
+ * numbers are 32-bit word offsets into the register bank of a lane.
+ */
+
+/* IP core registers */
+#define REG_CONFIG  0   /* Configuration register */
+#define REG_KEY_LO  1   /* Register for lowest 32 bits of key */
+#define REG_KEY_MID 2   /* Register for middle 32 bits of key */
+#define REG_KEY_HI  3   /* Register for highest 16 bits of key */
+#define REG_IV_LO   4   /* Register for lowest 32 bits of IV */
+#define REG_IV_MID  5   /* Register for middle 32 bits of IV */
+#define REG_IV_HI   6   /* Register for highest 16 bits of key */
+#define REG_DAT_I   7   /* Input data register */
+#define REG_DAT_O   8   /* Cipher output data register */
+#define REG_INFO    9   /* Core information register */
+#define REG_SKIP    10  /* Number of key stream words discarded by the Skip bit */
+#define REG_DAT_Q   11  /* Data queue register, writing it queues the word for processing */
+#define REG_DMA_CTRL 12 /* DMA engine control register (lane 0 only) */
+#define REG_DMA_BASE 13 /* DMA engine ring base address register (lane 0 only) */
+#define REG_DMA_TAIL 14 /* DMA engine tail register, the doorbell (lane 0 only) */
+#define REG_DMA_HEAD 15 /* DMA engine head register (lane 0 only) */
+#define REG_STATE   16  /* First of 9 registers holding the cipher state, followed by key stream spare and valid */
+#define REG_KS_FIFO 27  /* Key stream FIFO register */
+#define REG_KS_STAT 28  /* Key stream status register */
+#define REG_IER     29  /* Interrupt enable register */
+#define REG_ISR     30  /* Interrupt status register (write one to clear) */
+#define REG_DMA_STAT 31 /* DMA engine status register (lane 0 only, write one to clear) */
+
+/* Register banks of the lanes */
+#define LANE_STRIDE         32      /* Distance between the register banks of two lanes */
+#define REG_INFO_LANES_MASK 0xff    /* Info register bits holding the number of lanes */
+#define REG_INFO_CFG_SHIFT  8       /* Info register bits holding BITS_PER_CYCLE and the FIFO depths */
+#define REG_INFO_BITS_SHIFT 8       /* Info register byte holding BITS_PER_CYCLE */
+#define REG_INFO_FIFO_SHIFT 16      /* Info register byte holding FIFO_DEPTH_LOG2 */
+#define REG_INFO_KS_SHIFT   24      /* Info register byte holding KS_FIFO_DEPTH_LOG2 */
+
+/*
+ * FIFO windows of the full AXI4 slave (second memory region of the core), in
+ * words like the registers. The lower half of the region holds the push
+ * windows, the upper half the pop windows, one per lane.
+ */
+#define WIN_STRIDE          1024    /* Distance between the windows of two lanes (4 KiB) */
+#define WIN_REGION_LANES(sz) ((sz)/(2*WIN_STRIDE*4))  /* Lanes covered by a region of sz bytes */
+
+/* Config register bits */
+#define REG_CONFIG_BIT_INIT     0   /* Initialize the core after specifying key and IV */
+#define REG_CONFIG_BIT_STOP     1   /* Stop the core and reset the instance */
+#define REG_CONFIG_BIT_PROC     2   /* Queue input data for processing */
+#define REG_CONFIG_BIT_STREAM   3   /* Exchange data via the AXI4-Stream interfaces instead of registers */
+#define REG_CONFIG_BIT_RESTORE  4   /* Load the cipher state registers into the cipher */
+#define REG_CONFIG_BIT_HOLD     5   /* Stop prefetching key stream */
+#define REG_CONFIG_BIT_SKIP     6   /* Discard REG_SKIP key stream words */
+#define REG_CONFIG_BIT_BUSY     8   /* Read-only bit indicating wheter core is currently busy */
+#define REG_CONFIG_BIT_IDONE    9   /* Read-only bit indicating whether initialization phase has completed */
+#define REG_CONFIG_BIT_SDONE    10  /* Read-only bit indicating whether the last skip has completed */
+#define REG_CONFIG_BIT_DIDLE    11  /* Read-only bit indicating whether the DMA engine has no descriptor to process */
+#define REG_CONFIG_IFREE_SHIFT  16  /* Read-only byte holding the number of free input FIFO entries */
+#define REG_CONFIG_OLVL_SHIFT   24  /* Read-only byte holding the number of output FIFO entries */
+#define REG_CONFIG_LVL_MASK     0xff
+
+/* Key stream status register bits */
+#define REG_KS_STAT_BIT_GEN     8   /* Read-only bit indicating whether a key stream word is being generated */
+#define REG_KS_STAT_LVL_MASK    0xff
+
+/* Interrupt enable/status register bits */
+#define IRQ_BIT_IDONE           0   /* Initialization or restore completed */
+#define IRQ_BIT_OAVAIL          1   /* Output FIFO holds at least one word */
+#define IRQ_BIT_SDONE           2   /* Skip completed */
+#define IRQ_BIT_DMA             3   /* DMA descriptor requesting an event completed or failed */
+
+/* DMA engine registers */
+#define REG_DMA_CTRL_BIT_EN     0   /* Process the descriptors between head and tail */
+#define REG_DMA_CTRL_LOG2_SHIFT 8   /* Bits holding log2 of the number of ring entries */
+#define REG_DMA_CTRL_BIT_BUSY   16  /* Read-only bit indicating whether a descriptor is being processed */
+#define REG_DMA_STAT_BIT_ERR    0   /* A bus error occurred, the engine stopped */
+
+/* DMA engine descriptors, see hdl/ip/axi_trivium_v1_0_M00_AXI.v */
+#define DMA_DESC_SESS_CONT      0   /* Continue the key stream of the previous descriptor */
+#define DMA_DESC_SESS_KEY       1   /* Start a new key stream from the key and IV block */
+#define DMA_DESC_SESS_STATE     2   /* Restore the state block (registers REG_STATE to REG_STATE + 10) */
+#define DMA_DESC_SESS_ALIGN     64  /* Alignment of key and IV or state blocks in bytes */
+#define DMA_DESC_BIT_EVT        31  /* Raise IRQ_BIT_DMA on completion */
+#define DMA_DESC_STAT_BIT_ERR   30  /* Status: the descriptor failed */
+#define DMA_DESC_STAT_BIT_DONE  31  /* Status: the descriptor was processed */
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Tracepoints of the AXI Trivium driver. They mark the expensive operations
+ * of a request on a lane, i.e. acquiring and releasing the lane, the warm-up
+ * of a new key stream, restoring a saved state, fast-forwarding the key
+ * stream and the encryption itself, such that ftrace and perf can attribute
+ * the latency of a request. Each event names the device and the lane it
+ * refers to.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM axi_trivium
+
+#if !defined(__AXI_TRIVIUM_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define __AXI_TRIVIUM_TRACE_H
+
+#include <linux/tracepoint.h>   /* TRACE_EVENT() and co. */
+
+/* Events referring to a lane only */
+DECLARE_EVENT_CLASS(axi_trivium_lane,
+    TP_PROTO(struct lane_info *p_lane),
+    TP_ARGS(p_lane),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(p_lane->p_core->p_dev))
+        __field(unsigned int, lane)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(p_lane->p_core->p_dev));
+        __entry->lane = p_lane - p_lane->p_core->p_lanes;
+    ),
+    TP_printk("%s lane=%u", __get_str(dev), __entry->lane)
+);
+
+/* Events reporting the outcome of an operation on a lane */
+DECLARE_EVENT_CLASS(axi_trivium_lane_ret,
+    TP_PROTO(struct lane_info *p_lane, int ret_val),
+    TP_ARGS(p_lane, ret_val),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(p_lane->p_core->p_dev))
+        __field(unsigned int, lane)
+        __field(int, ret_val)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(p_lane->p_core->p_dev));
+        __entry->lane = p_lane - p_lane->p_core->p_lanes;
+        __entry->ret_val = ret_val;
+    ),
+    TP_printk("%s lane=%u ret=%d", __get_str(dev), __entry->lane, __entry->ret_val)
+);
+
+/* Lane mutex, wait_ns and hold_ns are the time spent waiting for and holding it */
+DEFINE_EVENT(axi_trivium_lane, axi_trivium_lock_acquire,
+    TP_PROTO(struct lane_info *p_lane),
+    TP_ARGS(p_lane)
+);
+
+TRACE_EVENT(axi_trivium_lock_acquired,
+    TP_PROTO(struct lane_info *p_lane, u64 wait_ns),
+    TP_ARGS(p_lane, wait_ns),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(p_lane->p_core->p_dev))
+        __field(unsigned int, lane)
+        __field(u64, wait_ns)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(p_lane->p_core->p_dev));
+        __entry->lane = p_lane - p_lane->p_core->p_lanes;
+        __entry->wait_ns = wait_ns;
+    ),
+    TP_printk("%s lane=%u wait_ns=%llu", __get_str(dev), __entry->lane, __entry->wait_ns)
+);
+
+TRACE_EVENT(axi_trivium_lock_release,
+    TP_PROTO(struct lane_info *p_lane, u64 hold_ns),
+    TP_ARGS(p_lane, hold_ns),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(p_lane->p_core->p_dev))
+        __field(unsigned int, lane)
+        __field(u64, hold_ns)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(p_lane->p_core->p_dev));
+        __entry->lane = p_lane - p_lane->p_core->p_lanes;
+        __entry->hold_ns = hold_ns;
+    ),
+    TP_printk("%s lane=%u hold_ns=%llu", __get_str(dev), __entry->lane, __entry->hold_ns)
+);
+
+/* context_swap(), i.e. loading key and IV and the warm-up phase */
+DEFINE_EVENT(axi_trivium_lane, axi_trivium_context_swap_start,
+    TP_PROTO(struct lane_info *p_lane),
+    TP_ARGS(p_lane)
+);
+
+DEFINE_EVENT(axi_trivium_lane_ret, axi_trivium_context_swap_end,
+    TP_PROTO(struct lane_info *p_lane, int ret_val),
+    TP_ARGS(p_lane, ret_val)
+);
+
+/* state_restore(), the alternative to context_swap() for a saved state */
+DEFINE_EVENT(axi_trivium_lane, axi_trivium_state_restore_start,
+    TP_PROTO(struct lane_info *p_lane),
+    TP_ARGS(p_lane)
+);
+
+DEFINE_EVENT(axi_trivium_lane_ret, axi_trivium_state_restore_end,
+    TP_PROTO(struct lane_info *p_lane, int ret_val),
+    TP_ARGS(p_lane, ret_val)
+);
+
+/* encrypt() */
+TRACE_EVENT(axi_trivium_encrypt_start,
+    TP_PROTO(struct lane_info *p_lane, unsigned int num_words),
+    TP_ARGS(p_lane, num_words),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(p_lane->p_core->p_dev))
+        __field(unsigned int, lane)
+        __field(unsigned int, num_words)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(p_lane->p_core->p_dev));
+        __entry->lane = p_lane - p_lane->p_core->p_lanes;
+        __entry->num_words = num_words;
+    ),
+    TP_printk("%s lane=%u words=%u", __get_str(dev), __entry->lane, __entry->num_words)
+);
+
+DEFINE_EVENT(axi_trivium_lane_ret, axi_trivium_encrypt_end,
+    TP_PROTO(struct lane_info *p_lane, int ret_val),
+    TP_ARGS(p_lane, ret_val)
+);
+
+/* lane_skip() */
+TRACE_EVENT(axi_trivium_skip_start,
+    TP_PROTO(struct lane_info *p_lane, u64 num_words),
+    TP_ARGS(p_lane, num_words),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(p_lane->p_core->p_dev))
+        __field(unsigned int, lane)
+        __field(u64, num_words)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(p_lane->p_core->p_dev));
+        __entry->lane = p_lane - p_lane->p_core->p_lanes;
+        __entry->num_words = num_words;
+    ),
+    TP_printk("%s lane=%u words=%llu", __get_str(dev), __entry->lane, __entry->num_words)
+);
+
+DEFINE_EVENT(axi_trivium_lane_ret, axi_trivium_skip_end,
+    TP_PROTO(struct lane_info *p_lane, int ret_val),
+    TP_ARGS(p_lane, ret_val)
+);
+
+#endif
+
+/* This part must be outside the include guard */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE axi_trivium_trace
+#include <trace/define_trace.h>
@@ -1,4 +1,4 @@
-import os, binascii
+import os, sys, binascii, ctypes, fcntl, mmap, select, struct
 from collections import deque
 from random import randint
 
@@ -191,4 +191,270 @@ def main():
 
     print("Tests successfully completed!")
 
-main()
\ No newline at end of file
+# Commands of the /dev/axi_trivium character device, see axi_trivium_ioctl.h
+AXI_TRIVIUM_IOC_SETUP = (3 << 30) | (32 << 16) | (ord('T') << 8) | 1
+AXI_TRIVIUM_IOC_DOORBELL = (ord('T') << 8) | 2
+
+# Encrypt batches of messages in place using the shared ring of the character device
+def ringTest():
+    numTests = 10
+    numEntries = 8
+    bufSz = 400
+
+    for testNum in range(numTests):
+        devFd = os.open("/dev/axi_trivium", os.O_RDWR)
+
+        # Generate key and IV for this test round
+        curKey = []
+        curIV = []
+        for i in range(10):
+            curKey += [randint(0, 255)]
+            curIV += [randint(0, 255)]
+
+        # Initialize reference
+        trivInst = Trivium(hexToBitList(binascii.hexlify(bytearray(curKey)).zfill(20).decode()), hexToBitList(binascii.hexlify(bytearray(curIV)).zfill(20).decode()))
+
+        # Set up the session and map the ring
+        setup = bytearray(struct.pack("<10s10sIII", bytes(curKey[::-1]), bytes(curIV[::-1]), numEntries, bufSz, 0))
+        fcntl.ioctl(devFd, AXI_TRIVIUM_IOC_SETUP, setup)
+        ring = mmap.mmap(devFd, struct.unpack_from("<I", setup, 28)[0])
+        sqOff, cqOff, bufOff = struct.unpack_from("<III", ring, 24)
+
+        # Submit a random number of messages, the key stream continues across messages
+        numMsgs = randint(1, numEntries)
+        sqTail = struct.unpack_from("<I", ring, 4)[0]
+        ctRefs = []
+        for msgNum in range(numMsgs):
+            numBytes = randint(1, bufSz//4)*4
+            pt = []
+            for i in range(numBytes):
+                pt += [randint(0, 255)]
+
+            ctRefs += [bitListToHex(trivInst.encrypt(hexToBitList(binascii.hexlify(bytearray(pt)).decode())))]
+            ring[bufOff + msgNum*bufSz:bufOff + msgNum*bufSz + numBytes] = bytes(pt[::-1])
+            struct.pack_into("<QII", ring, sqOff + ((sqTail + msgNum)%numEntries)*16, msgNum, msgNum, numBytes)
+
+        struct.pack_into("<I", ring, 4, sqTail + numMsgs)
+        if fcntl.ioctl(devFd, AXI_TRIVIUM_IOC_DOORBELL) != numMsgs:
+            print("Doorbell failed in test " + str(testNum))
+            exit()
+
+        # Check completions and the ciphertext in place
+        cqHead = struct.unpack_from("<I", ring, 8)[0]
+        for msgNum in range(numMsgs):
+            userData, res, _ = struct.unpack_from("<QiI", ring, cqOff + ((cqHead + msgNum)%numEntries)*16)
+            ctHw = ring[bufOff + userData*bufSz:bufOff + userData*bufSz + res][::-1]
+            if res < 0 or binascii.hexlify(ctHw) != ctRefs[userData].encode():
+                print("Ring encryption failed in test " + str(testNum) + ", message " + str(userData))
+                print("Ref: " + ctRefs[userData])
+                print("HW: " + binascii.hexlify(ctHw).decode())
+
+                ring.close()
+                os.close(devFd)
+                exit()
+
+        struct.pack_into("<I", ring, 8, cqHead + numMsgs)
+
+        print("Ring test " + str(testNum) + " passed...")
+        ring.close()
+        os.close(devFd)
+
+    print("Ring tests successfully completed!")
+
+# Command submitting a batch of jobs, see axi_trivium_ioctl.h
+AXI_TRIVIUM_IOC_BATCH = (3 << 30) | (24 << 16) | (ord('T') << 8) | 3
+
+# Encrypt a batch of jobs for a few keys, jobs sharing key and IV continue the same key stream
+def batchTest():
+    numTests = 10
+
+    for testNum in range(numTests):
+        devFd = os.open("/dev/axi_trivium", os.O_RDWR)
+
+        # Generate a few key/IV pairs with a reference instance each
+        numStreams = randint(1, 4)
+        streams = []
+        for streamNum in range(numStreams):
+            curKey = []
+            curIV = []
+            for i in range(10):
+                curKey += [randint(0, 255)]
+                curIV += [randint(0, 255)]
+
+            streams += [(curKey, curIV, Trivium(hexToBitList(binascii.hexlify(bytearray(curKey)).zfill(20).decode()), hexToBitList(binascii.hexlify(bytearray(curIV)).zfill(20).decode())))]
+
+        # Jobs of the different streams are interleaved, each job encrypts in place
+        numJobs = randint(1, 16)
+        bufs = []
+        ctRefs = []
+        jobs = bytearray(numJobs*48)
+        for jobNum in range(numJobs):
+            curKey, curIV, trivInst = streams[randint(0, numStreams - 1)]
+            numBytes = randint(1, 100)*4
+            pt = []
+            for i in range(numBytes):
+                pt += [randint(0, 255)]
+
+            ctRefs += [bitListToHex(trivInst.encrypt(hexToBitList(binascii.hexlify(bytearray(pt)).decode())))]
+            bufs += [ctypes.create_string_buffer(bytes(pt[::-1]), numBytes)]
+            addr = ctypes.addressof(bufs[jobNum])
+            struct.pack_into("<10s10sIQQiI", jobs, jobNum*48, bytes(curKey[::-1]), bytes(curIV[::-1]), numBytes, addr, addr, 0, 0)
+
+        jobBuf = ctypes.create_string_buffer(bytes(jobs), len(jobs))
+        batch = bytearray(struct.pack("<QIIQ", ctypes.addressof(jobBuf), numJobs, 0, 0))
+        fcntl.ioctl(devFd, AXI_TRIVIUM_IOC_BATCH, batch)
+
+        # Check the status and output of each job
+        for jobNum in range(numJobs):
+            res = struct.unpack_from("<i", jobBuf.raw, jobNum*48 + 40)[0]
+            ctHw = bufs[jobNum].raw[::-1]
+            if res != len(ctHw) or binascii.hexlify(ctHw) != ctRefs[jobNum].encode():
+                print("Batch encryption failed in test " + str(testNum) + ", job " + str(jobNum))
+                print("Ref: " + ctRefs[jobNum])
+                print("HW: " + binascii.hexlify(ctHw).decode())
+
+                os.close(devFd)
+                exit()
+
+        print("Batch test " + str(testNum) + " passed (" + str(struct.unpack_from("<Q", batch, 16)[0]) + " ns)...")
+        os.close(devFd)
+
+    print("Batch tests successfully completed!")
+
+# Encrypt parts of messages out of order via pwrite() on /proc/axi_trivium, the file position being the key
+# stream position. The second half is encrypted first, which fast-forwards the key stream, then the first half
+# is encrypted after starting over and finally the last word once more
+def seekTest():
+    numTests = 10
+
+    for testNum in range(numTests):
+        procFd = os.open("/proc/axi_trivium", os.O_RDWR)
+
+        curKey = [randint(0, 255) for i in range(10)]
+        curIV = [randint(0, 255) for i in range(10)]
+        trivInst = Trivium(hexToBitList(binascii.hexlify(bytearray(curKey)).zfill(20).decode()), hexToBitList(binascii.hexlify(bytearray(curIV)).zfill(20).decode()))
+        os.write(procFd, bytes(curKey[::-1]))
+        os.write(procFd, bytes(curIV[::-1]))
+
+        # Reference of the whole message, in the byte order of /proc/axi_trivium
+        numWords = randint(2, 50)
+        pt = bytes([randint(0, 255) for i in range(4*numWords)])
+        ctRef = bytes.fromhex(bitListToHex(trivInst.encrypt(hexToBitList(binascii.hexlify(pt[::-1]).decode()))))[::-1]
+
+        ctHw = bytearray(4*numWords)
+        for start, end in [(numWords//2, numWords), (0, numWords//2), (numWords - 1, numWords)]:
+            os.pwrite(procFd, pt[4*start:4*end], 4*start)
+            ctHw[4*start:4*end] = os.read(procFd, 4*(end - start))
+
+        os.close(procFd)
+        if bytes(ctHw) != ctRef:
+            print("Encryption failed in seek test " + str(testNum))
+            print("Ref: " + binascii.hexlify(ctRef).decode())
+            print("HW: " + binascii.hexlify(ctHw).decode())
+            exit()
+
+        print("Seek test " + str(testNum) + " passed...")
+
+    print("Seek tests successfully completed!")
+
+# Pipeline the parts of messages through /dev/axi_trivium opened with O_NONBLOCK: all parts are submitted before
+# any result is collected, poll() signals room for another request and available results, and the results are
+# read in chunks that do not match the parts
+def pipelineTest():
+    numTests = 10
+
+    for testNum in range(numTests):
+        devFd = os.open("/dev/axi_trivium", os.O_RDWR | os.O_NONBLOCK)
+        pollObj = select.poll()
+        pollObj.register(devFd, select.POLLIN | select.POLLOUT)
+
+        curKey = [randint(0, 255) for i in range(10)]
+        curIV = [randint(0, 255) for i in range(10)]
+        trivInst = Trivium(hexToBitList(binascii.hexlify(bytearray(curKey)).zfill(20).decode()), hexToBitList(binascii.hexlify(bytearray(curIV)).zfill(20).decode()))
+        os.write(devFd, bytes(curKey[::-1]))
+        os.write(devFd, bytes(curIV[::-1]))
+
+        # Reference of the whole message, in the byte order of /dev/axi_trivium
+        numWords = randint(20, 200)
+        pt = bytes([randint(0, 255) for i in range(4*numWords)])
+        ctRef = bytes.fromhex(bitListToHex(trivInst.encrypt(hexToBitList(binascii.hexlify(pt[::-1]).decode()))))[::-1]
+
+        # Submit the parts and collect whatever is available in between
+        ctHw = bytearray()
+        start = 0
+        while len(ctHw) < len(pt):
+            events = dict(pollObj.poll(1000))
+            if not events.get(devFd):
+                print("Pipeline test " + str(testNum) + " timed out")
+                os.close(devFd)
+                exit()
+
+            if start < numWords and events[devFd] & select.POLLOUT:
+                end = min(start + randint(1, 20), numWords)
+                os.write(devFd, pt[4*start:4*end])
+                start = end
+                if start == numWords:
+                    pollObj.modify(devFd, select.POLLIN)
+            elif events[devFd] & select.POLLIN:
+                ctHw += os.read(devFd, 4*randint(1, 30))
+
+        os.close(devFd)
+        if bytes(ctHw) != ctRef:
+            print("Encryption failed in pipeline test " + str(testNum))
+            print("Ref: " + binascii.hexlify(ctRef).decode())
+            print("HW: " + binascii.hexlify(ctHw).decode())
+            exit()
+
+        print("Pipeline test " + str(testNum) + " passed...")
+
+    print("Pipeline tests successfully completed!")
+
+# Iterate over the tests of a binary vector file (see reference_implementation/trivium_vectors.py) as
+# (key, iv, pt, ct). The file is memory-mapped, all values are in the byte order of /proc/axi_trivium
+def readVectors(fileName):
+    with open(fileName, "rb") as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    magic, version, numTests = struct.unpack_from("<4sIQ", data, 0)
+    if magic != b"TRVV" or version != 1:
+        print(fileName + " is no vector file")
+        exit()
+
+    off = 16
+    for testNum in range(numTests):
+        key, iv, numWords = struct.unpack_from("<10s10sI", data, off)
+        off += 24
+        yield key, iv, data[off:off + 4*numWords], data[off + 4*numWords:off + 8*numWords]
+        off += 8*numWords
+
+# Encrypt every test of a vector file via /proc/axi_trivium, the ciphertext is taken from the file
+def vectorTest(fileName):
+    testNum = 0
+    for key, iv, pt, ct in readVectors(fileName):
+        procFd = os.open("/proc/axi_trivium", os.O_RDWR)
+        os.write(procFd, key)
+        os.write(procFd, iv)
+        os.write(procFd, pt)
+        ctHw = os.read(procFd, len(pt))
+        os.close(procFd)
+
+        if ctHw != ct:
+            print("Encryption failed in vector test " + str(testNum))
+            print("Ref: " + binascii.hexlify(ct).decode())
+            print("HW: " + binascii.hexlify(ctHw).decode())
+            exit()
+
+        testNum += 1
+
+    print("Vector tests successfully completed (" + str(testNum) + " tests)!")
+
+# Usage: trivium_test.py [<vector_file>], with a vector file only its tests are run
+if len(sys.argv) > 1:
+    vectorTest(sys.argv[1])
+else:
+    main()
+    seekTest()
+    pipelineTest()
+    ringTest()
+    batchTest()
+    ringTest()